@@ -20,43 +20,60 @@ if((NOT ${COMPILE_RESULT}) OR (NOT RUN_RESULT EQUAL 0))
     message(FATAL "Only little endian systems are supported")
 endif()
 
+# The code is not compiled with -march=native. Instead, every implementation
+# is compiled (per file) with the flags of the instructions it uses, and the
+# library chooses at runtime only the implementations that the CPU supports.
+# Therefore, the tests below check only the compiler support (and not the
+# platform support).
 if(X86_64)
+    set(AVX_FLAGS     "-mavx")
+    set(AVX2_FLAGS    "-mavx2")
+    set(AVX512_FLAGS  "-mavx2 -mavx512f -mavx512bw -mavx512vl")
+    set(SHA_EXT_FLAGS "-msse4.1 -msha")
+
+    # The alternative implementation uses the AVX512VL rotate instructions
+    # also in the AVX and AVX2 code.
+    if(ALTERNATIVE_AVX512_IMPL)
+        set(AVX_FLAGS  "${AVX_FLAGS} -mavx512f -mavx512vl")
+        set(AVX2_FLAGS "${AVX2_FLAGS} -mavx512f -mavx512vl")
+    endif()
+
     # Test AVX2
-    try_run(RUN_RESULT COMPILE_RESULT
-            "${CMAKE_BINARY_DIR}" "${PROJECT_SOURCE_DIR}/cmake/test_x86_64_avx2.c"
-            COMPILE_DEFINITIONS "-march=native -Werror -Wall -Wpedantic"
-            OUTPUT_VARIABLE OUTPUT
+    try_compile(COMPILE_RESULT
+                "${CMAKE_BINARY_DIR}" "${PROJECT_SOURCE_DIR}/cmake/test_x86_64_avx2.c"
+                COMPILE_DEFINITIONS "${AVX2_FLAGS} -Werror -Wall -Wpedantic"
+                OUTPUT_VARIABLE OUTPUT
     )
 
-    if(${COMPILE_RESULT} AND (RUN_RESULT EQUAL 0))
+    if(${COMPILE_RESULT})
         set(CMAKE_C_FLAGS "${CMAKE_C_FLAGS} -DAVX2_SUPPORT")
-        set(AVX2 1)        
+        set(AVX2 1)
     else()
         message(STATUS "The AVX2 implementation is not supported")
     endif()
 
     # Test AVX512
-    try_run(RUN_RESULT COMPILE_RESULT
-            "${CMAKE_BINARY_DIR}" "${PROJECT_SOURCE_DIR}/cmake/test_x86_64_avx512.c"
-            COMPILE_DEFINITIONS "-march=native -Werror -Wall -Wpedantic"
-            OUTPUT_VARIABLE OUTPUT
+    try_compile(COMPILE_RESULT
+                "${CMAKE_BINARY_DIR}" "${PROJECT_SOURCE_DIR}/cmake/test_x86_64_avx512.c"
+                COMPILE_DEFINITIONS "${AVX512_FLAGS} -Werror -Wall -Wpedantic"
+                OUTPUT_VARIABLE OUTPUT
     )
 
-    if(${COMPILE_RESULT} AND (RUN_RESULT EQUAL 0))
+    if(AVX2 AND ${COMPILE_RESULT})
         set(CMAKE_C_FLAGS "${CMAKE_C_FLAGS} -DAVX512_SUPPORT")
-        set(AVX512 1)        
+        set(AVX512 1)
     else()
         message(STATUS "The AVX512 implementation is not supported")
     endif()
-    
+
     # Test SHA extension
-    try_run(RUN_RESULT COMPILE_RESULT
-            "${CMAKE_BINARY_DIR}" "${PROJECT_SOURCE_DIR}/cmake/test_x86_64_sha_ni.c"
-            COMPILE_DEFINITIONS "-march=native -Werror -Wall -Wpedantic"
-            OUTPUT_VARIABLE OUTPUT
+    try_compile(COMPILE_RESULT
+                "${CMAKE_BINARY_DIR}" "${PROJECT_SOURCE_DIR}/cmake/test_x86_64_sha_ni.c"
+                COMPILE_DEFINITIONS "${SHA_EXT_FLAGS} -Werror -Wall -Wpedantic"
+                OUTPUT_VARIABLE OUTPUT
     )
 
-    if(${COMPILE_RESULT} AND (RUN_RESULT EQUAL 0))
+    if(${COMPILE_RESULT})
         set(CMAKE_C_FLAGS "${CMAKE_C_FLAGS} -DX86_64_SHA_SUPPORT")
         set(SHA_EXT 1)
     else()
@@ -65,17 +82,55 @@ if(X86_64)
 endif()
 
 if(AARCH64)
-    # Test AVX2
-    try_run(RUN_RESULT COMPILE_RESULT
-            "${CMAKE_BINARY_DIR}" "${PROJECT_SOURCE_DIR}/cmake/test_aarch64_sha_ni.c"
-            COMPILE_DEFINITIONS "-I${INCLUDE_DIR}/internal -mcpu=native -Werror -Wall -Wpedantic"
-            OUTPUT_VARIABLE OUTPUT
+    set(SHA_EXT_FLAGS "-march=armv8-a+crypto")
+
+    # Test SHA extension
+    try_compile(COMPILE_RESULT
+                "${CMAKE_BINARY_DIR}" "${PROJECT_SOURCE_DIR}/cmake/test_aarch64_sha_ni.c"
+                COMPILE_DEFINITIONS "-I${INCLUDE_DIR}/internal ${SHA_EXT_FLAGS} -Werror -Wall -Wpedantic"
+                OUTPUT_VARIABLE OUTPUT
     )
 
-    if(${COMPILE_RESULT} AND (RUN_RESULT EQUAL 0))
+    if(${COMPILE_RESULT})
         set(CMAKE_C_FLAGS "${CMAKE_C_FLAGS} -DAARCH64_SHA_SUPPORT")
-        set(SHA_EXT 1)        
+        set(SHA_EXT 1)
     else()
         message(STATUS "The SHA_EXT implementation is not supported")
     endif()
+
+    # The SHA512 instructions are an ARMv8.2 extension, separate from the
+    # SHA256 ones
+    set(SHA512_EXT_FLAGS "-march=armv8.2-a+sha3")
+
+    # Test SHA512 extension
+    try_compile(COMPILE_RESULT
+                "${CMAKE_BINARY_DIR}" "${PROJECT_SOURCE_DIR}/cmake/test_aarch64_sha512.c"
+                COMPILE_DEFINITIONS "-I${INCLUDE_DIR}/internal ${SHA512_EXT_FLAGS} -Werror -Wall -Wpedantic"
+                OUTPUT_VARIABLE OUTPUT
+    )
+
+    if(SHA_EXT AND ${COMPILE_RESULT})
+        set(CMAKE_C_FLAGS "${CMAKE_C_FLAGS} -DAARCH64_SHA512_SUPPORT")
+        set(SHA512_EXT 1)
+    else()
+        message(STATUS "The SHA512_EXT implementation is not supported")
+    endif()
+
+    # The SVE code is vector length agnostic, so a single build runs on every
+    # SVE vector length
+    set(SVE_FLAGS "-march=armv8.2-a+sve")
+
+    # Test SVE
+    try_compile(COMPILE_RESULT
+                "${CMAKE_BINARY_DIR}" "${PROJECT_SOURCE_DIR}/cmake/test_aarch64_sve.c"
+                COMPILE_DEFINITIONS "${SVE_FLAGS} -Werror -Wall -Wpedantic"
+                OUTPUT_VARIABLE OUTPUT
+    )
+
+    if(${COMPILE_RESULT})
+        set(CMAKE_C_FLAGS "${CMAKE_C_FLAGS} -DAARCH64_SVE_SUPPORT")
+        set(SVE 1)
+    else()
+        message(STATUS "The SVE implementation is not supported")
+    endif()
 endif()
@@ -10,10 +10,9 @@ set(CMAKE_C_FLAGS "${CMAKE_C_FLAGS} -fvisibility=hidden -Wall -Wextra -Werror -W
 set(CMAKE_C_FLAGS "${CMAKE_C_FLAGS} -Wunused -Wcomment -Wchar-subscripts -Wuninitialized -Wshadow")
 set(CMAKE_C_FLAGS "${CMAKE_C_FLAGS} -Wwrite-strings -Wformat-security -Wcast-qual -Wunused-result")
 
+# The ISA specific flags are set per source file (see sources.cmake).
 if(X86_64)
-    set(CMAKE_C_FLAGS "${CMAKE_C_FLAGS} -march=native -mno-red-zone")
-else()
-    set(CMAKE_C_FLAGS "${CMAKE_C_FLAGS} -mcpu=native")
+    set(CMAKE_C_FLAGS "${CMAKE_C_FLAGS} -mno-red-zone")
 endif()
 
 # Avoiding GCC 4.8 bug
@@ -0,0 +1,74 @@
+# Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+# SPDX-License-Identifier: Apache-2.0
+
+include(GNUInstallDirs)
+include(CMakePackageConfigHelpers)
+
+set(LIB_NAME sha2intrin)
+
+# Compile the sources once (the code is always compiled with -fPIC) and use
+# the objects for both the static and the shared libraries.
+add_library(${LIB_NAME}_objects OBJECT ${SHA_SOURCES} ${OPENSSL_SOURCES})
+
+add_library(${LIB_NAME}_static STATIC $<TARGET_OBJECTS:${LIB_NAME}_objects>)
+add_library(${LIB_NAME}_shared SHARED $<TARGET_OBJECTS:${LIB_NAME}_objects>)
+
+# Only the API of include/sha.h is exported (see SHA_API)
+foreach(type static shared)
+  set_target_properties(${LIB_NAME}_${type} PROPERTIES
+                        OUTPUT_NAME ${LIB_NAME}
+                        EXPORT_NAME ${type}
+  )
+
+  target_include_directories(${LIB_NAME}_${type} INTERFACE
+                             $<BUILD_INTERFACE:${INCLUDE_DIR}>
+                             $<INSTALL_INTERFACE:${CMAKE_INSTALL_INCLUDEDIR}>
+  )
+endforeach()
+
+# The direct file hashing (sha_file_direct.c) reads the file in a thread, and
+# the tree hashing runs on a thread pool (thread_pool.c)
+find_package(Threads REQUIRED)
+target_link_libraries(${LIB_NAME}_static INTERFACE Threads::Threads)
+target_link_libraries(${LIB_NAME}_shared PRIVATE Threads::Threads)
+
+set_target_properties(${LIB_NAME}_shared PROPERTIES
+                      VERSION ${PROJECT_VERSION}
+                      SOVERSION ${PROJECT_VERSION_MAJOR}
+)
+
+set(CONFIG_INSTALL_DIR ${CMAKE_INSTALL_LIBDIR}/cmake/${LIB_NAME})
+
+install(TARGETS ${LIB_NAME}_static ${LIB_NAME}_shared
+        EXPORT ${LIB_NAME}-targets
+        ARCHIVE DESTINATION ${CMAKE_INSTALL_LIBDIR}
+        LIBRARY DESTINATION ${CMAKE_INSTALL_LIBDIR}
+        RUNTIME DESTINATION ${CMAKE_INSTALL_BINDIR}
+)
+
+install(FILES ${INCLUDE_DIR}/sha.h DESTINATION ${CMAKE_INSTALL_INCLUDEDIR})
+
+# Allows find_package(sha2intrin) and linking with sha2intrin::static or
+# sha2intrin::shared
+install(EXPORT ${LIB_NAME}-targets
+        NAMESPACE ${LIB_NAME}::
+        DESTINATION ${CONFIG_INSTALL_DIR}
+)
+
+configure_package_config_file(
+  ${PROJECT_SOURCE_DIR}/cmake/${LIB_NAME}-config.cmake.in
+  ${CMAKE_CURRENT_BINARY_DIR}/${LIB_NAME}-config.cmake
+  INSTALL_DESTINATION ${CONFIG_INSTALL_DIR}
+)
+
+write_basic_package_version_file(
+  ${CMAKE_CURRENT_BINARY_DIR}/${LIB_NAME}-config-version.cmake
+  VERSION ${PROJECT_VERSION}
+  COMPATIBILITY SameMajorVersion
+)
+
+install(FILES
+        ${CMAKE_CURRENT_BINARY_DIR}/${LIB_NAME}-config.cmake
+        ${CMAKE_CURRENT_BINARY_DIR}/${LIB_NAME}-config-version.cmake
+        DESTINATION ${CONFIG_INSTALL_DIR}
+)
@@ -2,13 +2,35 @@
 # SPDX-License-Identifier: Apache-2.0
 
 set(SHA_SOURCES 
+    ${SRC_DIR}/cpu_features.c
+    ${SRC_DIR}/sha_file.c
+    ${SRC_DIR}/sha_file_direct.c
+    ${SRC_DIR}/thread_pool.c
+    ${SRC_DIR}/sha_multi_pool.c
+
     ${SRC_DIR}/sha256.c 
     ${SRC_DIR}/sha256_consts.c 
     ${SRC_DIR}/sha256_compress_generic.c
+    ${SRC_DIR}/sha256_multi.c
+    ${SRC_DIR}/hmac_sha256.c
+    ${SRC_DIR}/pbkdf2_sha256.c
+    ${SRC_DIR}/hkdf_sha256.c
+    ${SRC_DIR}/merkle_sha256.c
+    ${SRC_DIR}/sha256_fixed.c
+    ${SRC_DIR}/sha256d.c
+    ${SRC_DIR}/sha256d_scan.c
+    ${SRC_DIR}/tree_sha256.c
     
     ${SRC_DIR}/sha512.c 
     ${SRC_DIR}/sha512_consts.c 
     ${SRC_DIR}/sha512_compress_generic.c
+    ${SRC_DIR}/sha512_multi.c
+    ${SRC_DIR}/hmac_sha512.c
+    ${SRC_DIR}/pbkdf2_sha512.c
+    ${SRC_DIR}/hkdf_sha512.c
+    ${SRC_DIR}/merkle_sha512.c
+    ${SRC_DIR}/sha512_fixed.c
+    ${SRC_DIR}/tree_sha512.c
 )
 
 set(OPENSSL_DIR ${SRC_DIR}/openssl)
@@ -29,23 +51,56 @@ if(X86_64)
         ${SRC_DIR}/sha512_compress_x86_64_avx.c
     )
 
+    set_source_files_properties(
+        ${SRC_DIR}/sha256_compress_x86_64_avx.c
+        ${SRC_DIR}/sha512_compress_x86_64_avx.c
+        PROPERTIES COMPILE_FLAGS "${AVX_FLAGS}"
+    )
+
     if(AVX2)
         set(SHA_SOURCES ${SHA_SOURCES}
             ${SRC_DIR}/sha256_compress_x86_64_avx2.c
+            ${SRC_DIR}/sha256_multi_compress_x86_64_avx2.c
+            ${SRC_DIR}/sha512_compress_x86_64_avx2.c
+            ${SRC_DIR}/sha512_multi_compress_x86_64_avx2.c
+        )
+
+        set_source_files_properties(
+            ${SRC_DIR}/sha256_compress_x86_64_avx2.c
+            ${SRC_DIR}/sha256_multi_compress_x86_64_avx2.c
             ${SRC_DIR}/sha512_compress_x86_64_avx2.c
+            ${SRC_DIR}/sha512_multi_compress_x86_64_avx2.c
+            PROPERTIES COMPILE_FLAGS "${AVX2_FLAGS}"
         )
     endif()
     
     if(AVX512)
         set(SHA_SOURCES ${SHA_SOURCES}
             ${SRC_DIR}/sha256_compress_x86_64_avx512.c
+            ${SRC_DIR}/sha256_multi_compress_x86_64_avx512.c
             ${SRC_DIR}/sha512_compress_x86_64_avx512.c
+            ${SRC_DIR}/sha512_multi_compress_x86_64_avx512.c
+        )
+
+        set_source_files_properties(
+            ${SRC_DIR}/sha256_compress_x86_64_avx512.c
+            ${SRC_DIR}/sha256_multi_compress_x86_64_avx512.c
+            ${SRC_DIR}/sha512_compress_x86_64_avx512.c
+            ${SRC_DIR}/sha512_multi_compress_x86_64_avx512.c
+            PROPERTIES COMPILE_FLAGS "${AVX512_FLAGS}"
         )
     endif()
     
     if(SHA_EXT)
         set(SHA_SOURCES ${SHA_SOURCES}
             ${SRC_DIR}/sha256_compress_x86_64_sha_ext.c
+            ${SRC_DIR}/sha256_multi_compress_x86_64_sha_ext.c
+        )
+
+        set_source_files_properties(
+            ${SRC_DIR}/sha256_compress_x86_64_sha_ext.c
+            ${SRC_DIR}/sha256_multi_compress_x86_64_sha_ext.c
+            PROPERTIES COMPILE_FLAGS "${SHA_EXT_FLAGS}"
         )
     endif()
 
@@ -56,10 +111,46 @@ if(X86_64)
 endif()
 
 if(AARCH64)
+    # NEON is part of the ARMv8-A baseline and needs no flags
+    set(SHA_SOURCES ${SHA_SOURCES}
+        ${SRC_DIR}/sha256_compress_aarch64_neon.c
+        ${SRC_DIR}/sha256_multi_compress_aarch64_neon.c
+        ${SRC_DIR}/sha512_compress_aarch64_neon.c
+    )
+
     if(SHA_EXT)
         set(SHA_SOURCES ${SHA_SOURCES}
             ${SRC_DIR}/sha256_compress_aarch64_sha_ext.c
         )
+
+        set_source_files_properties(
+            ${SRC_DIR}/sha256_compress_aarch64_sha_ext.c
+            PROPERTIES COMPILE_FLAGS "${SHA_EXT_FLAGS}"
+        )
+    endif()
+
+    if(SHA512_EXT)
+        set(SHA_SOURCES ${SHA_SOURCES}
+            ${SRC_DIR}/sha512_compress_aarch64_sha_ext.c
+        )
+
+        set_source_files_properties(
+            ${SRC_DIR}/sha512_compress_aarch64_sha_ext.c
+            PROPERTIES COMPILE_FLAGS "${SHA512_EXT_FLAGS}"
+        )
+    endif()
+
+    if(SVE)
+        set(SHA_SOURCES ${SHA_SOURCES}
+            ${SRC_DIR}/sha256_multi_compress_aarch64_sve.c
+            ${SRC_DIR}/sha512_multi_compress_aarch64_sve.c
+        )
+
+        set_source_files_properties(
+            ${SRC_DIR}/sha256_multi_compress_aarch64_sve.c
+            ${SRC_DIR}/sha512_multi_compress_aarch64_sve.c
+            PROPERTIES COMPILE_FLAGS "${SVE_FLAGS}"
+        )
     endif()
     
     set(OPENSSL_SOURCES ${OPENSSL_SOURCES}
@@ -0,0 +1,17 @@
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <stdint.h>
+#include "neon_defs.h"
+
+int main(void)
+{
+    uint64_t   data[2] = {0};
+    uint64x2_t TMP[2]  = {0};
+
+    TMP[0] = vld1q_u64(data);
+    TMP[1] = vsha512su0q_u64(TMP[0], TMP[0]);
+
+    // Check for vsha512hq_u64 intrinsic
+    vsha512hq_u64(TMP[0], TMP[1], TMP[0]);
+}
@@ -0,0 +1,18 @@
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <stdint.h>
+#include <arm_sve.h>
+
+int main(void)
+{
+    uint32_t data[64] = {0};
+
+    // Check for the predicated SVE intrinsics
+    const svbool_t   pg  = svwhilelt_b32_u64(0, svcntw());
+    const svuint32_t tmp = svld1_u32(pg, data);
+
+    svst1_u32(pg, data, svrevb_u32_x(pg, svadd_u32_x(pg, tmp, tmp)));
+
+    return (int)data[0];
+}
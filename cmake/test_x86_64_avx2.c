@@ -7,7 +7,7 @@
 int main(void)
 {
   __m256i reg;
-  uint64_t mem[4];
+  uint64_t mem[4] = {0};
   reg = _mm256_loadu_si256((const __m256i*)mem);
   _mm256_storeu_si256((__m256i*)mem, reg);
 }
@@ -7,7 +7,7 @@
 int main(void)
 {
   __m512i reg;
-  uint64_t mem[8];
+  uint64_t mem[8] = {0};
   reg = _mm512_loadu_si512((const __m512i*)mem);
   _mm512_storeu_si512((__m512i*)mem, reg);
 }
@@ -14,6 +14,8 @@ typedef __m256i vec_t;
 #define MADD32(src, imm8, a, b) (_mm256_mask_add_epi32(src, imm8, a, b))
 #define ROR32(a, imm8)          (_mm256_ror_epi32(a, imm8))
 #define ROR64(a, imm8)          (_mm256_ror_epi64(a, imm8))
+#define SET1_32(a)              (_mm256_set1_epi32(a))
+#define SET1_64(a)              (_mm256_set1_epi64x(a))
 #define SHUF8(a, mask)          (_mm256_shuffle_epi8(a, mask))
 #define SHUF32(a, mask)         (_mm256_shuffle_epi32(a, mask))
 #define SLL32(a, imm8)          (_mm256_slli_epi32(a, imm8))
@@ -42,11 +44,9 @@ typedef __m256i vec_t;
       STORE128(hi_mem, _mm256_extracti128_si256(reg, 1)); \
     } while(0)
 
-#  define LOADU2(hi_mem, lo_mem, reg)                          \
-    do {                                                       \
-      reg = _mm256_insertf128_si256(reg, LOAD128(hi_mem), 1);  \
-      reg = _mm256_insertf128_si256(x[i], LOAD128(lo_mem), 0); \
-    } while(0)
+#  define LOADU2(hi_mem, lo_mem, reg)                                \
+    ((reg) = _mm256_inserti128_si256(                                \
+       _mm256_castsi128_si256(LOAD128(lo_mem)), LOAD128(hi_mem), 1))
 #endif
 
 // In every 128-bit value choose the two lowest 32-bit values.
@@ -12,8 +12,11 @@ typedef __m512i vec_t;
 #define ALIGNR8(a, b, mask)     (_mm512_alignr_epi8(a, b, mask))
 #define LOAD(mem)               (_mm512_loadu_si512((const vec_t *)(mem)))
 #define MADD32(src, imm8, a, b) (_mm512_mask_add_epi32(src, imm8, a, b))
+#define MADD64(src, imm8, a, b) (_mm512_mask_add_epi64(src, imm8, a, b))
 #define ROR32(a, imm8)          (_mm512_ror_epi32(a, imm8))
 #define ROR64(a, imm8)          (_mm512_ror_epi64(a, imm8))
+#define SET1_32(a)              (_mm512_set1_epi32(a))
+#define SET1_64(a)              (_mm512_set1_epi64(a))
 #define SHUF32(a, mask)         (_mm512_shuffle_epi32(a, mask))
 #define SHUF8(a, mask)          (_mm512_shuffle_epi8(a, mask))
 #define SLL32(a, imm8)          (_mm512_slli_epi32(a, imm8))
@@ -35,7 +38,7 @@ typedef __m512i vec_t;
 
 #define LOADU4(mem3, mem2, mem1, mem0, reg)            \
   do {                                                 \
-    (reg) = _mm512_inserti32x4(reg, LOAD128(mem0), 0); \
+    (reg) = _mm512_castsi128_si512(LOAD128(mem0));     \
     (reg) = _mm512_inserti32x4(reg, LOAD128(mem1), 1); \
     (reg) = _mm512_inserti32x4(reg, LOAD128(mem2), 2); \
     (reg) = _mm512_inserti32x4(reg, LOAD128(mem3), 3); \
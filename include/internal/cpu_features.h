@@ -0,0 +1,25 @@
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include "defs.h"
+#include "sha.h"
+
+// Returns impl if it is available for SHA256 on the current CPU. Otherwise
+// (including AUTO_IMPL) returns the fastest available SHA256 implementation.
+sha_impl_t sha256_resolve_impl(IN sha_impl_t impl);
+
+// Returns impl if it is available for SHA512 on the current CPU. Otherwise
+// (including AUTO_IMPL) returns the fastest available SHA512 implementation.
+sha_impl_t sha512_resolve_impl(IN sha_impl_t impl);
+
+// Returns impl if it is available for SHA256 on the current CPU. Otherwise
+// (including AUTO_IMPL) returns the fastest available implementation for
+// hashing independent messages with sha256_multi.
+sha_impl_t sha256_multi_resolve_impl(IN sha_impl_t impl);
+
+// Returns impl if it is available for SHA512 on the current CPU. Otherwise
+// (including AUTO_IMPL) returns the fastest available implementation for
+// hashing independent messages with sha512_multi.
+sha_impl_t sha512_multi_resolve_impl(IN sha_impl_t impl);
@@ -21,6 +21,7 @@
 
 #define LSB1(x) ((x)&0x1)
 #define LSB2(x) ((x)&0x3)
+#define LSB3(x) ((x)&0x7)
 #define LSB4(x) ((x)&0xf)
 
 #define ROTR16(x, s) (((x) >> (s)) | (x) << (16 - (s)))
@@ -5,6 +5,11 @@
 #  include <arm_neon.h>
 #endif
 
+// Rotate every 32-bit (64-bit) lane of a right by imm (a constant). The shift
+// right and insert instruction merges the two parts of the rotation.
+#define NEON_ROR32(a, imm) (vsriq_n_u32(vshlq_n_u32(a, 32 - (imm)), a, imm))
+#define NEON_ROR64(a, imm) (vsriq_n_u64(vshlq_n_u64(a, 64 - (imm)), a, imm))
+
 #if !defined(__clang__)
 static inline uint8x16x4_t vld1q_u8_x4(const uint8_t *mem)
 {
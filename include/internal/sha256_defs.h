@@ -3,6 +3,7 @@
 
 #pragma once
 
+#include "defs.h"
 #include "sha.h"
 
 typedef uint32_t sha256_word_t;
@@ -13,8 +14,25 @@ typedef uint32_t sha256_word_t;
 #define SHA256_HASH_WORDS_NUM  (SHA256_HASH_BYTE_LEN / sizeof(sha256_word_t))
 #define SHA256_BLOCK_WORDS_NUM (SHA256_BLOCK_BYTE_LEN / sizeof(sha256_word_t))
 
+// The padding ends with the length of the message in bits, in
+// SHA256_PAD_LEN_BYTE_LEN bytes
+#define SHA256_PAD_LEN_BYTE_LEN (8)
+
 #define SHA256_FINAL_ROUND_START_IDX 48
 
+// The block of a message that is a single digest (32 bytes) holds the digest in
+// W[0..7] and a constant padding: W[8] = 0x80000000, W[9..14] = 0 and
+// W[15] = 256 (the length in bits)
+#define SHA256_DGST_PAD_END_WORD UINT32_C(0x80000000)
+#define SHA256_DGST_PAD_LEN_WORD UINT32_C(0x00000100)
+
+// The second block of an 80 bytes header (SHA256d nonce scanning) holds the
+// last 16 bytes of the header in W[0..3], where W[3] is the nonce, and a
+// constant padding: W[4] = 0x80000000, W[5..14] = 0 and W[15] = 640
+#define SHA256D_SCAN_NONCE_WORD_IDX 3
+#define SHA256D_SCAN_PAD_END_WORD   UINT32_C(0x80000000)
+#define SHA256D_SCAN_PAD_LEN_WORD   UINT32_C(0x00000280)
+
 // The SHA state: parameters a-h
 typedef ALIGN(64) struct sha256_state_st {
   sha256_word_t w[SHA256_HASH_WORDS_NUM];
@@ -24,6 +42,64 @@ typedef ALIGN(64) struct sha256_msg_schedule_st {
   sha256_word_t w[SHA256_BLOCK_WORDS_NUM];
 } sha256_msg_schedule_t;
 
+// The maximal number of messages that the multi-buffer implementations hash in
+// parallel (16 32-bit lanes of an AVX512 register).
+#define SHA256_MAX_LANES_NUM 16
+
+// The states of SHA256_MAX_LANES_NUM independent messages. The states are
+// stored transposed: w[j][i] holds the j-th word of the i-th lane, so that
+// every row can be loaded directly into a vector register.
+typedef ALIGN(64) struct sha256_lanes_state_st {
+  sha256_word_t w[SHA256_HASH_WORDS_NUM][SHA256_MAX_LANES_NUM];
+} sha256_lanes_state_t;
+
+// The hashing context of the public (sha.h) streaming API
+struct sha256_ctx_s {
+  ALIGN(64) sha256_state_t state;
+  uint64_t len;
+
+  ALIGN(64) uint8_t data[2 * SHA256_BLOCK_BYTE_LEN];
+
+  sha256_word_t rem;
+  sha_impl_t    impl;
+
+  // The digest is truncated to dgst_byte_len bytes (see sha224_init)
+  size_t dgst_byte_len;
+};
+
+// The HMAC key of the public (sha.h) HMAC API
+struct hmac_sha256_key_s {
+  // The states after compressing (key XOR ipad) and (key XOR opad)
+  sha256_state_t inner;
+  sha256_state_t outer;
+
+  sha_impl_t impl;
+};
+
+// The nonce scanning context of the public (sha.h) SHA256d scan API. Only the
+// nonce (W[3]) of the second block of the header changes, so the rounds and
+// the parts of the message schedule that do not depend on it are computed once.
+struct sha256d_scan_s {
+  // The state after the first block of the header (the midstate)
+  sha256_state_t mid;
+
+  // The state after the rounds 0-2 of the second block
+  sha256_state_t pre_rounds;
+
+  // The words W[0..2] of the second block, in the order of the header
+  sha256_word_t tail[SHA256D_SCAN_NONCE_WORD_IDX];
+
+  // W[16], W[17] and the parts of W[18] and W[19] that do not depend on the
+  // nonce (W[18] = pre_w[2] + sigma0(W[3]), W[19] = pre_w[3] + W[3])
+  sha256_word_t pre_w[4];
+
+  sha_impl_t single_impl;
+  sha_impl_t multi_impl;
+};
+
+#define HMAC_IPAD_BYTE (0x36)
+#define HMAC_OPAD_BYTE (0x5c)
+
 #define Sigma0_0 2
 #define Sigma0_1 13
 #define Sigma0_2 22
@@ -56,6 +132,12 @@ ALIGN(64) extern const sha256_word_t K256[SHA256_ROUNDS_NUM];
 ALIGN(64) extern const sha256_word_t K256x2[2 * SHA256_ROUNDS_NUM];
 ALIGN(64) extern const sha256_word_t K256x4[4 * SHA256_ROUNDS_NUM];
 
+// The message schedule of the constant padding block of a one block message,
+// added to K256 (see sha256_consts.c)
+ALIGN(64) extern const sha256_word_t WK256_PAD64[SHA256_ROUNDS_NUM];
+
+ALIGN(64) extern const sha256_word_t IV256[SHA256_HASH_WORDS_NUM];
+
 #define ROTATE_STATE(s)                  \
   do {                                   \
     const sha256_word_t tmp = (s)->w[7]; \
@@ -89,10 +171,45 @@ _INLINE_ void accumulate_state(IN OUT sha256_state_t *dst,
   }
 }
 
+// Compresses blocks_num blocks with the implementation impl. The caller must
+// resolve impl (see cpu_features.h).
+void sha256_compress(IN OUT sha256_state_t *state,
+                     IN const uint8_t *data,
+                     IN size_t         blocks_num,
+                     IN sha_impl_t     impl);
+
 void sha256_compress_generic(IN OUT sha256_state_t *state,
                              IN const uint8_t *data,
                              IN size_t         blocks_num);
 
+// Pads the message of ctx and compresses its last block(s). ctx->state then
+// holds the final state, before it is byte swapped into the digest.
+void sha256_final_state(IN OUT sha256_ctx_t *ctx);
+
+// Compresses a block whose message schedule is known in advance. wk[i] holds
+// the i-th word of the schedule added to K256[i], so only the rounds are
+// computed.
+void sha256_compress_wk_generic(IN OUT sha256_state_t *state,
+                                IN const sha256_word_t wk[SHA256_ROUNDS_NUM]);
+
+// Compresses the last block of a message whose last SHA256_HASH_BYTE_LEN bytes
+// are the digest in state, starting from init. The block holds the digest and
+// the padding of a message of len_word bits (a whole number of blocks and a
+// digest). The words of state are the message words of the block, so they are
+// used without byte swapping them into a block. state then holds the result.
+void sha256_compress_dgst_generic(IN OUT sha256_state_t *state,
+                                  IN const sha256_state_t *init,
+                                  IN sha256_word_t         len_word);
+
+// Replaces the final state of a message with the final state of its digest
+// (SHA256d): sha256_compress_dgst_generic from IV256, with a message of the
+// digest alone.
+void sha256_rehash_generic(IN OUT sha256_state_t *state);
+
+// Rehashes state with the implementation impl (see sha256_rehash_generic). The
+// caller must resolve impl.
+void sha256_rehash(IN OUT sha256_state_t *state, IN sha_impl_t impl);
+
 #if defined(X86_64)
 
 void sha256_compress_x86_64_avx(IN OUT sha256_state_t *state,
@@ -110,14 +227,204 @@ void sha256_compress_x86_64_avx512(IN OUT sha256_state_t *state,
 void sha256_compress_x86_64_sha_ext(IN OUT sha256_state_t *state,
                                     IN const uint8_t *data,
                                     IN size_t         blocks_num);
+
+// See sha256_compress_wk_generic
+void sha256_compress_wk_x86_64_sha_ext(
+  IN OUT sha256_state_t *state,
+  IN const sha256_word_t wk[SHA256_ROUNDS_NUM]);
+
+// See sha256_compress_dgst_generic
+void sha256_compress_dgst_x86_64_sha_ext(IN OUT sha256_state_t *state,
+                                         IN const sha256_state_t *init,
+                                         IN sha256_word_t         len_word);
+
+// See sha256_rehash_generic
+void sha256_rehash_x86_64_sha_ext(IN OUT sha256_state_t *state);
 #endif // X86_64
 
+// The multi-buffer compress functions compress blocks_num consecutive blocks
+// of every active lane. The blocks of lane i start at data[i]. Lane i is active
+// if bit i of lanes_mask is set. The state of an inactive lane is not modified
+// and its data pointer is not read.
+typedef void (*sha256_multi_compress_t)(IN OUT sha256_lanes_state_t *state,
+                                        IN const uint8_t *data[],
+                                        IN size_t         blocks_num,
+                                        IN uint32_t       lanes_mask);
+
+// Returns the multi-buffer compress function of multi_impl (resolved with
+// sha256_multi_resolve_impl) and sets lanes_num to its number of lanes. Returns
+// NULL if multi_impl has no multi-buffer implementation.
+sha256_multi_compress_t sha256_multi_compress_func(OUT size_t *lanes_num,
+                                                  IN sha_impl_t multi_impl);
+
+// Compresses, in every active lane, a block whose message schedule is the same
+// in all the lanes and is known in advance (see sha256_compress_wk_generic)
+typedef void (*sha256_multi_compress_wk_t)(
+  IN OUT sha256_lanes_state_t *state,
+  IN const sha256_word_t wk[SHA256_ROUNDS_NUM],
+  IN uint32_t            lanes_mask);
+
+// Returns the compress_wk function of multi_impl, or NULL if it has none
+sha256_multi_compress_wk_t sha256_multi_compress_wk_func(
+  IN sha_impl_t multi_impl);
+
+// Rehashes the state of every active lane (see sha256_rehash_generic)
+typedef void (*sha256_multi_rehash_t)(IN OUT sha256_lanes_state_t *state,
+                                      IN uint32_t lanes_mask);
+
+// Returns the rehash function of multi_impl, or NULL if it has none
+sha256_multi_rehash_t sha256_multi_rehash_func(IN sha_impl_t multi_impl);
+
+// Compresses, in every active lane, the digest block of the state of the lane
+// from the state of the lane in init (see sha256_compress_dgst_generic)
+typedef void (*sha256_multi_compress_dgst_t)(
+  IN OUT sha256_lanes_state_t *state,
+  IN const sha256_lanes_state_t *init,
+  IN sha256_word_t               len_word,
+  IN uint32_t                    lanes_mask);
+
+// Returns the compress_dgst function of multi_impl, or NULL if it has none
+sha256_multi_compress_dgst_t sha256_multi_compress_dgst_func(
+  IN sha_impl_t multi_impl);
+
+// Hashes msgs_num messages in parallel lanes (see sha256_multi). Message i
+// continues from init_state[i], the state after compressing prefix_byte_len
+// bytes (a multiple of the block size) that precede it. When init_state is NULL
+// the messages start from the IV and prefix_byte_len must be zero.
+void sha256_multi_from_states(OUT uint8_t *dgst[],
+                              IN const sha256_state_t *init_state[],
+                              IN size_t                prefix_byte_len,
+                              IN const uint8_t *data[],
+                              IN const size_t   byte_len[],
+                              IN size_t         msgs_num,
+                              IN sha_impl_t     impl);
+
+// Computes the final SHA256d states of the header of scan with the lanes_num
+// consecutive nonces first_nonce, first_nonce + 1, ... in the lanes of state
+typedef void (*sha256d_scan_lanes_t)(OUT sha256_lanes_state_t *state,
+                                     IN const sha256d_scan_t *scan,
+                                     IN uint32_t              first_nonce);
+
+#if defined(AVX2_SUPPORT)
+// 8 lanes
+void sha256_multi_compress_x86_64_avx2(IN OUT sha256_lanes_state_t *state,
+                                       IN const uint8_t *data[],
+                                       IN size_t         blocks_num,
+                                       IN uint32_t       lanes_mask);
+
+void sha256_multi_compress_wk_x86_64_avx2(
+  IN OUT sha256_lanes_state_t *state,
+  IN const sha256_word_t wk[SHA256_ROUNDS_NUM],
+  IN uint32_t            lanes_mask);
+
+void sha256_multi_rehash_x86_64_avx2(IN OUT sha256_lanes_state_t *state,
+                                     IN uint32_t lanes_mask);
+
+void sha256_multi_compress_dgst_x86_64_avx2(
+  IN OUT sha256_lanes_state_t *state,
+  IN const sha256_lanes_state_t *init,
+  IN sha256_word_t               len_word,
+  IN uint32_t                    lanes_mask);
+
+void sha256d_scan_lanes_x86_64_avx2(OUT sha256_lanes_state_t *state,
+                                    IN const sha256d_scan_t *scan,
+                                    IN uint32_t              first_nonce);
+#endif
+
+#if defined(AVX512_SUPPORT)
+// 16 lanes
+void sha256_multi_compress_x86_64_avx512(IN OUT sha256_lanes_state_t *state,
+                                         IN const uint8_t *data[],
+                                         IN size_t         blocks_num,
+                                         IN uint32_t       lanes_mask);
+
+void sha256_multi_compress_wk_x86_64_avx512(
+  IN OUT sha256_lanes_state_t *state,
+  IN const sha256_word_t wk[SHA256_ROUNDS_NUM],
+  IN uint32_t            lanes_mask);
+
+void sha256_multi_rehash_x86_64_avx512(IN OUT sha256_lanes_state_t *state,
+                                       IN uint32_t lanes_mask);
+
+void sha256_multi_compress_dgst_x86_64_avx512(
+  IN OUT sha256_lanes_state_t *state,
+  IN const sha256_lanes_state_t *init,
+  IN sha256_word_t               len_word,
+  IN uint32_t                    lanes_mask);
+
+void sha256d_scan_lanes_x86_64_avx512(OUT sha256_lanes_state_t *state,
+                                      IN const sha256d_scan_t *scan,
+                                      IN uint32_t              first_nonce);
+#endif
+
+#if defined(X86_64_SHA_SUPPORT)
+// 2 lanes (interleaved)
+void sha256_multi_compress_x86_64_sha_ext(IN OUT sha256_lanes_state_t *state,
+                                          IN const uint8_t *data[],
+                                          IN size_t         blocks_num,
+                                          IN uint32_t       lanes_mask);
+
+void sha256_multi_compress_wk_x86_64_sha_ext(
+  IN OUT sha256_lanes_state_t *state,
+  IN const sha256_word_t wk[SHA256_ROUNDS_NUM],
+  IN uint32_t            lanes_mask);
+
+void sha256_multi_rehash_x86_64_sha_ext(IN OUT sha256_lanes_state_t *state,
+                                        IN uint32_t lanes_mask);
+
+void sha256_multi_compress_dgst_x86_64_sha_ext(
+  IN OUT sha256_lanes_state_t *state,
+  IN const sha256_lanes_state_t *init,
+  IN sha256_word_t               len_word,
+  IN uint32_t                    lanes_mask);
+#endif
+
 #if defined(AARCH64)
 void sha256_compress_aarch64_sha_ext(IN OUT sha256_state_t *state,
                                      IN const uint8_t *data,
                                      IN size_t         blocks_num);
 #endif
 
+#if defined(NEON_SUPPORT)
+void sha256_compress_aarch64_neon(IN OUT sha256_state_t *state,
+                                  IN const uint8_t *data,
+                                  IN size_t         blocks_num);
+
+// 4 lanes
+void sha256_multi_compress_aarch64_neon(IN OUT sha256_lanes_state_t *state,
+                                        IN const uint8_t *data[],
+                                        IN size_t         blocks_num,
+                                        IN uint32_t       lanes_mask);
+
+void sha256_multi_compress_wk_aarch64_neon(
+  IN OUT sha256_lanes_state_t *state,
+  IN const sha256_word_t wk[SHA256_ROUNDS_NUM],
+  IN uint32_t            lanes_mask);
+
+void sha256_multi_rehash_aarch64_neon(IN OUT sha256_lanes_state_t *state,
+                                      IN uint32_t lanes_mask);
+
+void sha256_multi_compress_dgst_aarch64_neon(
+  IN OUT sha256_lanes_state_t *state,
+  IN const sha256_lanes_state_t *init,
+  IN sha256_word_t               len_word,
+  IN uint32_t                    lanes_mask);
+
+void sha256d_scan_lanes_aarch64_neon(OUT sha256_lanes_state_t *state,
+                                     IN const sha256d_scan_t *scan,
+                                     IN uint32_t              first_nonce);
+#endif
+
+#if defined(AARCH64_SVE_SUPPORT)
+// The number of 32-bit lanes of the SVE vectors, up to SHA256_MAX_LANES_NUM
+size_t sha256_multi_lanes_num_aarch64_sve(void);
+
+void sha256_multi_compress_aarch64_sve(IN OUT sha256_lanes_state_t *state,
+                                       IN const uint8_t *data[],
+                                       IN size_t         blocks_num,
+                                       IN uint32_t       lanes_mask);
+#endif
+
 // This ASM code was borrowed from OpenSSL as is.
 extern void sha256_block_data_order_local(IN OUT sha256_word_t *state,
                                           IN const uint8_t *data,
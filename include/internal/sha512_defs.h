@@ -3,6 +3,7 @@
 
 #pragma once
 
+#include "defs.h"
 #include "sha.h"
 
 typedef uint64_t sha512_word_t;
@@ -13,8 +14,16 @@ typedef uint64_t sha512_word_t;
 #define SHA512_HASH_WORDS_NUM  (SHA512_HASH_BYTE_LEN / sizeof(sha512_word_t))
 #define SHA512_BLOCK_WORDS_NUM (SHA512_BLOCK_BYTE_LEN / sizeof(sha512_word_t))
 
+// The padding ends with the length of the message in bits, in
+// SHA512_PAD_LEN_BYTE_LEN bytes
+#define SHA512_PAD_LEN_BYTE_LEN (16)
+
 #define SHA512_FINAL_ROUND_START_IDX 64
 
+// The block of a message that ends with a digest (64 bytes) holds the digest in
+// W[0..7], W[8] = 0x8000000000000000, zeros and the length in bits in W[15]
+#define SHA512_DGST_PAD_END_WORD UINT64_C(0x8000000000000000)
+
 // The SHA state: parameters a-h
 typedef struct sha512_state_st {
   ALIGN(64) sha512_word_t w[SHA512_HASH_WORDS_NUM];
@@ -24,6 +33,42 @@ typedef struct sha512_msg_schedule_st {
   ALIGN(64) sha512_word_t w[SHA512_BLOCK_WORDS_NUM];
 } sha512_msg_schedule_t;
 
+// The maximal number of messages that the multi-buffer implementations hash in
+// parallel (8 64-bit lanes of an AVX512 register).
+#define SHA512_MAX_LANES_NUM 8
+
+// The states of SHA512_MAX_LANES_NUM independent messages. The states are
+// stored transposed: w[j][i] holds the j-th word of the i-th lane.
+typedef struct sha512_lanes_state_st {
+  ALIGN(64) sha512_word_t w[SHA512_HASH_WORDS_NUM][SHA512_MAX_LANES_NUM];
+} sha512_lanes_state_t;
+
+// The hashing context of the public (sha.h) streaming API
+struct sha512_ctx_s {
+  ALIGN(64) sha512_state_t state;
+  uint64_t len;
+
+  ALIGN(64) uint8_t data[2 * SHA512_BLOCK_BYTE_LEN];
+
+  sha512_word_t rem;
+  sha_impl_t    impl;
+
+  // The digest is truncated to dgst_byte_len bytes (see sha384_init)
+  size_t dgst_byte_len;
+};
+
+// The HMAC key of the public (sha.h) HMAC API
+struct hmac_sha512_key_s {
+  // The states after compressing (key XOR ipad) and (key XOR opad)
+  sha512_state_t inner;
+  sha512_state_t outer;
+
+  sha_impl_t impl;
+};
+
+#define HMAC_IPAD_BYTE (0x36)
+#define HMAC_OPAD_BYTE (0x5c)
+
 #define Sigma0_0 28
 #define Sigma0_1 34
 #define Sigma0_2 39
@@ -56,6 +101,12 @@ ALIGN(64) extern const sha512_word_t K512[SHA512_ROUNDS_NUM];
 ALIGN(64) extern const sha512_word_t K512x2[2 * SHA512_ROUNDS_NUM];
 ALIGN(64) extern const sha512_word_t K512x4[4 * SHA512_ROUNDS_NUM];
 
+// The message schedule of the constant padding block of a one block message,
+// added to K512 (see sha512_consts.c)
+ALIGN(64) extern const sha512_word_t WK512_PAD128[SHA512_ROUNDS_NUM];
+
+ALIGN(64) extern const sha512_word_t IV512[SHA512_HASH_WORDS_NUM];
+
 #define ROTATE_STATE(s)                  \
   do {                                   \
     const sha512_word_t tmp = (s)->w[7]; \
@@ -89,10 +140,32 @@ _INLINE_ void accumulate_state(IN OUT sha512_state_t *dst,
   }
 }
 
+// Compresses blocks_num blocks with the implementation impl. The caller must
+// resolve impl (see cpu_features.h).
+void sha512_compress(IN OUT sha512_state_t *state,
+                     IN const uint8_t *data,
+                     IN size_t         blocks_num,
+                     IN sha_impl_t     impl);
+
 void sha512_compress_generic(IN OUT sha512_state_t *state,
                              IN const uint8_t *data,
                              IN size_t         blocks_num);
 
+// Compresses a block whose message schedule is known in advance. wk[i] holds
+// the i-th word of the schedule added to K512[i], so only the rounds are
+// computed.
+void sha512_compress_wk_generic(IN OUT sha512_state_t *state,
+                                IN const sha512_word_t wk[SHA512_ROUNDS_NUM]);
+
+// Compresses the last block of a message whose last SHA512_HASH_BYTE_LEN bytes
+// are the digest in state, starting from init. The block holds the digest and
+// the padding of a message of len_word bits. The words of state are the message
+// words of the block, so they are used without byte swapping them into a block.
+// state then holds the result.
+void sha512_compress_dgst_generic(IN OUT sha512_state_t *state,
+                                  IN const sha512_state_t *init,
+                                  IN sha512_word_t         len_word);
+
 #if defined(X86_64)
 void sha512_compress_x86_64_avx(IN OUT sha512_state_t *state,
                                 IN const uint8_t *data,
@@ -107,6 +180,116 @@ void sha512_compress_x86_64_avx512(IN OUT sha512_state_t *state,
                                    IN size_t         blocks_num);
 #endif // X86_64
 
+#if defined(NEON_SUPPORT)
+void sha512_compress_aarch64_neon(IN OUT sha512_state_t *state,
+                                  IN const uint8_t *data,
+                                  IN size_t         blocks_num);
+#endif // NEON_SUPPORT
+
+#if defined(AARCH64_SHA512_SUPPORT)
+void sha512_compress_aarch64_sha_ext(IN OUT sha512_state_t *state,
+                                     IN const uint8_t *data,
+                                     IN size_t         blocks_num);
+#endif // AARCH64_SHA512_SUPPORT
+
+// The multi-buffer compress functions compress blocks_num consecutive blocks
+// of every active lane. The blocks of lane i start at data[i]. Lane i is active
+// if bit i of lanes_mask is set. The state of an inactive lane is not modified
+// and its data pointer is not read.
+typedef void (*sha512_multi_compress_t)(IN OUT sha512_lanes_state_t *state,
+                                        IN const uint8_t *data[],
+                                        IN size_t         blocks_num,
+                                        IN uint32_t       lanes_mask);
+
+// Returns the multi-buffer compress function of multi_impl (resolved with
+// sha512_multi_resolve_impl) and sets lanes_num to its number of lanes. Returns
+// NULL if multi_impl has no multi-buffer implementation.
+sha512_multi_compress_t sha512_multi_compress_func(OUT size_t *lanes_num,
+                                                  IN sha_impl_t multi_impl);
+
+// Compresses, in every active lane, a block whose message schedule is the same
+// in all the lanes and is known in advance (see sha512_compress_wk_generic)
+typedef void (*sha512_multi_compress_wk_t)(
+  IN OUT sha512_lanes_state_t *state,
+  IN const sha512_word_t wk[SHA512_ROUNDS_NUM],
+  IN uint32_t            lanes_mask);
+
+// Returns the compress_wk function of multi_impl, or NULL if it has none
+sha512_multi_compress_wk_t sha512_multi_compress_wk_func(
+  IN sha_impl_t multi_impl);
+
+// Compresses, in every active lane, the digest block of the state of the lane
+// from the state of the lane in init (see sha512_compress_dgst_generic)
+typedef void (*sha512_multi_compress_dgst_t)(
+  IN OUT sha512_lanes_state_t *state,
+  IN const sha512_lanes_state_t *init,
+  IN sha512_word_t               len_word,
+  IN uint32_t                    lanes_mask);
+
+// Returns the compress_dgst function of multi_impl, or NULL if it has none
+sha512_multi_compress_dgst_t sha512_multi_compress_dgst_func(
+  IN sha_impl_t multi_impl);
+
+// Hashes msgs_num messages in parallel lanes (see sha512_multi). Message i
+// continues from init_state[i], the state after compressing prefix_byte_len
+// bytes (a multiple of the block size) that precede it. When init_state is NULL
+// the messages start from the IV and prefix_byte_len must be zero.
+void sha512_multi_from_states(OUT uint8_t *dgst[],
+                              IN const sha512_state_t *init_state[],
+                              IN size_t                prefix_byte_len,
+                              IN const uint8_t *data[],
+                              IN const size_t   byte_len[],
+                              IN size_t         msgs_num,
+                              IN sha_impl_t     impl);
+
+#if defined(AVX2_SUPPORT)
+// 4 lanes
+void sha512_multi_compress_x86_64_avx2(IN OUT sha512_lanes_state_t *state,
+                                       IN const uint8_t *data[],
+                                       IN size_t         blocks_num,
+                                       IN uint32_t       lanes_mask);
+
+void sha512_multi_compress_wk_x86_64_avx2(
+  IN OUT sha512_lanes_state_t *state,
+  IN const sha512_word_t wk[SHA512_ROUNDS_NUM],
+  IN uint32_t            lanes_mask);
+
+void sha512_multi_compress_dgst_x86_64_avx2(
+  IN OUT sha512_lanes_state_t *state,
+  IN const sha512_lanes_state_t *init,
+  IN sha512_word_t               len_word,
+  IN uint32_t                    lanes_mask);
+#endif
+
+#if defined(AVX512_SUPPORT)
+// 8 lanes
+void sha512_multi_compress_x86_64_avx512(IN OUT sha512_lanes_state_t *state,
+                                         IN const uint8_t *data[],
+                                         IN size_t         blocks_num,
+                                         IN uint32_t       lanes_mask);
+
+void sha512_multi_compress_wk_x86_64_avx512(
+  IN OUT sha512_lanes_state_t *state,
+  IN const sha512_word_t wk[SHA512_ROUNDS_NUM],
+  IN uint32_t            lanes_mask);
+
+void sha512_multi_compress_dgst_x86_64_avx512(
+  IN OUT sha512_lanes_state_t *state,
+  IN const sha512_lanes_state_t *init,
+  IN sha512_word_t               len_word,
+  IN uint32_t                    lanes_mask);
+#endif
+
+#if defined(AARCH64_SVE_SUPPORT)
+// The number of 64-bit lanes of the SVE vectors, up to SHA512_MAX_LANES_NUM
+size_t sha512_multi_lanes_num_aarch64_sve(void);
+
+void sha512_multi_compress_aarch64_sve(IN OUT sha512_lanes_state_t *state,
+                                       IN const uint8_t *data[],
+                                       IN size_t         blocks_num,
+                                       IN uint32_t       lanes_mask);
+#endif
+
 // This ASM code was borrowed from OpenSSL as is.
 extern void sha512_block_data_order_local(IN OUT sha512_word_t *state,
                                           IN const uint8_t *data,
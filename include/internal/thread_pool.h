@@ -0,0 +1,54 @@
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include "defs.h"
+#include "sha.h"
+
+// A task of a job. Computes the task task_idx of arg.
+typedef void (*thread_task_t)(IN OUT void *arg, IN size_t task_idx);
+
+// Returns the number of online CPUs (at least 1)
+size_t thread_pool_cpus_num(void);
+
+// Runs task(arg, i) for every i < tasks_num on the threads of pool, including
+// the calling thread, and returns when all the tasks are complete. The tasks
+// are split evenly between the threads, and a thread that completed its tasks
+// steals half of the remaining tasks of another thread, so tasks of different
+// lengths are balanced. Jobs that are submitted to the same pool from several
+// threads run one after the other. A NULL pool runs the tasks on the calling
+// thread.
+void thread_pool_exec(IN OUT sha_pool_t *pool,
+                      IN size_t          tasks_num,
+                      IN thread_task_t   task,
+                      IN OUT void *      arg);
+
+// Runs a single job (see thread_pool_exec) on a temporary pool of threads_num
+// threads (threads_num == 0 means one thread per CPU). If the threads cannot
+// be created, the tasks run on the calling thread.
+void thread_pool_run(IN size_t        threads_num,
+                     IN size_t        tasks_num,
+                     IN thread_task_t task,
+                     IN OUT void *    arg);
+
+// sha256_multi or sha512_multi
+typedef void (*sha_multi_func_t)(OUT uint8_t *dgst[],
+                                 IN const uint8_t *data[],
+                                 IN const size_t   byte_len[],
+                                 IN size_t         msgs_num,
+                                 IN sha_impl_t     impl);
+
+// Hashes the messages with multi in batches on the threads of pool (see
+// sha256_multi_pool). The batches are balanced by the number of padded blocks
+// of every message, computed from the block size of the hash function and from
+// the size of the length at the end of its padding.
+int sha_multi_pool(OUT uint8_t *dgst[],
+                   IN const uint8_t *data[],
+                   IN const size_t   byte_len[],
+                   IN size_t         msgs_num,
+                   IN OUT sha_pool_t *pool,
+                   IN sha_multi_func_t multi,
+                   IN size_t           block_byte_len,
+                   IN size_t           pad_len_byte_len,
+                   IN sha_impl_t       impl);
@@ -1,54 +1,694 @@
 // Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
 // SPDX-License-Identifier: Apache-2.0
+//
+// The public API of the library.
 
 #pragma once
 
-#include "internal/defs.h"
+#include <stddef.h>
+#include <stdint.h>
 
-typedef enum sha_impl_e
-{
-  GENERIC_IMPL,
-
-#if defined(X86_64)
-  AVX_IMPL,
-  OPENSSL_AVX_IMPL,
+#if !defined(IN)
+#  define IN
 #endif
 
-#if defined(AVX2_SUPPORT)
-  AVX2_IMPL,
-  OPENSSL_AVX2_IMPL,
+#if !defined(OUT)
+#  define OUT
 #endif
 
-#if defined(AVX512_SUPPORT)
-  AVX512_IMPL,
+// The library is compiled with -fvisibility=hidden, only the functions that
+// are declared with SHA_API are exported.
+#if defined(__GNUC__) || defined(__clang__)
+#  define SHA_API __attribute__((visibility("default")))
+#else
+#  define SHA_API
 #endif
 
-#if defined(X86_64_SHA_SUPPORT)
-  SHA_EXT_IMPL,
-  OPENSSL_SHA_EXT_IMPL,
-#endif
+// The values of this enum are part of the ABI of the library, and therefore do
+// not depend on the platform. Implementations that were not compiled in, or
+// that the current CPU does not support, fall back to AUTO_IMPL.
+typedef enum sha_impl_e
+{
+  GENERIC_IMPL = 0,
 
-#if defined(NEON_SUPPORT)
-  NEON_IMPL,
-  OPENSSL_NEON_IMPL,
-#endif
+  // X86-64 implementations
+  AVX_IMPL          = 1,
+  OPENSSL_AVX_IMPL  = 2,
+  AVX2_IMPL         = 3,
+  OPENSSL_AVX2_IMPL = 4,
+  AVX512_IMPL       = 5,
 
-#if defined(AARCH64_SHA_SUPPORT)
-  SHA_EXT_IMPL,
-  OPENSSL_SHA_EXT_IMPL,
-#endif
+  // X86-64 and AARCH64 implementations
+  SHA_EXT_IMPL         = 6,
+  OPENSSL_SHA_EXT_IMPL = 7,
+
+  // AARCH64 implementations
+  NEON_IMPL         = 8,
+  OPENSSL_NEON_IMPL = 9,
 
+  // Use the fastest implementation that the current CPU supports.
+  // The choice is made once, when the library is loaded.
+  AUTO_IMPL = 10,
+
+  // AARCH64 multi-buffer implementation (sha*_multi). It hashes as many
+  // messages in parallel as the SVE vector length allows. Single messages are
+  // hashed with the NEON implementation.
+  SVE_IMPL = 11,
 } sha_impl_t;
 
 #define SHA256_HASH_BYTE_LEN 32
 #define SHA512_HASH_BYTE_LEN 64
 
-void sha256(OUT uint8_t *dgst,
-            IN const uint8_t *data,
-            IN size_t         byte_len,
-            IN sha_impl_t     impl);
+// The truncated variants (FIPS 180-4) use the SHA256/SHA512 compress functions
+// with their own IVs, so every implementation supports them.
+#define SHA224_HASH_BYTE_LEN      28
+#define SHA384_HASH_BYTE_LEN      48
+#define SHA512_T224_HASH_BYTE_LEN 28
+#define SHA512_T256_HASH_BYTE_LEN 32
+
+// Returns 1 if impl is compiled in and the current CPU supports it, otherwise
+// returns 0.
+SHA_API int sha_impl_supported(IN sha_impl_t impl);
+
+// Same as sha_impl_supported, for the SHA512 compress functions. The SHA
+// extension implementations of SHA512 need the SHA512 instructions (ARMv8.2
+// SHA512 on aarch64), which the x86-64 SHA extension does not have.
+SHA_API int sha512_impl_supported(IN sha_impl_t impl);
+
+//////////////////////////////
+//  One-shot API
+//////////////////////////////
+
+SHA_API void sha256(OUT uint8_t *dgst,
+                    IN const uint8_t *data,
+                    IN size_t         byte_len,
+                    IN sha_impl_t     impl);
+
+SHA_API void sha512(OUT uint8_t *dgst,
+                    IN const uint8_t *data,
+                    IN size_t         byte_len,
+                    IN sha_impl_t     impl);
+
+SHA_API void sha224(OUT uint8_t *dgst,
+                    IN const uint8_t *data,
+                    IN size_t         byte_len,
+                    IN sha_impl_t     impl);
+
+SHA_API void sha384(OUT uint8_t *dgst,
+                    IN const uint8_t *data,
+                    IN size_t         byte_len,
+                    IN sha_impl_t     impl);
+
+SHA_API void sha512_t224(OUT uint8_t *dgst,
+                         IN const uint8_t *data,
+                         IN size_t         byte_len,
+                         IN sha_impl_t     impl);
+
+SHA_API void sha512_t256(OUT uint8_t *dgst,
+                         IN const uint8_t *data,
+                         IN size_t         byte_len,
+                         IN sha_impl_t     impl);
+
+//////////////////////////////
+//  Streaming (incremental) API
+//////////////////////////////
+
+// Opaque hashing contexts
+typedef struct sha256_ctx_s sha256_ctx_t;
+typedef struct sha512_ctx_s sha512_ctx_t;
+
+// Allocates a context. Returns NULL on failure.
+// A context can be reused: after sha*_final it can be passed to sha*_init.
+SHA_API sha256_ctx_t *sha256_ctx_new(void);
+SHA_API sha512_ctx_t *sha512_ctx_new(void);
+
+// Cleans and frees a context (ctx may be NULL).
+SHA_API void sha256_ctx_free(IN OUT sha256_ctx_t *ctx);
+SHA_API void sha512_ctx_free(IN OUT sha512_ctx_t *ctx);
+
+// Copies the state of a message, for example to continue several messages from
+// a common prefix (a midstate) that is hashed only once.
+SHA_API void sha256_ctx_copy(OUT sha256_ctx_t *dst, IN const sha256_ctx_t *src);
+SHA_API void sha512_ctx_copy(OUT sha512_ctx_t *dst, IN const sha512_ctx_t *src);
+
+// Starts a new message. The implementation is resolved here, once per message.
+SHA_API void sha256_init(OUT sha256_ctx_t *ctx, IN sha_impl_t impl);
+SHA_API void sha512_init(OUT sha512_ctx_t *ctx, IN sha_impl_t impl);
+
+// Starts a message of a truncated variant. The variants continue with the
+// update and final functions of their base hash (sha224 with sha256_*, and
+// sha384, sha512_t224 and sha512_t256 with sha512_*), and the digest is
+// SHA*_HASH_BYTE_LEN bytes of the variant.
+SHA_API void sha224_init(OUT sha256_ctx_t *ctx, IN sha_impl_t impl);
+SHA_API void sha384_init(OUT sha512_ctx_t *ctx, IN sha_impl_t impl);
+SHA_API void sha512_t224_init(OUT sha512_ctx_t *ctx, IN sha_impl_t impl);
+SHA_API void sha512_t256_init(OUT sha512_ctx_t *ctx, IN sha_impl_t impl);
+
+// Hashes the next byte_len bytes of the message. Full blocks are compressed
+// directly from data, only a partial block is buffered in the context.
+SHA_API void sha256_update(IN OUT sha256_ctx_t *ctx,
+                           IN const uint8_t *data,
+                           IN size_t         byte_len);
+
+SHA_API void sha512_update(IN OUT sha512_ctx_t *ctx,
+                           IN const uint8_t *data,
+                           IN size_t         byte_len);
+
+// Writes the digest and cleans the context.
+SHA_API void sha256_final(OUT uint8_t *dgst, IN OUT sha256_ctx_t *ctx);
+SHA_API void sha512_final(OUT uint8_t *dgst, IN OUT sha512_ctx_t *ctx);
+
+//////////////////////////////
+//  Multi-buffer API
+//////////////////////////////
+
+// Hashes msgs_num independent messages: dgst[i] = SHA256(data[i], byte_len[i]).
+// The AVX2 and AVX512 implementations hash 8 and 16 messages in parallel, one
+// message per 32-bit lane of a vector register. The x86-64 SHA extension
+// implementation interleaves the rounds of 2 messages. The messages may have
+// different lengths. Other implementations hash the messages one by one.
+SHA_API void sha256_multi(OUT uint8_t *dgst[],
+                          IN const uint8_t *data[],
+                          IN const size_t   byte_len[],
+                          IN size_t         msgs_num,
+                          IN sha_impl_t     impl);
+
+// Hashes msgs_num independent messages: dgst[i] = SHA512(data[i], byte_len[i]).
+// The AVX2 and AVX512 implementations hash 4 and 8 messages in parallel, one
+// message per 64-bit lane of a vector register.
+SHA_API void sha512_multi(OUT uint8_t *dgst[],
+                          IN const uint8_t *data[],
+                          IN const size_t   byte_len[],
+                          IN size_t         msgs_num,
+                          IN sha_impl_t     impl);
+
+// A lane that completed its message is refilled with the next message, so the
+// lanes are only partially busy at the end of a batch. The lane utilization is
+// reported in the counters of sha_multi_stats_t:
+//   - Every multi-buffer compression of n blocks adds n * (the number of lanes)
+//     to lanes_blocks_num, and n * (the number of lanes with a message) to
+//     busy_blocks_num. The utilization is busy_blocks_num / lanes_blocks_num.
+//   - The blocks that are compressed with the single buffer implementation
+//     (the last message of a batch, or all the messages when there is no
+//     multi-buffer implementation) are added to single_blocks_num.
+typedef struct sha_multi_stats_s {
+  uint64_t lanes_blocks_num;
+  uint64_t busy_blocks_num;
+  uint64_t single_blocks_num;
+} sha_multi_stats_t;
+
+// Same as sha*_multi, and adds the lane utilization of the batch to stats.
+SHA_API void sha256_multi_stats(OUT uint8_t *dgst[],
+                                IN const uint8_t *data[],
+                                IN const size_t   byte_len[],
+                                IN size_t         msgs_num,
+                                IN sha_impl_t     impl,
+                                IN OUT sha_multi_stats_t *stats);
+
+SHA_API void sha512_multi_stats(OUT uint8_t *dgst[],
+                                IN const uint8_t *data[],
+                                IN const size_t   byte_len[],
+                                IN size_t         msgs_num,
+                                IN sha_impl_t     impl,
+                                IN OUT sha_multi_stats_t *stats);
+
+//////////////////////////////
+//  Fixed length API
+//////////////////////////////
+
+// Hashes a message of exactly 32 or 64 (SHA256) and 64 or 128 (SHA512) bytes,
+// such as a digest or a pair of digests. The padding of these lengths is
+// constant and is not computed per message.
+SHA_API void sha256_32B(OUT uint8_t *dgst,
+                        IN const uint8_t *data,
+                        IN sha_impl_t     impl);
+
+SHA_API void sha256_64B(OUT uint8_t *dgst,
+                        IN const uint8_t *data,
+                        IN sha_impl_t     impl);
+
+SHA_API void sha512_64B(OUT uint8_t *dgst,
+                        IN const uint8_t *data,
+                        IN sha_impl_t     impl);
+
+SHA_API void sha512_128B(OUT uint8_t *dgst,
+                         IN const uint8_t *data,
+                         IN sha_impl_t     impl);
+
+// Hashes msgs_num messages of the fixed length in parallel lanes (see
+// sha256_multi). The messages are stored consecutively in data and the digests
+// consecutively in dgst.
+SHA_API void sha256_32B_multi(OUT uint8_t *dgst,
+                              IN const uint8_t *data,
+                              IN size_t         msgs_num,
+                              IN sha_impl_t     impl);
+
+SHA_API void sha256_64B_multi(OUT uint8_t *dgst,
+                              IN const uint8_t *data,
+                              IN size_t         msgs_num,
+                              IN sha_impl_t     impl);
+
+SHA_API void sha512_64B_multi(OUT uint8_t *dgst,
+                              IN const uint8_t *data,
+                              IN size_t         msgs_num,
+                              IN sha_impl_t     impl);
+
+SHA_API void sha512_128B_multi(OUT uint8_t *dgst,
+                               IN const uint8_t *data,
+                               IN size_t         msgs_num,
+                               IN sha_impl_t     impl);
+
+//////////////////////////////
+//  SHA256d API
+//////////////////////////////
+
+// dgst = SHA256(SHA256(data)). The second hash is compressed directly from the
+// final state of the first one, with a constant padding. An empty data may be
+// passed as NULL.
+SHA_API void sha256d(OUT uint8_t *dgst,
+                     IN const uint8_t *data,
+                     IN size_t         byte_len,
+                     IN sha_impl_t     impl);
+
+// Completes a message that was started with sha256_init and sha256_update
+// (or continued from a midstate with sha256_ctx_copy) with SHA256d instead of
+// SHA256. Writes the digest and cleans the context.
+SHA_API void sha256d_final(OUT uint8_t *dgst, IN OUT sha256_ctx_t *ctx);
+
+// Hashes msgs_num independent messages with SHA256d in parallel lanes (see
+// sha256_multi). The second hash of all the lanes is computed together, from
+// the transposed final states of the first hash.
+SHA_API void sha256d_multi(OUT uint8_t *dgst[],
+                           IN const uint8_t *data[],
+                           IN const size_t   byte_len[],
+                           IN size_t         msgs_num,
+                           IN sha_impl_t     impl);
+
+// Nonce scanning of 80 bytes headers (e.g., block headers) with SHA256d. The
+// nonce is the last 4 bytes of the header (little endian). A scan context
+// holds the state after the first 64 bytes of the header (the midstate) and
+// the parts of the second block that do not depend on the nonce, so every
+// candidate nonce costs a part of one block and the second hash.
+#define SHA256D_HEADER_BYTE_LEN 80
+
+typedef struct sha256d_scan_s sha256d_scan_t;
+
+// Allocates a scan context. Returns NULL on failure.
+SHA_API sha256d_scan_t *sha256d_scan_new(void);
+
+// Cleans and frees a scan context (scan may be NULL).
+SHA_API void sha256d_scan_free(IN OUT sha256d_scan_t *scan);
+
+// Precomputes the midstate of header (SHA256D_HEADER_BYTE_LEN bytes). The
+// nonce bytes of header are ignored. The implementation is resolved here.
+SHA_API void sha256d_scan_init(OUT sha256d_scan_t *scan,
+                               IN const uint8_t *header,
+                               IN sha_impl_t     impl);
+
+// Hashes the header of scan with the nonces first_nonce, first_nonce + 1, ...
+// (nonces_num <= 2^32 nonces, wrapping around) in parallel lanes, and writes
+// to hits the nonces whose digest, read as a 256-bit little endian number, is
+// less than or equal to target (SHA256_HASH_BYTE_LEN bytes, little endian).
+// Stops after max_hits hits. Returns the number of hits.
+SHA_API size_t sha256d_scan(OUT uint32_t hits[],
+                            IN size_t   max_hits,
+                            IN const sha256d_scan_t *scan,
+                            IN uint32_t              first_nonce,
+                            IN uint64_t              nonces_num,
+                            IN const uint8_t *       target);
+
+//////////////////////////////
+//  HMAC API
+//////////////////////////////
+
+// Opaque HMAC keys. A key holds the states after compressing the
+// (key XOR ipad) and (key XOR opad) blocks, so that computing a MAC with a
+// prepared key saves two compressions.
+typedef struct hmac_sha256_key_s hmac_sha256_key_t;
+typedef struct hmac_sha512_key_s hmac_sha512_key_t;
+
+// Allocates a key. Returns NULL on failure.
+SHA_API hmac_sha256_key_t *hmac_sha256_key_new(void);
+SHA_API hmac_sha512_key_t *hmac_sha512_key_new(void);
+
+// Cleans and frees a key (key may be NULL).
+SHA_API void hmac_sha256_key_free(IN OUT hmac_sha256_key_t *key);
+SHA_API void hmac_sha512_key_free(IN OUT hmac_sha512_key_t *key);
+
+// Precomputes the inner and outer states of key_data. The implementation is
+// resolved here and is used by every MAC that is computed with the key.
+SHA_API void hmac_sha256_key_init(OUT hmac_sha256_key_t *key,
+                                  IN const uint8_t *key_data,
+                                  IN size_t         key_byte_len,
+                                  IN sha_impl_t     impl);
+
+SHA_API void hmac_sha512_key_init(OUT hmac_sha512_key_t *key,
+                                  IN const uint8_t *key_data,
+                                  IN size_t         key_byte_len,
+                                  IN sha_impl_t     impl);
+
+// mac = HMAC(key, data). The MAC is SHA*_HASH_BYTE_LEN bytes long.
+SHA_API void hmac_sha256(OUT uint8_t *mac,
+                         IN const hmac_sha256_key_t *key,
+                         IN const uint8_t *          data,
+                         IN size_t                   byte_len);
+
+SHA_API void hmac_sha512(OUT uint8_t *mac,
+                         IN const hmac_sha512_key_t *key,
+                         IN const uint8_t *          data,
+                         IN size_t                   byte_len);
+
+// Streaming HMAC: hmac_sha*_init starts ctx from the inner state of key, the
+// message is hashed with sha*_update, and hmac_sha*_final writes the MAC and
+// cleans ctx.
+SHA_API void hmac_sha256_init(OUT sha256_ctx_t *ctx,
+                              IN const hmac_sha256_key_t *key);
+
+SHA_API void hmac_sha512_init(OUT sha512_ctx_t *ctx,
+                              IN const hmac_sha512_key_t *key);
+
+SHA_API void hmac_sha256_final(OUT uint8_t *mac,
+                               IN OUT sha256_ctx_t *ctx,
+                               IN const hmac_sha256_key_t *key);
+
+SHA_API void hmac_sha512_final(OUT uint8_t *mac,
+                               IN OUT sha512_ctx_t *ctx,
+                               IN const hmac_sha512_key_t *key);
+
+// Batched HMAC: computes mac[i] = HMAC(key[i], data[i]) for msgs_num messages,
+// hashing the inner and the outer hashes of several messages in parallel SIMD
+// lanes (see sha*_multi). The implementation of the keys is ignored, and impl
+// selects the multi-buffer implementation.
+SHA_API void hmac_sha256_multi(OUT uint8_t *mac[],
+                               IN const hmac_sha256_key_t *key[],
+                               IN const uint8_t *data[],
+                               IN const size_t   byte_len[],
+                               IN size_t         msgs_num,
+                               IN sha_impl_t     impl);
+
+SHA_API void hmac_sha512_multi(OUT uint8_t *mac[],
+                               IN const hmac_sha512_key_t *key[],
+                               IN const uint8_t *data[],
+                               IN const size_t   byte_len[],
+                               IN size_t         msgs_num,
+                               IN sha_impl_t     impl);
+
+// Batched HMAC verification: compares HMAC(key[i], data[i]) with the
+// SHA*_HASH_BYTE_LEN bytes of tag[i] in constant time, and sets bit (i % 8) of
+// pass_bitmap[i / 8] if they are equal (and clears it otherwise). pass_bitmap
+// holds (msgs_num + 7) / 8 bytes.
+SHA_API void hmac_sha256_verify_multi(OUT uint8_t *pass_bitmap,
+                                      IN const hmac_sha256_key_t *key[],
+                                      IN const uint8_t *data[],
+                                      IN const size_t   byte_len[],
+                                      IN const uint8_t *tag[],
+                                      IN size_t         msgs_num,
+                                      IN sha_impl_t     impl);
+
+SHA_API void hmac_sha512_verify_multi(OUT uint8_t *pass_bitmap,
+                                      IN const hmac_sha512_key_t *key[],
+                                      IN const uint8_t *data[],
+                                      IN const size_t   byte_len[],
+                                      IN const uint8_t *tag[],
+                                      IN size_t         msgs_num,
+                                      IN sha_impl_t     impl);
+
+//////////////////////////////
+//  PBKDF2 API
+//////////////////////////////
+
+// PBKDF2-HMAC-SHA* (RFC 8018): derives out_byte_len bytes from the password
+// pwd and the salt with iter_num (>= 1) iterations. When the output spans
+// several hash blocks, the blocks are derived in parallel SIMD lanes. An empty
+// password or salt may be passed as NULL.
+SHA_API void pbkdf2_hmac_sha256(OUT uint8_t *out,
+                                IN size_t         out_byte_len,
+                                IN const uint8_t *pwd,
+                                IN size_t         pwd_byte_len,
+                                IN const uint8_t *salt,
+                                IN size_t         salt_byte_len,
+                                IN size_t         iter_num,
+                                IN sha_impl_t     impl);
+
+SHA_API void pbkdf2_hmac_sha512(OUT uint8_t *out,
+                                IN size_t         out_byte_len,
+                                IN const uint8_t *pwd,
+                                IN size_t         pwd_byte_len,
+                                IN const uint8_t *salt,
+                                IN size_t         salt_byte_len,
+                                IN size_t         iter_num,
+                                IN sha_impl_t     impl);
+
+// Derives out_byte_len bytes into out[i] for each of the pwds_num passwords
+// pwd[i] with the salt salt[i]. The passwords are derived in parallel SIMD
+// lanes.
+SHA_API void pbkdf2_hmac_sha256_multi(OUT uint8_t *out[],
+                                      IN size_t         out_byte_len,
+                                      IN const uint8_t *pwd[],
+                                      IN const size_t   pwd_byte_len[],
+                                      IN const uint8_t *salt[],
+                                      IN const size_t   salt_byte_len[],
+                                      IN size_t         pwds_num,
+                                      IN size_t         iter_num,
+                                      IN sha_impl_t     impl);
+
+SHA_API void pbkdf2_hmac_sha512_multi(OUT uint8_t *out[],
+                                      IN size_t         out_byte_len,
+                                      IN const uint8_t *pwd[],
+                                      IN const size_t   pwd_byte_len[],
+                                      IN const uint8_t *salt[],
+                                      IN const size_t   salt_byte_len[],
+                                      IN size_t         pwds_num,
+                                      IN size_t         iter_num,
+                                      IN sha_impl_t     impl);
+
+//////////////////////////////
+//  HKDF API
+//////////////////////////////
+
+// HKDF-Extract (RFC 5869): prk = HMAC(salt, ikm). The PRK is
+// SHA*_HASH_BYTE_LEN bytes long. An empty salt may be passed as NULL.
+SHA_API void hkdf_sha256_extract(OUT uint8_t *prk,
+                                 IN const uint8_t *salt,
+                                 IN size_t         salt_byte_len,
+                                 IN const uint8_t *ikm,
+                                 IN size_t         ikm_byte_len,
+                                 IN sha_impl_t     impl);
+
+SHA_API void hkdf_sha512_extract(OUT uint8_t *prk,
+                                 IN const uint8_t *salt,
+                                 IN size_t         salt_byte_len,
+                                 IN const uint8_t *ikm,
+                                 IN size_t         ikm_byte_len,
+                                 IN sha_impl_t     impl);
+
+// HKDF-Expand: derives okm_byte_len (at most 255 * SHA*_HASH_BYTE_LEN) bytes
+// from the PRK and info. prk_key is the PRK prepared with hmac_sha*_key_init,
+// so that expanding several outputs of the same PRK prepares it only once.
+// An empty info may be passed as NULL. Returns 0 on success and -1 with errno
+// set to EINVAL when okm_byte_len is too large.
+SHA_API int hkdf_sha256_expand(OUT uint8_t *okm,
+                               IN size_t okm_byte_len,
+                               IN const hmac_sha256_key_t *prk_key,
+                               IN const uint8_t *          info,
+                               IN size_t                   info_byte_len);
+
+SHA_API int hkdf_sha512_expand(OUT uint8_t *okm,
+                               IN size_t okm_byte_len,
+                               IN const hmac_sha512_key_t *prk_key,
+                               IN const uint8_t *          info,
+                               IN size_t                   info_byte_len);
+
+// Expands outputs_num outputs of the same PRK: okm[i] holds okm_byte_len[i]
+// bytes that are derived with info[i]. The outputs are expanded in parallel
+// SIMD lanes. Returns 0 on success and -1 with errno set to EINVAL, without
+// deriving any output, when one of the okm_byte_len[i] is too large.
+SHA_API int hkdf_sha256_expand_multi(OUT uint8_t *okm[],
+                                     IN const size_t okm_byte_len[],
+                                     IN const hmac_sha256_key_t *prk_key,
+                                     IN const uint8_t *          info[],
+                                     IN const size_t             info_byte_len[],
+                                     IN size_t                   outputs_num,
+                                     IN sha_impl_t               impl);
+
+SHA_API int hkdf_sha512_expand_multi(OUT uint8_t *okm[],
+                                     IN const size_t okm_byte_len[],
+                                     IN const hmac_sha512_key_t *prk_key,
+                                     IN const uint8_t *          info[],
+                                     IN const size_t             info_byte_len[],
+                                     IN size_t                   outputs_num,
+                                     IN sha_impl_t               impl);
+
+// HKDF: Extract followed by Expand. Returns 0 on success and -1 with errno set
+// to EINVAL when okm_byte_len is too large.
+SHA_API int hkdf_sha256(OUT uint8_t *okm,
+                        IN size_t         okm_byte_len,
+                        IN const uint8_t *salt,
+                        IN size_t         salt_byte_len,
+                        IN const uint8_t *ikm,
+                        IN size_t         ikm_byte_len,
+                        IN const uint8_t *info,
+                        IN size_t         info_byte_len,
+                        IN sha_impl_t     impl);
+
+SHA_API int hkdf_sha512(OUT uint8_t *okm,
+                        IN size_t         okm_byte_len,
+                        IN const uint8_t *salt,
+                        IN size_t         salt_byte_len,
+                        IN const uint8_t *ikm,
+                        IN size_t         ikm_byte_len,
+                        IN const uint8_t *info,
+                        IN size_t         info_byte_len,
+                        IN sha_impl_t     impl);
+
+//////////////////////////////
+//  Merkle tree API
+//////////////////////////////
+
+typedef enum merkle_mode_e
+{
+  // leaf = H(data), node = H(left || right)
+  MERKLE_PLAIN_MODE = 0,
+
+  // RFC 6962 domain separation:
+  // leaf = H(0x00 || data), node = H(0x01 || left || right)
+  MERKLE_RFC6962_MODE = 1,
+} merkle_mode_t;
+
+// Returns the number of nodes (including the leaves) of a tree with leaves_num
+// leaves. A tree without leaves has a single node, the hash of the empty
+// string.
+SHA_API size_t merkle_nodes_num(IN size_t leaves_num);
+
+// Builds the Merkle tree of leaves_num leaves, where leaf[i] is leaf_byte_len[i]
+// bytes long. nodes receives merkle_nodes_num(leaves_num) digests of
+// SHA*_HASH_BYTE_LEN bytes, level by level: the hashes of the leaves first and
+// the root last. The last node of a level with an odd number of nodes is moved
+// up unchanged, so the tree has the shape of RFC 6962.
+// All the nodes of a level are hashed together in parallel SIMD lanes.
+SHA_API void merkle_sha256_tree(OUT uint8_t *nodes,
+                                IN const uint8_t *leaf[],
+                                IN const size_t   leaf_byte_len[],
+                                IN size_t         leaves_num,
+                                IN merkle_mode_t  mode,
+                                IN sha_impl_t     impl);
+
+SHA_API void merkle_sha512_tree(OUT uint8_t *nodes,
+                                IN const uint8_t *leaf[],
+                                IN const size_t   leaf_byte_len[],
+                                IN size_t         leaves_num,
+                                IN merkle_mode_t  mode,
+                                IN sha_impl_t     impl);
+
+//////////////////////////////
+//  File API
+//////////////////////////////
+
+// Hashes the file at path. A regular file is memory mapped with sequential
+// read-ahead advice and its pages are compressed in place, without copying
+// them into a buffer. Other files (e.g., pipes), and regular files that report
+// a size of 0 (e.g., in procfs), are read until their end.
+// Returns 0 on success and -1 on failure (errno is set). A file that is found
+// shorter than its size at open fails with EIO. The file must not be
+// truncated while it is hashed: reading a mapped page past the new end of the
+// file raises SIGBUS, which terminates the process unless it is handled. Use
+// sha*_file_direct for files that other processes may truncate.
+SHA_API int sha256_file(OUT uint8_t *dgst,
+                        IN const char *path,
+                        IN sha_impl_t  impl);
+
+SHA_API int sha512_file(OUT uint8_t *dgst,
+                        IN const char *path,
+                        IN sha_impl_t  impl);
+
+// Hashes the file at path with direct (O_DIRECT) reads that bypass the page
+// cache, for files that are read once. A reader thread keeps several aligned
+// buffers in flight, while the calling thread compresses the buffers that
+// were already read. File systems without O_DIRECT are read through the page
+// cache. Returns 0 on success and -1 on failure (errno is set).
+SHA_API int sha256_file_direct(OUT uint8_t *dgst,
+                               IN const char *path,
+                               IN sha_impl_t  impl);
+
+SHA_API int sha512_file_direct(OUT uint8_t *dgst,
+                               IN const char *path,
+                               IN sha_impl_t  impl);
+
+//////////////////////////////
+//  Tree hashing API
+//////////////////////////////
+
+// Parallel tree hashing (version 1) of a single large input. The construction
+// is fixed and can be verified with any SHA2 implementation:
+//   - The input is split into chunks of chunk_byte_len bytes. The last chunk
+//     may be shorter, and an empty input has a single empty chunk.
+//   - leaf[i] = SHA(L || chunk[i]), where L is a block (64 bytes for SHA256
+//     and 128 bytes for SHA512) that holds SHA_TREE_LEAF_TAG followed by zeros.
+//   - root = SHA(R || leaf[0] || leaf[1] || ...), where R is a block that holds
+//     SHA_TREE_ROOT_TAG followed by zeros, and ends with chunk_byte_len and the
+//     input length in bytes, as 64-bit big endian integers.
+// The chunks are hashed on threads_num threads (0 means one thread per CPU),
+// and every thread hashes several chunks in parallel SIMD lanes.
+#define SHA_TREE_LEAF_TAG "sha2intrin tree v1 leaf"
+#define SHA_TREE_ROOT_TAG "sha2intrin tree v1 root"
+
+#define SHA_TREE_DEFAULT_CHUNK_BYTE_LEN (1UL << 20)
+
+// dgst = root. chunk_byte_len must be a positive multiple of the block size.
+// Returns 0 on success and -1 on failure (errno is set to EINVAL for a bad
+// chunk_byte_len and to ENOMEM when the leaves cannot be allocated).
+SHA_API int sha256_tree(OUT uint8_t *dgst,
+                        IN const uint8_t *data,
+                        IN size_t         byte_len,
+                        IN size_t         chunk_byte_len,
+                        IN size_t         threads_num,
+                        IN sha_impl_t     impl);
+
+SHA_API int sha512_tree(OUT uint8_t *dgst,
+                        IN const uint8_t *data,
+                        IN size_t         byte_len,
+                        IN size_t         chunk_byte_len,
+                        IN size_t         threads_num,
+                        IN sha_impl_t     impl);
+
+//////////////////////////////
+//  Thread pool API
+//////////////////////////////
+
+// A pool of worker threads for batches of independent messages. The threads
+// of a pool steal work from each other, and a pool can be used for many
+// batches, so the threads are created once.
+typedef struct sha_pool_s sha_pool_t;
+
+// Creates a pool of threads_num threads, including the thread that submits a
+// batch (threads_num == 0 means one thread per CPU). Returns NULL on failure.
+SHA_API sha_pool_t *sha_pool_new(IN size_t threads_num);
+
+// Stops the threads and frees the pool (pool may be NULL). The pool must not
+// have a batch in progress.
+SHA_API void sha_pool_free(IN OUT sha_pool_t *pool);
+
+// Returns the number of threads of the pool (1 for NULL). It may be smaller
+// than requested, if some threads could not be created.
+SHA_API size_t sha_pool_threads_num(IN const sha_pool_t *pool);
+
+// Hashes msgs_num independent messages on the threads of pool (see
+// sha*_multi): dgst[i] = SHA(data[i], byte_len[i]). The messages are sorted
+// by their number of blocks and hashed in batches of messages of similar
+// lengths, so the lanes of the multi-buffer implementations stay full. The
+// calling thread hashes batches too, and the function returns when all the
+// digests are written. A NULL pool hashes the batches on the calling thread.
+// Returns 0 on success and -1 on failure (errno is set).
+SHA_API int sha256_multi_pool(OUT uint8_t *dgst[],
+                              IN const uint8_t *data[],
+                              IN const size_t   byte_len[],
+                              IN size_t         msgs_num,
+                              IN OUT sha_pool_t *pool,
+                              IN sha_impl_t      impl);
 
-void sha512(OUT uint8_t *dgst,
-            IN const uint8_t *data,
-            IN size_t         byte_len,
-            IN sha_impl_t     impl);
+SHA_API int sha512_multi_pool(OUT uint8_t *dgst[],
+                              IN const uint8_t *data[],
+                              IN const size_t   byte_len[],
+                              IN size_t         msgs_num,
+                              IN OUT sha_pool_t *pool,
+                              IN sha_impl_t      impl);
@@ -0,0 +1,471 @@
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+// Runtime detection of the CPU features that every implementation requires.
+// The features are read once, when the library is loaded, and are used to
+// resolve AUTO_IMPL to the fastest implementation that the CPU supports.
+// This allows running the same binary on platforms with different ISA
+// extensions.
+
+#include "cpu_features.h"
+
+#if defined(X86_64)
+#  include <cpuid.h>
+#endif
+
+#if defined(AARCH64) && defined(__linux__)
+#  include <sys/auxv.h>
+#endif
+
+#if defined(AARCH64) && defined(__APPLE__)
+#  include <sys/sysctl.h>
+#endif
+
+#define CPU_FEATURES_INITIALIZED (1U << 0)
+#define CPU_FEATURE_SSSE3        (1U << 1)
+#define CPU_FEATURE_SSE41        (1U << 2)
+#define CPU_FEATURE_AVX          (1U << 3)
+#define CPU_FEATURE_AVX2         (1U << 4)
+#define CPU_FEATURE_BMI1         (1U << 5)
+#define CPU_FEATURE_BMI2         (1U << 6)
+#define CPU_FEATURE_AVX512F      (1U << 7)
+#define CPU_FEATURE_AVX512BW     (1U << 8)
+#define CPU_FEATURE_AVX512VL     (1U << 9)
+#define CPU_FEATURE_NEON         (1U << 10)
+#define CPU_FEATURE_SHA_EXT      (1U << 11)
+#define CPU_FEATURE_SHA512_EXT   (1U << 12)
+#define CPU_FEATURE_SVE          (1U << 13)
+
+// The ALTERNATIVE_AVX512_IMPL flag makes the AVX/AVX2 code use the AVX512VL
+// rotate instructions.
+#if defined(ALTERNATIVE_AVX512_IMPL)
+#  define ALTERNATIVE_FEATURES (CPU_FEATURE_AVX512F | CPU_FEATURE_AVX512VL)
+#else
+#  define ALTERNATIVE_FEATURES 0
+#endif
+
+#define AVX_FEATURES \
+  (CPU_FEATURE_SSSE3 | CPU_FEATURE_AVX | ALTERNATIVE_FEATURES)
+#define AVX2_FEATURES (AVX_FEATURES | CPU_FEATURE_AVX2)
+#define AVX512_FEATURES \
+  (AVX2_FEATURES | CPU_FEATURE_AVX512F | CPU_FEATURE_AVX512BW | \
+   CPU_FEATURE_AVX512VL)
+#define OPENSSL_AVX_FEATURES (CPU_FEATURE_SSSE3 | CPU_FEATURE_AVX)
+#define OPENSSL_AVX2_FEATURES \
+  (OPENSSL_AVX_FEATURES | CPU_FEATURE_AVX2 | CPU_FEATURE_BMI1 | \
+   CPU_FEATURE_BMI2)
+#define X86_64_SHA_EXT_FEATURES \
+  (CPU_FEATURE_SSSE3 | CPU_FEATURE_SSE41 | CPU_FEATURE_SHA_EXT)
+
+// The implementations ordered from the fastest to the slowest.
+// The OpenSSL implementations are excluded because they are controlled through
+// a global capabilities array, and are therefore not thread safe.
+static const sha_impl_t sha256_impls_by_speed[] = {
+#if defined(X86_64_SHA_SUPPORT) || defined(AARCH64_SHA_SUPPORT)
+  SHA_EXT_IMPL,
+#endif
+#if defined(AVX512_SUPPORT)
+  AVX512_IMPL,
+#endif
+#if defined(AVX2_SUPPORT)
+  AVX2_IMPL,
+#endif
+#if defined(X86_64)
+  AVX_IMPL,
+#endif
+#if defined(NEON_SUPPORT)
+  NEON_IMPL,
+#endif
+  GENERIC_IMPL};
+
+static const sha_impl_t sha512_impls_by_speed[] = {
+#if defined(AARCH64_SHA512_SUPPORT)
+  SHA_EXT_IMPL,
+#endif
+#if defined(AVX512_SUPPORT)
+  AVX512_IMPL,
+#endif
+#if defined(AVX2_SUPPORT)
+  AVX2_IMPL,
+#endif
+#if defined(X86_64)
+  AVX_IMPL,
+#endif
+#if defined(NEON_SUPPORT)
+  NEON_IMPL,
+#endif
+  GENERIC_IMPL};
+
+// The implementations of sha256_multi ordered from the fastest to the slowest.
+// The AVX512 (16 lanes) implementation is faster than the SHA extension
+// implementation (2 interleaved messages), but the AVX2 (8 lanes) one is not.
+// On AARCH64, the SHA extension hashes the messages one by one, and is still
+// faster than the SVE (4-16 lanes) and NEON (4 lanes) implementations.
+static const sha_impl_t sha256_multi_impls_by_speed[] = {
+#if defined(AVX512_SUPPORT)
+  AVX512_IMPL,
+#endif
+#if defined(X86_64_SHA_SUPPORT) || defined(AARCH64_SHA_SUPPORT)
+  SHA_EXT_IMPL,
+#endif
+#if defined(AVX2_SUPPORT)
+  AVX2_IMPL,
+#endif
+#if defined(X86_64)
+  AVX_IMPL,
+#endif
+#if defined(AARCH64_SVE_SUPPORT)
+  SVE_IMPL,
+#endif
+#if defined(NEON_SUPPORT)
+  NEON_IMPL,
+#endif
+  GENERIC_IMPL};
+
+static const sha_impl_t sha512_multi_impls_by_speed[] = {
+#if defined(AARCH64_SHA512_SUPPORT)
+  SHA_EXT_IMPL,
+#endif
+#if defined(AVX512_SUPPORT)
+  AVX512_IMPL,
+#endif
+#if defined(AVX2_SUPPORT)
+  AVX2_IMPL,
+#endif
+#if defined(X86_64)
+  AVX_IMPL,
+#endif
+#if defined(AARCH64_SVE_SUPPORT)
+  SVE_IMPL,
+#endif
+#if defined(NEON_SUPPORT)
+  NEON_IMPL,
+#endif
+  GENERIC_IMPL};
+
+static uint32_t   cpu_features           = 0;
+static sha_impl_t sha256_best_impl       = GENERIC_IMPL;
+static sha_impl_t sha512_best_impl       = GENERIC_IMPL;
+static sha_impl_t sha256_multi_best_impl = GENERIC_IMPL;
+static sha_impl_t sha512_multi_best_impl = GENERIC_IMPL;
+
+#if defined(X86_64)
+
+// Bits of CPUID leaf 1 (ECX)
+#  define CPUID1_ECX_SSSE3   (1U << 9)
+#  define CPUID1_ECX_SSE41   (1U << 19)
+#  define CPUID1_ECX_OSXSAVE (1U << 27)
+#  define CPUID1_ECX_AVX     (1U << 28)
+
+// Bits of CPUID leaf 7 sub-leaf 0 (EBX)
+#  define CPUID7_EBX_BMI1     (1U << 3)
+#  define CPUID7_EBX_AVX2     (1U << 5)
+#  define CPUID7_EBX_BMI2     (1U << 8)
+#  define CPUID7_EBX_AVX512F  (1U << 16)
+#  define CPUID7_EBX_SHA      (1U << 29)
+#  define CPUID7_EBX_AVX512BW (1U << 30)
+#  define CPUID7_EBX_AVX512VL (1U << 31)
+
+// The bits of XCR0 that indicate that the OS saves the XMM/YMM registers, and
+// the opmask/ZMM registers.
+#  define XCR0_YMM_STATE    (0x06)
+#  define XCR0_AVX512_STATE (0xe0)
+
+_INLINE_ uint64_t read_xcr0(void)
+{
+  uint32_t lo;
+  uint32_t hi;
+  __asm__ __volatile__("xgetbv\n\t" : "=a"(lo), "=d"(hi) : "c"(0));
+  return lo | ((uint64_t)hi << 32);
+}
+
+_INLINE_ uint32_t detect_cpu_features(void)
+{
+  uint32_t eax      = 0;
+  uint32_t ebx      = 0;
+  uint32_t ecx      = 0;
+  uint32_t edx      = 0;
+  uint32_t features = 0;
+  uint64_t xcr0     = 0;
+
+  if(!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+    return features;
+  }
+
+  if(ecx & CPUID1_ECX_SSSE3) {
+    features |= CPU_FEATURE_SSSE3;
+  }
+
+  if(ecx & CPUID1_ECX_SSE41) {
+    features |= CPU_FEATURE_SSE41;
+  }
+
+  // The AVX* instructions can only be used if the OS saves their registers
+  if(ecx & CPUID1_ECX_OSXSAVE) {
+    xcr0 = read_xcr0();
+  }
+
+  const int ymm_state    = ((xcr0 & XCR0_YMM_STATE) == XCR0_YMM_STATE);
+  const int avx512_state = ymm_state &&
+                           ((xcr0 & XCR0_AVX512_STATE) == XCR0_AVX512_STATE);
+
+  if(ymm_state && (ecx & CPUID1_ECX_AVX)) {
+    features |= CPU_FEATURE_AVX;
+  }
+
+  if(!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+    return features;
+  }
+
+  if(ebx & CPUID7_EBX_BMI1) {
+    features |= CPU_FEATURE_BMI1;
+  }
+
+  if(ebx & CPUID7_EBX_BMI2) {
+    features |= CPU_FEATURE_BMI2;
+  }
+
+  if(ebx & CPUID7_EBX_SHA) {
+    features |= CPU_FEATURE_SHA_EXT;
+  }
+
+  if(ymm_state && (ebx & CPUID7_EBX_AVX2)) {
+    features |= CPU_FEATURE_AVX2;
+  }
+
+  if(avx512_state) {
+    if(ebx & CPUID7_EBX_AVX512F) {
+      features |= CPU_FEATURE_AVX512F;
+    }
+
+    if(ebx & CPUID7_EBX_AVX512BW) {
+      features |= CPU_FEATURE_AVX512BW;
+    }
+
+    if(ebx & CPUID7_EBX_AVX512VL) {
+      features |= CPU_FEATURE_AVX512VL;
+    }
+  }
+
+  return features;
+}
+
+#elif defined(AARCH64)
+
+#  if !defined(HWCAP_ASIMD)
+#    define HWCAP_ASIMD (1UL << 1)
+#  endif
+
+#  if !defined(HWCAP_SHA2)
+#    define HWCAP_SHA2 (1UL << 6)
+#  endif
+
+#  if !defined(HWCAP_SHA512)
+#    define HWCAP_SHA512 (1UL << 21)
+#  endif
+
+#  if !defined(HWCAP_SVE)
+#    define HWCAP_SVE (1UL << 22)
+#  endif
+
+_INLINE_ uint32_t detect_cpu_features(void)
+{
+#  if defined(__linux__)
+  const unsigned long hwcap    = getauxval(AT_HWCAP);
+  uint32_t            features = 0;
+
+  if(hwcap & HWCAP_ASIMD) {
+    features |= CPU_FEATURE_NEON;
+  }
+
+  if(hwcap & HWCAP_SHA2) {
+    features |= CPU_FEATURE_SHA_EXT;
+  }
+
+  if(hwcap & HWCAP_SHA512) {
+    features |= CPU_FEATURE_SHA512_EXT;
+  }
+
+  if(hwcap & HWCAP_SVE) {
+    features |= CPU_FEATURE_SVE;
+  }
+
+  return features;
+#  else
+  // All the Apple aarch64 processors support the NEON and SHA2 instructions
+  uint32_t features = CPU_FEATURE_NEON | CPU_FEATURE_SHA_EXT;
+
+#    if defined(__APPLE__)
+  int    sha512     = 0;
+  size_t sha512_len = sizeof(sha512);
+
+  if((0 == sysctlbyname("hw.optional.armv8_2_sha512", &sha512, &sha512_len,
+                        NULL, 0)) &&
+     sha512) {
+    features |= CPU_FEATURE_SHA512_EXT;
+  }
+#    endif
+
+  return features;
+#  endif
+}
+
+#else
+
+_INLINE_ uint32_t detect_cpu_features(void) { return 0; }
+
+#endif
+
+_INLINE_ int has_features(IN const uint32_t features)
+{
+  return (cpu_features & features) == features;
+}
+
+// The x86-64 SHA extension has no SHA512 instructions. On aarch64, they are a
+// separate extension (ARMv8.2 SHA512).
+int sha512_impl_supported(IN const sha_impl_t impl)
+{
+  int available = sha_impl_supported(impl);
+
+  if((impl == SHA_EXT_IMPL) || (impl == OPENSSL_SHA_EXT_IMPL)) {
+#if defined(AARCH64_SHA512_SUPPORT)
+    available &= has_features(CPU_FEATURE_SHA512_EXT);
+#else
+    available = 0;
+#endif
+  }
+
+  return available;
+}
+
+// Runs once, when the library is loaded.
+__attribute__((constructor)) static void init_cpu_features(void)
+{
+  cpu_features = detect_cpu_features() | CPU_FEATURES_INITIALIZED;
+
+  for(size_t i = 0; i < sizeof(sha256_impls_by_speed) / sizeof(sha_impl_t);
+      i++) {
+    if(sha_impl_supported(sha256_impls_by_speed[i])) {
+      sha256_best_impl = sha256_impls_by_speed[i];
+      break;
+    }
+  }
+
+  for(size_t i = 0; i < sizeof(sha512_impls_by_speed) / sizeof(sha_impl_t);
+      i++) {
+    if(sha512_impl_supported(sha512_impls_by_speed[i])) {
+      sha512_best_impl = sha512_impls_by_speed[i];
+      break;
+    }
+  }
+
+  for(size_t i = 0;
+      i < sizeof(sha256_multi_impls_by_speed) / sizeof(sha_impl_t); i++) {
+    if(sha_impl_supported(sha256_multi_impls_by_speed[i])) {
+      sha256_multi_best_impl = sha256_multi_impls_by_speed[i];
+      break;
+    }
+  }
+
+  for(size_t i = 0;
+      i < sizeof(sha512_multi_impls_by_speed) / sizeof(sha_impl_t); i++) {
+    if(sha512_impl_supported(sha512_multi_impls_by_speed[i])) {
+      sha512_multi_best_impl = sha512_multi_impls_by_speed[i];
+      break;
+    }
+  }
+}
+
+_INLINE_ void ensure_cpu_features(void)
+{
+  // Protects against a call from another constructor that runs before
+  // init_cpu_features().
+  if(!(cpu_features & CPU_FEATURES_INITIALIZED)) {
+    init_cpu_features();
+  }
+}
+
+int sha_impl_supported(IN const sha_impl_t impl)
+{
+  ensure_cpu_features();
+
+  switch(impl) {
+    case GENERIC_IMPL:
+    case AUTO_IMPL: return 1;
+
+#if defined(X86_64)
+    case AVX_IMPL: return has_features(AVX_FEATURES);
+    case OPENSSL_AVX_IMPL: return has_features(OPENSSL_AVX_FEATURES);
+#endif
+
+#if defined(AVX2_SUPPORT)
+    case AVX2_IMPL: return has_features(AVX2_FEATURES);
+    case OPENSSL_AVX2_IMPL: return has_features(OPENSSL_AVX2_FEATURES);
+#endif
+
+#if defined(AVX512_SUPPORT)
+    case AVX512_IMPL: return has_features(AVX512_FEATURES);
+#endif
+
+#if defined(X86_64_SHA_SUPPORT)
+    case SHA_EXT_IMPL:
+    case OPENSSL_SHA_EXT_IMPL: return has_features(X86_64_SHA_EXT_FEATURES);
+#endif
+
+#if defined(NEON_SUPPORT)
+    case NEON_IMPL:
+    case OPENSSL_NEON_IMPL: return has_features(CPU_FEATURE_NEON);
+#endif
+
+#if defined(AARCH64_SHA_SUPPORT)
+    case SHA_EXT_IMPL:
+    case OPENSSL_SHA_EXT_IMPL: return has_features(CPU_FEATURE_SHA_EXT);
+#endif
+
+#if defined(AARCH64_SVE_SUPPORT)
+    case SVE_IMPL: return has_features(CPU_FEATURE_SVE | CPU_FEATURE_NEON);
+#endif
+
+    default: return 0;
+  }
+}
+
+sha_impl_t sha256_resolve_impl(IN const sha_impl_t impl)
+{
+  if((impl != AUTO_IMPL) && sha_impl_supported(impl)) {
+    return impl;
+  }
+
+  ensure_cpu_features();
+  return sha256_best_impl;
+}
+
+sha_impl_t sha512_resolve_impl(IN const sha_impl_t impl)
+{
+  if((impl != AUTO_IMPL) && sha512_impl_supported(impl)) {
+    return impl;
+  }
+
+  ensure_cpu_features();
+  return sha512_best_impl;
+}
+
+sha_impl_t sha256_multi_resolve_impl(IN const sha_impl_t impl)
+{
+  if((impl != AUTO_IMPL) && sha_impl_supported(impl)) {
+    return impl;
+  }
+
+  ensure_cpu_features();
+  return sha256_multi_best_impl;
+}
+
+sha_impl_t sha512_multi_resolve_impl(IN const sha_impl_t impl)
+{
+  if((impl != AUTO_IMPL) && sha512_impl_supported(impl)) {
+    return impl;
+  }
+
+  ensure_cpu_features();
+  return sha512_multi_best_impl;
+}
@@ -0,0 +1,235 @@
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+// HKDF-SHA512 (RFC 5869).
+// The expand step computes T(i) = HMAC(PRK, T(i-1) || info || i). The PRK is
+// passed as a prepared HMAC key, so the two key blocks are compressed once per
+// PRK and not once per T(i). Independent outputs of the same PRK are expanded
+// in parallel lanes (see hmac_sha512_multi).
+
+#include <assert.h>
+#include <errno.h>
+
+#include "sha512_defs.h"
+
+// The outputs of hkdf_sha512_expand_multi with longer info are expanded one
+// by one
+#define MULTI_MAX_INFO_BYTE_LEN 512
+
+// The message of T(i): T(i-1) || info || i
+#define MULTI_MAX_MSG_BYTE_LEN \
+  (SHA512_HASH_BYTE_LEN + MULTI_MAX_INFO_BYTE_LEN + 1)
+
+#define MAX_OKM_BYTE_LEN (255 * SHA512_HASH_BYTE_LEN)
+
+void hkdf_sha512_extract(OUT uint8_t *prk,
+                         IN const uint8_t *salt,
+                         IN const size_t   salt_byte_len,
+                         IN const uint8_t *ikm,
+                         IN const size_t   ikm_byte_len,
+                         IN const sha_impl_t impl)
+{
+  assert(prk != NULL);
+  assert((salt != NULL) || (salt_byte_len == 0));
+  assert((ikm != NULL) || (ikm_byte_len == 0));
+
+  hmac_sha512_key_t key;
+
+  // An empty salt is a string of zeros of the hash length, which HMAC pads to
+  // the same key block
+  hmac_sha512_key_init(&key, salt, salt_byte_len, impl);
+  hmac_sha512(prk, &key, ikm, ikm_byte_len);
+
+  secure_clean(&key, sizeof(key));
+}
+
+int hkdf_sha512_expand(OUT uint8_t *okm,
+                       IN const size_t okm_byte_len,
+                       IN const hmac_sha512_key_t *prk_key,
+                       IN const uint8_t *          info,
+                       IN const size_t             info_byte_len)
+{
+  assert((okm != NULL) || (okm_byte_len == 0));
+  assert(prk_key != NULL);
+  assert((info != NULL) || (info_byte_len == 0));
+
+  // The counter i of T(i) is a single byte
+  if(okm_byte_len > MAX_OKM_BYTE_LEN) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  uint8_t      t[SHA512_HASH_BYTE_LEN];
+  sha512_ctx_t ctx;
+
+  for(size_t pos = 0, i = 1; pos < okm_byte_len; i++) {
+    const uint8_t ctr     = (uint8_t)i;
+    const size_t  rem_len = okm_byte_len - pos;
+    const size_t  t_len   = (i == 1) ? 0 : SHA512_HASH_BYTE_LEN;
+    const size_t  out_len = (rem_len < sizeof(t)) ? rem_len : sizeof(t);
+
+    hmac_sha512_init(&ctx, prk_key);
+    sha512_update(&ctx, t, t_len);
+    sha512_update(&ctx, info, info_byte_len);
+    sha512_update(&ctx, &ctr, sizeof(ctr));
+    hmac_sha512_final(t, &ctx, prk_key);
+
+    my_memcpy(&okm[pos], t, out_len);
+    pos += out_len;
+  }
+
+  secure_clean(t, sizeof(t));
+  return 0;
+}
+
+// Expands num <= SHA512_MAX_LANES_NUM outputs with info of at most
+// MULTI_MAX_INFO_BYTE_LEN bytes. In every round, the T(i) of all the outputs
+// that are not complete yet are computed together.
+_INLINE_ void expand_lanes(OUT uint8_t *okm[],
+                           IN const size_t okm_byte_len[],
+                           IN const hmac_sha512_key_t *prk_key,
+                           IN const uint8_t *          info[],
+                           IN const size_t             info_byte_len[],
+                           IN const size_t             num,
+                           IN const sha_impl_t         impl)
+{
+  ALIGN(64) uint8_t msg[SHA512_MAX_LANES_NUM][MULTI_MAX_MSG_BYTE_LEN];
+  ALIGN(64) uint8_t t[SHA512_MAX_LANES_NUM][SHA512_HASH_BYTE_LEN];
+
+  const hmac_sha512_key_t *keys[SHA512_MAX_LANES_NUM];
+  const uint8_t *          data[SHA512_MAX_LANES_NUM];
+  uint8_t *                mac[SHA512_MAX_LANES_NUM];
+  size_t                   byte_len[SHA512_MAX_LANES_NUM];
+  size_t                   idx[SHA512_MAX_LANES_NUM];
+
+  size_t max_okm_byte_len = 0;
+
+  for(size_t l = 0; l < num; l++) {
+    my_memcpy(&msg[l][SHA512_HASH_BYTE_LEN], info[l], info_byte_len[l]);
+    keys[l] = prk_key;
+
+    if(okm_byte_len[l] > max_okm_byte_len) {
+      max_okm_byte_len = okm_byte_len[l];
+    }
+  }
+
+  for(size_t i = 1, pos = 0; pos < max_okm_byte_len;
+      i++, pos += SHA512_HASH_BYTE_LEN) {
+    size_t active_num = 0;
+
+    // The message of T(1) does not include T(0)
+    const size_t t_len = (i == 1) ? 0 : SHA512_HASH_BYTE_LEN;
+
+    for(size_t l = 0; l < num; l++) {
+      if(pos >= okm_byte_len[l]) {
+        continue;
+      }
+
+      msg[l][SHA512_HASH_BYTE_LEN + info_byte_len[l]] = (uint8_t)i;
+
+      data[active_num]     = &msg[l][SHA512_HASH_BYTE_LEN - t_len];
+      byte_len[active_num] = t_len + info_byte_len[l] + 1;
+      mac[active_num]      = t[l];
+      idx[active_num]      = l;
+      active_num++;
+    }
+
+    hmac_sha512_multi(mac, keys, data, byte_len, active_num, impl);
+
+    for(size_t k = 0; k < active_num; k++) {
+      const size_t l       = idx[k];
+      const size_t rem_len = okm_byte_len[l] - pos;
+
+      my_memcpy(&okm[l][pos], t[l],
+                (rem_len < SHA512_HASH_BYTE_LEN) ? rem_len
+                                                 : SHA512_HASH_BYTE_LEN);
+      my_memcpy(msg[l], t[l], SHA512_HASH_BYTE_LEN);
+    }
+  }
+
+  secure_clean(msg, sizeof(msg));
+  secure_clean(t, sizeof(t));
+}
+
+int hkdf_sha512_expand_multi(OUT uint8_t *okm[],
+                             IN const size_t okm_byte_len[],
+                             IN const hmac_sha512_key_t *prk_key,
+                             IN const uint8_t *          info[],
+                             IN const size_t             info_byte_len[],
+                             IN const size_t             outputs_num,
+                             IN const sha_impl_t         impl)
+{
+  assert((okm != NULL) && (okm_byte_len != NULL) && (prk_key != NULL));
+  assert((info != NULL) && (info_byte_len != NULL));
+
+  uint8_t *      lanes_okm[SHA512_MAX_LANES_NUM];
+  size_t         lanes_okm_byte_len[SHA512_MAX_LANES_NUM];
+  const uint8_t *lanes_info[SHA512_MAX_LANES_NUM];
+  size_t         lanes_info_byte_len[SHA512_MAX_LANES_NUM];
+  size_t         num = 0;
+
+  // No output is derived when one of them is too long
+  for(size_t i = 0; i < outputs_num; i++) {
+    if(okm_byte_len[i] > MAX_OKM_BYTE_LEN) {
+      errno = EINVAL;
+      return -1;
+    }
+  }
+
+  for(size_t i = 0; i < outputs_num; i++) {
+    if(info_byte_len[i] > MULTI_MAX_INFO_BYTE_LEN) {
+      hkdf_sha512_expand(okm[i], okm_byte_len[i], prk_key, info[i],
+                         info_byte_len[i]);
+      continue;
+    }
+
+    lanes_okm[num]           = okm[i];
+    lanes_okm_byte_len[num]  = okm_byte_len[i];
+    lanes_info[num]          = info[i];
+    lanes_info_byte_len[num] = info_byte_len[i];
+    num++;
+
+    if(num == SHA512_MAX_LANES_NUM) {
+      expand_lanes(lanes_okm, lanes_okm_byte_len, prk_key, lanes_info,
+                   lanes_info_byte_len, num, impl);
+      num = 0;
+    }
+  }
+
+  if(num != 0) {
+    expand_lanes(lanes_okm, lanes_okm_byte_len, prk_key, lanes_info,
+                 lanes_info_byte_len, num, impl);
+  }
+
+  return 0;
+}
+
+int hkdf_sha512(OUT uint8_t *okm,
+                IN const size_t   okm_byte_len,
+                IN const uint8_t *salt,
+                IN const size_t   salt_byte_len,
+                IN const uint8_t *ikm,
+                IN const size_t   ikm_byte_len,
+                IN const uint8_t *info,
+                IN const size_t   info_byte_len,
+                IN const sha_impl_t impl)
+{
+  uint8_t           prk[SHA512_HASH_BYTE_LEN];
+  hmac_sha512_key_t prk_key;
+
+  // Fail before the extract step
+  if(okm_byte_len > MAX_OKM_BYTE_LEN) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  hkdf_sha512_extract(prk, salt, salt_byte_len, ikm, ikm_byte_len, impl);
+  hmac_sha512_key_init(&prk_key, prk, sizeof(prk), impl);
+  const int ret =
+    hkdf_sha512_expand(okm, okm_byte_len, &prk_key, info, info_byte_len);
+
+  secure_clean(prk, sizeof(prk));
+  secure_clean(&prk_key, sizeof(prk_key));
+
+  return ret;
+}
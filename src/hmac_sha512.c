@@ -0,0 +1,257 @@
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+// HMAC-SHA512 (RFC 2104) with precomputed inner and outer states.
+
+// For posix_memalign
+#define _POSIX_C_SOURCE 200112L
+
+#include <assert.h>
+#include <stdlib.h>
+
+#include "sha512_defs.h"
+
+// Compresses the block (key XOR pad) starting from the IV
+_INLINE_ void pad_state(OUT sha512_state_t *state,
+                        OUT sha_impl_t *    impl,
+                        IN const uint8_t    key_block[SHA512_BLOCK_BYTE_LEN],
+                        IN const uint8_t    pad,
+                        IN const sha_impl_t req_impl)
+{
+  ALIGN(64) uint8_t block[SHA512_BLOCK_BYTE_LEN];
+  sha512_ctx_t      ctx;
+
+  for(size_t i = 0; i < SHA512_BLOCK_BYTE_LEN; i++) {
+    block[i] = key_block[i] ^ pad;
+  }
+
+  sha512_init(&ctx, req_impl);
+  sha512_update(&ctx, block, SHA512_BLOCK_BYTE_LEN);
+  *state = ctx.state;
+  *impl  = ctx.impl;
+
+  secure_clean(block, sizeof(block));
+  secure_clean(&ctx, sizeof(ctx));
+}
+
+void hmac_sha512_key_init(OUT hmac_sha512_key_t *key,
+                          IN const uint8_t *key_data,
+                          IN const size_t   key_byte_len,
+                          IN const sha_impl_t impl)
+{
+  assert(key != NULL);
+  assert((key_data != NULL) || (key_byte_len == 0));
+
+  ALIGN(64) uint8_t key_block[SHA512_BLOCK_BYTE_LEN] = {0};
+
+  // Keys that are longer than a block are hashed first
+  if(key_byte_len > SHA512_BLOCK_BYTE_LEN) {
+    sha512(key_block, key_data, key_byte_len, impl);
+  } else {
+    my_memcpy(key_block, key_data, key_byte_len);
+  }
+
+  pad_state(&key->inner, &key->impl, key_block, HMAC_IPAD_BYTE, impl);
+  pad_state(&key->outer, &key->impl, key_block, HMAC_OPAD_BYTE, impl);
+
+  secure_clean(key_block, sizeof(key_block));
+}
+
+// Computes the outer hash: mac = SHA512(key XOR opad || inner_dgst). The first
+// block is already compressed in key->outer, and the second block is padded
+// here directly.
+_INLINE_ void outer_hash(OUT uint8_t *mac,
+                         IN const hmac_sha512_key_t *key,
+                         IN const uint8_t *          inner_dgst)
+{
+  ALIGN(64) uint8_t block[SHA512_BLOCK_BYTE_LEN] = {0};
+  sha512_state_t    s                             = key->outer;
+
+  // Byteswap the length in bits of the hashed message
+  const uint64_t bswap_len =
+    bswap_64(8 * (SHA512_BLOCK_BYTE_LEN + SHA512_HASH_BYTE_LEN));
+
+  my_memcpy(block, inner_dgst, SHA512_HASH_BYTE_LEN);
+  block[SHA512_HASH_BYTE_LEN] = SHA512_MSG_END_SYMBOL;
+  my_memcpy(&block[SHA512_BLOCK_BYTE_LEN - sizeof(bswap_len)],
+            (const uint8_t *)&bswap_len, sizeof(bswap_len));
+
+  sha512_compress(&s, block, 1, key->impl);
+
+  // This implementation assumes running on a Little endian machine
+  for(size_t i = 0; i < SHA512_HASH_WORDS_NUM; i++) {
+    const sha512_word_t w = bswap_64(s.w[i]);
+    my_memcpy(&mac[i * sizeof(w)], (const uint8_t *)&w, sizeof(w));
+  }
+
+  secure_clean(block, sizeof(block));
+  secure_clean(&s, sizeof(s));
+}
+
+void hmac_sha512_init(OUT sha512_ctx_t *ctx, IN const hmac_sha512_key_t *key)
+{
+  assert((ctx != NULL) && (key != NULL));
+
+  // Continue from the state after the (key XOR ipad) block
+  ctx->state = key->inner;
+  ctx->len   = SHA512_BLOCK_BYTE_LEN;
+  ctx->rem   = 0;
+  ctx->impl  = key->impl;
+
+  ctx->dgst_byte_len = SHA512_HASH_BYTE_LEN;
+}
+
+void hmac_sha512_final(OUT uint8_t *mac,
+                       IN OUT sha512_ctx_t *ctx,
+                       IN const hmac_sha512_key_t *key)
+{
+  assert((mac != NULL) && (ctx != NULL) && (key != NULL));
+
+  uint8_t inner_dgst[SHA512_HASH_BYTE_LEN];
+
+  sha512_final(inner_dgst, ctx);
+  outer_hash(mac, key, inner_dgst);
+
+  secure_clean(inner_dgst, sizeof(inner_dgst));
+}
+
+void hmac_sha512(OUT uint8_t *mac,
+                 IN const hmac_sha512_key_t *key,
+                 IN const uint8_t *          data,
+                 IN const size_t             byte_len)
+{
+  assert((data != NULL) || (byte_len == 0));
+
+  sha512_ctx_t ctx;
+  hmac_sha512_init(&ctx, key);
+  sha512_update(&ctx, data, byte_len);
+  hmac_sha512_final(mac, &ctx, key);
+}
+
+// Computes the MACs of msgs_num <= SHA512_MAX_LANES_NUM messages. The inner
+// hashes continue from the inner states of the keys, and the outer hashes hash
+// the inner digests from the outer states, both in parallel lanes.
+_INLINE_ void mac_lanes(OUT uint8_t *mac[],
+                        IN const hmac_sha512_key_t *key[],
+                        IN const uint8_t *data[],
+                        IN const size_t   byte_len[],
+                        IN const size_t   msgs_num,
+                        IN const sha_impl_t impl)
+{
+  ALIGN(64) uint8_t inner_dgst[SHA512_MAX_LANES_NUM][SHA512_HASH_BYTE_LEN];
+
+  const sha512_state_t *inner[SHA512_MAX_LANES_NUM];
+  const sha512_state_t *outer[SHA512_MAX_LANES_NUM];
+  uint8_t *             inner_dgst_out[SHA512_MAX_LANES_NUM];
+  const uint8_t *       inner_dgst_in[SHA512_MAX_LANES_NUM];
+  size_t                inner_dgst_len[SHA512_MAX_LANES_NUM];
+
+  assert(msgs_num <= SHA512_MAX_LANES_NUM);
+
+  for(size_t i = 0; i < msgs_num; i++) {
+    assert(key[i] != NULL);
+
+    inner[i]          = &key[i]->inner;
+    outer[i]          = &key[i]->outer;
+    inner_dgst_out[i] = inner_dgst[i];
+    inner_dgst_in[i]  = inner_dgst[i];
+    inner_dgst_len[i] = SHA512_HASH_BYTE_LEN;
+  }
+
+  sha512_multi_from_states(inner_dgst_out, inner, SHA512_BLOCK_BYTE_LEN, data,
+                           byte_len, msgs_num, impl);
+  sha512_multi_from_states(mac, outer, SHA512_BLOCK_BYTE_LEN, inner_dgst_in,
+                           inner_dgst_len, msgs_num, impl);
+
+  secure_clean(inner_dgst, sizeof(inner_dgst));
+}
+
+void hmac_sha512_multi(OUT uint8_t *mac[],
+                       IN const hmac_sha512_key_t *key[],
+                       IN const uint8_t *data[],
+                       IN const size_t   byte_len[],
+                       IN const size_t   msgs_num,
+                       IN const sha_impl_t impl)
+{
+  assert((mac != NULL) && (key != NULL));
+  assert((data != NULL) && (byte_len != NULL));
+
+  for(size_t i = 0; i < msgs_num; i += SHA512_MAX_LANES_NUM) {
+    const size_t rem_num = msgs_num - i;
+    const size_t num =
+      (rem_num < SHA512_MAX_LANES_NUM) ? rem_num : SHA512_MAX_LANES_NUM;
+
+    mac_lanes(&mac[i], &key[i], &data[i], &byte_len[i], num, impl);
+  }
+}
+
+// Returns 1 if a and b are equal and 0 otherwise, in constant time
+_INLINE_ uint8_t tags_equal(IN const uint8_t *a, IN const uint8_t *b)
+{
+  uint32_t diff = 0;
+
+  for(size_t i = 0; i < SHA512_HASH_BYTE_LEN; i++) {
+    diff |= (uint32_t)(a[i] ^ b[i]);
+  }
+
+  // diff is at most 0xff, so (diff - 1) has its MSB set only if diff == 0
+  return (uint8_t)((diff - 1) >> 31);
+}
+
+void hmac_sha512_verify_multi(OUT uint8_t *pass_bitmap,
+                              IN const hmac_sha512_key_t *key[],
+                              IN const uint8_t *data[],
+                              IN const size_t   byte_len[],
+                              IN const uint8_t *tag[],
+                              IN const size_t   msgs_num,
+                              IN const sha_impl_t impl)
+{
+  assert((pass_bitmap != NULL) && (key != NULL) && (tag != NULL));
+  assert((data != NULL) && (byte_len != NULL));
+
+  ALIGN(64) uint8_t mac[SHA512_MAX_LANES_NUM][SHA512_HASH_BYTE_LEN];
+  uint8_t *         mac_ptr[SHA512_MAX_LANES_NUM];
+
+  for(size_t i = 0; i < SHA512_MAX_LANES_NUM; i++) {
+    mac_ptr[i] = mac[i];
+  }
+
+  my_memset(pass_bitmap, 0, (msgs_num + 7) / 8);
+
+  for(size_t i = 0; i < msgs_num; i += SHA512_MAX_LANES_NUM) {
+    const size_t rem_num = msgs_num - i;
+    const size_t num =
+      (rem_num < SHA512_MAX_LANES_NUM) ? rem_num : SHA512_MAX_LANES_NUM;
+
+    mac_lanes(mac_ptr, &key[i], &data[i], &byte_len[i], num, impl);
+
+    for(size_t j = 0; j < num; j++) {
+      const size_t idx = i + j;
+      pass_bitmap[idx >> 3] |= tags_equal(mac[j], tag[idx]) << (idx & 7);
+    }
+  }
+
+  secure_clean(mac, sizeof(mac));
+}
+
+hmac_sha512_key_t *hmac_sha512_key_new(void)
+{
+  void *key = NULL;
+
+  // The key includes 64-bytes aligned fields
+  if(0 != posix_memalign(&key, 64, sizeof(hmac_sha512_key_t))) {
+    return NULL;
+  }
+
+  return (hmac_sha512_key_t *)key;
+}
+
+void hmac_sha512_key_free(IN OUT hmac_sha512_key_t *key)
+{
+  if(key == NULL) {
+    return;
+  }
+
+  secure_clean(key, sizeof(*key));
+  free(key);
+}
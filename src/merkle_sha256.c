@@ -0,0 +1,277 @@
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+// Merkle trees over SHA256.
+// The tree is built level by level, and all the nodes of a level are hashed
+// together in the lanes of the multi-buffer implementations. An inner node
+// hashes exactly two digests (64 bytes), so in the plain mode the nodes of a
+// level are hashed in place with sha256_64B_multi. In the RFC 6962 mode the
+// 0x01 prefix shifts the digests by one byte, and the two blocks are staged per
+// node.
+
+#include <assert.h>
+
+#include "cpu_features.h"
+#include "sha256_defs.h"
+
+#define LEAF_PREFIX (0x00)
+#define NODE_PREFIX (0x01)
+
+// The message of an inner node in the RFC 6962 mode: 0x01 || left || right
+#define PREFIXED_NODE_BYTE_LEN (1 + (2 * SHA256_HASH_BYTE_LEN))
+
+// sha256_state_t is 64 bytes aligned and cannot be an array element
+typedef struct node_state_s {
+  sha256_state_t s;
+} node_state_t;
+
+typedef struct lanes_s {
+  sha256_multi_compress_t compress;
+  size_t                  lanes_num;
+  sha_impl_t              single_impl;
+  sha_impl_t              impl;
+} lanes_t;
+
+// Compresses one block (when block1 is NULL) or two blocks of num messages,
+// starting from the IV. The messages are compressed lanes_num at a time.
+_INLINE_ void compress_lanes(OUT node_state_t state[],
+                             IN const uint8_t *block0[],
+                             IN const uint8_t *block1[],
+                             IN const size_t   num,
+                             IN const lanes_t *lanes)
+{
+  sha256_lanes_state_t s;
+
+  for(size_t k = 0; k < num; k += lanes->lanes_num) {
+    const size_t n =
+      ((num - k) < lanes->lanes_num) ? (num - k) : lanes->lanes_num;
+    uint32_t lanes_mask = 0;
+
+    // A single message is compressed with the single buffer implementation
+    if(n == 1) {
+      for(size_t j = 0; j < SHA256_HASH_WORDS_NUM; j++) {
+        state[k].s.w[j] = IV256[j];
+      }
+
+      sha256_compress(&state[k].s, block0[k], 1, lanes->single_impl);
+      if(block1 != NULL) {
+        sha256_compress(&state[k].s, block1[k], 1, lanes->single_impl);
+      }
+      continue;
+    }
+
+    for(size_t i = 0; i < n; i++) {
+      for(size_t j = 0; j < SHA256_HASH_WORDS_NUM; j++) {
+        s.w[j][i] = IV256[j];
+      }
+      lanes_mask |= (UINT32_C(1) << i);
+    }
+
+    lanes->compress(&s, &block0[k], 1, lanes_mask);
+    if(block1 != NULL) {
+      lanes->compress(&s, &block1[k], 1, lanes_mask);
+    }
+
+    for(size_t i = 0; i < n; i++) {
+      for(size_t j = 0; j < SHA256_HASH_WORDS_NUM; j++) {
+        state[k + i].s.w[j] = s.w[j][i];
+      }
+    }
+  }
+
+  secure_clean(&s, sizeof(s));
+}
+
+// This implementation assumes running on a Little endian machine
+_INLINE_ void store_dgst(OUT uint8_t *dgst, IN const sha256_state_t *state)
+{
+  for(size_t j = 0; j < SHA256_HASH_WORDS_NUM; j++) {
+    const sha256_word_t w = bswap_32(state->w[j]);
+    my_memcpy(&dgst[j * sizeof(w)], (const uint8_t *)&w, sizeof(w));
+  }
+}
+
+// Stages the two padded blocks of 0x01 || left || right
+_INLINE_ void stage_prefixed_node(OUT uint8_t blocks[2 * SHA256_BLOCK_BYTE_LEN],
+                                  IN const uint8_t *pair)
+{
+  // Byteswap the length in bits of the hashed message
+  const uint64_t bswap_len = bswap_64(8 * PREFIXED_NODE_BYTE_LEN);
+
+  blocks[0] = NODE_PREFIX;
+  my_memcpy(&blocks[1], pair, 2 * SHA256_HASH_BYTE_LEN);
+  blocks[PREFIXED_NODE_BYTE_LEN] = SHA256_MSG_END_SYMBOL;
+  my_memset(&blocks[PREFIXED_NODE_BYTE_LEN + 1], 0,
+            (2 * SHA256_BLOCK_BYTE_LEN) - PREFIXED_NODE_BYTE_LEN - 1);
+  my_memcpy(&blocks[(2 * SHA256_BLOCK_BYTE_LEN) - sizeof(bswap_len)],
+            (const uint8_t *)&bswap_len, sizeof(bswap_len));
+}
+
+// Hashes num <= SHA256_MAX_LANES_NUM pairs of consecutive child digests into
+// num parent digests of the RFC 6962 mode
+_INLINE_ void hash_prefixed_nodes(OUT uint8_t *parent,
+                                  IN const uint8_t *child,
+                                  IN const size_t   num,
+                                  IN const lanes_t *lanes)
+{
+  ALIGN(64) uint8_t staged[SHA256_MAX_LANES_NUM][2 * SHA256_BLOCK_BYTE_LEN];
+  node_state_t      state[SHA256_MAX_LANES_NUM];
+  const uint8_t *   block0[SHA256_MAX_LANES_NUM];
+  const uint8_t *   block1[SHA256_MAX_LANES_NUM];
+
+  for(size_t i = 0; i < num; i++) {
+    stage_prefixed_node(staged[i], &child[2 * i * SHA256_HASH_BYTE_LEN]);
+    block0[i] = staged[i];
+    block1[i] = &staged[i][SHA256_BLOCK_BYTE_LEN];
+  }
+
+  compress_lanes(state, block0, block1, num, lanes);
+
+  for(size_t i = 0; i < num; i++) {
+    store_dgst(&parent[i * SHA256_HASH_BYTE_LEN], &state[i].s);
+  }
+}
+
+// Hashes num <= SHA256_MAX_LANES_NUM leaves into consecutive digests
+_INLINE_ void hash_leaves(OUT uint8_t *dgst,
+                          IN const uint8_t *     leaf[],
+                          IN const size_t        leaf_byte_len[],
+                          IN const size_t        num,
+                          IN const merkle_mode_t mode,
+                          IN const lanes_t *     lanes)
+{
+  uint8_t *leaf_dgst[SHA256_MAX_LANES_NUM];
+
+  for(size_t i = 0; i < num; i++) {
+    leaf_dgst[i] = &dgst[i * SHA256_HASH_BYTE_LEN];
+  }
+
+  if(mode == MERKLE_PLAIN_MODE) {
+    sha256_multi(leaf_dgst, leaf, leaf_byte_len, num, lanes->impl);
+    return;
+  }
+
+  // The 0x00 prefix shifts the leaf by one byte. The first block (the prefix
+  // and the first 63 bytes of the leaf) is staged and compressed in lanes, and
+  // the rest of the leaf continues from its state, read in place. Leaves that
+  // do not fill the first block are staged entirely.
+  ALIGN(64) uint8_t first[SHA256_MAX_LANES_NUM][SHA256_BLOCK_BYTE_LEN];
+  node_state_t      state[SHA256_MAX_LANES_NUM];
+
+  const uint8_t *       block0[SHA256_MAX_LANES_NUM];
+  const sha256_state_t *long_state[SHA256_MAX_LANES_NUM];
+  uint8_t *             long_dgst[SHA256_MAX_LANES_NUM];
+  const uint8_t *       long_data[SHA256_MAX_LANES_NUM];
+  size_t                long_byte_len[SHA256_MAX_LANES_NUM];
+  uint8_t *             short_dgst[SHA256_MAX_LANES_NUM];
+  const uint8_t *       short_data[SHA256_MAX_LANES_NUM];
+  size_t                short_byte_len[SHA256_MAX_LANES_NUM];
+  size_t                long_num  = 0;
+  size_t                short_num = 0;
+
+  for(size_t i = 0; i < num; i++) {
+    const size_t head_byte_len = (leaf_byte_len[i] < SHA256_BLOCK_BYTE_LEN - 1)
+                                   ? leaf_byte_len[i]
+                                   : SHA256_BLOCK_BYTE_LEN - 1;
+
+    first[i][0] = LEAF_PREFIX;
+    my_memcpy(&first[i][1], leaf[i], head_byte_len);
+
+    if(leaf_byte_len[i] < SHA256_BLOCK_BYTE_LEN - 1) {
+      short_dgst[short_num]     = leaf_dgst[i];
+      short_data[short_num]     = first[i];
+      short_byte_len[short_num] = 1 + leaf_byte_len[i];
+      short_num++;
+    } else {
+      block0[long_num]        = first[i];
+      long_state[long_num]    = &state[long_num].s;
+      long_dgst[long_num]     = leaf_dgst[i];
+      long_data[long_num]     = &leaf[i][head_byte_len];
+      long_byte_len[long_num] = leaf_byte_len[i] - head_byte_len;
+      long_num++;
+    }
+  }
+
+  compress_lanes(state, block0, NULL, long_num, lanes);
+
+  sha256_multi_from_states(long_dgst, long_state, SHA256_BLOCK_BYTE_LEN,
+                           long_data, long_byte_len, long_num, lanes->impl);
+  sha256_multi_from_states(short_dgst, NULL, 0, short_data, short_byte_len,
+                           short_num, lanes->impl);
+
+  secure_clean(first, sizeof(first));
+  secure_clean(state, sizeof(state));
+}
+
+size_t merkle_nodes_num(IN const size_t leaves_num)
+{
+  size_t nodes_num = 1;
+
+  for(size_t n = leaves_num; n > 1; n = (n + 1) / 2) {
+    nodes_num += n;
+  }
+
+  return nodes_num;
+}
+
+void merkle_sha256_tree(OUT uint8_t *nodes,
+                        IN const uint8_t *leaf[],
+                        IN const size_t   leaf_byte_len[],
+                        IN const size_t   leaves_num,
+                        IN const merkle_mode_t mode,
+                        IN const sha_impl_t    impl)
+{
+  assert(nodes != NULL);
+  assert(((leaf != NULL) && (leaf_byte_len != NULL)) || (leaves_num == 0));
+
+  lanes_t lanes;
+
+  // The root of an empty tree is the hash of the empty string (in both modes)
+  if(leaves_num == 0) {
+    sha256(nodes, (const uint8_t *)"", 0, impl);
+    return;
+  }
+
+  lanes.impl        = impl;
+  lanes.single_impl = sha256_resolve_impl(impl);
+  lanes.compress    = sha256_multi_compress_func(
+    &lanes.lanes_num, sha256_multi_resolve_impl(impl));
+
+  for(size_t i = 0; i < leaves_num; i += SHA256_MAX_LANES_NUM) {
+    const size_t rem_num = leaves_num - i;
+    const size_t num =
+      (rem_num < SHA256_MAX_LANES_NUM) ? rem_num : SHA256_MAX_LANES_NUM;
+
+    hash_leaves(&nodes[i * SHA256_HASH_BYTE_LEN], &leaf[i], &leaf_byte_len[i],
+                num, mode, &lanes);
+  }
+
+  uint8_t *level = nodes;
+
+  for(size_t n = leaves_num; n > 1; n = (n + 1) / 2) {
+    uint8_t *    next      = &level[n * SHA256_HASH_BYTE_LEN];
+    const size_t pairs_num = n / 2;
+
+    // The pairs of the plain mode are consecutive messages of a fixed length
+    if(mode == MERKLE_PLAIN_MODE) {
+      sha256_64B_multi(next, level, pairs_num, impl);
+    } else {
+      for(size_t i = 0; i < pairs_num; i += SHA256_MAX_LANES_NUM) {
+        const size_t rem_num = pairs_num - i;
+        const size_t num =
+          (rem_num < SHA256_MAX_LANES_NUM) ? rem_num : SHA256_MAX_LANES_NUM;
+
+        hash_prefixed_nodes(&next[i * SHA256_HASH_BYTE_LEN],
+                            &level[2 * i * SHA256_HASH_BYTE_LEN], num, &lanes);
+      }
+    }
+
+    // The last node of an odd level moves up unchanged
+    if(n & 1) {
+      my_memcpy(&next[pairs_num * SHA256_HASH_BYTE_LEN],
+                &level[(n - 1) * SHA256_HASH_BYTE_LEN], SHA256_HASH_BYTE_LEN);
+    }
+
+    level = next;
+  }
+}
@@ -5,6 +5,7 @@
 
 
 .globl	sha256_block_data_order_local
+.hidden	sha256_block_data_order_local
 .type	sha256_block_data_order_local,@function
 .align	16
 sha256_block_data_order_local:
@@ -5478,3 +5479,4 @@ sha256_block_data_order_local_avx2:
 3:
 	.p2align 3
 4:
+	.section .note.GNU-stack,"",@progbits
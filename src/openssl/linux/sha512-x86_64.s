@@ -5,6 +5,7 @@
 
 
 .globl	sha512_block_data_order_local
+.hidden	sha512_block_data_order_local
 .type	sha512_block_data_order_local,@function
 .align	16
 sha512_block_data_order_local:
@@ -5483,3 +5484,4 @@ sha512_block_data_order_local_avx2:
 3:
 	.p2align 3
 4:
+	.section .note.GNU-stack,"",@progbits
@@ -5,6 +5,7 @@
 
 
 .globl	_sha256_block_data_order_local
+.private_extern	_sha256_block_data_order_local
 
 .p2align	4
 _sha256_block_data_order_local:
@@ -0,0 +1,323 @@
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+// PBKDF2-HMAC-SHA512 (RFC 8018).
+// Every iteration U_j = HMAC(P, U_(j-1)) hashes a single block that holds
+// U_(j-1) and a fixed padding, both in the inner and in the outer hash. The
+// implementations that compress a digest block from the state words
+// (sha512_compress_dgst_*) keep U_j in words across the iterations. The others
+// pad the block once, and every iteration only writes the previous digest into
+// it and compresses it from the precomputed states of the password.
+// Independent output blocks (of one or of several passwords) are derived in
+// parallel lanes of the multi-buffer implementations.
+
+#include <assert.h>
+
+#include "cpu_features.h"
+#include "sha512_defs.h"
+
+// The length in bits of the message of the digest block: the (key XOR pad)
+// block followed by the digest
+#define HMAC_DGST_LEN_WORD (8 * (SHA512_BLOCK_BYTE_LEN + SHA512_HASH_BYTE_LEN))
+
+// A single output block (T_i) of a password
+typedef struct pbkdf2_job_s {
+  hmac_sha512_key_t key;
+
+  const uint8_t *salt;
+  size_t         salt_byte_len;
+  uint32_t       block_idx;
+
+  uint8_t *out;
+  size_t   out_byte_len;
+} pbkdf2_job_t;
+
+// Pads the block that holds a digest. The hashed message is the
+// (key XOR pad) block followed by the digest.
+_INLINE_ void pad_block(OUT uint8_t block[SHA512_BLOCK_BYTE_LEN])
+{
+  // Byteswap the length in bits of the hashed message
+  const uint64_t bswap_len =
+    bswap_64(8 * (SHA512_BLOCK_BYTE_LEN + SHA512_HASH_BYTE_LEN));
+
+  my_memset(&block[SHA512_HASH_BYTE_LEN], 0,
+            SHA512_BLOCK_BYTE_LEN - SHA512_HASH_BYTE_LEN);
+  block[SHA512_HASH_BYTE_LEN] = SHA512_MSG_END_SYMBOL;
+  my_memcpy(&block[SHA512_BLOCK_BYTE_LEN - sizeof(bswap_len)],
+            (const uint8_t *)&bswap_len, sizeof(bswap_len));
+}
+
+// U_1 = HMAC(P, S || INT(i))
+_INLINE_ void first_iteration(OUT uint8_t u[SHA512_HASH_BYTE_LEN],
+                              IN const pbkdf2_job_t *job)
+{
+  const uint32_t bswap_idx = bswap_32(job->block_idx);
+  sha512_ctx_t   ctx;
+
+  hmac_sha512_init(&ctx, &job->key);
+  sha512_update(&ctx, job->salt, job->salt_byte_len);
+  sha512_update(&ctx, (const uint8_t *)&bswap_idx, sizeof(bswap_idx));
+  hmac_sha512_final(u, &ctx, &job->key);
+}
+
+// This implementation assumes running on a Little endian machine
+_INLINE_ sha512_word_t load_word(IN const uint8_t *in)
+{
+  sha512_word_t w;
+  my_memcpy((uint8_t *)&w, in, sizeof(w));
+  return bswap_64(w);
+}
+
+_INLINE_ void store_word(OUT uint8_t *out, IN const sha512_word_t w)
+{
+  const sha512_word_t bswap_w = bswap_64(w);
+  my_memcpy(out, (const uint8_t *)&bswap_w, sizeof(bswap_w));
+}
+
+_INLINE_ void write_output(OUT pbkdf2_job_t *job, IN const sha512_state_t *t)
+{
+  uint8_t dgst[SHA512_HASH_BYTE_LEN];
+
+  for(size_t j = 0; j < SHA512_HASH_WORDS_NUM; j++) {
+    store_word(&dgst[j * sizeof(sha512_word_t)], t->w[j]);
+  }
+
+  my_memcpy(job->out, dgst, job->out_byte_len);
+  secure_clean(dgst, sizeof(dgst));
+}
+
+// Replaces u with the state of the digest block of u compressed from init.
+// block is the padded digest block of the implementations without a word-level
+// kernel.
+_INLINE_ void compress_dgst_single(IN OUT sha512_state_t *u,
+                                   IN const sha512_state_t *init,
+                                   IN OUT uint8_t block[SHA512_BLOCK_BYTE_LEN],
+                                   IN const sha_impl_t impl)
+{
+  if(impl == GENERIC_IMPL) {
+    sha512_compress_dgst_generic(u, init, HMAC_DGST_LEN_WORD);
+    return;
+  }
+
+  for(size_t j = 0; j < SHA512_HASH_WORDS_NUM; j++) {
+    store_word(&block[j * sizeof(sha512_word_t)], u->w[j]);
+  }
+
+  *u = *init;
+  sha512_compress(u, block, 1, impl);
+}
+
+_INLINE_ void derive_single(IN OUT pbkdf2_job_t *job,
+                            IN const size_t      iter_num,
+                            IN const sha_impl_t  impl)
+{
+  ALIGN(64) uint8_t block[SHA512_BLOCK_BYTE_LEN];
+  sha512_state_t    u;
+  sha512_state_t    t;
+
+  first_iteration(block, job);
+  pad_block(block);
+
+  for(size_t j = 0; j < SHA512_HASH_WORDS_NUM; j++) {
+    u.w[j] = load_word(&block[j * sizeof(sha512_word_t)]);
+  }
+
+  t = u;
+
+  for(size_t c = 1; c < iter_num; c++) {
+    compress_dgst_single(&u, &job->key.inner, block, impl);
+    compress_dgst_single(&u, &job->key.outer, block, impl);
+
+    for(size_t j = 0; j < SHA512_HASH_WORDS_NUM; j++) {
+      t.w[j] ^= u.w[j];
+    }
+  }
+
+  write_output(job, &t);
+
+  secure_clean(block, sizeof(block));
+  secure_clean(&u, sizeof(u));
+  secure_clean(&t, sizeof(t));
+}
+
+// Stores the digest of every lane of s into the block of the lane
+_INLINE_ void store_lanes(OUT uint8_t block[][SHA512_BLOCK_BYTE_LEN],
+                          IN const sha512_lanes_state_t *s,
+                          IN const size_t                lanes_num)
+{
+  for(size_t l = 0; l < lanes_num; l++) {
+    for(size_t j = 0; j < SHA512_HASH_WORDS_NUM; j++) {
+      store_word(&block[l][j * sizeof(sha512_word_t)], s->w[j][l]);
+    }
+  }
+}
+
+_INLINE_ void derive_lanes(IN OUT pbkdf2_job_t *jobs,
+                           IN const size_t      lanes_num,
+                           IN const size_t      iter_num,
+                           IN sha512_multi_compress_t      compress,
+                           IN sha512_multi_compress_dgst_t compress_dgst)
+{
+  ALIGN(64) uint8_t block[SHA512_MAX_LANES_NUM][SHA512_BLOCK_BYTE_LEN];
+
+  sha512_lanes_state_t inner = {0};
+  sha512_lanes_state_t outer = {0};
+  sha512_lanes_state_t t     = {0};
+  sha512_lanes_state_t s;
+
+  const uint8_t *ptr[SHA512_MAX_LANES_NUM];
+  uint32_t       lanes_mask = 0;
+
+  for(size_t l = 0; l < lanes_num; l++) {
+    first_iteration(block[l], &jobs[l]);
+    pad_block(block[l]);
+
+    for(size_t j = 0; j < SHA512_HASH_WORDS_NUM; j++) {
+      inner.w[j][l] = jobs[l].key.inner.w[j];
+      outer.w[j][l] = jobs[l].key.outer.w[j];
+      t.w[j][l]     = load_word(&block[l][j * sizeof(sha512_word_t)]);
+    }
+
+    ptr[l] = block[l];
+    lanes_mask |= (UINT32_C(1) << l);
+  }
+
+  s = t;
+
+  for(size_t c = 1; c < iter_num; c++) {
+    if(compress_dgst != NULL) {
+      // U_j stays in the state words of the lanes
+      compress_dgst(&s, &inner, HMAC_DGST_LEN_WORD, lanes_mask);
+      compress_dgst(&s, &outer, HMAC_DGST_LEN_WORD, lanes_mask);
+    } else {
+      s = inner;
+      compress(&s, ptr, 1, lanes_mask);
+      store_lanes(block, &s, lanes_num);
+
+      s = outer;
+      compress(&s, ptr, 1, lanes_mask);
+      store_lanes(block, &s, lanes_num);
+    }
+
+    for(size_t j = 0; j < SHA512_HASH_WORDS_NUM; j++) {
+      for(size_t l = 0; l < SHA512_MAX_LANES_NUM; l++) {
+        t.w[j][l] ^= s.w[j][l];
+      }
+    }
+  }
+
+  for(size_t l = 0; l < lanes_num; l++) {
+    sha512_state_t lane_t;
+
+    for(size_t j = 0; j < SHA512_HASH_WORDS_NUM; j++) {
+      lane_t.w[j] = t.w[j][l];
+    }
+
+    write_output(&jobs[l], &lane_t);
+    secure_clean(&lane_t, sizeof(lane_t));
+  }
+
+  secure_clean(block, sizeof(block));
+  secure_clean(&inner, sizeof(inner));
+  secure_clean(&outer, sizeof(outer));
+  secure_clean(&s, sizeof(s));
+  secure_clean(&t, sizeof(t));
+}
+
+// Derives the output blocks of all the passwords, lanes_num blocks at a time.
+// The blocks of a password are consecutive, and a password that spans several
+// lanes prepares its key only once.
+_INLINE_ void pbkdf2(OUT uint8_t *out[],
+                     IN const size_t   out_byte_len,
+                     IN const uint8_t *pwd[],
+                     IN const size_t   pwd_byte_len[],
+                     IN const uint8_t *salt[],
+                     IN const size_t   salt_byte_len[],
+                     IN const size_t   pwds_num,
+                     IN const size_t   iter_num,
+                     IN const sha_impl_t impl)
+{
+  const size_t blocks_num =
+    (out_byte_len + SHA512_HASH_BYTE_LEN - 1) / SHA512_HASH_BYTE_LEN;
+  const size_t jobs_num = pwds_num * blocks_num;
+
+  const sha_impl_t multi_impl  = sha512_multi_resolve_impl(impl);
+  const sha_impl_t single_impl = sha512_resolve_impl(impl);
+  size_t           lanes_num   = 1;
+
+  const sha512_multi_compress_t compress =
+    sha512_multi_compress_func(&lanes_num, multi_impl);
+  const sha512_multi_compress_dgst_t compress_dgst =
+    sha512_multi_compress_dgst_func(multi_impl);
+
+  pbkdf2_job_t jobs[SHA512_MAX_LANES_NUM];
+
+  for(size_t k = 0; k < jobs_num; k += lanes_num) {
+    const size_t num = ((jobs_num - k) < lanes_num) ? (jobs_num - k) : lanes_num;
+
+    for(size_t l = 0; l < num; l++) {
+      const size_t p   = (k + l) / blocks_num;
+      const size_t b   = (k + l) % blocks_num;
+      const size_t pos = b * SHA512_HASH_BYTE_LEN;
+
+      if((l != 0) && (b != 0)) {
+        jobs[l].key = jobs[l - 1].key;
+      } else {
+        hmac_sha512_key_init(&jobs[l].key, pwd[p], pwd_byte_len[p],
+                             single_impl);
+      }
+
+      jobs[l].salt          = salt[p];
+      jobs[l].salt_byte_len = salt_byte_len[p];
+      jobs[l].block_idx     = (uint32_t)(b + 1);
+      jobs[l].out           = &out[p][pos];
+      jobs[l].out_byte_len  = ((out_byte_len - pos) < SHA512_HASH_BYTE_LEN)
+                                ? (out_byte_len - pos)
+                                : SHA512_HASH_BYTE_LEN;
+    }
+
+    if(num == 1) {
+      derive_single(&jobs[0], iter_num, single_impl);
+    } else {
+      derive_lanes(jobs, num, iter_num, compress, compress_dgst);
+    }
+  }
+
+  secure_clean(jobs, sizeof(jobs));
+}
+
+void pbkdf2_hmac_sha512(OUT uint8_t *out,
+                        IN const size_t   out_byte_len,
+                        IN const uint8_t *pwd,
+                        IN const size_t   pwd_byte_len,
+                        IN const uint8_t *salt,
+                        IN const size_t   salt_byte_len,
+                        IN const size_t   iter_num,
+                        IN const sha_impl_t impl)
+{
+  assert((out != NULL) || (out_byte_len == 0));
+  assert((pwd != NULL) || (pwd_byte_len == 0));
+  assert((salt != NULL) || (salt_byte_len == 0));
+  assert(iter_num != 0);
+
+  pbkdf2(&out, out_byte_len, &pwd, &pwd_byte_len, &salt, &salt_byte_len, 1,
+         iter_num, impl);
+}
+
+void pbkdf2_hmac_sha512_multi(OUT uint8_t *out[],
+                              IN const size_t   out_byte_len,
+                              IN const uint8_t *pwd[],
+                              IN const size_t   pwd_byte_len[],
+                              IN const uint8_t *salt[],
+                              IN const size_t   salt_byte_len[],
+                              IN const size_t   pwds_num,
+                              IN const size_t   iter_num,
+                              IN const sha_impl_t impl)
+{
+  assert((out != NULL) && (pwd != NULL) && (pwd_byte_len != NULL));
+  assert((salt != NULL) && (salt_byte_len != NULL));
+  assert(iter_num != 0);
+
+  pbkdf2(out, out_byte_len, pwd, pwd_byte_len, salt, salt_byte_len, pwds_num,
+         iter_num, impl);
+}
@@ -1,24 +1,24 @@
 // Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
 // SPDX-License-Identifier: Apache-2.0
 
+// For posix_memalign
+#define _POSIX_C_SOURCE 200112L
+
 #include <assert.h>
+#include <stdlib.h>
 
+#include "cpu_features.h"
 #include "sha256_defs.h"
 
-#define LAST_BLOCK_BYTE_LEN (2 * SHA256_BLOCK_BYTE_LEN)
-
-typedef struct sha256_hash_s {
-  ALIGN(64) sha256_state_t state;
-  uint64_t len;
-
-  ALIGN(64) uint8_t data[LAST_BLOCK_BYTE_LEN];
+void sha256_init(OUT sha256_ctx_t *ctx, IN const sha_impl_t impl)
+{
+  assert(ctx != NULL);
 
-  sha256_word_t rem;
-  sha_impl_t    impl;
-} sha256_ctx_t;
+  ctx->len           = 0;
+  ctx->rem           = 0;
+  ctx->impl          = sha256_resolve_impl(impl);
+  ctx->dgst_byte_len = SHA256_HASH_BYTE_LEN;
 
-_INLINE_ void sha256_init(OUT sha256_ctx_t *ctx)
-{
   ctx->state.w[0] = UINT32_C(0x6a09e667);
   ctx->state.w[1] = UINT32_C(0xbb67ae85);
   ctx->state.w[2] = UINT32_C(0x3c6ef372);
@@ -29,85 +29,111 @@ _INLINE_ void sha256_init(OUT sha256_ctx_t *ctx)
   ctx->state.w[7] = UINT32_C(0x5be0cd19);
 }
 
-_INLINE_ void sha256_compress(IN OUT sha256_ctx_t *ctx,
-                              IN const uint8_t *data,
-                              IN const size_t   blocks_num)
+// SHA-224 is SHA-256 with a different IV and a truncated digest
+void sha224_init(OUT sha256_ctx_t *ctx, IN const sha_impl_t impl)
 {
-  assert((ctx != NULL) && (data != NULL));
+  sha256_init(ctx, impl);
+
+  ctx->dgst_byte_len = SHA224_HASH_BYTE_LEN;
+
+  ctx->state.w[0] = UINT32_C(0xc1059ed8);
+  ctx->state.w[1] = UINT32_C(0x367cd507);
+  ctx->state.w[2] = UINT32_C(0x3070dd17);
+  ctx->state.w[3] = UINT32_C(0xf70e5939);
+  ctx->state.w[4] = UINT32_C(0xffc00b31);
+  ctx->state.w[5] = UINT32_C(0x68581511);
+  ctx->state.w[6] = UINT32_C(0x64f98fa7);
+  ctx->state.w[7] = UINT32_C(0xbefa4fa4);
+}
+
+void sha256_compress(IN OUT sha256_state_t *state,
+                     IN const uint8_t *  data,
+                     IN const size_t     blocks_num,
+                     IN const sha_impl_t impl)
+{
+  assert((state != NULL) && (data != NULL));
 
   // OpenSSL code can crash without this check
   if(blocks_num == 0) {
     return;
   }
 
-  switch(ctx->impl) {
+  switch(impl) {
 #if defined(X86_64)
     case AVX_IMPL:
-      sha256_compress_x86_64_avx(&ctx->state, data, blocks_num);
+      sha256_compress_x86_64_avx(state, data, blocks_num);
       break;
 
     case OPENSSL_AVX_IMPL:
       RUN_OPENSSL_CODE_WITH_AVX(
-        sha256_block_data_order_local(ctx->state.w, data, blocks_num););
+        sha256_block_data_order_local(state->w, data, blocks_num););
       break;
 #endif
 
 #if defined(AVX2_SUPPORT)
     case AVX2_IMPL:
-      sha256_compress_x86_64_avx2(&ctx->state, data, blocks_num);
+      sha256_compress_x86_64_avx2(state, data, blocks_num);
       break;
 
     case OPENSSL_AVX2_IMPL:
       RUN_OPENSSL_CODE_WITH_AVX2(
-        sha256_block_data_order_local(ctx->state.w, data, blocks_num););
+        sha256_block_data_order_local(state->w, data, blocks_num););
       break;
 #endif
 
 #if defined(AVX512_SUPPORT)
     case AVX512_IMPL:
-      sha256_compress_x86_64_avx512(&ctx->state, data, blocks_num);
+      sha256_compress_x86_64_avx512(state, data, blocks_num);
       break;
 #endif
 
 #if defined(X86_64_SHA_SUPPORT)
     case SHA_EXT_IMPL:
-      sha256_compress_x86_64_sha_ext(&ctx->state, data, blocks_num);
+      sha256_compress_x86_64_sha_ext(state, data, blocks_num);
       break;
 
     case OPENSSL_SHA_EXT_IMPL:
       RUN_OPENSSL_CODE_WITH_SHA_EXT(
-        sha256_block_data_order_local(ctx->state.w, data, blocks_num););
+        sha256_block_data_order_local(state->w, data, blocks_num););
       break;
 #endif
 
 #if defined(NEON_SUPPORT)
+#  if defined(AARCH64_SVE_SUPPORT)
+    // SVE only has a multi-buffer implementation
+    case SVE_IMPL:
+#  endif
+    case NEON_IMPL:
+      sha256_compress_aarch64_neon(state, data, blocks_num);
+      break;
+
     case OPENSSL_NEON_IMPL:
       RUN_OPENSSL_CODE_WITH_NEON(
-        sha256_block_data_order_local(ctx->state.w, data, blocks_num););
+        sha256_block_data_order_local(state->w, data, blocks_num););
       break;
 #endif
 
 #if defined(AARCH64_SHA_SUPPORT)
     case SHA_EXT_IMPL:
-      sha256_compress_aarch64_sha_ext(&ctx->state, data, blocks_num);
+      sha256_compress_aarch64_sha_ext(state, data, blocks_num);
       break;
 
     case OPENSSL_SHA_EXT_IMPL:
       RUN_OPENSSL_CODE_WITH_SHA256_EXT(
-        sha256_block_data_order_local(ctx->state.w, data, blocks_num););
+        sha256_block_data_order_local(state->w, data, blocks_num););
       break;
 #endif
-    default: sha256_compress_generic(&ctx->state, data, blocks_num); break;
+    default: sha256_compress_generic(state, data, blocks_num); break;
   }
 }
 
-_INLINE_ void sha256_update(IN OUT sha256_ctx_t *ctx,
-                            IN const uint8_t *data,
-                            IN size_t         byte_len)
+void sha256_update(IN OUT sha256_ctx_t *ctx,
+                   IN const uint8_t *data,
+                   IN size_t         byte_len)
 {
   // On exiting this function ctx->rem < SHA256_BLOCK_BYTE_LEN
 
-  assert((ctx != NULL) && (data != NULL));
+  assert((ctx != NULL) && ((data != NULL) || (byte_len == 0)));
 
   if(byte_len == 0) {
     return;
@@ -127,7 +153,7 @@ _INLINE_ void sha256_update(IN OUT sha256_ctx_t *ctx,
   if(ctx->rem != 0) {
     const size_t clen = SHA256_BLOCK_BYTE_LEN - ctx->rem;
     my_memcpy(&ctx->data[ctx->rem], data, clen);
-    sha256_compress(ctx, ctx->data, 1);
+    sha256_compress(&ctx->state, ctx->data, 1, ctx->impl);
 
     data += clen;
     byte_len -= clen;
@@ -141,7 +167,7 @@ _INLINE_ void sha256_update(IN OUT sha256_ctx_t *ctx,
     const size_t blocks_num           = (byte_len >> 6);
     const size_t full_blocks_byte_len = (blocks_num << 6);
 
-    sha256_compress(ctx, data, blocks_num);
+    sha256_compress(&ctx->state, data, blocks_num, ctx->impl);
 
     data += full_blocks_byte_len;
     byte_len -= full_blocks_byte_len;
@@ -152,9 +178,9 @@ _INLINE_ void sha256_update(IN OUT sha256_ctx_t *ctx,
   ctx->rem = byte_len;
 }
 
-_INLINE_ void sha256_final(OUT uint8_t *dgst, IN OUT sha256_ctx_t *ctx)
+void sha256_final_state(IN OUT sha256_ctx_t *ctx)
 {
-  assert((ctx != NULL) && (dgst != NULL));
+  assert(ctx != NULL);
   assert(ctx->rem < SHA256_BLOCK_BYTE_LEN);
 
   // Byteswap the length in bits of the hashed message
@@ -171,7 +197,14 @@ _INLINE_ void sha256_final(OUT uint8_t *dgst, IN OUT sha256_ctx_t *ctx)
             sizeof(bswap_len));
 
   // Compress the final block
-  sha256_compress(ctx, ctx->data, last_block_num);
+  sha256_compress(&ctx->state, ctx->data, last_block_num, ctx->impl);
+}
+
+void sha256_final(OUT uint8_t *dgst, IN OUT sha256_ctx_t *ctx)
+{
+  assert((ctx != NULL) && (dgst != NULL));
+
+  sha256_final_state(ctx);
 
   // This implementation assumes running on a Little endian machine
   ctx->state.w[0] = bswap_32(ctx->state.w[0]);
@@ -182,7 +215,7 @@ _INLINE_ void sha256_final(OUT uint8_t *dgst, IN OUT sha256_ctx_t *ctx)
   ctx->state.w[5] = bswap_32(ctx->state.w[5]);
   ctx->state.w[6] = bswap_32(ctx->state.w[6]);
   ctx->state.w[7] = bswap_32(ctx->state.w[7]);
-  my_memcpy(dgst, &ctx->state, SHA256_HASH_BYTE_LEN);
+  my_memcpy(dgst, &ctx->state, ctx->dgst_byte_len);
 
   secure_clean(ctx, sizeof(*ctx));
 }
@@ -194,9 +227,50 @@ void sha256(OUT uint8_t *dgst,
 {
   assert((data != NULL) || (dgst != NULL));
 
-  sha256_ctx_t ctx = {0};
-  ctx.impl         = impl;
-  sha256_init(&ctx);
+  sha256_ctx_t ctx;
+  sha256_init(&ctx, impl);
   sha256_update(&ctx, data, byte_len);
   sha256_final(dgst, &ctx);
 }
+
+void sha224(OUT uint8_t *dgst,
+            IN const uint8_t *  data,
+            IN const size_t     byte_len,
+            IN const sha_impl_t impl)
+{
+  assert((data != NULL) || (dgst != NULL));
+
+  sha256_ctx_t ctx;
+  sha224_init(&ctx, impl);
+  sha256_update(&ctx, data, byte_len);
+  sha256_final(dgst, &ctx);
+}
+
+sha256_ctx_t *sha256_ctx_new(void)
+{
+  void *ctx = NULL;
+
+  // The context includes 64-bytes aligned fields
+  if(0 != posix_memalign(&ctx, 64, sizeof(sha256_ctx_t))) {
+    return NULL;
+  }
+
+  return (sha256_ctx_t *)ctx;
+}
+
+void sha256_ctx_free(IN OUT sha256_ctx_t *ctx)
+{
+  if(ctx == NULL) {
+    return;
+  }
+
+  secure_clean(ctx, sizeof(*ctx));
+  free(ctx);
+}
+
+void sha256_ctx_copy(OUT sha256_ctx_t *dst, IN const sha256_ctx_t *src)
+{
+  assert((dst != NULL) && (src != NULL));
+
+  my_memcpy(dst, src, sizeof(*dst));
+}
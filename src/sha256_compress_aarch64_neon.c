@@ -0,0 +1,130 @@
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+// An implementation of the compress function of SHA256 using NEON, for
+// AARCH64 CPUs without the SHA extension. As in the AVX implementation
+// (sha256_compress_x86_64_avx.c), the message schedule of the next 4 rounds is
+// computed in a vector register while the current rounds run on the scalar
+// registers.
+
+#include "neon_defs.h"
+#include "sha256_defs.h"
+
+#define MS_VEC_NUM   (SHA256_BLOCK_BYTE_LEN / sizeof(uint32x4_t))
+#define WORDS_IN_VEC (sizeof(uint32x4_t) / sizeof(sha256_word_t))
+
+#define NEON_sigma0(x) \
+  (NEON_ROR32(x, sigma0_0) ^ NEON_ROR32(x, sigma0_1) ^ vshrq_n_u32(x, sigma0_2))
+#define NEON_sigma1(x) \
+  (NEON_ROR32(x, sigma1_0) ^ NEON_ROR32(x, sigma1_1) ^ vshrq_n_u32(x, sigma1_2))
+
+_INLINE_ void rotate_x(uint32x4_t x[MS_VEC_NUM])
+{
+  const uint32x4_t tmp = x[0];
+  x[0]                 = x[1];
+  x[1]                 = x[2];
+  x[2]                 = x[3];
+  x[3]                 = tmp;
+}
+
+// Receives x[3:0] = d[15:0] and computes d[i] += sigma0(d[i + 1]) +
+// sigma1(d[i + 14]) + d[i + 9] for d[3:0]. d[2] and d[3] depend on the new
+// d[0] and d[1] (through sigma1), so sigma1 is computed on each half. Returns
+// the new words added to the round constants.
+_INLINE_ uint32x4_t update_x(IN OUT uint32x4_t x[MS_VEC_NUM],
+                             IN const sha256_word_t *k256_p)
+{
+  const uint32x2_t zero = vdup_n_u32(0);
+
+  const uint32x4_t d4_1  = vextq_u32(x[0], x[1], 1);
+  const uint32x4_t d12_9 = vextq_u32(x[2], x[3], 1);
+  uint32x4_t       t;
+
+  x[0] = vaddq_u32(vaddq_u32(x[0], d12_9), NEON_sigma0(d4_1));
+
+  // sigma1(0) = 0, so the zero half does not change the other words
+  t    = vcombine_u32(vget_high_u32(x[3]), zero); // d[-,-,15,14]
+  x[0] = vaddq_u32(x[0], NEON_sigma1(t));
+  t    = vcombine_u32(zero, vget_low_u32(x[0])); // d[17,16,-,-]
+  x[0] = vaddq_u32(x[0], NEON_sigma1(t));
+
+  rotate_x(x);
+
+  return vaddq_u32(x[3], vld1q_u32(k256_p));
+}
+
+_INLINE_ void load_data(OUT uint32x4_t x[MS_VEC_NUM],
+                        IN OUT sha256_msg_schedule_t *ms,
+                        IN const uint8_t *data)
+{
+  PRAGMA_LOOP_UNROLL_4
+
+  for(size_t i = 0; i < MS_VEC_NUM; i++) {
+    const size_t pos = WORDS_IN_VEC * i;
+
+    x[i] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(&data[16 * i])));
+    vst1q_u32(&ms->w[pos], vaddq_u32(x[i], vld1q_u32(&K256[pos])));
+  }
+}
+
+_INLINE_ void rounds_0_47(sha256_state_t *       cur_state,
+                          uint32x4_t             x[MS_VEC_NUM],
+                          sha256_msg_schedule_t *ms)
+{
+  // The first SHA256_BLOCK_WORDS_NUM entries of K256 were loaded in
+  // load_data(...).
+  size_t k256_idx = SHA256_BLOCK_WORDS_NUM;
+
+  // Rounds 0-47 (0-15, 16-31, 32-47)
+  for(size_t i = 0; i < 3; i++) {
+
+    PRAGMA_LOOP_UNROLL_4
+
+    for(size_t j = 0; j < MS_VEC_NUM; j++) {
+      const size_t pos = WORDS_IN_VEC * j;
+
+      const uint32x4_t y = update_x(x, &K256[k256_idx]);
+
+      sha_round(cur_state, ms->w[pos + 0], 0);
+      sha_round(cur_state, ms->w[pos + 1], 0);
+      sha_round(cur_state, ms->w[pos + 2], 0);
+      sha_round(cur_state, ms->w[pos + 3], 0);
+
+      vst1q_u32(&ms->w[pos], y);
+      k256_idx += WORDS_IN_VEC;
+    }
+  }
+}
+
+_INLINE_ void rounds_48_63(sha256_state_t *             cur_state,
+                           const sha256_msg_schedule_t *ms)
+{
+  PRAGMA_LOOP_UNROLL_16
+
+  for(size_t i = SHA256_FINAL_ROUND_START_IDX; i < SHA256_ROUNDS_NUM; i++) {
+    sha_round(cur_state, ms->w[LSB4(i)], 0);
+  }
+}
+
+void sha256_compress_aarch64_neon(IN OUT sha256_state_t *state,
+                                  IN const uint8_t *data,
+                                  IN size_t         blocks_num)
+{
+  sha256_state_t        cur_state;
+  sha256_msg_schedule_t ms;
+  uint32x4_t            x[MS_VEC_NUM];
+
+  while(blocks_num--) {
+    my_memcpy(cur_state.w, state->w, sizeof(cur_state.w));
+
+    load_data(x, &ms, data);
+    data += SHA256_BLOCK_BYTE_LEN;
+
+    rounds_0_47(&cur_state, x, &ms);
+    rounds_48_63(&cur_state, &ms);
+    accumulate_state(state, &cur_state);
+  }
+
+  secure_clean(&cur_state, sizeof(cur_state));
+  secure_clean(&ms, sizeof(ms));
+}
@@ -58,3 +58,59 @@ void sha256_compress_generic(IN OUT sha256_state_t *state,
   secure_clean(&cur_state, sizeof(cur_state));
   secure_clean(&ms, sizeof(ms));
 }
+
+void sha256_compress_wk_generic(IN OUT sha256_state_t *state,
+                                IN const sha256_word_t wk[SHA256_ROUNDS_NUM])
+{
+  sha256_state_t cur_state;
+
+  my_memcpy(&cur_state, state, sizeof(cur_state));
+
+  // The message schedule is already added to the constants
+  PRAGMA_LOOP_UNROLL_64
+
+  for(size_t i = 0; i < SHA256_ROUNDS_NUM; i++) {
+    sha_round(&cur_state, wk[i], 0);
+  }
+
+  accumulate_state(state, &cur_state);
+  secure_clean(&cur_state, sizeof(cur_state));
+}
+
+void sha256_compress_dgst_generic(IN OUT sha256_state_t *state,
+                                  IN const sha256_state_t *init,
+                                  IN sha256_word_t         len_word)
+{
+  sha256_state_t        cur_state;
+  sha256_msg_schedule_t ms = {0};
+
+  for(size_t i = 0; i < SHA256_HASH_WORDS_NUM; i++) {
+    ms.w[i] = state->w[i];
+  }
+
+  ms.w[SHA256_HASH_WORDS_NUM]      = SHA256_DGST_PAD_END_WORD;
+  ms.w[SHA256_BLOCK_WORDS_NUM - 1] = len_word;
+
+  my_memcpy(state, init, sizeof(*state));
+  my_memcpy(&cur_state, state, sizeof(cur_state));
+
+  PRAGMA_LOOP_UNROLL_16
+
+  for(size_t i = 0; i < SHA256_BLOCK_WORDS_NUM; i++) {
+    sha_round(&cur_state, ms.w[i], K256[i]);
+  }
+
+  rounds_16_63(&cur_state, &ms);
+  accumulate_state(state, &cur_state);
+
+  secure_clean(&cur_state, sizeof(cur_state));
+  secure_clean(&ms, sizeof(ms));
+}
+
+void sha256_rehash_generic(IN OUT sha256_state_t *state)
+{
+  sha256_state_t iv;
+
+  my_memcpy(&iv, IV256, sizeof(iv));
+  sha256_compress_dgst_generic(state, &iv, SHA256_DGST_PAD_LEN_WORD);
+}
@@ -20,89 +20,175 @@
   (SETR32(K256[4 * (i)], K256[(4 * (i)) + 1], K256[(4 * (i)) + 2], \
           K256[(4 * (i)) + 3]))
 
+// Converts the state words (ABCD, EFGH) to the ABEF/CDGH form of the SHA
+// extension
+_INLINE_ void load_state(OUT vec_t *state0,
+                         OUT vec_t *state1,
+                         IN const sha256_word_t w[SHA256_HASH_WORDS_NUM])
+{
+  const vec_t tmp = SHUF32(LOAD(&w[0]), 0xB1);   // CDAB
+  *state1         = SHUF32(LOAD(&w[4]), 0x1B);   // EFGH
+  *state0         = ALIGNR8(tmp, *state1, 8);    // ABEF
+  *state1         = BLEND16(*state1, tmp, 0xF0); // CDGH
+}
+
+_INLINE_ void store_state(OUT sha256_state_t *state,
+                          IN const vec_t      state0,
+                          IN const vec_t      state1)
+{
+  const vec_t tmp  = SHUF32(state0, 0x1B); // FEBA
+  const vec_t dchg = SHUF32(state1, 0xB1); // DCHG
+
+  STORE((vec_t *)&state->w[0], BLEND16(tmp, dchg, 0xF0)); // DCBA
+  STORE((vec_t *)&state->w[4], ALIGNR8(dchg, tmp, 8));    // HGFE
+}
+
+// Compresses one block. msgtmp holds the 16 message words (already byte
+// swapped) and is overwritten by the message schedule.
+_INLINE_ void compress_block(IN OUT vec_t *state0,
+                             IN OUT vec_t *state1,
+                             IN OUT vec_t  msgtmp[4])
+{
+  vec_t msg;
+  vec_t tmp;
+
+  // Save the current state
+  const vec_t ABEF_SAVE = *state0;
+  const vec_t CDGH_SAVE = *state1;
+
+  // Rounds 0-3
+  msg     = ADD32(msgtmp[0], SET_K(0));
+  *state1 = RND2(*state1, *state0, msg);
+  msg     = SHUF32(msg, 0x0E);
+  *state0 = RND2(*state0, *state1, msg);
+
+  PRAGMA_LOOP_UNROLL_2
+
+  // Rounds 4-7 (i=1)
+  // Rounds 8-11 (i=2)
+  for(size_t i = 1; i <= 2; i++) {
+    msg           = ADD32(msgtmp[i], SET_K(i));
+    *state1       = RND2(*state1, *state0, msg);
+    msg           = SHUF32(msg, 0x0E);
+    *state0       = RND2(*state0, *state1, msg);
+    msgtmp[i - 1] = SHAMSG1(msgtmp[i - 1], msgtmp[i]);
+  }
+
+  PRAGMA_LOOP_UNROLL_12
+
+  // Rounds 12-59 in blocks of 4 (12 multi-rounds)
+  for(size_t i = 3; i <= 14; i++) {
+    const size_t prev = LSB2(i - 1);
+    const size_t curr = LSB2(i);
+    const size_t next = LSB2(i + 1);
+
+    msg          = ADD32(msgtmp[curr], SET_K(i));
+    *state1      = RND2(*state1, *state0, msg);
+    tmp          = ALIGNR8(msgtmp[curr], msgtmp[prev], 4);
+    msgtmp[next] = ADD32(msgtmp[next], tmp);
+    msgtmp[next] = SHAMSG2(msgtmp[next], msgtmp[curr]);
+    msg          = SHUF32(msg, 0x0E);
+    *state0      = RND2(*state0, *state1, msg);
+    msgtmp[prev] = SHAMSG1(msgtmp[prev], msgtmp[curr]);
+  }
+
+  // Rounds 60-63
+  msg     = ADD32(msgtmp[3], SET_K(15));
+  *state1 = RND2(*state1, *state0, msg);
+  msg     = SHUF32(msg, 0x0E);
+  *state0 = RND2(*state0, *state1, msg);
+
+  // Accumulate state
+  *state0 = ADD32(*state0, ABEF_SAVE);
+  *state1 = ADD32(*state1, CDGH_SAVE);
+}
+
 void sha256_compress_x86_64_sha_ext(IN OUT sha256_state_t *state,
                                     IN const uint8_t *data,
                                     IN size_t         blocks_num)
 {
   vec_t state0;
   vec_t state1;
-  vec_t msg;
-  vec_t tmp;
   vec_t msgtmp[4];
-  vec_t ABEF_SAVE;
-  vec_t CDGH_SAVE;
 
   const vec_t shuf_mask =
     SET64(UINT64_C(0x0c0d0e0f08090a0b), UINT64_C(0x0405060700010203));
 
-  tmp    = SHUF32(LOAD(&state->w[0]), 0xB1); // CDAB
-  state1 = SHUF32(LOAD(&state->w[4]), 0x1B); // EFGH
-  state0 = ALIGNR8(tmp, state1, 8);          // ABEF
-  state1 = BLEND16(state1, tmp, 0xF0);       // CDGH
+  load_state(&state0, &state1, state->w);
 
   while(blocks_num--) {
-    // Save the current state
-    ABEF_SAVE = state0;
-    CDGH_SAVE = state1;
-
-    // Rounds 0-3
-    msgtmp[0] = SHUF8(LOAD(&data[0]), shuf_mask);
-    msg       = ADD32(msgtmp[0], SET_K(0));
-    state1    = RND2(state1, state0, msg);
-    msg       = SHUF32(msg, 0x0E);
-    state0    = RND2(state0, state1, msg);
-
-    PRAGMA_LOOP_UNROLL_2
-
-    // Rounds 4-7 (i=1)
-    // Rounds 8-11 (i=2)
-    for(size_t i = 1; i <= 2; i++) {
-      msgtmp[i]     = SHUF8(LOAD(&data[16 * i]), shuf_mask);
-      msg           = ADD32(msgtmp[i], SET_K(i));
-      state1        = RND2(state1, state0, msg);
-      msg           = SHUF32(msg, 0x0E);
-      state0        = RND2(state0, state1, msg);
-      msgtmp[i - 1] = SHAMSG1(msgtmp[i - 1], msgtmp[i]);
+    PRAGMA_LOOP_UNROLL_4
+
+    for(size_t i = 0; i < 4; i++) {
+      msgtmp[i] = SHUF8(LOAD(&data[16 * i]), shuf_mask);
     }
 
-    // Rounds 12-59 in blocks of 4 (12 multi-rounds)
-    msgtmp[3] = SHUF8(LOAD(&data[48]), shuf_mask);
+    compress_block(&state0, &state1, msgtmp);
+
+    data += SHA256_BLOCK_BYTE_LEN;
+  }
+
+  store_state(state, state0, state1);
+}
+
+void sha256_compress_wk_x86_64_sha_ext(
+  IN OUT sha256_state_t *state,
+  IN const sha256_word_t wk[SHA256_ROUNDS_NUM])
+{
+  vec_t state0;
+  vec_t state1;
+  vec_t msg;
 
-    PRAGMA_LOOP_UNROLL_12
+  load_state(&state0, &state1, state->w);
 
-    for(size_t i = 3; i <= 14; i++) {
-      const size_t prev = LSB2(i - 1);
-      const size_t curr = LSB2(i);
-      const size_t next = LSB2(i + 1);
+  const vec_t ABEF_SAVE = state0;
+  const vec_t CDGH_SAVE = state1;
 
-      msg          = ADD32(msgtmp[curr], SET_K(i));
-      state1       = RND2(state1, state0, msg);
-      tmp          = ALIGNR8(msgtmp[curr], msgtmp[prev], 4);
-      msgtmp[next] = ADD32(msgtmp[next], tmp);
-      msgtmp[next] = SHAMSG2(msgtmp[next], msgtmp[curr]);
-      msg          = SHUF32(msg, 0x0E);
-      state0       = RND2(state0, state1, msg);
-      msgtmp[prev] = SHAMSG1(msgtmp[prev], msgtmp[curr]);
-    }
+  PRAGMA_LOOP_UNROLL_16
 
-    // Rounds 60-63
-    msg    = ADD32(msgtmp[3], SET_K(15));
+  // The message schedule is already added to the constants, so the
+  // sha256msg1/sha256msg2 steps are skipped
+  for(size_t i = 0; i < 16; i++) {
+    msg    = LOAD(&wk[4 * i]);
     state1 = RND2(state1, state0, msg);
     msg    = SHUF32(msg, 0x0E);
     state0 = RND2(state0, state1, msg);
+  }
 
-    // Accumulate state
-    state0 = ADD32(state0, ABEF_SAVE);
-    state1 = ADD32(state1, CDGH_SAVE);
+  // Accumulate state
+  state0 = ADD32(state0, ABEF_SAVE);
+  state1 = ADD32(state1, CDGH_SAVE);
 
-    data += SHA256_BLOCK_BYTE_LEN;
-  }
+  store_state(state, state0, state1);
+}
+
+// Compresses, from init, the block that holds the digest in state and the
+// padding of a message of len_word bits
+_INLINE_ void compress_dgst(IN OUT sha256_state_t *state,
+                            IN const sha256_word_t init[SHA256_HASH_WORDS_NUM],
+                            IN const sha256_word_t len_word)
+{
+  vec_t state0;
+  vec_t state1;
 
-  tmp    = SHUF32(state0, 0x1B);       // FEBA
-  state1 = SHUF32(state1, 0xB1);       // DCHG
-  state0 = BLEND16(tmp, state1, 0xF0); // DCBA
-  state1 = ALIGNR8(state1, tmp, 8);    // ABEF
+  // The digest words are the message words, and stay in registers
+  vec_t msgtmp[4] = {LOAD(&state->w[0]), LOAD(&state->w[4]),
+                     SETR32(SHA256_DGST_PAD_END_WORD, 0, 0, 0),
+                     SETR32(0, 0, 0, len_word)};
 
-  STORE((vec_t *)&state->w[0], state0);
-  STORE((vec_t *)&state->w[4], state1);
+  load_state(&state0, &state1, init);
+  compress_block(&state0, &state1, msgtmp);
+  store_state(state, state0, state1);
+}
+
+void sha256_compress_dgst_x86_64_sha_ext(IN OUT sha256_state_t *state,
+                                         IN const sha256_state_t *init,
+                                         IN sha256_word_t         len_word)
+{
+  compress_dgst(state, init->w, len_word);
+}
+
+void sha256_rehash_x86_64_sha_ext(IN OUT sha256_state_t *state)
+{
+  compress_dgst(state, IV256, SHA256_DGST_PAD_LEN_WORD);
 }
@@ -116,3 +116,36 @@ const sha256_word_t K256x4[4 * SHA256_ROUNDS_NUM] = {
   DUP4(K256_52, K256_53, K256_54, K256_55),
   DUP4(K256_56, K256_57, K256_58, K256_59),
   DUP4(K256_60, K256_61, K256_62, K256_63)};
+
+// The padding block of a 64 bytes message is constant, and so is its message
+// schedule. WK256_PAD64[i] = W[i] + K256[i] of that block.
+ALIGN(64)
+const sha256_word_t WK256_PAD64[SHA256_ROUNDS_NUM] = {
+  UINT32_C(0xc28a2f98), UINT32_C(0x71374491), UINT32_C(0xb5c0fbcf),
+  UINT32_C(0xe9b5dba5), UINT32_C(0x3956c25b), UINT32_C(0x59f111f1),
+  UINT32_C(0x923f82a4), UINT32_C(0xab1c5ed5), UINT32_C(0xd807aa98),
+  UINT32_C(0x12835b01), UINT32_C(0x243185be), UINT32_C(0x550c7dc3),
+  UINT32_C(0x72be5d74), UINT32_C(0x80deb1fe), UINT32_C(0x9bdc06a7),
+  UINT32_C(0xc19bf374), UINT32_C(0x649b69c1), UINT32_C(0xf0fe4786),
+  UINT32_C(0x0fe1edc6), UINT32_C(0x240cf254), UINT32_C(0x4fe9346f),
+  UINT32_C(0x6cc984be), UINT32_C(0x61b9411e), UINT32_C(0x16f988fa),
+  UINT32_C(0xf2c65152), UINT32_C(0xa88e5a6d), UINT32_C(0xb019fc65),
+  UINT32_C(0xb9d99ec7), UINT32_C(0x9a1231c3), UINT32_C(0xe70eeaa0),
+  UINT32_C(0xfdb1232b), UINT32_C(0xc7353eb0), UINT32_C(0x3069bad5),
+  UINT32_C(0xcb976d5f), UINT32_C(0x5a0f118f), UINT32_C(0xdc1eeefd),
+  UINT32_C(0x0a35b689), UINT32_C(0xde0b7a04), UINT32_C(0x58f4ca9d),
+  UINT32_C(0xe15d5b16), UINT32_C(0x007f3e86), UINT32_C(0x37088980),
+  UINT32_C(0xa507ea32), UINT32_C(0x6fab9537), UINT32_C(0x17406110),
+  UINT32_C(0x0d8cd6f1), UINT32_C(0xcdaa3b6d), UINT32_C(0xc0bbbe37),
+  UINT32_C(0x83613bda), UINT32_C(0xdb48a363), UINT32_C(0x0b02e931),
+  UINT32_C(0x6fd15ca7), UINT32_C(0x521afaca), UINT32_C(0x31338431),
+  UINT32_C(0x6ed41a95), UINT32_C(0x6d437890), UINT32_C(0xc39c91f2),
+  UINT32_C(0x9eccabbd), UINT32_C(0xb5c9a0e6), UINT32_C(0x532fb63c),
+  UINT32_C(0xd2c741c6), UINT32_C(0x07237ea3), UINT32_C(0xa4954b68),
+  UINT32_C(0x4c191d76)};
+
+ALIGN(64)
+const sha256_word_t IV256[SHA256_HASH_WORDS_NUM] = {
+  UINT32_C(0x6a09e667), UINT32_C(0xbb67ae85), UINT32_C(0x3c6ef372),
+  UINT32_C(0xa54ff53a), UINT32_C(0x510e527f), UINT32_C(0x9b05688c),
+  UINT32_C(0x1f83d9ab), UINT32_C(0x5be0cd19)};
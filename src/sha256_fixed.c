@@ -0,0 +1,269 @@
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+// SHA256 of messages of a fixed length of 32 or 64 bytes.
+// The padding of such messages is known in advance. A 32 bytes message and its
+// padding fit in a single block, where only the first half is copied from the
+// message. A 64 bytes message is followed by a block that holds only the
+// padding, so the message schedule of that block is constant as well, and it
+// is compressed from the precomputed W[i] + K256[i] (WK256_PAD64) without
+// expanding the schedule.
+
+#include <assert.h>
+
+#include "cpu_features.h"
+#include "sha256_defs.h"
+
+#define MSG32_BYTE_LEN 32
+#define MSG64_BYTE_LEN 64
+
+// The second half of the single block of a 32 bytes message
+ALIGN(64)
+static const uint8_t msg32_pad[SHA256_BLOCK_BYTE_LEN - MSG32_BYTE_LEN] = {
+  SHA256_MSG_END_SYMBOL, [SHA256_BLOCK_BYTE_LEN - MSG32_BYTE_LEN - 2] = 0x01};
+
+// The padding block of a 64 bytes message
+ALIGN(64)
+static const uint8_t msg64_pad_block[SHA256_BLOCK_BYTE_LEN] = {
+  SHA256_MSG_END_SYMBOL, [SHA256_BLOCK_BYTE_LEN - 2] = 0x02};
+
+_INLINE_ void init_state(OUT sha256_state_t *state)
+{
+  for(size_t j = 0; j < SHA256_HASH_WORDS_NUM; j++) {
+    state->w[j] = IV256[j];
+  }
+}
+
+// This implementation assumes running on a Little endian machine
+_INLINE_ void store_dgst(OUT uint8_t *dgst, IN const sha256_state_t *state)
+{
+  for(size_t j = 0; j < SHA256_HASH_WORDS_NUM; j++) {
+    const sha256_word_t w = bswap_32(state->w[j]);
+    my_memcpy(&dgst[j * sizeof(w)], (const uint8_t *)&w, sizeof(w));
+  }
+}
+
+// Compresses the padding block of a 64 bytes message
+_INLINE_ void compress_pad64(IN OUT sha256_state_t *state,
+                             IN const sha_impl_t     impl)
+{
+  switch(impl) {
+#if defined(X86_64_SHA_SUPPORT)
+    case SHA_EXT_IMPL:
+      sha256_compress_wk_x86_64_sha_ext(state, WK256_PAD64);
+      break;
+#endif
+
+    case GENERIC_IMPL: sha256_compress_wk_generic(state, WK256_PAD64); break;
+
+    default: sha256_compress(state, msg64_pad_block, 1, impl); break;
+  }
+}
+
+void sha256_32B(OUT uint8_t *dgst,
+                IN const uint8_t *data,
+                IN const sha_impl_t impl)
+{
+  assert((dgst != NULL) && (data != NULL));
+
+  ALIGN(64) uint8_t block[SHA256_BLOCK_BYTE_LEN];
+  sha256_state_t    s;
+
+  my_memcpy(block, data, MSG32_BYTE_LEN);
+  my_memcpy(&block[MSG32_BYTE_LEN], msg32_pad, sizeof(msg32_pad));
+
+  init_state(&s);
+  sha256_compress(&s, block, 1, sha256_resolve_impl(impl));
+  store_dgst(dgst, &s);
+
+  secure_clean(block, sizeof(block));
+  secure_clean(&s, sizeof(s));
+}
+
+void sha256_64B(OUT uint8_t *dgst,
+                IN const uint8_t *data,
+                IN const sha_impl_t impl)
+{
+  assert((dgst != NULL) && (data != NULL));
+
+  const sha_impl_t single_impl = sha256_resolve_impl(impl);
+  sha256_state_t   s;
+
+  init_state(&s);
+  sha256_compress(&s, data, 1, single_impl);
+  compress_pad64(&s, single_impl);
+  store_dgst(dgst, &s);
+
+  secure_clean(&s, sizeof(s));
+}
+
+typedef struct lanes_s {
+  sha256_multi_compress_t    compress;
+  sha256_multi_compress_wk_t compress_wk;
+  size_t                     lanes_num;
+  sha_impl_t                 single_impl;
+} lanes_t;
+
+// Returns 0 if impl has no multi-buffer implementation
+_INLINE_ int init_lanes(OUT lanes_t *lanes, IN const sha_impl_t impl)
+{
+  const sha_impl_t multi_impl = sha256_multi_resolve_impl(impl);
+
+  lanes->compress    = sha256_multi_compress_func(&lanes->lanes_num, multi_impl);
+  lanes->compress_wk = sha256_multi_compress_wk_func(multi_impl);
+  lanes->single_impl = sha256_resolve_impl(impl);
+
+  return (lanes->compress != NULL);
+}
+
+_INLINE_ void init_lanes_state(OUT sha256_lanes_state_t *state,
+                               IN const size_t           num)
+{
+  for(size_t j = 0; j < SHA256_HASH_WORDS_NUM; j++) {
+    for(size_t l = 0; l < num; l++) {
+      state->w[j][l] = IV256[j];
+    }
+  }
+}
+
+_INLINE_ void store_lanes_dgst(OUT uint8_t *dgst,
+                               IN const sha256_lanes_state_t *state,
+                               IN const size_t                num)
+{
+  for(size_t l = 0; l < num; l++) {
+    for(size_t j = 0; j < SHA256_HASH_WORDS_NUM; j++) {
+      const sha256_word_t w = bswap_32(state->w[j][l]);
+      my_memcpy(&dgst[(l * SHA256_HASH_BYTE_LEN) + (j * sizeof(w))],
+                (const uint8_t *)&w, sizeof(w));
+    }
+  }
+}
+
+// Hashes num <= lanes_num messages of 32 bytes
+_INLINE_ void hash32_lanes(OUT uint8_t *dgst,
+                           IN const uint8_t *data,
+                           IN const size_t   num,
+                           IN const lanes_t *lanes)
+{
+  ALIGN(64) uint8_t block[SHA256_MAX_LANES_NUM][SHA256_BLOCK_BYTE_LEN];
+
+  sha256_lanes_state_t state;
+  const uint8_t *      ptr[SHA256_MAX_LANES_NUM];
+  uint32_t             lanes_mask = 0;
+
+  for(size_t l = 0; l < num; l++) {
+    my_memcpy(block[l], &data[l * MSG32_BYTE_LEN], MSG32_BYTE_LEN);
+    my_memcpy(&block[l][MSG32_BYTE_LEN], msg32_pad, sizeof(msg32_pad));
+
+    ptr[l] = block[l];
+    lanes_mask |= (UINT32_C(1) << l);
+  }
+
+  init_lanes_state(&state, num);
+  lanes->compress(&state, ptr, 1, lanes_mask);
+  store_lanes_dgst(dgst, &state, num);
+
+  secure_clean(block, sizeof(block));
+  secure_clean(&state, sizeof(state));
+}
+
+// Hashes num <= lanes_num messages of 64 bytes. The messages are read in place
+// and only the padding block is compressed differently.
+_INLINE_ void hash64_lanes(OUT uint8_t *dgst,
+                           IN const uint8_t *data,
+                           IN const size_t   num,
+                           IN const lanes_t *lanes)
+{
+  sha256_lanes_state_t state;
+  const uint8_t *      ptr[SHA256_MAX_LANES_NUM];
+  uint32_t             lanes_mask = 0;
+
+  for(size_t l = 0; l < num; l++) {
+    ptr[l] = &data[l * MSG64_BYTE_LEN];
+    lanes_mask |= (UINT32_C(1) << l);
+  }
+
+  init_lanes_state(&state, num);
+  lanes->compress(&state, ptr, 1, lanes_mask);
+
+  if(lanes->compress_wk != NULL) {
+    lanes->compress_wk(&state, WK256_PAD64, lanes_mask);
+  } else {
+    for(size_t l = 0; l < num; l++) {
+      ptr[l] = msg64_pad_block;
+    }
+    lanes->compress(&state, ptr, 1, lanes_mask);
+  }
+
+  store_lanes_dgst(dgst, &state, num);
+
+  secure_clean(&state, sizeof(state));
+}
+
+void sha256_32B_multi(OUT uint8_t *dgst,
+                      IN const uint8_t *data,
+                      IN const size_t   msgs_num,
+                      IN const sha_impl_t impl)
+{
+  assert((dgst != NULL) || (msgs_num == 0));
+  assert((data != NULL) || (msgs_num == 0));
+
+  lanes_t lanes;
+
+  // No multi-buffer implementation, hash the messages one by one
+  if(!init_lanes(&lanes, impl)) {
+    for(size_t i = 0; i < msgs_num; i++) {
+      sha256_32B(&dgst[i * SHA256_HASH_BYTE_LEN], &data[i * MSG32_BYTE_LEN],
+                 lanes.single_impl);
+    }
+    return;
+  }
+
+  for(size_t i = 0; i < msgs_num; i += lanes.lanes_num) {
+    const size_t rem_num = msgs_num - i;
+    const size_t num = (rem_num < lanes.lanes_num) ? rem_num : lanes.lanes_num;
+
+    uint8_t *      out = &dgst[i * SHA256_HASH_BYTE_LEN];
+    const uint8_t *in  = &data[i * MSG32_BYTE_LEN];
+
+    if(num == 1) {
+      sha256_32B(out, in, lanes.single_impl);
+    } else {
+      hash32_lanes(out, in, num, &lanes);
+    }
+  }
+}
+
+void sha256_64B_multi(OUT uint8_t *dgst,
+                      IN const uint8_t *data,
+                      IN const size_t   msgs_num,
+                      IN const sha_impl_t impl)
+{
+  assert((dgst != NULL) || (msgs_num == 0));
+  assert((data != NULL) || (msgs_num == 0));
+
+  lanes_t lanes;
+
+  // No multi-buffer implementation, hash the messages one by one
+  if(!init_lanes(&lanes, impl)) {
+    for(size_t i = 0; i < msgs_num; i++) {
+      sha256_64B(&dgst[i * SHA256_HASH_BYTE_LEN], &data[i * MSG64_BYTE_LEN],
+                 lanes.single_impl);
+    }
+    return;
+  }
+
+  for(size_t i = 0; i < msgs_num; i += lanes.lanes_num) {
+    const size_t rem_num = msgs_num - i;
+    const size_t num = (rem_num < lanes.lanes_num) ? rem_num : lanes.lanes_num;
+
+    uint8_t *      out = &dgst[i * SHA256_HASH_BYTE_LEN];
+    const uint8_t *in  = &data[i * MSG64_BYTE_LEN];
+
+    if(num == 1) {
+      sha256_64B(out, in, lanes.single_impl);
+    } else {
+      hash64_lanes(out, in, num, &lanes);
+    }
+  }
+}
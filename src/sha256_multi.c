@@ -0,0 +1,586 @@
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+// Hashing independent messages in parallel SIMD lanes.
+// Every message is split into two segments: its full blocks, that are read
+// directly from the message, and its padded tail (one or two blocks) that is
+// prepared in advance. The lanes are compressed together as long as they all
+// have blocks left in their current segment. Lanes that finished their
+// segment switch to the tail. A lane that finished its tail swaps its final
+// state out and the next message in, so the lanes stay busy while messages of
+// different lengths complete. Only the lanes of the last messages are masked.
+
+#include <assert.h>
+
+#include "cpu_features.h"
+#include "sha256_defs.h"
+#include "thread_pool.h"
+
+// The padding of a message spans one or two blocks
+#define TAIL_BYTE_LEN (2 * SHA256_BLOCK_BYTE_LEN)
+
+typedef struct lanes_ctx_s {
+  sha256_lanes_state_t state;
+
+  ALIGN(64) uint8_t tail[SHA256_MAX_LANES_NUM][TAIL_BYTE_LEN];
+
+  // The next block of every lane and the number of blocks left in its current
+  // segment (its full blocks or its tail).
+  const uint8_t *ptr[SHA256_MAX_LANES_NUM];
+  size_t         blocks_num[SHA256_MAX_LANES_NUM];
+
+  // The number of blocks of the tail (zero once the lane switched to it)
+  size_t tail_blocks_num[SHA256_MAX_LANES_NUM];
+
+  // The message of every lane
+  size_t msg_idx[SHA256_MAX_LANES_NUM];
+
+  // The final states of the completed messages, until their digests are
+  // written (SHA256d rehashes them together first)
+  sha256_lanes_state_t done;
+  size_t               done_idx[SHA256_MAX_LANES_NUM];
+  size_t               done_num;
+} lanes_ctx_t;
+
+// Copies the last (partial) block of the message into tail and pads it.
+// Returns the number of blocks of the padded tail.
+_INLINE_ size_t pad_tail(OUT uint8_t tail[TAIL_BYTE_LEN],
+                         IN const uint8_t *rem_data,
+                         IN const size_t   rem_byte_len,
+                         IN const size_t   byte_len)
+{
+  // Byteswap the length in bits of the hashed message
+  const uint64_t bswap_len  = bswap_64(8 * (uint64_t)byte_len);
+  const size_t   blocks_num = (rem_byte_len < 56) ? 1 : 2;
+  const size_t   last_qw_pos =
+    (blocks_num * SHA256_BLOCK_BYTE_LEN) - sizeof(bswap_len);
+
+  my_memcpy(tail, rem_data, rem_byte_len);
+  tail[rem_byte_len] = SHA256_MSG_END_SYMBOL;
+  my_memset(&tail[rem_byte_len + 1], 0, TAIL_BYTE_LEN - rem_byte_len - 1);
+  my_memcpy(&tail[last_qw_pos], (const uint8_t *)&bswap_len, sizeof(bswap_len));
+
+  return blocks_num;
+}
+
+_INLINE_ void init_lane(OUT lanes_ctx_t *ctx,
+                        IN const size_t          i,
+                        IN const sha256_state_t *init_state,
+                        IN const size_t          prefix_byte_len,
+                        IN const uint8_t *data,
+                        IN const size_t   byte_len)
+{
+  const size_t full_blocks_num = byte_len >> 6;
+  const size_t rem_byte_len    = byte_len & (SHA256_BLOCK_BYTE_LEN - 1);
+
+  if(init_state == NULL) {
+    ctx->state.w[0][i] = UINT32_C(0x6a09e667);
+    ctx->state.w[1][i] = UINT32_C(0xbb67ae85);
+    ctx->state.w[2][i] = UINT32_C(0x3c6ef372);
+    ctx->state.w[3][i] = UINT32_C(0xa54ff53a);
+    ctx->state.w[4][i] = UINT32_C(0x510e527f);
+    ctx->state.w[5][i] = UINT32_C(0x9b05688c);
+    ctx->state.w[6][i] = UINT32_C(0x1f83d9ab);
+    ctx->state.w[7][i] = UINT32_C(0x5be0cd19);
+  } else {
+    for(size_t j = 0; j < SHA256_HASH_WORDS_NUM; j++) {
+      ctx->state.w[j][i] = init_state->w[j];
+    }
+  }
+
+  ctx->tail_blocks_num[i] = pad_tail(ctx->tail[i], &data[full_blocks_num << 6],
+                                     rem_byte_len, prefix_byte_len + byte_len);
+
+  ctx->ptr[i]        = data;
+  ctx->blocks_num[i] = full_blocks_num;
+
+  if(full_blocks_num == 0) {
+    ctx->ptr[i]             = ctx->tail[i];
+    ctx->blocks_num[i]      = ctx->tail_blocks_num[i];
+    ctx->tail_blocks_num[i] = 0;
+  }
+}
+
+_INLINE_ void advance_lane(IN OUT lanes_ctx_t *ctx,
+                           IN const size_t     i,
+                           IN const size_t     blocks_num)
+{
+  ctx->ptr[i] += blocks_num * SHA256_BLOCK_BYTE_LEN;
+  ctx->blocks_num[i] -= blocks_num;
+
+  if((ctx->blocks_num[i] == 0) && (ctx->tail_blocks_num[i] != 0)) {
+    ctx->ptr[i]             = ctx->tail[i];
+    ctx->blocks_num[i]      = ctx->tail_blocks_num[i];
+    ctx->tail_blocks_num[i] = 0;
+  }
+}
+
+// When a single lane is left there is no gain from the SIMD lanes, and the
+// lane is completed with the (faster) single buffer implementation.
+_INLINE_ void complete_single_lane(IN OUT lanes_ctx_t *ctx,
+                                   IN const size_t     i,
+                                   IN const sha_impl_t impl,
+                                   IN OUT sha_multi_stats_t *stats)
+{
+  sha256_state_t s;
+
+  for(size_t j = 0; j < SHA256_HASH_WORDS_NUM; j++) {
+    s.w[j] = ctx->state.w[j][i];
+  }
+
+  while(ctx->blocks_num[i] != 0) {
+    stats->single_blocks_num += ctx->blocks_num[i];
+    sha256_compress(&s, ctx->ptr[i], ctx->blocks_num[i], impl);
+    advance_lane(ctx, i, ctx->blocks_num[i]);
+  }
+
+  for(size_t j = 0; j < SHA256_HASH_WORDS_NUM; j++) {
+    ctx->state.w[j][i] = s.w[j];
+  }
+
+  secure_clean(&s, sizeof(s));
+}
+
+// SHA256d hashes the digests of the completed messages once more, directly
+// from their final states. A single message is rehashed with the single
+// buffer implementation.
+_INLINE_ void rehash_done(IN OUT lanes_ctx_t *ctx,
+                          IN sha256_multi_rehash_t rehash,
+                          IN const sha_impl_t      single_impl)
+{
+  if(ctx->done_num > 1) {
+    rehash(&ctx->done, (uint32_t)((UINT64_C(1) << ctx->done_num) - 1));
+    return;
+  }
+
+  for(size_t i = 0; i < ctx->done_num; i++) {
+    sha256_state_t s;
+
+    for(size_t j = 0; j < SHA256_HASH_WORDS_NUM; j++) {
+      s.w[j] = ctx->done.w[j][i];
+    }
+
+    sha256_rehash(&s, single_impl);
+
+    for(size_t j = 0; j < SHA256_HASH_WORDS_NUM; j++) {
+      ctx->done.w[j][i] = s.w[j];
+    }
+
+    secure_clean(&s, sizeof(s));
+  }
+}
+
+// Writes the digests of the completed messages. When rehash is not NULL the
+// digests are hashed once more (SHA256d).
+_INLINE_ void flush_done(OUT uint8_t *dgst[],
+                         IN OUT lanes_ctx_t *ctx,
+                         IN sha256_multi_rehash_t rehash,
+                         IN const sha_impl_t      single_impl)
+{
+  if(rehash != NULL) {
+    rehash_done(ctx, rehash, single_impl);
+  }
+
+  // This implementation assumes running on a Little endian machine
+  for(size_t i = 0; i < ctx->done_num; i++) {
+    for(size_t j = 0; j < SHA256_HASH_WORDS_NUM; j++) {
+      const sha256_word_t w = bswap_32(ctx->done.w[j][i]);
+      my_memcpy(&dgst[ctx->done_idx[i]][j * sizeof(w)], (const uint8_t *)&w,
+                sizeof(w));
+    }
+  }
+
+  ctx->done_num = 0;
+}
+
+// Swaps the final state of the completed message of lane i out. The digests
+// are written once lanes_num messages completed.
+_INLINE_ void swap_out_lane(OUT uint8_t *dgst[],
+                            IN OUT lanes_ctx_t *ctx,
+                            IN const size_t     i,
+                            IN const size_t     lanes_num,
+                            IN sha256_multi_rehash_t rehash,
+                            IN const sha_impl_t      single_impl)
+{
+  for(size_t j = 0; j < SHA256_HASH_WORDS_NUM; j++) {
+    ctx->done.w[j][ctx->done_num] = ctx->state.w[j][i];
+  }
+
+  ctx->done_idx[ctx->done_num++] = ctx->msg_idx[i];
+
+  if(ctx->done_num == lanes_num) {
+    flush_done(dgst, ctx, rehash, single_impl);
+  }
+}
+
+// Swaps the next message (if there is one) into lane i
+_INLINE_ void swap_in_lane(IN OUT lanes_ctx_t *ctx,
+                           IN const size_t     i,
+                           IN OUT size_t *     next,
+                           IN const sha256_state_t *init_state[],
+                           IN const size_t          prefix_byte_len,
+                           IN const uint8_t *data[],
+                           IN const size_t   byte_len[],
+                           IN const size_t   msgs_num)
+{
+  const size_t idx = *next;
+
+  ctx->blocks_num[i] = 0;
+  if(idx == msgs_num) {
+    return;
+  }
+
+  init_lane(ctx, i, (init_state == NULL) ? NULL : init_state[idx],
+            prefix_byte_len, data[idx], byte_len[idx]);
+  ctx->msg_idx[i] = idx;
+  *next           = idx + 1;
+}
+
+// Hashes msgs_num messages in lanes_num lanes. When rehash is not NULL the
+// digests are hashed once more (SHA256d).
+_INLINE_ void hash_lanes(OUT uint8_t *dgst[],
+                         IN const sha256_state_t *init_state[],
+                         IN const size_t          prefix_byte_len,
+                         IN const uint8_t *data[],
+                         IN const size_t   byte_len[],
+                         IN const size_t   msgs_num,
+                         IN const size_t   lanes_num,
+                         IN sha256_multi_compress_t compress,
+                         IN sha256_multi_rehash_t   rehash,
+                         IN const sha_impl_t        single_impl,
+                         IN OUT sha_multi_stats_t *stats)
+{
+  lanes_ctx_t ctx;
+  size_t      next = 0;
+
+  ctx.done_num = 0;
+
+  for(size_t i = 0; i < lanes_num; i++) {
+    swap_in_lane(&ctx, i, &next, init_state, prefix_byte_len, data, byte_len,
+                 msgs_num);
+  }
+
+  while(1) {
+    uint32_t lanes_mask  = 0;
+    size_t   active_num  = 0;
+    size_t   last_active = 0;
+    size_t   min_blocks  = 0;
+
+    for(size_t i = 0; i < lanes_num; i++) {
+      if(ctx.blocks_num[i] == 0) {
+        continue;
+      }
+
+      if((active_num == 0) || (ctx.blocks_num[i] < min_blocks)) {
+        min_blocks = ctx.blocks_num[i];
+      }
+
+      lanes_mask |= (UINT32_C(1) << i);
+      last_active = i;
+      active_num++;
+    }
+
+    if(active_num == 0) {
+      break;
+    }
+
+    // The completed lanes are refilled, so a single lane is left only at the
+    // end
+    if(active_num == 1) {
+      complete_single_lane(&ctx, last_active, single_impl, stats);
+      swap_out_lane(dgst, &ctx, last_active, lanes_num, rehash, single_impl);
+      continue;
+    }
+
+    compress(&ctx.state, ctx.ptr, min_blocks, lanes_mask);
+
+    stats->lanes_blocks_num += lanes_num * min_blocks;
+    stats->busy_blocks_num += active_num * min_blocks;
+
+    for(size_t i = 0; i < lanes_num; i++) {
+      if(((lanes_mask >> i) & 1) == 0) {
+        continue;
+      }
+
+      advance_lane(&ctx, i, min_blocks);
+
+      if(ctx.blocks_num[i] == 0) {
+        swap_out_lane(dgst, &ctx, i, lanes_num, rehash, single_impl);
+        swap_in_lane(&ctx, i, &next, init_state, prefix_byte_len, data,
+                     byte_len, msgs_num);
+      }
+    }
+  }
+
+  flush_done(dgst, &ctx, rehash, single_impl);
+
+  secure_clean(&ctx, sizeof(ctx));
+}
+
+sha256_multi_compress_t sha256_multi_compress_func(OUT size_t *lanes_num,
+                                                  IN const sha_impl_t multi_impl)
+{
+  sha256_multi_compress_t compress = NULL;
+
+  *lanes_num = 1;
+
+  switch(multi_impl) {
+#if defined(AVX2_SUPPORT)
+    case AVX2_IMPL:
+      compress   = sha256_multi_compress_x86_64_avx2;
+      *lanes_num = 8;
+      break;
+#endif
+
+#if defined(AVX512_SUPPORT)
+    case AVX512_IMPL:
+      compress   = sha256_multi_compress_x86_64_avx512;
+      *lanes_num = 16;
+      break;
+#endif
+
+#if defined(X86_64_SHA_SUPPORT)
+    case SHA_EXT_IMPL:
+      compress   = sha256_multi_compress_x86_64_sha_ext;
+      *lanes_num = 2;
+      break;
+#endif
+
+#if defined(NEON_SUPPORT)
+    case NEON_IMPL:
+      compress   = sha256_multi_compress_aarch64_neon;
+      *lanes_num = 4;
+      break;
+#endif
+
+#if defined(AARCH64_SVE_SUPPORT)
+    case SVE_IMPL:
+      compress   = sha256_multi_compress_aarch64_sve;
+      *lanes_num = sha256_multi_lanes_num_aarch64_sve();
+      break;
+#endif
+
+    default: break;
+  }
+
+  return compress;
+}
+
+sha256_multi_compress_wk_t sha256_multi_compress_wk_func(
+  IN const sha_impl_t multi_impl)
+{
+  sha256_multi_compress_wk_t compress_wk = NULL;
+
+  switch(multi_impl) {
+#if defined(AVX2_SUPPORT)
+    case AVX2_IMPL:
+      compress_wk = sha256_multi_compress_wk_x86_64_avx2;
+      break;
+#endif
+
+#if defined(AVX512_SUPPORT)
+    case AVX512_IMPL:
+      compress_wk = sha256_multi_compress_wk_x86_64_avx512;
+      break;
+#endif
+
+#if defined(X86_64_SHA_SUPPORT)
+    case SHA_EXT_IMPL:
+      compress_wk = sha256_multi_compress_wk_x86_64_sha_ext;
+      break;
+#endif
+
+#if defined(NEON_SUPPORT)
+    case NEON_IMPL: compress_wk = sha256_multi_compress_wk_aarch64_neon; break;
+#endif
+
+    default: break;
+  }
+
+  return compress_wk;
+}
+
+sha256_multi_rehash_t sha256_multi_rehash_func(IN const sha_impl_t multi_impl)
+{
+  sha256_multi_rehash_t rehash = NULL;
+
+  switch(multi_impl) {
+#if defined(AVX2_SUPPORT)
+    case AVX2_IMPL: rehash = sha256_multi_rehash_x86_64_avx2; break;
+#endif
+
+#if defined(AVX512_SUPPORT)
+    case AVX512_IMPL: rehash = sha256_multi_rehash_x86_64_avx512; break;
+#endif
+
+#if defined(X86_64_SHA_SUPPORT)
+    case SHA_EXT_IMPL: rehash = sha256_multi_rehash_x86_64_sha_ext; break;
+#endif
+
+#if defined(NEON_SUPPORT)
+    case NEON_IMPL: rehash = sha256_multi_rehash_aarch64_neon; break;
+#endif
+
+    default: break;
+  }
+
+  return rehash;
+}
+
+sha256_multi_compress_dgst_t sha256_multi_compress_dgst_func(
+  IN const sha_impl_t multi_impl)
+{
+  sha256_multi_compress_dgst_t compress_dgst = NULL;
+
+  switch(multi_impl) {
+#if defined(AVX2_SUPPORT)
+    case AVX2_IMPL:
+      compress_dgst = sha256_multi_compress_dgst_x86_64_avx2;
+      break;
+#endif
+
+#if defined(AVX512_SUPPORT)
+    case AVX512_IMPL:
+      compress_dgst = sha256_multi_compress_dgst_x86_64_avx512;
+      break;
+#endif
+
+#if defined(X86_64_SHA_SUPPORT)
+    case SHA_EXT_IMPL:
+      compress_dgst = sha256_multi_compress_dgst_x86_64_sha_ext;
+      break;
+#endif
+
+#if defined(NEON_SUPPORT)
+    case NEON_IMPL:
+      compress_dgst = sha256_multi_compress_dgst_aarch64_neon;
+      break;
+#endif
+
+    default: break;
+  }
+
+  return compress_dgst;
+}
+
+// Hashes a single message that continues from init_state
+_INLINE_ void hash_one(OUT uint8_t *dgst,
+                       IN const sha256_state_t *init_state,
+                       IN const size_t          prefix_byte_len,
+                       IN const uint8_t *data,
+                       IN const size_t   byte_len,
+                       IN const sha_impl_t impl)
+{
+  sha256_ctx_t ctx;
+
+  sha256_init(&ctx, impl);
+  if(init_state != NULL) {
+    ctx.state = *init_state;
+    ctx.len   = prefix_byte_len;
+  }
+
+  sha256_update(&ctx, data, byte_len);
+  sha256_final(dgst, &ctx);
+}
+
+// Hashes the messages in parallel lanes, and when double_hash is set hashes
+// their digests once more (SHA256d)
+_INLINE_ void multi_from_states(OUT uint8_t *dgst[],
+                                IN const sha256_state_t *init_state[],
+                                IN const size_t          prefix_byte_len,
+                                IN const uint8_t *data[],
+                                IN const size_t   byte_len[],
+                                IN const size_t   msgs_num,
+                                IN const int      double_hash,
+                                IN const sha_impl_t impl,
+                                IN OUT sha_multi_stats_t *stats)
+{
+  assert((dgst != NULL) && (data != NULL) && (byte_len != NULL));
+  assert((prefix_byte_len & (SHA256_BLOCK_BYTE_LEN - 1)) == 0);
+  assert((init_state != NULL) || (prefix_byte_len == 0));
+
+  const sha_impl_t  multi_impl   = sha256_multi_resolve_impl(impl);
+  size_t            lanes_num    = 1;
+  sha_multi_stats_t unused_stats = {0};
+
+  if(stats == NULL) {
+    stats = &unused_stats;
+  }
+
+  const sha256_multi_compress_t compress =
+    sha256_multi_compress_func(&lanes_num, multi_impl);
+  const sha256_multi_rehash_t rehash =
+    double_hash ? sha256_multi_rehash_func(multi_impl) : NULL;
+
+  // No multi-buffer implementation (or, for SHA256d, no multi-buffer rehash),
+  // hash the messages one by one
+  if((compress == NULL) || (double_hash && (rehash == NULL))) {
+    for(size_t i = 0; i < msgs_num; i++) {
+      stats->single_blocks_num += ((byte_len[i] + 8) >> 6) + 1;
+
+      if(double_hash) {
+        sha256d(dgst[i], data[i], byte_len[i], multi_impl);
+      } else {
+        hash_one(dgst[i], (init_state == NULL) ? NULL : init_state[i],
+                 prefix_byte_len, data[i], byte_len[i], multi_impl);
+      }
+    }
+    return;
+  }
+
+  hash_lanes(dgst, init_state, prefix_byte_len, data, byte_len, msgs_num,
+             lanes_num, compress, rehash, sha256_resolve_impl(impl), stats);
+}
+
+void sha256_multi_from_states(OUT uint8_t *dgst[],
+                              IN const sha256_state_t *init_state[],
+                              IN const size_t          prefix_byte_len,
+                              IN const uint8_t *data[],
+                              IN const size_t   byte_len[],
+                              IN const size_t   msgs_num,
+                              IN const sha_impl_t impl)
+{
+  multi_from_states(dgst, init_state, prefix_byte_len, data, byte_len,
+                    msgs_num, 0, impl, NULL);
+}
+
+void sha256_multi(OUT uint8_t *dgst[],
+                  IN const uint8_t *data[],
+                  IN const size_t   byte_len[],
+                  IN const size_t   msgs_num,
+                  IN const sha_impl_t impl)
+{
+  sha256_multi_from_states(dgst, NULL, 0, data, byte_len, msgs_num, impl);
+}
+
+void sha256_multi_stats(OUT uint8_t *dgst[],
+                        IN const uint8_t *data[],
+                        IN const size_t   byte_len[],
+                        IN const size_t   msgs_num,
+                        IN const sha_impl_t impl,
+                        IN OUT sha_multi_stats_t *stats)
+{
+  assert(stats != NULL);
+
+  multi_from_states(dgst, NULL, 0, data, byte_len, msgs_num, 0, impl, stats);
+}
+
+void sha256d_multi(OUT uint8_t *dgst[],
+                   IN const uint8_t *data[],
+                   IN const size_t   byte_len[],
+                   IN const size_t   msgs_num,
+                   IN const sha_impl_t impl)
+{
+  multi_from_states(dgst, NULL, 0, data, byte_len, msgs_num, 1, impl, NULL);
+}
+
+int sha256_multi_pool(OUT uint8_t *dgst[],
+                      IN const uint8_t *data[],
+                      IN const size_t   byte_len[],
+                      IN const size_t   msgs_num,
+                      IN OUT sha_pool_t *pool,
+                      IN const sha_impl_t impl)
+{
+  return sha_multi_pool(dgst, data, byte_len, msgs_num, pool, sha256_multi,
+                        SHA256_BLOCK_BYTE_LEN, SHA256_PAD_LEN_BYTE_LEN, impl);
+}
@@ -0,0 +1,199 @@
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+// A multi-buffer implementation of the compress function of SHA256 using NEON.
+// Hashes 4 independent messages in parallel (one message per 32-bit lane).
+
+#include "neon_defs.h"
+#include "sha256_defs.h"
+
+typedef uint32x4_t vec_t;
+
+#define LANES_NUM (sizeof(vec_t) / sizeof(sha256_word_t))
+
+#define ADD32(a, b)          (vaddq_u32(a, b))
+#define SET1_32(a)           (vdupq_n_u32(a))
+#define SRL32(a, imm)        (vshrq_n_u32(a, imm))
+#define LANES_ROR32(a, imm8) NEON_ROR32(a, imm8)
+
+// The lanes helper uses only the macros above and the C operators on vectors,
+// so it is shared with the x86-64 implementations. It depends on vec_t and on
+// the macros ADD32, SET1_32, SRL32 and LANES_ROR32.
+#include "sha256_multi_compress_lanes_helper.c"
+
+// Returns a vector whose 32-bit lane i is all ones if bit i of lanes_mask is set
+_INLINE_ vec_t lanes_vmask_of(IN const uint32_t lanes_mask)
+{
+  static const sha256_word_t lanes_bits[LANES_NUM] = {1, 2, 4, 8};
+
+  return vtstq_u32(SET1_32(lanes_mask), vld1q_u32(lanes_bits));
+}
+
+// Transposes the 4x4 matrix of 32-bit words r, so that out[j] holds the j-th
+// word of every row.
+_INLINE_ void transpose_4x4(OUT vec_t out[4], IN const vec_t r[4])
+{
+  const uint64x2_t t0 = vreinterpretq_u64_u32(vtrn1q_u32(r[0], r[1]));
+  const uint64x2_t t1 = vreinterpretq_u64_u32(vtrn2q_u32(r[0], r[1]));
+  const uint64x2_t t2 = vreinterpretq_u64_u32(vtrn1q_u32(r[2], r[3]));
+  const uint64x2_t t3 = vreinterpretq_u64_u32(vtrn2q_u32(r[2], r[3]));
+
+  out[0] = vreinterpretq_u32_u64(vtrn1q_u64(t0, t2));
+  out[1] = vreinterpretq_u32_u64(vtrn1q_u64(t1, t3));
+  out[2] = vreinterpretq_u32_u64(vtrn2q_u64(t0, t2));
+  out[3] = vreinterpretq_u32_u64(vtrn2q_u64(t1, t3));
+}
+
+// Loads the block at offset of every active lane into x (transposed and byte
+// swapped). The words of inactive lanes are set to zero.
+_INLINE_ void load_lanes(OUT vec_t x[16],
+                         IN const uint8_t *data[],
+                         IN const size_t   offset,
+                         IN const uint32_t lanes_mask)
+{
+  vec_t r[LANES_NUM];
+
+  PRAGMA_LOOP_UNROLL_4
+
+  for(size_t j = 0; j < 4; j++) {
+    PRAGMA_LOOP_UNROLL_4
+
+    for(size_t i = 0; i < LANES_NUM; i++) {
+      if((lanes_mask >> i) & 1) {
+        const uint8x16_t d = vld1q_u8(&data[i][offset + (j * sizeof(vec_t))]);
+        r[i]               = vreinterpretq_u32_u8(vrev32q_u8(d));
+      } else {
+        r[i] = SET1_32(0);
+      }
+    }
+
+    transpose_4x4(&x[j * LANES_NUM], r);
+  }
+}
+
+void sha256_multi_compress_aarch64_neon(IN OUT sha256_lanes_state_t *state,
+                                        IN const uint8_t *data[],
+                                        IN size_t         blocks_num,
+                                        IN uint32_t       lanes_mask)
+{
+  const vec_t lanes_vmask = lanes_vmask_of(lanes_mask);
+
+  vec_t s[8];
+  vec_t x[16];
+
+  PRAGMA_LOOP_UNROLL_8
+
+  for(size_t i = 0; i < 8; i++) {
+    s[i] = vld1q_u32(state->w[i]);
+  }
+
+  for(size_t b = 0; b < blocks_num; b++) {
+    load_lanes(x, data, b * SHA256_BLOCK_BYTE_LEN, lanes_mask);
+    lanes_compress_block(s, x, lanes_vmask);
+  }
+
+  PRAGMA_LOOP_UNROLL_8
+
+  for(size_t i = 0; i < 8; i++) {
+    vst1q_u32(state->w[i], s[i]);
+  }
+
+  secure_clean(x, sizeof(x));
+}
+
+void sha256_multi_compress_wk_aarch64_neon(
+  IN OUT sha256_lanes_state_t *state,
+  IN const sha256_word_t wk[SHA256_ROUNDS_NUM],
+  IN uint32_t            lanes_mask)
+{
+  const vec_t lanes_vmask = lanes_vmask_of(lanes_mask);
+
+  vec_t s[8];
+
+  PRAGMA_LOOP_UNROLL_8
+
+  for(size_t i = 0; i < 8; i++) {
+    s[i] = vld1q_u32(state->w[i]);
+  }
+
+  lanes_compress_wk(s, wk, lanes_vmask);
+
+  PRAGMA_LOOP_UNROLL_8
+
+  for(size_t i = 0; i < 8; i++) {
+    vst1q_u32(state->w[i], s[i]);
+  }
+}
+
+void sha256_multi_rehash_aarch64_neon(IN OUT sha256_lanes_state_t *state,
+                                      IN uint32_t lanes_mask)
+{
+  const vec_t lanes_vmask = lanes_vmask_of(lanes_mask);
+
+  vec_t s[8];
+
+  PRAGMA_LOOP_UNROLL_8
+
+  for(size_t i = 0; i < 8; i++) {
+    s[i] = vld1q_u32(state->w[i]);
+  }
+
+  lanes_rehash(s, lanes_vmask);
+
+  PRAGMA_LOOP_UNROLL_8
+
+  for(size_t i = 0; i < 8; i++) {
+    vst1q_u32(state->w[i], s[i]);
+  }
+}
+
+void sha256_multi_compress_dgst_aarch64_neon(
+  IN OUT sha256_lanes_state_t *state,
+  IN const sha256_lanes_state_t *init,
+  IN sha256_word_t               len_word,
+  IN uint32_t                    lanes_mask)
+{
+  const vec_t lanes_vmask = lanes_vmask_of(lanes_mask);
+
+  vec_t s[8];
+  vec_t t[8];
+
+  PRAGMA_LOOP_UNROLL_8
+
+  for(size_t j = 0; j < 8; j++) {
+    s[j] = vld1q_u32(state->w[j]);
+    t[j] = vld1q_u32(init->w[j]);
+  }
+
+  lanes_compress_dgst(s, t, len_word, lanes_vmask);
+
+  PRAGMA_LOOP_UNROLL_8
+
+  for(size_t j = 0; j < 8; j++) {
+    vst1q_u32(state->w[j], s[j]);
+  }
+}
+
+void sha256d_scan_lanes_aarch64_neon(OUT sha256_lanes_state_t *state,
+                                     IN const sha256d_scan_t *scan,
+                                     IN const uint32_t        first_nonce)
+{
+  ALIGN(64) sha256_word_t nonce[LANES_NUM];
+
+  vec_t s[8];
+
+  // The nonce is stored in little endian and W[3] is read in big endian
+  PRAGMA_LOOP_UNROLL_4
+
+  for(size_t l = 0; l < LANES_NUM; l++) {
+    nonce[l] = bswap_32(first_nonce + (uint32_t)l);
+  }
+
+  lanes_scan(s, scan, vld1q_u32(nonce));
+
+  PRAGMA_LOOP_UNROLL_8
+
+  for(size_t i = 0; i < 8; i++) {
+    vst1q_u32(state->w[i], s[i]);
+  }
+}
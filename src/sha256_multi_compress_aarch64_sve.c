@@ -0,0 +1,172 @@
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+// A multi-buffer implementation of the compress function of SHA256 using SVE.
+// Every 32-bit lane of a vector register holds a word of a different message,
+// as in the AVX2/AVX512 implementations, but the code does not depend on the
+// vector length: it hashes as many messages as the vector has 32-bit lanes (up
+// to SHA256_MAX_LANES_NUM). SVE vectors cannot be stored in arrays, so the
+// state is kept in eight variables and the message schedule in memory.
+
+#include <arm_sve.h>
+
+#include "sha256_defs.h"
+
+// The operations use the predicate pg of the enclosing function
+#define ADD(a, b)     svadd_u32_x(pg, a, b)
+#define ROR(a, imm)   \
+  svorr_u32_x(pg, svlsr_n_u32_x(pg, a, imm), svlsl_n_u32_x(pg, a, 32 - (imm)))
+#define SRL(a, imm)   svlsr_n_u32_x(pg, a, imm)
+#define XOR3(a, b, c) sveor_u32_x(pg, sveor_u32_x(pg, a, b), c)
+
+#define SVE_Sigma0(x) XOR3(ROR(x, Sigma0_0), ROR(x, Sigma0_1), ROR(x, Sigma0_2))
+#define SVE_Sigma1(x) XOR3(ROR(x, Sigma1_0), ROR(x, Sigma1_1), ROR(x, Sigma1_2))
+#define SVE_sigma0(x) XOR3(ROR(x, sigma0_0), ROR(x, sigma0_1), SRL(x, sigma0_2))
+#define SVE_sigma1(x) XOR3(ROR(x, sigma1_0), ROR(x, sigma1_1), SRL(x, sigma1_2))
+
+// Equivalent to Ch/Maj of sha256_defs.h with fewer operations
+#define SVE_Ch(x, y, z) \
+  sveor_u32_x(pg, z, svand_u32_x(pg, x, sveor_u32_x(pg, y, z)))
+#define SVE_Maj(x, y, z)                 \
+  svorr_u32_x(pg, svand_u32_x(pg, x, y), \
+              svand_u32_x(pg, z, svorr_u32_x(pg, x, y)))
+
+// The rotation of the state is done by renaming the variables
+#define LANES_ROUND(a, b, c, d, e, f, g, h, i)                             \
+  do {                                                                     \
+    const svuint32_t x = ADD(schedule(pg, ms, i), svdup_u32(K256[i]));     \
+    const svuint32_t t1 =                                                  \
+      ADD(ADD(h, SVE_Sigma1(e)), ADD(SVE_Ch(e, f, g), x));                 \
+    const svuint32_t t2 = ADD(SVE_Sigma0(a), SVE_Maj(a, b, c));            \
+                                                                           \
+    d = ADD(d, t1);                                                        \
+    h = ADD(t1, t2);                                                       \
+  } while(0)
+
+size_t sha256_multi_lanes_num_aarch64_sve(void)
+{
+  const size_t lanes_num = svcntw();
+
+  return (lanes_num < SHA256_MAX_LANES_NUM) ? lanes_num
+                                            : SHA256_MAX_LANES_NUM;
+}
+
+// Returns W[i] of every lane. For i >= 16, W[i] is computed and replaces
+// W[i - 16] in ms.
+_INLINE_ svuint32_t schedule(IN const svbool_t    pg,
+                             IN OUT sha256_word_t ms[][SHA256_MAX_LANES_NUM],
+                             IN const size_t      i)
+{
+  if(i < SHA256_BLOCK_WORDS_NUM) {
+    return svld1_u32(pg, ms[i]);
+  }
+
+  const svuint32_t w0  = svld1_u32(pg, ms[LSB4(i)]);
+  const svuint32_t w1  = svld1_u32(pg, ms[LSB4(i + 1)]);
+  const svuint32_t w9  = svld1_u32(pg, ms[LSB4(i + 9)]);
+  const svuint32_t w14 = svld1_u32(pg, ms[LSB4(i + 14)]);
+  const svuint32_t w   = ADD(ADD(w0, SVE_sigma0(w1)), ADD(SVE_sigma1(w14), w9));
+
+  svst1_u32(pg, ms[LSB4(i)], w);
+  return w;
+}
+
+// Loads the block at offset of every active lane into ms (transposed and byte
+// swapped). The words of inactive lanes are set to zero.
+_INLINE_ void load_lanes(OUT sha256_word_t ms[][SHA256_MAX_LANES_NUM],
+                         IN const svbool_t pg,
+                         IN const uint8_t *data[],
+                         IN const size_t   offset,
+                         IN const size_t   lanes_num,
+                         IN const uint32_t lanes_mask)
+{
+  for(size_t i = 0; i < lanes_num; i++) {
+    sha256_word_t w[SHA256_BLOCK_WORDS_NUM] = {0};
+
+    if((lanes_mask >> i) & 1) {
+      my_memcpy(w, &data[i][offset], SHA256_BLOCK_BYTE_LEN);
+    }
+
+    for(size_t j = 0; j < SHA256_BLOCK_WORDS_NUM; j++) {
+      ms[j][i] = w[j];
+    }
+  }
+
+  for(size_t j = 0; j < SHA256_BLOCK_WORDS_NUM; j++) {
+    svst1_u32(pg, ms[j], svrevb_u32_x(pg, svld1_u32(pg, ms[j])));
+  }
+}
+
+void sha256_multi_compress_aarch64_sve(IN OUT sha256_lanes_state_t *state,
+                                       IN const uint8_t *data[],
+                                       IN size_t         blocks_num,
+                                       IN uint32_t       lanes_mask)
+{
+  ALIGN(64) sha256_word_t ms[SHA256_BLOCK_WORDS_NUM][SHA256_MAX_LANES_NUM];
+
+  const size_t   lanes_num = sha256_multi_lanes_num_aarch64_sve();
+  const svbool_t pg        = svwhilelt_b32_u64(0, lanes_num);
+
+  // Lane i is active if bit i of lanes_mask is set
+  const svuint32_t lanes_bits =
+    svlsl_u32_x(pg, svdup_u32(1), svindex_u32(0, 1));
+  const svbool_t active = svcmpne_n_u32(
+    pg, svand_u32_x(pg, svdup_u32(lanes_mask), lanes_bits), 0);
+
+  svuint32_t a = svld1_u32(pg, state->w[0]);
+  svuint32_t b = svld1_u32(pg, state->w[1]);
+  svuint32_t c = svld1_u32(pg, state->w[2]);
+  svuint32_t d = svld1_u32(pg, state->w[3]);
+  svuint32_t e = svld1_u32(pg, state->w[4]);
+  svuint32_t f = svld1_u32(pg, state->w[5]);
+  svuint32_t g = svld1_u32(pg, state->w[6]);
+  svuint32_t h = svld1_u32(pg, state->w[7]);
+
+  for(size_t blk = 0; blk < blocks_num; blk++) {
+    const svuint32_t a0 = a;
+    const svuint32_t b0 = b;
+    const svuint32_t c0 = c;
+    const svuint32_t d0 = d;
+    const svuint32_t e0 = e;
+    const svuint32_t f0 = f;
+    const svuint32_t g0 = g;
+    const svuint32_t h0 = h;
+
+    load_lanes(ms, pg, data, blk * SHA256_BLOCK_BYTE_LEN, lanes_num,
+               lanes_mask);
+
+    PRAGMA_LOOP_UNROLL_8
+
+    for(size_t i = 0; i < SHA256_ROUNDS_NUM; i += 8) {
+      LANES_ROUND(a, b, c, d, e, f, g, h, i + 0);
+      LANES_ROUND(h, a, b, c, d, e, f, g, i + 1);
+      LANES_ROUND(g, h, a, b, c, d, e, f, i + 2);
+      LANES_ROUND(f, g, h, a, b, c, d, e, i + 3);
+      LANES_ROUND(e, f, g, h, a, b, c, d, i + 4);
+      LANES_ROUND(d, e, f, g, h, a, b, c, i + 5);
+      LANES_ROUND(c, d, e, f, g, h, a, b, i + 6);
+      LANES_ROUND(b, c, d, e, f, g, h, a, i + 7);
+    }
+
+    // The state of an inactive lane is not modified
+    a = svsel_u32(active, ADD(a, a0), a0);
+    b = svsel_u32(active, ADD(b, b0), b0);
+    c = svsel_u32(active, ADD(c, c0), c0);
+    d = svsel_u32(active, ADD(d, d0), d0);
+    e = svsel_u32(active, ADD(e, e0), e0);
+    f = svsel_u32(active, ADD(f, f0), f0);
+    g = svsel_u32(active, ADD(g, g0), g0);
+    h = svsel_u32(active, ADD(h, h0), h0);
+  }
+
+  svst1_u32(pg, state->w[0], a);
+  svst1_u32(pg, state->w[1], b);
+  svst1_u32(pg, state->w[2], c);
+  svst1_u32(pg, state->w[3], d);
+  svst1_u32(pg, state->w[4], e);
+  svst1_u32(pg, state->w[5], f);
+  svst1_u32(pg, state->w[6], g);
+  svst1_u32(pg, state->w[7], h);
+
+  secure_clean(ms, sizeof(ms));
+}
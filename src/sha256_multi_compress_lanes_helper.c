@@ -0,0 +1,243 @@
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+// A multi-buffer implementation of the compress function of SHA256.
+// Every 32-bit lane of a vector register holds a word of a different message.
+// Therefore, unlike the single buffer AVX* implementations that only vectorize
+// the message schedule, here all the 64 rounds are computed in SIMD.
+
+// This file depends on vec_t and on the macros ADD32, SET1_32 and LANES_ROR32.
+// The including file may also define LANES_XOR3, LANES_Ch and LANES_Maj with
+// instructions that compute them at once (e.g., the AVX512 VPTERNLOG).
+
+#if !defined(LANES_XOR3)
+#  define LANES_XOR3(a, b, c) ((a) ^ (b) ^ (c))
+#endif
+
+// Equivalent to Ch/Maj of sha256_defs.h with fewer operations
+#if !defined(LANES_Ch)
+#  define LANES_Ch(x, y, z)  ((z) ^ ((x) & ((y) ^ (z))))
+#  define LANES_Maj(x, y, z) (((x) & (y)) | ((z) & ((x) | (y))))
+#endif
+
+#define LANES_Sigma0(x) \
+  LANES_XOR3(LANES_ROR32(x, Sigma0_0), LANES_ROR32(x, Sigma0_1), \
+             LANES_ROR32(x, Sigma0_2))
+#define LANES_Sigma1(x) \
+  LANES_XOR3(LANES_ROR32(x, Sigma1_0), LANES_ROR32(x, Sigma1_1), \
+             LANES_ROR32(x, Sigma1_2))
+#define LANES_sigma0(x) \
+  LANES_XOR3(LANES_ROR32(x, sigma0_0), LANES_ROR32(x, sigma0_1), \
+             SRL32(x, sigma0_2))
+#define LANES_sigma1(x) \
+  LANES_XOR3(LANES_ROR32(x, sigma1_0), LANES_ROR32(x, sigma1_1), \
+             SRL32(x, sigma1_2))
+
+_INLINE_ void lanes_round(IN OUT vec_t s[8],
+                          IN const vec_t         x,
+                          IN const sha256_word_t k)
+{
+  const vec_t t1 = ADD32(ADD32(s[7], LANES_Sigma1(s[4])),
+                         ADD32(LANES_Ch(s[4], s[5], s[6]), ADD32(x, SET1_32(k))));
+  const vec_t t2 = ADD32(LANES_Sigma0(s[0]), LANES_Maj(s[0], s[1], s[2]));
+
+  // The compiler eliminates these moves when the rounds are unrolled
+  s[7] = s[6];
+  s[6] = s[5];
+  s[5] = s[4];
+  s[4] = ADD32(s[3], t1);
+  s[3] = s[2];
+  s[2] = s[1];
+  s[1] = s[0];
+  s[0] = ADD32(t1, t2);
+}
+
+// Compresses one block of every lane. x holds the (transposed and byte
+// swapped) block words and is overwritten by the message schedule.
+// The lanes of lanes_vmask that are zero are not accumulated into state.
+_INLINE_ void lanes_compress_block(IN OUT vec_t state[8],
+                                   IN OUT vec_t x[16],
+                                   IN const vec_t lanes_vmask)
+{
+  vec_t s[8];
+
+  PRAGMA_LOOP_UNROLL_8
+
+  for(size_t i = 0; i < 8; i++) {
+    s[i] = state[i];
+  }
+
+  PRAGMA_LOOP_UNROLL_16
+
+  for(size_t i = 0; i < SHA256_BLOCK_WORDS_NUM; i++) {
+    lanes_round(s, x[i], K256[i]);
+  }
+
+  PRAGMA_LOOP_UNROLL_48
+
+  for(size_t i = SHA256_BLOCK_WORDS_NUM; i < SHA256_ROUNDS_NUM; i++) {
+    x[LSB4(i)] = ADD32(ADD32(x[LSB4(i)], LANES_sigma0(x[LSB4(i + 1)])),
+                       ADD32(LANES_sigma1(x[LSB4(i + 14)]), x[LSB4(i + 9)]));
+    lanes_round(s, x[LSB4(i)], K256[i]);
+  }
+
+  PRAGMA_LOOP_UNROLL_8
+
+  for(size_t i = 0; i < 8; i++) {
+    state[i] = ADD32(state[i], s[i] & lanes_vmask);
+  }
+}
+
+// Compresses a block whose message schedule is the same in every lane and is
+// known in advance (see sha256_compress_wk_generic). Only the rounds are
+// computed.
+_INLINE_ void lanes_compress_wk(IN OUT vec_t state[8],
+                                IN const sha256_word_t wk[SHA256_ROUNDS_NUM],
+                                IN const vec_t         lanes_vmask)
+{
+  vec_t s[8];
+
+  PRAGMA_LOOP_UNROLL_8
+
+  for(size_t i = 0; i < 8; i++) {
+    s[i] = state[i];
+  }
+
+  PRAGMA_LOOP_UNROLL_64
+
+  for(size_t i = 0; i < SHA256_ROUNDS_NUM; i++) {
+    lanes_round(s, SET1_32(wk[i]), 0);
+  }
+
+  PRAGMA_LOOP_UNROLL_8
+
+  for(size_t i = 0; i < 8; i++) {
+    state[i] = ADD32(state[i], s[i] & lanes_vmask);
+  }
+}
+
+// Compresses, in every lane, the block that holds the digest in the state of
+// the lane and the padding of a message of len_word bits, starting from the
+// state of the lane in init (see sha256_compress_dgst_generic). The state
+// words of a lane are the message words of its digest block, and are already
+// transposed in state. The lanes of lanes_vmask that are zero are not
+// modified.
+_INLINE_ void lanes_compress_dgst(IN OUT vec_t state[8],
+                                  IN const vec_t         init[8],
+                                  IN const sha256_word_t len_word,
+                                  IN const vec_t         lanes_vmask)
+{
+  const vec_t all_lanes = SET1_32(-1);
+  const vec_t zero      = SET1_32(0);
+
+  vec_t s[8];
+  vec_t x[16];
+
+  PRAGMA_LOOP_UNROLL_8
+
+  for(size_t i = 0; i < 8; i++) {
+    x[i] = state[i];
+    s[i] = init[i];
+  }
+
+  x[8] = SET1_32(SHA256_DGST_PAD_END_WORD);
+
+  PRAGMA_LOOP_UNROLL_8
+
+  for(size_t i = 9; i < 15; i++) {
+    x[i] = zero;
+  }
+
+  x[15] = SET1_32(len_word);
+
+  lanes_compress_block(s, x, all_lanes);
+
+  PRAGMA_LOOP_UNROLL_8
+
+  for(size_t i = 0; i < 8; i++) {
+    state[i] = (s[i] & lanes_vmask) | (state[i] & ~lanes_vmask);
+  }
+
+  secure_clean(x, sizeof(x));
+}
+
+// Rehashes the state of every lane (see sha256_rehash_generic). The lanes of
+// lanes_vmask that are zero are not modified.
+_INLINE_ void lanes_rehash(IN OUT vec_t state[8], IN const vec_t lanes_vmask)
+{
+  vec_t iv[8];
+
+  PRAGMA_LOOP_UNROLL_8
+
+  for(size_t i = 0; i < 8; i++) {
+    iv[i] = SET1_32(IV256[i]);
+  }
+
+  lanes_compress_dgst(state, iv, SHA256_DGST_PAD_LEN_WORD, lanes_vmask);
+}
+
+// Computes the final SHA256d states of the header of scan with the nonce words
+// (W[3] of the second block) in the lanes of nonce. The rounds 0-2 of the
+// second block and W[16..17] are taken from scan, the constant padding words
+// W[4..15] are known at compile time, and the second hash is computed with
+// lanes_rehash.
+_INLINE_ void lanes_scan(OUT vec_t state[8],
+                         IN const sha256d_scan_t *scan,
+                         IN const vec_t           nonce)
+{
+  const vec_t all_lanes = SET1_32(-1);
+
+  vec_t s[8];
+  vec_t x[16];
+
+  PRAGMA_LOOP_UNROLL_8
+
+  for(size_t i = 0; i < 8; i++) {
+    s[i] = SET1_32(scan->pre_rounds.w[i]);
+  }
+
+  // W[0..2] are used only by W[16..18], which are taken from scan
+  x[SHA256D_SCAN_NONCE_WORD_IDX] = nonce;
+  x[4]                           = SET1_32(SHA256D_SCAN_PAD_END_WORD);
+
+  PRAGMA_LOOP_UNROLL_8
+
+  for(size_t i = 5; i < 15; i++) {
+    x[i] = SET1_32(0);
+  }
+
+  x[15] = SET1_32(SHA256D_SCAN_PAD_LEN_WORD);
+
+  PRAGMA_LOOP_UNROLL_16
+
+  for(size_t i = SHA256D_SCAN_NONCE_WORD_IDX; i < SHA256_BLOCK_WORDS_NUM; i++) {
+    lanes_round(s, x[i], K256[i]);
+  }
+
+  x[0] = SET1_32(scan->pre_w[0]);
+  x[1] = SET1_32(scan->pre_w[1]);
+  x[2] = ADD32(SET1_32(scan->pre_w[2]), LANES_sigma0(nonce));
+  x[3] = ADD32(SET1_32(scan->pre_w[3]), nonce);
+
+  PRAGMA_LOOP_UNROLL_4
+
+  for(size_t i = 16; i < 20; i++) {
+    lanes_round(s, x[LSB4(i)], K256[i]);
+  }
+
+  PRAGMA_LOOP_UNROLL_48
+
+  for(size_t i = 20; i < SHA256_ROUNDS_NUM; i++) {
+    x[LSB4(i)] = ADD32(ADD32(x[LSB4(i)], LANES_sigma0(x[LSB4(i + 1)])),
+                       ADD32(LANES_sigma1(x[LSB4(i + 14)]), x[LSB4(i + 9)]));
+    lanes_round(s, x[LSB4(i)], K256[i]);
+  }
+
+  PRAGMA_LOOP_UNROLL_8
+
+  for(size_t i = 0; i < 8; i++) {
+    state[i] = ADD32(SET1_32(scan->mid.w[i]), s[i]);
+  }
+
+  lanes_rehash(state, all_lanes);
+}
@@ -0,0 +1,226 @@
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+// A multi-buffer implementation of the compress function of SHA256 using avx2.
+// Hashes 8 independent messages in parallel (one message per 32-bit lane).
+
+#include "internal/avx2_defs.h"
+#include "sha256_defs.h"
+
+#define LANES_NUM (sizeof(vec_t) / sizeof(sha256_word_t))
+
+// AVX2 has no rotate instruction, it is available only with AVX512VL
+#if defined(ALTERNATIVE_AVX512_IMPL)
+#  define LANES_ROR32(a, imm8) ROR32(a, imm8)
+#else
+#  define LANES_ROR32(a, imm8) (SRL32(a, imm8) | SLL32(a, 32 - (imm8)))
+#endif
+
+// This file depends on vec_t and on the macros ADD32, SET1_32, SRL32 and
+// LANES_ROR32
+#include "sha256_multi_compress_lanes_helper.c"
+
+// Transposes the 8x8 matrix of 32-bit words r, so that out[j] holds the j-th
+// word of every row.
+_INLINE_ void transpose_8x8(OUT vec_t out[8], IN const vec_t r[8])
+{
+  vec_t t[8];
+  vec_t u[8];
+
+  // t[2i]   = r[2i][0], r[2i+1][0], r[2i][1], r[2i+1][1] (and words 4,5)
+  // t[2i+1] = r[2i][2], r[2i+1][2], r[2i][3], r[2i+1][3] (and words 6,7)
+  PRAGMA_LOOP_UNROLL_4
+
+  for(size_t i = 0; i < 4; i++) {
+    t[2 * i]     = _mm256_unpacklo_epi32(r[2 * i], r[2 * i + 1]);
+    t[2 * i + 1] = _mm256_unpackhi_epi32(r[2 * i], r[2 * i + 1]);
+  }
+
+  // u[4i+j] holds the words j and j+4 of the rows 4i..4i+3
+  PRAGMA_LOOP_UNROLL_2
+
+  for(size_t i = 0; i < 2; i++) {
+    u[4 * i + 0] = _mm256_unpacklo_epi64(t[4 * i], t[4 * i + 2]);
+    u[4 * i + 1] = _mm256_unpackhi_epi64(t[4 * i], t[4 * i + 2]);
+    u[4 * i + 2] = _mm256_unpacklo_epi64(t[4 * i + 1], t[4 * i + 3]);
+    u[4 * i + 3] = _mm256_unpackhi_epi64(t[4 * i + 1], t[4 * i + 3]);
+  }
+
+  PRAGMA_LOOP_UNROLL_4
+
+  for(size_t j = 0; j < 4; j++) {
+    out[j]     = _mm256_permute2x128_si256(u[j], u[4 + j], 0x20);
+    out[j + 4] = _mm256_permute2x128_si256(u[j], u[4 + j], 0x31);
+  }
+}
+
+// Loads the block at offset of every active lane into x (transposed and byte
+// swapped). The words of inactive lanes are set to zero.
+_INLINE_ void load_lanes(OUT vec_t x[16],
+                         IN const uint8_t *data[],
+                         IN const size_t   offset,
+                         IN const uint32_t lanes_mask)
+{
+  // 32 bits (4 bytes) swap masks
+  const vec_t shuf_mask =
+    _mm256_setr_epi32(DUP2(0x00010203, 0x04050607, 0x08090a0b, 0x0c0d0e0f));
+
+  vec_t r[LANES_NUM];
+
+  PRAGMA_LOOP_UNROLL_2
+
+  for(size_t j = 0; j < 2; j++) {
+    PRAGMA_LOOP_UNROLL_8
+
+    for(size_t i = 0; i < LANES_NUM; i++) {
+      if((lanes_mask >> i) & 1) {
+        r[i] = LOAD(&data[i][offset + (j * sizeof(vec_t))]);
+      } else {
+        r[i] = _mm256_setzero_si256();
+      }
+    }
+
+    transpose_8x8(&x[j * LANES_NUM], r);
+  }
+
+  PRAGMA_LOOP_UNROLL_16
+
+  for(size_t i = 0; i < SHA256_BLOCK_WORDS_NUM; i++) {
+    x[i] = SHUF8(x[i], shuf_mask);
+  }
+}
+
+void sha256_multi_compress_x86_64_avx2(IN OUT sha256_lanes_state_t *state,
+                                       IN const uint8_t *data[],
+                                       IN size_t         blocks_num,
+                                       IN uint32_t       lanes_mask)
+{
+  const vec_t lanes_bits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+  const vec_t lanes_vmask =
+    _mm256_cmpeq_epi32(SET1_32(lanes_mask) & lanes_bits, lanes_bits);
+
+  vec_t s[8];
+  vec_t x[16];
+
+  PRAGMA_LOOP_UNROLL_8
+
+  for(size_t i = 0; i < 8; i++) {
+    s[i] = LOAD(state->w[i]);
+  }
+
+  for(size_t b = 0; b < blocks_num; b++) {
+    load_lanes(x, data, b * SHA256_BLOCK_BYTE_LEN, lanes_mask);
+    lanes_compress_block(s, x, lanes_vmask);
+  }
+
+  PRAGMA_LOOP_UNROLL_8
+
+  for(size_t i = 0; i < 8; i++) {
+    STORE(state->w[i], s[i]);
+  }
+
+  secure_clean(x, sizeof(x));
+}
+
+void sha256_multi_compress_wk_x86_64_avx2(
+  IN OUT sha256_lanes_state_t *state,
+  IN const sha256_word_t wk[SHA256_ROUNDS_NUM],
+  IN uint32_t            lanes_mask)
+{
+  const vec_t lanes_bits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+  const vec_t lanes_vmask =
+    _mm256_cmpeq_epi32(SET1_32(lanes_mask) & lanes_bits, lanes_bits);
+
+  vec_t s[8];
+
+  PRAGMA_LOOP_UNROLL_8
+
+  for(size_t i = 0; i < 8; i++) {
+    s[i] = LOAD(state->w[i]);
+  }
+
+  lanes_compress_wk(s, wk, lanes_vmask);
+
+  PRAGMA_LOOP_UNROLL_8
+
+  for(size_t i = 0; i < 8; i++) {
+    STORE(state->w[i], s[i]);
+  }
+}
+
+void sha256_multi_rehash_x86_64_avx2(IN OUT sha256_lanes_state_t *state,
+                                     IN uint32_t lanes_mask)
+{
+  const vec_t lanes_bits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+  const vec_t lanes_vmask =
+    _mm256_cmpeq_epi32(SET1_32(lanes_mask) & lanes_bits, lanes_bits);
+
+  vec_t s[8];
+
+  PRAGMA_LOOP_UNROLL_8
+
+  for(size_t i = 0; i < 8; i++) {
+    s[i] = LOAD(state->w[i]);
+  }
+
+  lanes_rehash(s, lanes_vmask);
+
+  PRAGMA_LOOP_UNROLL_8
+
+  for(size_t i = 0; i < 8; i++) {
+    STORE(state->w[i], s[i]);
+  }
+}
+
+void sha256_multi_compress_dgst_x86_64_avx2(
+  IN OUT sha256_lanes_state_t *state,
+  IN const sha256_lanes_state_t *init,
+  IN sha256_word_t               len_word,
+  IN uint32_t                    lanes_mask)
+{
+  const vec_t lanes_bits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+  const vec_t lanes_vmask =
+    _mm256_cmpeq_epi32(SET1_32(lanes_mask) & lanes_bits, lanes_bits);
+
+  vec_t s[8];
+  vec_t t[8];
+
+  PRAGMA_LOOP_UNROLL_8
+
+  for(size_t j = 0; j < 8; j++) {
+    s[j] = LOAD(state->w[j]);
+    t[j] = LOAD(init->w[j]);
+  }
+
+  lanes_compress_dgst(s, t, len_word, lanes_vmask);
+
+  PRAGMA_LOOP_UNROLL_8
+
+  for(size_t j = 0; j < 8; j++) {
+    STORE(state->w[j], s[j]);
+  }
+}
+
+void sha256d_scan_lanes_x86_64_avx2(OUT sha256_lanes_state_t *state,
+                                    IN const sha256d_scan_t *scan,
+                                    IN const uint32_t        first_nonce)
+{
+  ALIGN(64) sha256_word_t nonce[LANES_NUM];
+
+  vec_t s[8];
+
+  // The nonce is stored in little endian and W[3] is read in big endian
+  PRAGMA_LOOP_UNROLL_8
+
+  for(size_t l = 0; l < LANES_NUM; l++) {
+    nonce[l] = bswap_32(first_nonce + (uint32_t)l);
+  }
+
+  lanes_scan(s, scan, LOAD(nonce));
+
+  PRAGMA_LOOP_UNROLL_8
+
+  for(size_t i = 0; i < 8; i++) {
+    STORE(state->w[i], s[i]);
+  }
+}
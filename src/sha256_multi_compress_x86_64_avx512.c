@@ -0,0 +1,221 @@
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+// A multi-buffer implementation of the compress function of SHA256 using
+// avx512. Hashes 16 independent messages in parallel (one message per 32-bit
+// lane). Every round is computed in SIMD: the sigmas with VPRORD and a
+// three-input XOR, and Ch/Maj with a single VPTERNLOGD each.
+
+#include "internal/avx512_defs.h"
+#include "sha256_defs.h"
+
+#define LANES_NUM            (sizeof(vec_t) / sizeof(sha256_word_t))
+#define LANES_ROR32(a, imm8) ROR32(a, imm8)
+
+// The immediates are the truth tables of the functions of (a, b, c)
+#define LANES_XOR3(a, b, c) (_mm512_ternarylogic_epi32(a, b, c, 0x96))
+#define LANES_Ch(x, y, z)   (_mm512_ternarylogic_epi32(x, y, z, 0xca))
+#define LANES_Maj(x, y, z)  (_mm512_ternarylogic_epi32(x, y, z, 0xe8))
+
+// This file depends on vec_t and on the macros ADD32, SET1_32, SRL32,
+// LANES_ROR32 and optionally LANES_XOR3, LANES_Ch and LANES_Maj
+#include "sha256_multi_compress_lanes_helper.c"
+
+// Transposes the 16x16 matrix of 32-bit words r, so that out[j] holds the j-th
+// word of every row.
+_INLINE_ void transpose_16x16(OUT vec_t out[16], IN const vec_t r[16])
+{
+  vec_t t[16];
+  vec_t u[16];
+
+  PRAGMA_LOOP_UNROLL_8
+
+  for(size_t i = 0; i < 8; i++) {
+    t[2 * i]     = _mm512_unpacklo_epi32(r[2 * i], r[2 * i + 1]);
+    t[2 * i + 1] = _mm512_unpackhi_epi32(r[2 * i], r[2 * i + 1]);
+  }
+
+  // In every 128-bit value k, u[4i+j] holds the word 4k+j of the rows 4i..4i+3
+  PRAGMA_LOOP_UNROLL_4
+
+  for(size_t i = 0; i < 4; i++) {
+    u[4 * i + 0] = _mm512_unpacklo_epi64(t[4 * i], t[4 * i + 2]);
+    u[4 * i + 1] = _mm512_unpackhi_epi64(t[4 * i], t[4 * i + 2]);
+    u[4 * i + 2] = _mm512_unpacklo_epi64(t[4 * i + 1], t[4 * i + 3]);
+    u[4 * i + 3] = _mm512_unpackhi_epi64(t[4 * i + 1], t[4 * i + 3]);
+  }
+
+  // Transpose the 4x4 matrices of 128-bit values
+  PRAGMA_LOOP_UNROLL_4
+
+  for(size_t j = 0; j < 4; j++) {
+    const vec_t v0 = _mm512_shuffle_i32x4(u[j], u[4 + j], 0x44);
+    const vec_t v1 = _mm512_shuffle_i32x4(u[j], u[4 + j], 0xee);
+    const vec_t v2 = _mm512_shuffle_i32x4(u[8 + j], u[12 + j], 0x44);
+    const vec_t v3 = _mm512_shuffle_i32x4(u[8 + j], u[12 + j], 0xee);
+
+    out[j]      = _mm512_shuffle_i32x4(v0, v2, 0x88);
+    out[j + 4]  = _mm512_shuffle_i32x4(v0, v2, 0xdd);
+    out[j + 8]  = _mm512_shuffle_i32x4(v1, v3, 0x88);
+    out[j + 12] = _mm512_shuffle_i32x4(v1, v3, 0xdd);
+  }
+}
+
+// Loads the block at offset of every active lane into x (transposed and byte
+// swapped). The words of inactive lanes are set to zero.
+_INLINE_ void load_lanes(OUT vec_t x[16],
+                         IN const uint8_t *data[],
+                         IN const size_t   offset,
+                         IN const uint32_t lanes_mask)
+{
+  // 32 bits (4 bytes) swap masks
+  const vec_t shuf_mask =
+    _mm512_set_epi32(DUP4(0x0c0d0e0f, 0x08090a0b, 0x04050607, 0x00010203));
+
+  vec_t r[LANES_NUM];
+
+  PRAGMA_LOOP_UNROLL_16
+
+  for(size_t i = 0; i < LANES_NUM; i++) {
+    if((lanes_mask >> i) & 1) {
+      r[i] = LOAD(&data[i][offset]);
+    } else {
+      r[i] = _mm512_setzero_si512();
+    }
+  }
+
+  transpose_16x16(x, r);
+
+  PRAGMA_LOOP_UNROLL_16
+
+  for(size_t i = 0; i < SHA256_BLOCK_WORDS_NUM; i++) {
+    x[i] = SHUF8(x[i], shuf_mask);
+  }
+}
+
+void sha256_multi_compress_x86_64_avx512(IN OUT sha256_lanes_state_t *state,
+                                         IN const uint8_t *data[],
+                                         IN size_t         blocks_num,
+                                         IN uint32_t       lanes_mask)
+{
+  const vec_t lanes_vmask = _mm512_maskz_set1_epi32((__mmask16)lanes_mask, -1);
+
+  vec_t s[8];
+  vec_t x[16];
+
+  PRAGMA_LOOP_UNROLL_8
+
+  for(size_t i = 0; i < 8; i++) {
+    s[i] = LOAD(state->w[i]);
+  }
+
+  for(size_t b = 0; b < blocks_num; b++) {
+    load_lanes(x, data, b * SHA256_BLOCK_BYTE_LEN, lanes_mask);
+    lanes_compress_block(s, x, lanes_vmask);
+  }
+
+  PRAGMA_LOOP_UNROLL_8
+
+  for(size_t i = 0; i < 8; i++) {
+    STORE(state->w[i], s[i]);
+  }
+
+  secure_clean(x, sizeof(x));
+}
+
+void sha256_multi_compress_wk_x86_64_avx512(
+  IN OUT sha256_lanes_state_t *state,
+  IN const sha256_word_t wk[SHA256_ROUNDS_NUM],
+  IN uint32_t            lanes_mask)
+{
+  const vec_t lanes_vmask = _mm512_maskz_set1_epi32((__mmask16)lanes_mask, -1);
+
+  vec_t s[8];
+
+  PRAGMA_LOOP_UNROLL_8
+
+  for(size_t i = 0; i < 8; i++) {
+    s[i] = LOAD(state->w[i]);
+  }
+
+  lanes_compress_wk(s, wk, lanes_vmask);
+
+  PRAGMA_LOOP_UNROLL_8
+
+  for(size_t i = 0; i < 8; i++) {
+    STORE(state->w[i], s[i]);
+  }
+}
+
+void sha256_multi_rehash_x86_64_avx512(IN OUT sha256_lanes_state_t *state,
+                                       IN uint32_t lanes_mask)
+{
+  const vec_t lanes_vmask = _mm512_maskz_set1_epi32((__mmask16)lanes_mask, -1);
+
+  vec_t s[8];
+
+  PRAGMA_LOOP_UNROLL_8
+
+  for(size_t i = 0; i < 8; i++) {
+    s[i] = LOAD(state->w[i]);
+  }
+
+  lanes_rehash(s, lanes_vmask);
+
+  PRAGMA_LOOP_UNROLL_8
+
+  for(size_t i = 0; i < 8; i++) {
+    STORE(state->w[i], s[i]);
+  }
+}
+
+void sha256_multi_compress_dgst_x86_64_avx512(
+  IN OUT sha256_lanes_state_t *state,
+  IN const sha256_lanes_state_t *init,
+  IN sha256_word_t               len_word,
+  IN uint32_t                    lanes_mask)
+{
+  const vec_t lanes_vmask = _mm512_maskz_set1_epi32((__mmask16)lanes_mask, -1);
+
+  vec_t s[8];
+  vec_t t[8];
+
+  PRAGMA_LOOP_UNROLL_8
+
+  for(size_t j = 0; j < 8; j++) {
+    s[j] = LOAD(state->w[j]);
+    t[j] = LOAD(init->w[j]);
+  }
+
+  lanes_compress_dgst(s, t, len_word, lanes_vmask);
+
+  PRAGMA_LOOP_UNROLL_8
+
+  for(size_t j = 0; j < 8; j++) {
+    STORE(state->w[j], s[j]);
+  }
+}
+
+void sha256d_scan_lanes_x86_64_avx512(OUT sha256_lanes_state_t *state,
+                                      IN const sha256d_scan_t *scan,
+                                      IN const uint32_t        first_nonce)
+{
+  ALIGN(64) sha256_word_t nonce[LANES_NUM];
+
+  vec_t s[8];
+
+  // The nonce is stored in little endian and W[3] is read in big endian
+  PRAGMA_LOOP_UNROLL_16
+
+  for(size_t l = 0; l < LANES_NUM; l++) {
+    nonce[l] = bswap_32(first_nonce + (uint32_t)l);
+  }
+
+  lanes_scan(s, scan, LOAD(nonce));
+
+  PRAGMA_LOOP_UNROLL_8
+
+  for(size_t i = 0; i < 8; i++) {
+    STORE(state->w[i], s[i]);
+  }
+}
@@ -0,0 +1,327 @@
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+// A multi-buffer implementation of the compress function of SHA256 using the
+// SHA extension. The sha256rnds2 instructions of a single message depend on
+// each other, so the single buffer implementation is bound by their latency.
+// Here the rounds of 2 independent messages are interleaved, so that the
+// instructions of one message execute while the other waits.
+// (Interleaving more messages spills the 16 xmm registers.)
+
+#include "avx_defs.h"
+#include "sha256_defs.h"
+
+#define LANES_NUM 2
+
+#define RND2(s0, s1, data) (_mm_sha256rnds2_epu32(s0, s1, data))
+#define SHAMSG1(m1, m2)    (_mm_sha256msg1_epu32(m1, m2))
+#define SHAMSG2(m1, m2)    (_mm_sha256msg2_epu32(m1, m2))
+
+#define SET_K(i)                                                   \
+  (SETR32(K256[4 * (i)], K256[(4 * (i)) + 1], K256[(4 * (i)) + 2], \
+          K256[(4 * (i)) + 3]))
+
+// Converts the state of lane l to the ABEF/CDGH form of the SHA extension
+_INLINE_ void load_lane_state(OUT vec_t *state0,
+                              OUT vec_t *state1,
+                              IN const sha256_lanes_state_t *state,
+                              IN const size_t                l)
+{
+  const vec_t abcd =
+    SETR32(state->w[0][l], state->w[1][l], state->w[2][l], state->w[3][l]);
+  const vec_t efgh =
+    SETR32(state->w[4][l], state->w[5][l], state->w[6][l], state->w[7][l]);
+
+  const vec_t tmp = SHUF32(abcd, 0xB1);          // CDAB
+  *state1         = SHUF32(efgh, 0x1B);          // EFGH
+  *state0         = ALIGNR8(tmp, *state1, 8);    // ABEF
+  *state1         = BLEND16(*state1, tmp, 0xF0); // CDGH
+}
+
+_INLINE_ void store_lane_state(OUT sha256_lanes_state_t *state,
+                               IN const size_t           l,
+                               IN const vec_t            state0,
+                               IN const vec_t            state1)
+{
+  ALIGN(16) sha256_word_t w[SHA256_HASH_WORDS_NUM];
+
+  const vec_t tmp  = SHUF32(state0, 0x1B); // FEBA
+  const vec_t dchg = SHUF32(state1, 0xB1); // DCHG
+  STORE(&w[0], BLEND16(tmp, dchg, 0xF0));  // DCBA
+  STORE(&w[4], ALIGNR8(dchg, tmp, 8));     // HGFE
+
+  for(size_t j = 0; j < SHA256_HASH_WORDS_NUM; j++) {
+    state->w[j][l] = w[j];
+  }
+}
+
+// Compresses one block of both lanes. msgtmp[l] holds the 16 message words of
+// lane l (already byte swapped) and is overwritten by its message schedule.
+_INLINE_ void compress_block_x2(IN OUT vec_t state0[LANES_NUM],
+                                IN OUT vec_t state1[LANES_NUM],
+                                IN OUT vec_t msgtmp[LANES_NUM][4])
+{
+  vec_t msg[LANES_NUM];
+  vec_t tmp[LANES_NUM];
+  vec_t ABEF_SAVE[LANES_NUM];
+  vec_t CDGH_SAVE[LANES_NUM];
+
+  PRAGMA_LOOP_UNROLL_2
+
+  // Save the current state and perform rounds 0-3
+  for(size_t l = 0; l < LANES_NUM; l++) {
+    ABEF_SAVE[l] = state0[l];
+    CDGH_SAVE[l] = state1[l];
+
+    msg[l]    = ADD32(msgtmp[l][0], SET_K(0));
+    state1[l] = RND2(state1[l], state0[l], msg[l]);
+    msg[l]    = SHUF32(msg[l], 0x0E);
+    state0[l] = RND2(state0[l], state1[l], msg[l]);
+  }
+
+  PRAGMA_LOOP_UNROLL_2
+
+  // Rounds 4-7 (i=1)
+  // Rounds 8-11 (i=2)
+  for(size_t i = 1; i <= 2; i++) {
+    PRAGMA_LOOP_UNROLL_2
+
+    for(size_t l = 0; l < LANES_NUM; l++) {
+      msg[l]           = ADD32(msgtmp[l][i], SET_K(i));
+      state1[l]        = RND2(state1[l], state0[l], msg[l]);
+      msg[l]           = SHUF32(msg[l], 0x0E);
+      state0[l]        = RND2(state0[l], state1[l], msg[l]);
+      msgtmp[l][i - 1] = SHAMSG1(msgtmp[l][i - 1], msgtmp[l][i]);
+    }
+  }
+
+  PRAGMA_LOOP_UNROLL_12
+
+  // Rounds 12-59 in blocks of 4 (12 multi-rounds)
+  for(size_t i = 3; i <= 14; i++) {
+    const size_t prev = LSB2(i - 1);
+    const size_t curr = LSB2(i);
+    const size_t next = LSB2(i + 1);
+
+    PRAGMA_LOOP_UNROLL_2
+
+    for(size_t l = 0; l < LANES_NUM; l++) {
+      msg[l]          = ADD32(msgtmp[l][curr], SET_K(i));
+      state1[l]       = RND2(state1[l], state0[l], msg[l]);
+      tmp[l]          = ALIGNR8(msgtmp[l][curr], msgtmp[l][prev], 4);
+      msgtmp[l][next] = ADD32(msgtmp[l][next], tmp[l]);
+      msgtmp[l][next] = SHAMSG2(msgtmp[l][next], msgtmp[l][curr]);
+      msg[l]          = SHUF32(msg[l], 0x0E);
+      state0[l]       = RND2(state0[l], state1[l], msg[l]);
+      msgtmp[l][prev] = SHAMSG1(msgtmp[l][prev], msgtmp[l][curr]);
+    }
+  }
+
+  PRAGMA_LOOP_UNROLL_2
+
+  // Rounds 60-63 and accumulate the state
+  for(size_t l = 0; l < LANES_NUM; l++) {
+    msg[l]    = ADD32(msgtmp[l][3], SET_K(15));
+    state1[l] = RND2(state1[l], state0[l], msg[l]);
+    msg[l]    = SHUF32(msg[l], 0x0E);
+    state0[l] = RND2(state0[l], state1[l], msg[l]);
+
+    state0[l] = ADD32(state0[l], ABEF_SAVE[l]);
+    state1[l] = ADD32(state1[l], CDGH_SAVE[l]);
+  }
+}
+
+_INLINE_ void compress_x2(IN OUT sha256_lanes_state_t *state,
+                          IN const uint8_t *data[],
+                          IN size_t         blocks_num)
+{
+  vec_t state0[LANES_NUM];
+  vec_t state1[LANES_NUM];
+  vec_t msgtmp[LANES_NUM][4];
+
+  const uint8_t *ptr[LANES_NUM] = {data[0], data[1]};
+
+  const vec_t shuf_mask =
+    SET64(UINT64_C(0x0c0d0e0f08090a0b), UINT64_C(0x0405060700010203));
+
+  load_lane_state(&state0[0], &state1[0], state, 0);
+  load_lane_state(&state0[1], &state1[1], state, 1);
+
+  while(blocks_num--) {
+    PRAGMA_LOOP_UNROLL_2
+
+    for(size_t l = 0; l < LANES_NUM; l++) {
+      PRAGMA_LOOP_UNROLL_4
+
+      for(size_t i = 0; i < 4; i++) {
+        msgtmp[l][i] = SHUF8(LOAD(&ptr[l][16 * i]), shuf_mask);
+      }
+
+      ptr[l] += SHA256_BLOCK_BYTE_LEN;
+    }
+
+    compress_block_x2(state0, state1, msgtmp);
+  }
+
+  store_lane_state(state, 0, state0[0], state1[0]);
+  store_lane_state(state, 1, state0[1], state1[1]);
+}
+
+void sha256_multi_compress_x86_64_sha_ext(IN OUT sha256_lanes_state_t *state,
+                                          IN const uint8_t *data[],
+                                          IN size_t         blocks_num,
+                                          IN uint32_t       lanes_mask)
+{
+  // Both lanes are active
+  if(LSB2(lanes_mask) == 0x3) {
+    compress_x2(state, data, blocks_num);
+    return;
+  }
+
+  // A single lane is active, use the single buffer implementation
+  for(size_t l = 0; l < LANES_NUM; l++) {
+    if((lanes_mask >> l) & 1) {
+      sha256_state_t s;
+
+      for(size_t j = 0; j < SHA256_HASH_WORDS_NUM; j++) {
+        s.w[j] = state->w[j][l];
+      }
+
+      sha256_compress_x86_64_sha_ext(&s, data[l], blocks_num);
+
+      for(size_t j = 0; j < SHA256_HASH_WORDS_NUM; j++) {
+        state->w[j][l] = s.w[j];
+      }
+    }
+  }
+}
+
+void sha256_multi_compress_wk_x86_64_sha_ext(
+  IN OUT sha256_lanes_state_t *state,
+  IN const sha256_word_t wk[SHA256_ROUNDS_NUM],
+  IN uint32_t            lanes_mask)
+{
+  vec_t state0[LANES_NUM];
+  vec_t state1[LANES_NUM];
+  vec_t ABEF_SAVE[LANES_NUM];
+  vec_t CDGH_SAVE[LANES_NUM];
+  vec_t msg[LANES_NUM];
+
+  // A single lane is active, use the single buffer implementation
+  if(LSB2(lanes_mask) != 0x3) {
+    for(size_t l = 0; l < LANES_NUM; l++) {
+      if((lanes_mask >> l) & 1) {
+        sha256_state_t s;
+
+        for(size_t j = 0; j < SHA256_HASH_WORDS_NUM; j++) {
+          s.w[j] = state->w[j][l];
+        }
+
+        sha256_compress_wk_x86_64_sha_ext(&s, wk);
+
+        for(size_t j = 0; j < SHA256_HASH_WORDS_NUM; j++) {
+          state->w[j][l] = s.w[j];
+        }
+      }
+    }
+    return;
+  }
+
+  PRAGMA_LOOP_UNROLL_2
+
+  for(size_t l = 0; l < LANES_NUM; l++) {
+    load_lane_state(&state0[l], &state1[l], state, l);
+    ABEF_SAVE[l] = state0[l];
+    CDGH_SAVE[l] = state1[l];
+  }
+
+  PRAGMA_LOOP_UNROLL_16
+
+  // Both lanes use the same schedule, only their rounds are interleaved
+  for(size_t i = 0; i < 16; i++) {
+    const vec_t wk4 = LOAD(&wk[4 * i]);
+
+    PRAGMA_LOOP_UNROLL_2
+
+    for(size_t l = 0; l < LANES_NUM; l++) {
+      state1[l] = RND2(state1[l], state0[l], wk4);
+      msg[l]    = SHUF32(wk4, 0x0E);
+      state0[l] = RND2(state0[l], state1[l], msg[l]);
+    }
+  }
+
+  PRAGMA_LOOP_UNROLL_2
+
+  for(size_t l = 0; l < LANES_NUM; l++) {
+    state0[l] = ADD32(state0[l], ABEF_SAVE[l]);
+    state1[l] = ADD32(state1[l], CDGH_SAVE[l]);
+    store_lane_state(state, l, state0[l], state1[l]);
+  }
+}
+
+void sha256_multi_compress_dgst_x86_64_sha_ext(
+  IN OUT sha256_lanes_state_t *state,
+  IN const sha256_lanes_state_t *init,
+  IN sha256_word_t               len_word,
+  IN uint32_t                    lanes_mask)
+{
+  vec_t state0[LANES_NUM];
+  vec_t state1[LANES_NUM];
+  vec_t msgtmp[LANES_NUM][4];
+
+  // A single lane is active, use the single buffer implementation
+  if(LSB2(lanes_mask) != 0x3) {
+    for(size_t l = 0; l < LANES_NUM; l++) {
+      if((lanes_mask >> l) & 1) {
+        sha256_state_t s;
+        sha256_state_t t;
+
+        for(size_t j = 0; j < SHA256_HASH_WORDS_NUM; j++) {
+          s.w[j] = state->w[j][l];
+          t.w[j] = init->w[j][l];
+        }
+
+        sha256_compress_dgst_x86_64_sha_ext(&s, &t, len_word);
+
+        for(size_t j = 0; j < SHA256_HASH_WORDS_NUM; j++) {
+          state->w[j][l] = s.w[j];
+        }
+      }
+    }
+    return;
+  }
+
+  PRAGMA_LOOP_UNROLL_2
+
+  // The digest words of every lane are its message words
+  for(size_t l = 0; l < LANES_NUM; l++) {
+    msgtmp[l][0] =
+      SETR32(state->w[0][l], state->w[1][l], state->w[2][l], state->w[3][l]);
+    msgtmp[l][1] =
+      SETR32(state->w[4][l], state->w[5][l], state->w[6][l], state->w[7][l]);
+    msgtmp[l][2] = SETR32(SHA256_DGST_PAD_END_WORD, 0, 0, 0);
+    msgtmp[l][3] = SETR32(0, 0, 0, len_word);
+
+    load_lane_state(&state0[l], &state1[l], init, l);
+  }
+
+  compress_block_x2(state0, state1, msgtmp);
+
+  store_lane_state(state, 0, state0[0], state1[0]);
+  store_lane_state(state, 1, state0[1], state1[1]);
+}
+
+void sha256_multi_rehash_x86_64_sha_ext(IN OUT sha256_lanes_state_t *state,
+                                        IN uint32_t lanes_mask)
+{
+  sha256_lanes_state_t iv;
+
+  for(size_t j = 0; j < SHA256_HASH_WORDS_NUM; j++) {
+    for(size_t l = 0; l < LANES_NUM; l++) {
+      iv.w[j][l] = IV256[j];
+    }
+  }
+
+  sha256_multi_compress_dgst_x86_64_sha_ext(state, &iv, SHA256_DGST_PAD_LEN_WORD,
+                                            lanes_mask);
+}
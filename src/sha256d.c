@@ -0,0 +1,79 @@
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+// SHA256d(x) = SHA256(SHA256(x)).
+// The second hash is a single block: the 32 bytes digest of the first hash and
+// a constant padding. The words of that digest are the words of the final
+// state of the first hash, so the block is compressed directly from the state
+// (see sha256_rehash_generic), without writing the digest and padding it with
+// a second hashing context.
+
+#include <assert.h>
+
+#include "sha256_defs.h"
+
+// The second half of the block of a 32 bytes message
+static const uint8_t dgst_pad[SHA256_BLOCK_BYTE_LEN - SHA256_HASH_BYTE_LEN] = {
+  SHA256_MSG_END_SYMBOL,
+  [SHA256_BLOCK_BYTE_LEN - SHA256_HASH_BYTE_LEN - 2] = 0x01};
+
+// This implementation assumes running on a Little endian machine
+_INLINE_ void store_dgst(OUT uint8_t *dgst, IN const sha256_state_t *state)
+{
+  for(size_t j = 0; j < SHA256_HASH_WORDS_NUM; j++) {
+    const sha256_word_t w = bswap_32(state->w[j]);
+    my_memcpy(&dgst[j * sizeof(w)], (const uint8_t *)&w, sizeof(w));
+  }
+}
+
+void sha256_rehash(IN OUT sha256_state_t *state, IN const sha_impl_t impl)
+{
+  ALIGN(64) uint8_t block[SHA256_BLOCK_BYTE_LEN];
+
+  switch(impl) {
+#if defined(X86_64_SHA_SUPPORT)
+    case SHA_EXT_IMPL: sha256_rehash_x86_64_sha_ext(state); return;
+#endif
+
+    case GENERIC_IMPL: sha256_rehash_generic(state); return;
+
+    default: break;
+  }
+
+  // The other implementations compress the digest block from memory
+  store_dgst(block, state);
+  my_memcpy(&block[SHA256_HASH_BYTE_LEN], dgst_pad, sizeof(dgst_pad));
+
+  for(size_t j = 0; j < SHA256_HASH_WORDS_NUM; j++) {
+    state->w[j] = IV256[j];
+  }
+
+  sha256_compress(state, block, 1, impl);
+
+  secure_clean(block, sizeof(block));
+}
+
+void sha256d_final(OUT uint8_t *dgst, IN OUT sha256_ctx_t *ctx)
+{
+  assert((ctx != NULL) && (dgst != NULL));
+
+  sha256_final_state(ctx);
+  sha256_rehash(&ctx->state, ctx->impl);
+  store_dgst(dgst, &ctx->state);
+
+  secure_clean(ctx, sizeof(*ctx));
+}
+
+void sha256d(OUT uint8_t *dgst,
+             IN const uint8_t *  data,
+             IN const size_t     byte_len,
+             IN const sha_impl_t impl)
+{
+  assert(dgst != NULL);
+  assert((data != NULL) || (byte_len == 0));
+
+  sha256_ctx_t ctx;
+  sha256_init(&ctx, impl);
+  sha256_update(&ctx, data, byte_len);
+  sha256d_final(dgst, &ctx);
+}
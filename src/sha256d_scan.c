@@ -0,0 +1,324 @@
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+// Nonce scanning of 80 bytes headers with SHA256d.
+// The first block of the header does not change, so its state (the midstate)
+// is computed once. In the second block only W[3] (the nonce) changes: the
+// rounds 0-2, W[16..17] and parts of W[18..19] are also computed once, and
+// the padding words are constants. The candidate nonces are hashed in the
+// lanes of the multi-buffer implementations, and the second hash continues
+// from the final states of the lanes (see sha256_rehash).
+
+// For posix_memalign
+#define _POSIX_C_SOURCE 200112L
+
+#include <assert.h>
+#include <stdlib.h>
+
+#include "cpu_features.h"
+#include "sha256_defs.h"
+
+#define HEADER_TAIL_BYTE_LEN (SHA256D_HEADER_BYTE_LEN - SHA256_BLOCK_BYTE_LEN)
+#define NONCE_BYTE_LEN       (sizeof(uint32_t))
+
+// The padding of the second block of an 80 bytes header
+static const uint8_t header_pad[SHA256_BLOCK_BYTE_LEN - HEADER_TAIL_BYTE_LEN] = {
+  SHA256_MSG_END_SYMBOL,
+  [SHA256_BLOCK_BYTE_LEN - HEADER_TAIL_BYTE_LEN - 2] = 0x02,
+  [SHA256_BLOCK_BYTE_LEN - HEADER_TAIL_BYTE_LEN - 1] = 0x80};
+
+// The lanes of the multi-buffer implementations
+typedef struct lanes_s {
+  sha256d_scan_lanes_t    scan;
+  sha256_multi_compress_t compress;
+  sha256_multi_rehash_t   rehash;
+  size_t                  lanes_num;
+} lanes_t;
+
+// This implementation assumes running on a Little endian machine
+_INLINE_ sha256_word_t load_be32(IN const uint8_t *p)
+{
+  sha256_word_t w;
+  my_memcpy((uint8_t *)&w, p, sizeof(w));
+  return bswap_32(w);
+}
+
+void sha256d_scan_init(OUT sha256d_scan_t *scan,
+                       IN const uint8_t *header,
+                       IN const sha_impl_t impl)
+{
+  assert((scan != NULL) && (header != NULL));
+
+  const uint8_t *tail = &header[SHA256_BLOCK_BYTE_LEN];
+  sha256_word_t  w[SHA256D_SCAN_NONCE_WORD_IDX];
+
+  scan->single_impl = sha256_resolve_impl(impl);
+  scan->multi_impl  = sha256_multi_resolve_impl(impl);
+
+  for(size_t j = 0; j < SHA256_HASH_WORDS_NUM; j++) {
+    scan->mid.w[j] = IV256[j];
+  }
+
+  sha256_compress(&scan->mid, header, 1, scan->single_impl);
+
+  scan->pre_rounds = scan->mid;
+
+  for(size_t i = 0; i < SHA256D_SCAN_NONCE_WORD_IDX; i++) {
+    w[i]          = load_be32(&tail[i * sizeof(sha256_word_t)]);
+    scan->tail[i] = w[i];
+    sha_round(&scan->pre_rounds, w[i], K256[i]);
+  }
+
+  // W[i] = sigma1(W[i-2]) + W[i-7] + sigma0(W[i-15]) + W[i-16], where
+  // W[5..14] = 0
+  scan->pre_w[0] = sigma0(w[1]) + w[0];
+  scan->pre_w[1] = sigma1(SHA256D_SCAN_PAD_LEN_WORD) + sigma0(w[2]) + w[1];
+  scan->pre_w[2] = sigma1(scan->pre_w[0]) + w[2];
+  scan->pre_w[3] = sigma1(scan->pre_w[1]) + sigma0(SHA256D_SCAN_PAD_END_WORD);
+
+  secure_clean(w, sizeof(w));
+}
+
+// Computes the final SHA256d state of the header of scan with the nonce word
+// w3 (see lanes_scan)
+_INLINE_ void scan_generic(OUT sha256_state_t *state,
+                           IN const sha256d_scan_t *scan,
+                           IN const sha256_word_t   w3)
+{
+  sha256_state_t s = scan->pre_rounds;
+  sha256_word_t  x[SHA256_BLOCK_WORDS_NUM];
+
+  x[SHA256D_SCAN_NONCE_WORD_IDX] = w3;
+  x[4]                           = SHA256D_SCAN_PAD_END_WORD;
+
+  for(size_t i = 5; i < 15; i++) {
+    x[i] = 0;
+  }
+
+  x[15] = SHA256D_SCAN_PAD_LEN_WORD;
+
+  for(size_t i = SHA256D_SCAN_NONCE_WORD_IDX; i < SHA256_BLOCK_WORDS_NUM; i++) {
+    sha_round(&s, x[i], K256[i]);
+  }
+
+  x[0] = scan->pre_w[0];
+  x[1] = scan->pre_w[1];
+  x[2] = scan->pre_w[2] + sigma0(w3);
+  x[3] = scan->pre_w[3] + w3;
+
+  for(size_t i = 16; i < 20; i++) {
+    sha_round(&s, x[LSB4(i)], K256[i]);
+  }
+
+  for(size_t i = 20; i < SHA256_ROUNDS_NUM; i++) {
+    x[LSB4(i)] += sigma0(x[LSB4(i + 1)]) + sigma1(x[LSB4(i + 14)]) +
+                  x[LSB4(i + 9)];
+    sha_round(&s, x[LSB4(i)], K256[i]);
+  }
+
+  *state = scan->mid;
+  accumulate_state(state, &s);
+  sha256_rehash_generic(state);
+
+  secure_clean(&s, sizeof(s));
+}
+
+// Stages the second block of the header of scan with nonce
+_INLINE_ void stage_block(OUT uint8_t block[SHA256_BLOCK_BYTE_LEN],
+                          IN const sha256d_scan_t *scan,
+                          IN const uint32_t        nonce)
+{
+  for(size_t i = 0; i < SHA256D_SCAN_NONCE_WORD_IDX; i++) {
+    const sha256_word_t w = bswap_32(scan->tail[i]);
+    my_memcpy(&block[i * sizeof(w)], (const uint8_t *)&w, sizeof(w));
+  }
+
+  // The nonce is stored in little endian
+  my_memcpy(&block[HEADER_TAIL_BYTE_LEN - NONCE_BYTE_LEN],
+            (const uint8_t *)&nonce, NONCE_BYTE_LEN);
+  my_memcpy(&block[HEADER_TAIL_BYTE_LEN], header_pad, sizeof(header_pad));
+}
+
+// Computes the final SHA256d state of the header of scan with nonce
+_INLINE_ void scan_one(OUT sha256_state_t *state,
+                       IN const sha256d_scan_t *scan,
+                       IN const uint32_t        nonce)
+{
+  ALIGN(64) uint8_t block[SHA256_BLOCK_BYTE_LEN];
+
+  if(scan->single_impl == GENERIC_IMPL) {
+    scan_generic(state, scan, bswap_32(nonce));
+    return;
+  }
+
+  stage_block(block, scan, nonce);
+
+  *state = scan->mid;
+  sha256_compress(state, block, 1, scan->single_impl);
+  sha256_rehash(state, scan->single_impl);
+}
+
+// Computes the final SHA256d states of the lanes_num nonces that start at
+// first_nonce. The implementations without a scan kernel (SHA_EXT) compress
+// staged blocks in their lanes.
+_INLINE_ void scan_lanes(OUT sha256_lanes_state_t *state,
+                         IN const sha256d_scan_t *scan,
+                         IN const uint32_t        first_nonce,
+                         IN const lanes_t *       lanes)
+{
+  ALIGN(64) uint8_t block[SHA256_MAX_LANES_NUM][SHA256_BLOCK_BYTE_LEN];
+
+  const uint8_t *ptr[SHA256_MAX_LANES_NUM];
+  uint32_t       lanes_mask = 0;
+
+  if(lanes->scan != NULL) {
+    lanes->scan(state, scan, first_nonce);
+    return;
+  }
+
+  for(size_t l = 0; l < lanes->lanes_num; l++) {
+    stage_block(block[l], scan, first_nonce + (uint32_t)l);
+    ptr[l] = block[l];
+    lanes_mask |= (UINT32_C(1) << l);
+
+    for(size_t j = 0; j < SHA256_HASH_WORDS_NUM; j++) {
+      state->w[j][l] = scan->mid.w[j];
+    }
+  }
+
+  lanes->compress(state, ptr, 1, lanes_mask);
+  lanes->rehash(state, lanes_mask);
+}
+
+// Returns 1 if the digest of the final state w, read as a 256-bit little
+// endian number, is less than or equal to target. The most significant word
+// of the number is the last digest word.
+_INLINE_ int below_target(IN const sha256_word_t w[SHA256_HASH_WORDS_NUM],
+                          IN const sha256_word_t target[SHA256_HASH_WORDS_NUM])
+{
+  for(size_t j = SHA256_HASH_WORDS_NUM; j-- > 0;) {
+    const sha256_word_t d = bswap_32(w[j]);
+
+    if(d != target[j]) {
+      return d < target[j];
+    }
+  }
+
+  return 1;
+}
+
+_INLINE_ void init_lanes(OUT lanes_t *lanes, IN const sha_impl_t multi_impl)
+{
+  lanes->scan     = NULL;
+  lanes->compress = sha256_multi_compress_func(&lanes->lanes_num, multi_impl);
+  lanes->rehash   = sha256_multi_rehash_func(multi_impl);
+
+  switch(multi_impl) {
+#if defined(AVX2_SUPPORT)
+    case AVX2_IMPL: lanes->scan = sha256d_scan_lanes_x86_64_avx2; break;
+#endif
+
+#if defined(AVX512_SUPPORT)
+    case AVX512_IMPL: lanes->scan = sha256d_scan_lanes_x86_64_avx512; break;
+#endif
+
+#if defined(NEON_SUPPORT)
+    case NEON_IMPL: lanes->scan = sha256d_scan_lanes_aarch64_neon; break;
+#endif
+
+    default: break;
+  }
+
+  // Without a scan kernel or a multi-buffer rehash (e.g., SVE) the lanes cannot
+  // finish SHA256d, so the nonces are hashed one by one
+  if((lanes->scan == NULL) && (lanes->rehash == NULL)) {
+    lanes->compress = NULL;
+  }
+}
+
+size_t sha256d_scan(OUT uint32_t hits[],
+                    IN const size_t max_hits,
+                    IN const sha256d_scan_t *scan,
+                    IN const uint32_t        first_nonce,
+                    IN const uint64_t        nonces_num,
+                    IN const uint8_t *       target)
+{
+  assert((hits != NULL) || (max_hits == 0));
+  assert((scan != NULL) && (target != NULL));
+  assert(nonces_num <= (UINT64_C(1) << 32));
+
+  sha256_lanes_state_t state;
+  sha256_state_t       s;
+  sha256_word_t        t[SHA256_HASH_WORDS_NUM];
+  sha256_word_t        w[SHA256_HASH_WORDS_NUM];
+  lanes_t              lanes;
+  size_t               hits_num = 0;
+
+  // This implementation assumes running on a Little endian machine
+  my_memcpy((uint8_t *)t, target, sizeof(t));
+
+  init_lanes(&lanes, scan->multi_impl);
+
+  // No multi-buffer implementation, hash the nonces one by one
+  if(lanes.compress == NULL) {
+    for(uint64_t k = 0; (k < nonces_num) && (hits_num < max_hits); k++) {
+      const uint32_t nonce = first_nonce + (uint32_t)k;
+
+      scan_one(&s, scan, nonce);
+      if(below_target(s.w, t)) {
+        hits[hits_num++] = nonce;
+      }
+    }
+
+    secure_clean(&s, sizeof(s));
+    return hits_num;
+  }
+
+  for(uint64_t k = 0; (k < nonces_num) && (hits_num < max_hits);
+      k += lanes.lanes_num) {
+    const uint64_t rem_num = nonces_num - k;
+    const size_t   num =
+      (rem_num < lanes.lanes_num) ? (size_t)rem_num : lanes.lanes_num;
+    const uint32_t nonce = first_nonce + (uint32_t)k;
+
+    // The nonces of the last lanes may be beyond the range, and their states
+    // are ignored
+    scan_lanes(&state, scan, nonce, &lanes);
+
+    for(size_t l = 0; (l < num) && (hits_num < max_hits); l++) {
+      for(size_t j = 0; j < SHA256_HASH_WORDS_NUM; j++) {
+        w[j] = state.w[j][l];
+      }
+
+      if(below_target(w, t)) {
+        hits[hits_num++] = nonce + (uint32_t)l;
+      }
+    }
+  }
+
+  secure_clean(&state, sizeof(state));
+  secure_clean(w, sizeof(w));
+  return hits_num;
+}
+
+sha256d_scan_t *sha256d_scan_new(void)
+{
+  void *scan = NULL;
+
+  // The scan context includes 64-bytes aligned fields
+  if(0 != posix_memalign(&scan, 64, sizeof(sha256d_scan_t))) {
+    return NULL;
+  }
+
+  return (sha256d_scan_t *)scan;
+}
+
+void sha256d_scan_free(IN OUT sha256d_scan_t *scan)
+{
+  if(scan == NULL) {
+    return;
+  }
+
+  secure_clean(scan, sizeof(*scan));
+  free(scan);
+}
@@ -1,24 +1,24 @@
 // Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
 // SPDX-License-Identifier: Apache-2.0
 
+// For posix_memalign
+#define _POSIX_C_SOURCE 200112L
+
 #include <assert.h>
+#include <stdlib.h>
 
+#include "cpu_features.h"
 #include "sha512_defs.h"
 
-#define LAST_BLOCK_BYTE_LEN (2 * SHA512_BLOCK_BYTE_LEN)
-
-typedef struct sha512_hash_s {
-  ALIGN(64) sha512_state_t state;
-  uint64_t len;
-
-  ALIGN(64) uint8_t data[LAST_BLOCK_BYTE_LEN];
+void sha512_init(OUT sha512_ctx_t *ctx, IN const sha_impl_t impl)
+{
+  assert(ctx != NULL);
 
-  sha512_word_t rem;
-  sha_impl_t    impl;
-} sha512_ctx_t;
+  ctx->len           = 0;
+  ctx->rem           = 0;
+  ctx->impl          = sha512_resolve_impl(impl);
+  ctx->dgst_byte_len = SHA512_HASH_BYTE_LEN;
 
-_INLINE_ void sha512_init(OUT sha512_ctx_t *ctx)
-{
   ctx->state.w[0] = UINT64_C(0x6a09e667f3bcc908);
   ctx->state.w[1] = UINT64_C(0xbb67ae8584caa73b);
   ctx->state.w[2] = UINT64_C(0x3c6ef372fe94f82b);
@@ -29,64 +29,134 @@ _INLINE_ void sha512_init(OUT sha512_ctx_t *ctx)
   ctx->state.w[7] = UINT64_C(0x5be0cd19137e2179);
 }
 
-_INLINE_ void sha512_compress(IN OUT sha512_ctx_t *ctx,
-                              IN const uint8_t *data,
-                              IN const size_t   blocks_num)
+// SHA-384, SHA-512/224 and SHA-512/256 are SHA-512 with different IVs and
+// truncated digests
+void sha384_init(OUT sha512_ctx_t *ctx, IN const sha_impl_t impl)
+{
+  sha512_init(ctx, impl);
+
+  ctx->dgst_byte_len = SHA384_HASH_BYTE_LEN;
+
+  ctx->state.w[0] = UINT64_C(0xcbbb9d5dc1059ed8);
+  ctx->state.w[1] = UINT64_C(0x629a292a367cd507);
+  ctx->state.w[2] = UINT64_C(0x9159015a3070dd17);
+  ctx->state.w[3] = UINT64_C(0x152fecd8f70e5939);
+  ctx->state.w[4] = UINT64_C(0x67332667ffc00b31);
+  ctx->state.w[5] = UINT64_C(0x8eb44a8768581511);
+  ctx->state.w[6] = UINT64_C(0xdb0c2e0d64f98fa7);
+  ctx->state.w[7] = UINT64_C(0x47b5481dbefa4fa4);
+}
+
+void sha512_t224_init(OUT sha512_ctx_t *ctx, IN const sha_impl_t impl)
 {
-  assert((ctx != NULL) && (data != NULL));
+  sha512_init(ctx, impl);
+
+  ctx->dgst_byte_len = SHA512_T224_HASH_BYTE_LEN;
+
+  ctx->state.w[0] = UINT64_C(0x8c3d37c819544da2);
+  ctx->state.w[1] = UINT64_C(0x73e1996689dcd4d6);
+  ctx->state.w[2] = UINT64_C(0x1dfab7ae32ff9c82);
+  ctx->state.w[3] = UINT64_C(0x679dd514582f9fcf);
+  ctx->state.w[4] = UINT64_C(0x0f6d2b697bd44da8);
+  ctx->state.w[5] = UINT64_C(0x77e36f7304c48942);
+  ctx->state.w[6] = UINT64_C(0x3f9d85a86a1d36c8);
+  ctx->state.w[7] = UINT64_C(0x1112e6ad91d692a1);
+}
+
+void sha512_t256_init(OUT sha512_ctx_t *ctx, IN const sha_impl_t impl)
+{
+  sha512_init(ctx, impl);
+
+  ctx->dgst_byte_len = SHA512_T256_HASH_BYTE_LEN;
+
+  ctx->state.w[0] = UINT64_C(0x22312194fc2bf72c);
+  ctx->state.w[1] = UINT64_C(0x9f555fa3c84c64c2);
+  ctx->state.w[2] = UINT64_C(0x2393b86b6f53b151);
+  ctx->state.w[3] = UINT64_C(0x963877195940eabd);
+  ctx->state.w[4] = UINT64_C(0x96283ee2a88effe3);
+  ctx->state.w[5] = UINT64_C(0xbe5e1e2553863992);
+  ctx->state.w[6] = UINT64_C(0x2b0199fc2c85b8aa);
+  ctx->state.w[7] = UINT64_C(0x0eb72ddc81c52ca2);
+}
+
+void sha512_compress(IN OUT sha512_state_t *state,
+                     IN const uint8_t *  data,
+                     IN const size_t     blocks_num,
+                     IN const sha_impl_t impl)
+{
+  assert((state != NULL) && (data != NULL));
 
   // OpenSSL code can crash without this check
   if(blocks_num == 0) {
     return;
   }
 
-  switch(ctx->impl) {
+  switch(impl) {
 #if defined(X86_64)
     case AVX_IMPL:
-      sha512_compress_x86_64_avx(&ctx->state, data, blocks_num);
+      sha512_compress_x86_64_avx(state, data, blocks_num);
       break;
 
     case OPENSSL_AVX_IMPL:
       RUN_OPENSSL_CODE_WITH_AVX(
-        sha512_block_data_order_local(ctx->state.w, data, blocks_num););
+        sha512_block_data_order_local(state->w, data, blocks_num););
       break;
 #endif
 
 #if defined(AVX2_SUPPORT)
     case AVX2_IMPL:
-      sha512_compress_x86_64_avx2(&ctx->state, data, blocks_num);
+      sha512_compress_x86_64_avx2(state, data, blocks_num);
       break;
 
     case OPENSSL_AVX2_IMPL:
       RUN_OPENSSL_CODE_WITH_AVX2(
-        sha512_block_data_order_local(ctx->state.w, data, blocks_num););
+        sha512_block_data_order_local(state->w, data, blocks_num););
       break;
 #endif
 
 #if defined(AVX512_SUPPORT)
     case AVX512_IMPL:
-      sha512_compress_x86_64_avx512(&ctx->state, data, blocks_num);
+      sha512_compress_x86_64_avx512(state, data, blocks_num);
       break;
 #endif
 
 #if defined(NEON_SUPPORT)
+#  if defined(AARCH64_SVE_SUPPORT)
+    // SVE only has a multi-buffer implementation
+    case SVE_IMPL:
+#  endif
+    case NEON_IMPL:
+      sha512_compress_aarch64_neon(state, data, blocks_num);
+      break;
+
     case OPENSSL_NEON_IMPL:
       RUN_OPENSSL_CODE_WITH_NEON(
-        sha512_block_data_order_local(ctx->state.w, data, blocks_num););
+        sha512_block_data_order_local(state->w, data, blocks_num););
       break;
 #endif
 
-    default: sha512_compress_generic(&ctx->state, data, blocks_num); break;
+#if defined(AARCH64_SHA512_SUPPORT)
+    case SHA_EXT_IMPL:
+      sha512_compress_aarch64_sha_ext(state, data, blocks_num);
+      break;
+
+    case OPENSSL_SHA_EXT_IMPL:
+      RUN_OPENSSL_CODE_WITH_SHA512_EXT(
+        sha512_block_data_order_local(state->w, data, blocks_num););
+      break;
+#endif
+
+    default: sha512_compress_generic(state, data, blocks_num); break;
   }
 }
 
-_INLINE_ void sha512_update(IN OUT sha512_ctx_t *ctx,
-                            IN const uint8_t *data,
-                            IN size_t         byte_len)
+void sha512_update(IN OUT sha512_ctx_t *ctx,
+                   IN const uint8_t *data,
+                   IN size_t         byte_len)
 {
   // On exiting this function ctx->rem < SHA512_BLOCK_BYTE_LEN
 
-  assert((ctx != NULL) && (data != NULL));
+  assert((ctx != NULL) && ((data != NULL) || (byte_len == 0)));
 
   if(byte_len == 0) {
     return;
@@ -106,7 +176,7 @@ _INLINE_ void sha512_update(IN OUT sha512_ctx_t *ctx,
   if(ctx->rem != 0) {
     const size_t clen = SHA512_BLOCK_BYTE_LEN - ctx->rem;
     my_memcpy(&ctx->data[ctx->rem], data, clen);
-    sha512_compress(ctx, ctx->data, 1);
+    sha512_compress(&ctx->state, ctx->data, 1, ctx->impl);
 
     data += clen;
     byte_len -= clen;
@@ -120,7 +190,7 @@ _INLINE_ void sha512_update(IN OUT sha512_ctx_t *ctx,
     const size_t blocks_num           = (byte_len >> 7);
     const size_t full_blocks_byte_len = (blocks_num << 7);
 
-    sha512_compress(ctx, data, blocks_num);
+    sha512_compress(&ctx->state, data, blocks_num, ctx->impl);
 
     data += full_blocks_byte_len;
     byte_len -= full_blocks_byte_len;
@@ -131,7 +201,7 @@ _INLINE_ void sha512_update(IN OUT sha512_ctx_t *ctx,
   ctx->rem = byte_len;
 }
 
-_INLINE_ void sha512_final(OUT uint8_t *dgst, IN OUT sha512_ctx_t *ctx)
+void sha512_final(OUT uint8_t *dgst, IN OUT sha512_ctx_t *ctx)
 {
   assert((ctx != NULL) && (dgst != NULL));
   assert(ctx->rem < SHA512_BLOCK_BYTE_LEN);
@@ -150,7 +220,7 @@ _INLINE_ void sha512_final(OUT uint8_t *dgst, IN OUT sha512_ctx_t *ctx)
             sizeof(bswap_len));
 
   // Compress the final block
-  sha512_compress(ctx, ctx->data, last_block_num);
+  sha512_compress(&ctx->state, ctx->data, last_block_num, ctx->impl);
 
   // This implementation assumes running on a Little endian machine
   ctx->state.w[0] = bswap_64(ctx->state.w[0]);
@@ -161,7 +231,7 @@ _INLINE_ void sha512_final(OUT uint8_t *dgst, IN OUT sha512_ctx_t *ctx)
   ctx->state.w[5] = bswap_64(ctx->state.w[5]);
   ctx->state.w[6] = bswap_64(ctx->state.w[6]);
   ctx->state.w[7] = bswap_64(ctx->state.w[7]);
-  my_memcpy(dgst, ctx->state.w, SHA512_HASH_BYTE_LEN);
+  my_memcpy(dgst, ctx->state.w, ctx->dgst_byte_len);
 
   secure_clean(ctx, sizeof(*ctx));
 }
@@ -173,9 +243,76 @@ void sha512(OUT uint8_t *dgst,
 {
   assert((data != NULL) || (dgst != NULL));
 
-  sha512_ctx_t ctx = {0};
-  ctx.impl         = impl;
-  sha512_init(&ctx);
+  sha512_ctx_t ctx;
+  sha512_init(&ctx, impl);
+  sha512_update(&ctx, data, byte_len);
+  sha512_final(dgst, &ctx);
+}
+
+void sha384(OUT uint8_t *dgst,
+            IN const uint8_t *  data,
+            IN const size_t     byte_len,
+            IN const sha_impl_t impl)
+{
+  assert((data != NULL) || (dgst != NULL));
+
+  sha512_ctx_t ctx;
+  sha384_init(&ctx, impl);
   sha512_update(&ctx, data, byte_len);
   sha512_final(dgst, &ctx);
 }
+
+void sha512_t224(OUT uint8_t *dgst,
+                 IN const uint8_t *  data,
+                 IN const size_t     byte_len,
+                 IN const sha_impl_t impl)
+{
+  assert((data != NULL) || (dgst != NULL));
+
+  sha512_ctx_t ctx;
+  sha512_t224_init(&ctx, impl);
+  sha512_update(&ctx, data, byte_len);
+  sha512_final(dgst, &ctx);
+}
+
+void sha512_t256(OUT uint8_t *dgst,
+                 IN const uint8_t *  data,
+                 IN const size_t     byte_len,
+                 IN const sha_impl_t impl)
+{
+  assert((data != NULL) || (dgst != NULL));
+
+  sha512_ctx_t ctx;
+  sha512_t256_init(&ctx, impl);
+  sha512_update(&ctx, data, byte_len);
+  sha512_final(dgst, &ctx);
+}
+
+sha512_ctx_t *sha512_ctx_new(void)
+{
+  void *ctx = NULL;
+
+  // The context includes 64-bytes aligned fields
+  if(0 != posix_memalign(&ctx, 64, sizeof(sha512_ctx_t))) {
+    return NULL;
+  }
+
+  return (sha512_ctx_t *)ctx;
+}
+
+void sha512_ctx_free(IN OUT sha512_ctx_t *ctx)
+{
+  if(ctx == NULL) {
+    return;
+  }
+
+  secure_clean(ctx, sizeof(*ctx));
+  free(ctx);
+}
+
+void sha512_ctx_copy(OUT sha512_ctx_t *dst, IN const sha512_ctx_t *src)
+{
+  assert((dst != NULL) && (src != NULL));
+
+  my_memcpy(dst, src, sizeof(*dst));
+}
@@ -0,0 +1,122 @@
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+// An implementation of the compress function of SHA512 using NEON, for
+// AARCH64 CPUs without the SHA512 extension. As in the AVX implementation
+// (sha512_compress_x86_64_avx.c), the message schedule of the next 2 rounds is
+// computed in a vector register while the current rounds run on the scalar
+// registers.
+
+#include "neon_defs.h"
+#include "sha512_defs.h"
+
+#define MS_VEC_NUM   (SHA512_BLOCK_BYTE_LEN / sizeof(uint64x2_t))
+#define WORDS_IN_VEC (sizeof(uint64x2_t) / sizeof(sha512_word_t))
+
+#define NEON_sigma0(x) \
+  (NEON_ROR64(x, sigma0_0) ^ NEON_ROR64(x, sigma0_1) ^ vshrq_n_u64(x, sigma0_2))
+#define NEON_sigma1(x) \
+  (NEON_ROR64(x, sigma1_0) ^ NEON_ROR64(x, sigma1_1) ^ vshrq_n_u64(x, sigma1_2))
+
+_INLINE_ void rotate_x(uint64x2_t x[MS_VEC_NUM])
+{
+  const uint64x2_t tmp = x[0];
+
+  for(size_t i = 0; i < 7; i++) {
+    x[i] = x[i + 1];
+  }
+
+  x[7] = tmp;
+}
+
+// Receives x[7:0] = q[15:0] and computes q[i] += sigma0(q[i + 1]) +
+// sigma1(q[i + 14]) + q[i + 9] for q[1:0]. Unlike SHA256, the two new words
+// do not depend on each other. Returns the new words added to the round
+// constants.
+_INLINE_ uint64x2_t update_x(IN OUT uint64x2_t x[MS_VEC_NUM],
+                             IN const sha512_word_t *k512_p)
+{
+  const uint64x2_t q2_1  = vextq_u64(x[0], x[1], 1);
+  const uint64x2_t q10_9 = vextq_u64(x[4], x[5], 1);
+
+  x[0] = vaddq_u64(vaddq_u64(x[0], q10_9),
+                   vaddq_u64(NEON_sigma0(q2_1), NEON_sigma1(x[7])));
+
+  rotate_x(x);
+
+  return vaddq_u64(x[7], vld1q_u64(k512_p));
+}
+
+_INLINE_ void load_data(OUT uint64x2_t x[MS_VEC_NUM],
+                        IN OUT sha512_msg_schedule_t *ms,
+                        IN const uint8_t *data)
+{
+  PRAGMA_LOOP_UNROLL_8
+
+  for(size_t i = 0; i < MS_VEC_NUM; i++) {
+    const size_t pos = WORDS_IN_VEC * i;
+
+    x[i] = vreinterpretq_u64_u8(vrev64q_u8(vld1q_u8(&data[16 * i])));
+    vst1q_u64(&ms->w[pos], vaddq_u64(x[i], vld1q_u64(&K512[pos])));
+  }
+}
+
+_INLINE_ void rounds_0_63(sha512_state_t *       cur_state,
+                          uint64x2_t             x[MS_VEC_NUM],
+                          sha512_msg_schedule_t *ms)
+{
+  // The first SHA512_BLOCK_WORDS_NUM entries of K512 were loaded in
+  // load_data(...).
+  size_t k512_idx = SHA512_BLOCK_WORDS_NUM;
+
+  // Rounds 0-63 (0-15, 16-31, 32-47, 48-63)
+  for(size_t i = 0; i < 4; i++) {
+
+    PRAGMA_LOOP_UNROLL_8
+
+    for(size_t j = 0; j < MS_VEC_NUM; j++) {
+      const size_t pos = WORDS_IN_VEC * j;
+
+      const uint64x2_t y = update_x(x, &K512[k512_idx]);
+
+      sha_round(cur_state, ms->w[pos], 0);
+      sha_round(cur_state, ms->w[pos + 1], 0);
+
+      vst1q_u64(&ms->w[pos], y);
+      k512_idx += WORDS_IN_VEC;
+    }
+  }
+}
+
+_INLINE_ void rounds_64_79(sha512_state_t *             cur_state,
+                           const sha512_msg_schedule_t *ms)
+{
+  PRAGMA_LOOP_UNROLL_16
+
+  for(size_t i = SHA512_FINAL_ROUND_START_IDX; i < SHA512_ROUNDS_NUM; i++) {
+    sha_round(cur_state, ms->w[LSB4(i)], 0);
+  }
+}
+
+void sha512_compress_aarch64_neon(IN OUT sha512_state_t *state,
+                                  IN const uint8_t *data,
+                                  IN size_t         blocks_num)
+{
+  sha512_state_t        cur_state;
+  sha512_msg_schedule_t ms;
+  uint64x2_t            x[MS_VEC_NUM];
+
+  while(blocks_num--) {
+    my_memcpy(cur_state.w, state->w, sizeof(cur_state.w));
+
+    load_data(x, &ms, data);
+    data += SHA512_BLOCK_BYTE_LEN;
+
+    rounds_0_63(&cur_state, x, &ms);
+    rounds_64_79(&cur_state, &ms);
+    accumulate_state(state, &cur_state);
+  }
+
+  secure_clean(&cur_state, sizeof(cur_state));
+  secure_clean(&ms, sizeof(ms));
+}
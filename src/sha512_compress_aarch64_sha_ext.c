@@ -0,0 +1,120 @@
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+// An implementation of the compress function of SHA512 using the AARCH64
+// SHA512 extension (ARMv8.2). It follows the structure of the OpenSSL
+// assembly (sha512-armv8.S). Every step computes two rounds. The state is kept
+// in pairs of words (a, b), (c, d), (e, f) and (g, h), and every step creates
+// the new (e, f) pair in a fifth register, so the registers rotate between the
+// steps.
+
+#include "neon_defs.h"
+#include "sha512_defs.h"
+
+_INLINE_ void load_data(uint64x2_t ms[8], const uint8_t *data)
+{
+  PRAGMA_LOOP_UNROLL_2
+
+  for(size_t i = 0; i < 2; i++) {
+    uint8x16x4_t d = vld1q_u8_x4(&data[64 * i]);
+    ms[4 * i]      = vreinterpretq_u64_u8(vrev64q_u8(d.val[0]));
+    ms[4 * i + 1]  = vreinterpretq_u64_u8(vrev64q_u8(d.val[1]));
+    ms[4 * i + 2]  = vreinterpretq_u64_u8(vrev64q_u8(d.val[2]));
+    ms[4 * i + 3]  = vreinterpretq_u64_u8(vrev64q_u8(d.val[3]));
+  }
+}
+
+// Computes W[t+16] and W[t+17] from ms[i] = (W[t], W[t+1]) and the seven
+// following pairs
+_INLINE_ uint64x2_t schedule(IN const uint64x2_t ms[8], IN const size_t i)
+{
+  const uint64x2_t w9_10 = vextq_u64(ms[LSB3(i + 4)], ms[LSB3(i + 5)], 1);
+  const uint64x2_t tmp   = vsha512su0q_u64(ms[i], ms[LSB3(i + 1)]);
+
+  return vsha512su1q_u64(tmp, ms[LSB3(i + 7)], w9_10);
+}
+
+// Computes the rounds t and t+1, where wk = (W[t] + K[t], W[t+1] + K[t+1]).
+// On output, gh holds the new (a, b) pair and ef_out the new (e, f) pair. The
+// new (c, d) and (g, h) pairs are ab and ef.
+_INLINE_ void rounds_x2(IN const uint64x2_t ab,
+                        IN const uint64x2_t cd,
+                        IN const uint64x2_t ef,
+                        IN OUT uint64x2_t *gh,
+                        OUT uint64x2_t *ef_out,
+                        IN const uint64x2_t wk)
+{
+  const uint64x2_t fg = vextq_u64(ef, *gh, 1);
+  const uint64x2_t de = vextq_u64(cd, ef, 1);
+
+  // (g + W[t+1] + K[t+1], h + W[t] + K[t])
+  *gh     = vaddq_u64(*gh, vextq_u64(wk, wk, 1));
+  *gh     = vsha512hq_u64(*gh, fg, de);
+  *ef_out = vaddq_u64(cd, *gh);
+  *gh     = vsha512h2q_u64(*gh, cd, ab);
+}
+
+void sha512_compress_aarch64_sha_ext(IN OUT sha512_state_t *state,
+                                     IN const uint8_t *data,
+                                     IN size_t         blocks_num)
+{
+  uint64x2_t ms[8];
+  uint64x2_t st[4];
+  uint64x2_t st_save[4];
+
+  PRAGMA_LOOP_UNROLL_4
+
+  for(size_t i = 0; i < 4; i++) {
+    st[i] = vld1q_u64(&state->w[2 * i]);
+  }
+
+  for(size_t j = 0; j < blocks_num; j++) {
+    uint64x2_t ab = st[0];
+    uint64x2_t cd = st[1];
+    uint64x2_t ef = st[2];
+    uint64x2_t gh = st[3];
+    uint64x2_t ef_out;
+
+    // Save current state
+    PRAGMA_LOOP_UNROLL_4
+
+    for(size_t i = 0; i < 4; i++) {
+      st_save[i] = st[i];
+    }
+
+    load_data(ms, data);
+
+    // Rounds 0-79, two rounds per iteration. The schedule of rounds 16-79 is
+    // computed in place, eight rounds ahead of its use.
+    PRAGMA_LOOP_UNROLL_48
+
+    for(size_t i = 0; i < (SHA512_ROUNDS_NUM / 2); i++) {
+      const uint64x2_t wk = vaddq_u64(ms[LSB3(i)], vld1q_u64(&K512[2 * i]));
+
+      if(i < ((SHA512_ROUNDS_NUM / 2) - 8)) {
+        ms[LSB3(i)] = schedule(ms, LSB3(i));
+      }
+
+      rounds_x2(ab, cd, ef, &gh, &ef_out, wk);
+
+      const uint64x2_t tmp = ab;
+      ab                   = gh;
+      gh                   = ef;
+      ef                   = ef_out;
+      cd                   = tmp;
+    }
+
+    st[0] = vaddq_u64(ab, st_save[0]);
+    st[1] = vaddq_u64(cd, st_save[1]);
+    st[2] = vaddq_u64(ef, st_save[2]);
+    st[3] = vaddq_u64(gh, st_save[3]);
+
+    data += SHA512_BLOCK_BYTE_LEN;
+  }
+
+  PRAGMA_LOOP_UNROLL_4
+
+  for(size_t i = 0; i < 4; i++) {
+    vst1q_u64(&state->w[2 * i], st[i]);
+  }
+}
@@ -58,3 +58,51 @@ void sha512_compress_generic(IN OUT sha512_state_t *state,
   secure_clean(&cur_state, sizeof(cur_state));
   secure_clean(&ms, sizeof(ms));
 }
+
+void sha512_compress_wk_generic(IN OUT sha512_state_t *state,
+                                IN const sha512_word_t wk[SHA512_ROUNDS_NUM])
+{
+  sha512_state_t cur_state;
+
+  my_memcpy(&cur_state, state, sizeof(cur_state));
+
+  // The message schedule is already added to the constants
+  PRAGMA_LOOP_UNROLL_80
+
+  for(size_t i = 0; i < SHA512_ROUNDS_NUM; i++) {
+    sha_round(&cur_state, wk[i], 0);
+  }
+
+  accumulate_state(state, &cur_state);
+  secure_clean(&cur_state, sizeof(cur_state));
+}
+
+void sha512_compress_dgst_generic(IN OUT sha512_state_t *state,
+                                  IN const sha512_state_t *init,
+                                  IN sha512_word_t         len_word)
+{
+  sha512_state_t        cur_state;
+  sha512_msg_schedule_t ms = {0};
+
+  for(size_t i = 0; i < SHA512_HASH_WORDS_NUM; i++) {
+    ms.w[i] = state->w[i];
+  }
+
+  ms.w[SHA512_HASH_WORDS_NUM]      = SHA512_DGST_PAD_END_WORD;
+  ms.w[SHA512_BLOCK_WORDS_NUM - 1] = len_word;
+
+  my_memcpy(state, init, sizeof(*state));
+  my_memcpy(&cur_state, state, sizeof(cur_state));
+
+  PRAGMA_LOOP_UNROLL_16
+
+  for(size_t i = 0; i < SHA512_BLOCK_WORDS_NUM; i++) {
+    sha_round(&cur_state, ms.w[i], K512[i]);
+  }
+
+  rounds_16_79(&cur_state, &ms);
+  accumulate_state(state, &cur_state);
+
+  secure_clean(&cur_state, sizeof(cur_state));
+  secure_clean(&ms, sizeof(ms));
+}
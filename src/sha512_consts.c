@@ -132,3 +132,55 @@ const sha512_word_t K512x4[4 * SHA512_ROUNDS_NUM] = {
   DUP4(K512_72, K512_73), DUP4(K512_74, K512_75), DUP4(K512_76, K512_77),
   DUP4(K512_78, K512_79),
 };
+
+// The padding block of a 128 bytes message is constant, and so is its message
+// schedule. WK512_PAD128[i] = W[i] + K512[i] of that block.
+ALIGN(64)
+const sha512_word_t WK512_PAD128[SHA512_ROUNDS_NUM] = {
+  UINT64_C(0xc28a2f98d728ae22), UINT64_C(0x7137449123ef65cd),
+  UINT64_C(0xb5c0fbcfec4d3b2f), UINT64_C(0xe9b5dba58189dbbc),
+  UINT64_C(0x3956c25bf348b538), UINT64_C(0x59f111f1b605d019),
+  UINT64_C(0x923f82a4af194f9b), UINT64_C(0xab1c5ed5da6d8118),
+  UINT64_C(0xd807aa98a3030242), UINT64_C(0x12835b0145706fbe),
+  UINT64_C(0x243185be4ee4b28c), UINT64_C(0x550c7dc3d5ffb4e2),
+  UINT64_C(0x72be5d74f27b896f), UINT64_C(0x80deb1fe3b1696b1),
+  UINT64_C(0x9bdc06a725c71235), UINT64_C(0xc19bf174cf692a94),
+  UINT64_C(0x649b69c19ef14ad2), UINT64_C(0xf03e4786384f45f3),
+  UINT64_C(0x11c1adc68b8cd5b9), UINT64_C(0x240ca1dc77ad9c65),
+  UINT64_C(0x3df12c6f5b2b0295), UINT64_C(0x6a74852aaeb0e883),
+  UINT64_C(0xdcb4cbddcd4a0114), UINT64_C(0x36f988da845153c5),
+  UINT64_C(0x9b4761d2eea727cb), UINT64_C(0xad33ee6d37b932c2),
+  UINT64_C(0xc143c7fbb90f6167), UINT64_C(0x577487c7d5ef1fd6),
+  UINT64_C(0xe9250da555d6c804), UINT64_C(0x1652326c7c6f319c),
+  UINT64_C(0x9c73c1308a6abe80), UINT64_C(0xedcb859d96f4174f),
+  UINT64_C(0x05992bbc5302ea46), UINT64_C(0xc0515d8c72d32b21),
+  UINT64_C(0xe27760859b58b01c), UINT64_C(0xbd776eecd97e28bf),
+  UINT64_C(0xfec461e497d05dfb), UINT64_C(0x8c65848a09b42f15),
+  UINT64_C(0x1d93677302646f8d), UINT64_C(0x71d7625be0029f9b),
+  UINT64_C(0xed8c8b143b918647), UINT64_C(0x5813345c6ddd5e95),
+  UINT64_C(0x44837edc639f1da6), UINT64_C(0x65309e51db9245d4),
+  UINT64_C(0xa4de07e39af7c84c), UINT64_C(0xea208293cb3b3d17),
+  UINT64_C(0x33abda924feb6a30), UINT64_C(0x8965f30d8a442337),
+  UINT64_C(0x90808dcdb29ea41b), UINT64_C(0xe2d6d8dad96f92ca),
+  UINT64_C(0xfd690c3258486648), UINT64_C(0xddb95f897e662ce2),
+  UINT64_C(0x6b2b08dcc03f02bc), UINT64_C(0x261c68ddf66cc62c),
+  UINT64_C(0xa4f0eddd57c1364d), UINT64_C(0xe35537ec1f29acd2),
+  UINT64_C(0x27e70659eef7b721), UINT64_C(0xdabbb3bf5db9f4c8),
+  UINT64_C(0x34436c1241ad0e37), UINT64_C(0x0302752801d6306b),
+  UINT64_C(0xbf77d7d65bedd8cd), UINT64_C(0xa9871d46c85cd973),
+  UINT64_C(0x5fdbae1fae40e068), UINT64_C(0x468af1bb676f47b0),
+  UINT64_C(0x809520bd379dac58), UINT64_C(0x2766590af071ca9c),
+  UINT64_C(0xff96fca3577ecade), UINT64_C(0x1c490d6456b3b489),
+  UINT64_C(0xe85734c184192ce6), UINT64_C(0x2ba01930bbb71001),
+  UINT64_C(0xabe1acaf661e43eb), UINT64_C(0x120f3b5f15bf003d),
+  UINT64_C(0xfd7d4cd1515c8209), UINT64_C(0x9cfa18c629a0c327),
+  UINT64_C(0x7e39ff2d2a3f2fae), UINT64_C(0x2ff0a5398e575356),
+  UINT64_C(0xc9117833006d097e), UINT64_C(0x09d40c7849733ff8),
+  UINT64_C(0x774d7c8f5f3aa6bd), UINT64_C(0xe04b4161aa09de75)};
+
+ALIGN(64)
+const sha512_word_t IV512[SHA512_HASH_WORDS_NUM] = {
+  UINT64_C(0x6a09e667f3bcc908), UINT64_C(0xbb67ae8584caa73b),
+  UINT64_C(0x3c6ef372fe94f82b), UINT64_C(0xa54ff53a5f1d36f1),
+  UINT64_C(0x510e527fade682d1), UINT64_C(0x9b05688c2b3e6c1f),
+  UINT64_C(0x1f83d9abfb41bd6b), UINT64_C(0x5be0cd19137e2179)};
@@ -0,0 +1,263 @@
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+// SHA512 of messages of a fixed length of 64 or 128 bytes.
+// The padding of such messages is known in advance. A 64 bytes message and its
+// padding fit in a single block, where only the first half is copied from the
+// message. A 128 bytes message is followed by a block that holds only the
+// padding, so the message schedule of that block is constant as well, and it
+// is compressed from the precomputed W[i] + K512[i] (WK512_PAD128) without
+// expanding the schedule.
+
+#include <assert.h>
+
+#include "cpu_features.h"
+#include "sha512_defs.h"
+
+#define MSG64_BYTE_LEN  64
+#define MSG128_BYTE_LEN 128
+
+// The second half of the single block of a 64 bytes message
+ALIGN(64)
+static const uint8_t msg64_pad[SHA512_BLOCK_BYTE_LEN - MSG64_BYTE_LEN] = {
+  SHA512_MSG_END_SYMBOL, [SHA512_BLOCK_BYTE_LEN - MSG64_BYTE_LEN - 2] = 0x02};
+
+// The padding block of a 128 bytes message
+ALIGN(64)
+static const uint8_t msg128_pad_block[SHA512_BLOCK_BYTE_LEN] = {
+  SHA512_MSG_END_SYMBOL, [SHA512_BLOCK_BYTE_LEN - 2] = 0x04};
+
+_INLINE_ void init_state(OUT sha512_state_t *state)
+{
+  for(size_t j = 0; j < SHA512_HASH_WORDS_NUM; j++) {
+    state->w[j] = IV512[j];
+  }
+}
+
+// This implementation assumes running on a Little endian machine
+_INLINE_ void store_dgst(OUT uint8_t *dgst, IN const sha512_state_t *state)
+{
+  for(size_t j = 0; j < SHA512_HASH_WORDS_NUM; j++) {
+    const sha512_word_t w = bswap_64(state->w[j]);
+    my_memcpy(&dgst[j * sizeof(w)], (const uint8_t *)&w, sizeof(w));
+  }
+}
+
+// Compresses the padding block of a 128 bytes message
+_INLINE_ void compress_pad128(IN OUT sha512_state_t *state,
+                             IN const sha_impl_t     impl)
+{
+  switch(impl) {
+    case GENERIC_IMPL: sha512_compress_wk_generic(state, WK512_PAD128); break;
+
+    default: sha512_compress(state, msg128_pad_block, 1, impl); break;
+  }
+}
+
+void sha512_64B(OUT uint8_t *dgst,
+                IN const uint8_t *data,
+                IN const sha_impl_t impl)
+{
+  assert((dgst != NULL) && (data != NULL));
+
+  ALIGN(64) uint8_t block[SHA512_BLOCK_BYTE_LEN];
+  sha512_state_t    s;
+
+  my_memcpy(block, data, MSG64_BYTE_LEN);
+  my_memcpy(&block[MSG64_BYTE_LEN], msg64_pad, sizeof(msg64_pad));
+
+  init_state(&s);
+  sha512_compress(&s, block, 1, sha512_resolve_impl(impl));
+  store_dgst(dgst, &s);
+
+  secure_clean(block, sizeof(block));
+  secure_clean(&s, sizeof(s));
+}
+
+void sha512_128B(OUT uint8_t *dgst,
+                IN const uint8_t *data,
+                IN const sha_impl_t impl)
+{
+  assert((dgst != NULL) && (data != NULL));
+
+  const sha_impl_t single_impl = sha512_resolve_impl(impl);
+  sha512_state_t   s;
+
+  init_state(&s);
+  sha512_compress(&s, data, 1, single_impl);
+  compress_pad128(&s, single_impl);
+  store_dgst(dgst, &s);
+
+  secure_clean(&s, sizeof(s));
+}
+
+typedef struct lanes_s {
+  sha512_multi_compress_t    compress;
+  sha512_multi_compress_wk_t compress_wk;
+  size_t                     lanes_num;
+  sha_impl_t                 single_impl;
+} lanes_t;
+
+// Returns 0 if impl has no multi-buffer implementation
+_INLINE_ int init_lanes(OUT lanes_t *lanes, IN const sha_impl_t impl)
+{
+  const sha_impl_t multi_impl = sha512_multi_resolve_impl(impl);
+
+  lanes->compress    = sha512_multi_compress_func(&lanes->lanes_num, multi_impl);
+  lanes->compress_wk = sha512_multi_compress_wk_func(multi_impl);
+  lanes->single_impl = sha512_resolve_impl(impl);
+
+  return (lanes->compress != NULL);
+}
+
+_INLINE_ void init_lanes_state(OUT sha512_lanes_state_t *state,
+                               IN const size_t           num)
+{
+  for(size_t j = 0; j < SHA512_HASH_WORDS_NUM; j++) {
+    for(size_t l = 0; l < num; l++) {
+      state->w[j][l] = IV512[j];
+    }
+  }
+}
+
+_INLINE_ void store_lanes_dgst(OUT uint8_t *dgst,
+                               IN const sha512_lanes_state_t *state,
+                               IN const size_t                num)
+{
+  for(size_t l = 0; l < num; l++) {
+    for(size_t j = 0; j < SHA512_HASH_WORDS_NUM; j++) {
+      const sha512_word_t w = bswap_64(state->w[j][l]);
+      my_memcpy(&dgst[(l * SHA512_HASH_BYTE_LEN) + (j * sizeof(w))],
+                (const uint8_t *)&w, sizeof(w));
+    }
+  }
+}
+
+// Hashes num <= lanes_num messages of 64 bytes
+_INLINE_ void hash64_lanes(OUT uint8_t *dgst,
+                           IN const uint8_t *data,
+                           IN const size_t   num,
+                           IN const lanes_t *lanes)
+{
+  ALIGN(64) uint8_t block[SHA512_MAX_LANES_NUM][SHA512_BLOCK_BYTE_LEN];
+
+  sha512_lanes_state_t state;
+  const uint8_t *      ptr[SHA512_MAX_LANES_NUM];
+  uint32_t             lanes_mask = 0;
+
+  for(size_t l = 0; l < num; l++) {
+    my_memcpy(block[l], &data[l * MSG64_BYTE_LEN], MSG64_BYTE_LEN);
+    my_memcpy(&block[l][MSG64_BYTE_LEN], msg64_pad, sizeof(msg64_pad));
+
+    ptr[l] = block[l];
+    lanes_mask |= (UINT32_C(1) << l);
+  }
+
+  init_lanes_state(&state, num);
+  lanes->compress(&state, ptr, 1, lanes_mask);
+  store_lanes_dgst(dgst, &state, num);
+
+  secure_clean(block, sizeof(block));
+  secure_clean(&state, sizeof(state));
+}
+
+// Hashes num <= lanes_num messages of 128 bytes. The messages are read in place
+// and only the padding block is compressed differently.
+_INLINE_ void hash128_lanes(OUT uint8_t *dgst,
+                           IN const uint8_t *data,
+                           IN const size_t   num,
+                           IN const lanes_t *lanes)
+{
+  sha512_lanes_state_t state;
+  const uint8_t *      ptr[SHA512_MAX_LANES_NUM];
+  uint32_t             lanes_mask = 0;
+
+  for(size_t l = 0; l < num; l++) {
+    ptr[l] = &data[l * MSG128_BYTE_LEN];
+    lanes_mask |= (UINT32_C(1) << l);
+  }
+
+  init_lanes_state(&state, num);
+  lanes->compress(&state, ptr, 1, lanes_mask);
+
+  if(lanes->compress_wk != NULL) {
+    lanes->compress_wk(&state, WK512_PAD128, lanes_mask);
+  } else {
+    for(size_t l = 0; l < num; l++) {
+      ptr[l] = msg128_pad_block;
+    }
+    lanes->compress(&state, ptr, 1, lanes_mask);
+  }
+
+  store_lanes_dgst(dgst, &state, num);
+
+  secure_clean(&state, sizeof(state));
+}
+
+void sha512_64B_multi(OUT uint8_t *dgst,
+                      IN const uint8_t *data,
+                      IN const size_t   msgs_num,
+                      IN const sha_impl_t impl)
+{
+  assert((dgst != NULL) || (msgs_num == 0));
+  assert((data != NULL) || (msgs_num == 0));
+
+  lanes_t lanes;
+
+  // No multi-buffer implementation, hash the messages one by one
+  if(!init_lanes(&lanes, impl)) {
+    for(size_t i = 0; i < msgs_num; i++) {
+      sha512_64B(&dgst[i * SHA512_HASH_BYTE_LEN], &data[i * MSG64_BYTE_LEN],
+                 lanes.single_impl);
+    }
+    return;
+  }
+
+  for(size_t i = 0; i < msgs_num; i += lanes.lanes_num) {
+    const size_t rem_num = msgs_num - i;
+    const size_t num = (rem_num < lanes.lanes_num) ? rem_num : lanes.lanes_num;
+
+    uint8_t *      out = &dgst[i * SHA512_HASH_BYTE_LEN];
+    const uint8_t *in  = &data[i * MSG64_BYTE_LEN];
+
+    if(num == 1) {
+      sha512_64B(out, in, lanes.single_impl);
+    } else {
+      hash64_lanes(out, in, num, &lanes);
+    }
+  }
+}
+
+void sha512_128B_multi(OUT uint8_t *dgst,
+                      IN const uint8_t *data,
+                      IN const size_t   msgs_num,
+                      IN const sha_impl_t impl)
+{
+  assert((dgst != NULL) || (msgs_num == 0));
+  assert((data != NULL) || (msgs_num == 0));
+
+  lanes_t lanes;
+
+  // No multi-buffer implementation, hash the messages one by one
+  if(!init_lanes(&lanes, impl)) {
+    for(size_t i = 0; i < msgs_num; i++) {
+      sha512_128B(&dgst[i * SHA512_HASH_BYTE_LEN], &data[i * MSG128_BYTE_LEN],
+                 lanes.single_impl);
+    }
+    return;
+  }
+
+  for(size_t i = 0; i < msgs_num; i += lanes.lanes_num) {
+    const size_t rem_num = msgs_num - i;
+    const size_t num = (rem_num < lanes.lanes_num) ? rem_num : lanes.lanes_num;
+
+    uint8_t *      out = &dgst[i * SHA512_HASH_BYTE_LEN];
+    const uint8_t *in  = &data[i * MSG128_BYTE_LEN];
+
+    if(num == 1) {
+      sha512_128B(out, in, lanes.single_impl);
+    } else {
+      hash128_lanes(out, in, num, &lanes);
+    }
+  }
+}
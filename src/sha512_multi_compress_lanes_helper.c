@@ -0,0 +1,161 @@
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+// A multi-buffer implementation of the compress function of SHA512.
+// Every 64-bit lane of a vector register holds a word of a different message.
+// Therefore, unlike the single buffer AVX* implementations that only vectorize
+// the message schedule, here all the 80 rounds are computed in SIMD.
+
+// This file depends on vec_t and on the macros ADD64, SET1_64, SRL64 and
+// LANES_ROR64. The including file may also define LANES_XOR3, LANES_Ch and
+// LANES_Maj with instructions that compute them at once (e.g., the AVX512
+// VPTERNLOG), and the type lanes_mask_t of the active lanes together with
+// LANES_MASK_ADD64 (e.g., an AVX512 opmask and a masked add).
+
+#if !defined(LANES_XOR3)
+#  define LANES_XOR3(a, b, c) ((a) ^ (b) ^ (c))
+#endif
+
+// Equivalent to Ch/Maj of sha512_defs.h with fewer operations
+#if !defined(LANES_Ch)
+#  define LANES_Ch(x, y, z)  ((z) ^ ((x) & ((y) ^ (z))))
+#  define LANES_Maj(x, y, z) (((x) & (y)) | ((z) & ((x) | (y))))
+#endif
+
+// By default, the active lanes are the lanes of a vector that are all ones
+#if !defined(LANES_MASK_ADD64)
+typedef vec_t lanes_mask_t;
+#  define LANES_MASK_ADD64(a, mask, b) ADD64(a, (b) & (mask))
+#endif
+
+#define LANES_Sigma0(x) \
+  LANES_XOR3(LANES_ROR64(x, Sigma0_0), LANES_ROR64(x, Sigma0_1), \
+             LANES_ROR64(x, Sigma0_2))
+#define LANES_Sigma1(x) \
+  LANES_XOR3(LANES_ROR64(x, Sigma1_0), LANES_ROR64(x, Sigma1_1), \
+             LANES_ROR64(x, Sigma1_2))
+#define LANES_sigma0(x) \
+  LANES_XOR3(LANES_ROR64(x, sigma0_0), LANES_ROR64(x, sigma0_1), \
+             SRL64(x, sigma0_2))
+#define LANES_sigma1(x) \
+  LANES_XOR3(LANES_ROR64(x, sigma1_0), LANES_ROR64(x, sigma1_1), \
+             SRL64(x, sigma1_2))
+
+_INLINE_ void lanes_round(IN OUT vec_t s[8],
+                          IN const vec_t         x,
+                          IN const sha512_word_t k)
+{
+  const vec_t t1 = ADD64(ADD64(s[7], LANES_Sigma1(s[4])),
+                         ADD64(LANES_Ch(s[4], s[5], s[6]), ADD64(x, SET1_64(k))));
+  const vec_t t2 = ADD64(LANES_Sigma0(s[0]), LANES_Maj(s[0], s[1], s[2]));
+
+  // The compiler eliminates these moves when the rounds are unrolled
+  s[7] = s[6];
+  s[6] = s[5];
+  s[5] = s[4];
+  s[4] = ADD64(s[3], t1);
+  s[3] = s[2];
+  s[2] = s[1];
+  s[1] = s[0];
+  s[0] = ADD64(t1, t2);
+}
+
+// Compresses one block of every lane. x holds the (transposed and byte
+// swapped) block words and is overwritten by the message schedule.
+// The inactive lanes of lanes_mask are not accumulated into state.
+_INLINE_ void lanes_compress_block(IN OUT vec_t state[8],
+                                   IN OUT vec_t x[16],
+                                   IN const lanes_mask_t lanes_mask)
+{
+  vec_t s[8];
+
+  PRAGMA_LOOP_UNROLL_8
+
+  for(size_t i = 0; i < 8; i++) {
+    s[i] = state[i];
+  }
+
+  PRAGMA_LOOP_UNROLL_16
+
+  for(size_t i = 0; i < SHA512_BLOCK_WORDS_NUM; i++) {
+    lanes_round(s, x[i], K512[i]);
+  }
+
+  PRAGMA_LOOP_UNROLL_64
+
+  for(size_t i = SHA512_BLOCK_WORDS_NUM; i < SHA512_ROUNDS_NUM; i++) {
+    x[LSB4(i)] = ADD64(ADD64(x[LSB4(i)], LANES_sigma0(x[LSB4(i + 1)])),
+                       ADD64(LANES_sigma1(x[LSB4(i + 14)]), x[LSB4(i + 9)]));
+    lanes_round(s, x[LSB4(i)], K512[i]);
+  }
+
+  PRAGMA_LOOP_UNROLL_8
+
+  for(size_t i = 0; i < 8; i++) {
+    state[i] = LANES_MASK_ADD64(state[i], lanes_mask, s[i]);
+  }
+}
+
+// Compresses a block whose message schedule is the same in every lane and is
+// known in advance (see sha512_compress_wk_generic). Only the rounds are
+// computed.
+_INLINE_ void lanes_compress_wk(IN OUT vec_t state[8],
+                                IN const sha512_word_t wk[SHA512_ROUNDS_NUM],
+                                IN const lanes_mask_t  lanes_mask)
+{
+  vec_t s[8];
+
+  PRAGMA_LOOP_UNROLL_8
+
+  for(size_t i = 0; i < 8; i++) {
+    s[i] = state[i];
+  }
+
+  PRAGMA_LOOP_UNROLL_80
+
+  for(size_t i = 0; i < SHA512_ROUNDS_NUM; i++) {
+    lanes_round(s, SET1_64(wk[i]), 0);
+  }
+
+  PRAGMA_LOOP_UNROLL_8
+
+  for(size_t i = 0; i < 8; i++) {
+    state[i] = LANES_MASK_ADD64(state[i], lanes_mask, s[i]);
+  }
+}
+
+// Compresses, in every active lane, the block that holds the digest in the
+// state of the lane and the padding of a message of len_word bits, starting
+// from the state of the lane in init (see sha512_compress_dgst_generic). The
+// state words of a lane are the message words of its digest block, and are
+// already transposed in state. The inactive lanes of lanes_mask are set to
+// their init, so the caller stores only the active lanes.
+_INLINE_ void lanes_compress_dgst(IN OUT vec_t state[8],
+                                  IN const vec_t         init[8],
+                                  IN const sha512_word_t len_word,
+                                  IN const lanes_mask_t  lanes_mask)
+{
+  const vec_t zero = SET1_64(0);
+
+  vec_t x[16];
+
+  PRAGMA_LOOP_UNROLL_8
+
+  for(size_t i = 0; i < 8; i++) {
+    x[i]     = state[i];
+    state[i] = init[i];
+  }
+
+  x[8] = SET1_64(SHA512_DGST_PAD_END_WORD);
+
+  PRAGMA_LOOP_UNROLL_8
+
+  for(size_t i = 9; i < 15; i++) {
+    x[i] = zero;
+  }
+
+  x[15] = SET1_64(len_word);
+
+  lanes_compress_block(state, x, lanes_mask);
+  secure_clean(x, sizeof(x));
+}
@@ -0,0 +1,161 @@
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+// A multi-buffer implementation of the compress function of SHA512 using avx2.
+// Hashes 4 independent messages in parallel (one message per 64-bit lane).
+
+#include "internal/avx2_defs.h"
+#include "sha512_defs.h"
+
+#define LANES_NUM (sizeof(vec_t) / sizeof(sha512_word_t))
+
+// AVX2 has no rotate instruction, it is available only with AVX512VL
+#if defined(ALTERNATIVE_AVX512_IMPL)
+#  define LANES_ROR64(a, imm8) ROR64(a, imm8)
+#else
+#  define LANES_ROR64(a, imm8) (SRL64(a, imm8) | SLL64(a, 64 - (imm8)))
+#endif
+
+// This file depends on vec_t and on the macros ADD64, SET1_64, SRL64 and
+// LANES_ROR64
+#include "sha512_multi_compress_lanes_helper.c"
+
+// Transposes the 4x4 matrix of 64-bit words r, so that out[j] holds the j-th
+// word of every row.
+_INLINE_ void transpose_4x4(OUT vec_t out[4], IN const vec_t r[4])
+{
+  // r[0][0], r[1][0] | r[0][2], r[1][2] (and similarly for the odd words)
+  const vec_t t0 = _mm256_unpacklo_epi64(r[0], r[1]);
+  const vec_t t1 = _mm256_unpackhi_epi64(r[0], r[1]);
+  const vec_t t2 = _mm256_unpacklo_epi64(r[2], r[3]);
+  const vec_t t3 = _mm256_unpackhi_epi64(r[2], r[3]);
+
+  out[0] = _mm256_permute2x128_si256(t0, t2, 0x20);
+  out[1] = _mm256_permute2x128_si256(t1, t3, 0x20);
+  out[2] = _mm256_permute2x128_si256(t0, t2, 0x31);
+  out[3] = _mm256_permute2x128_si256(t1, t3, 0x31);
+}
+
+// Loads the block at offset of every active lane into x (transposed and byte
+// swapped). The words of inactive lanes are set to zero.
+_INLINE_ void load_lanes(OUT vec_t x[16],
+                         IN const uint8_t *data[],
+                         IN const size_t   offset,
+                         IN const uint32_t lanes_mask)
+{
+  // 64 bits (8 bytes) swap masks
+  const vec_t shuf_mask =
+    _mm256_set_epi64x(DUP2(0x08090a0b0c0d0e0f, 0x0001020304050607));
+
+  vec_t r[LANES_NUM];
+
+  PRAGMA_LOOP_UNROLL_4
+
+  for(size_t j = 0; j < 4; j++) {
+    PRAGMA_LOOP_UNROLL_4
+
+    for(size_t i = 0; i < LANES_NUM; i++) {
+      if((lanes_mask >> i) & 1) {
+        r[i] = LOAD(&data[i][offset + (j * sizeof(vec_t))]);
+      } else {
+        r[i] = _mm256_setzero_si256();
+      }
+    }
+
+    transpose_4x4(&x[j * LANES_NUM], r);
+  }
+
+  PRAGMA_LOOP_UNROLL_16
+
+  for(size_t i = 0; i < SHA512_BLOCK_WORDS_NUM; i++) {
+    x[i] = SHUF8(x[i], shuf_mask);
+  }
+}
+
+void sha512_multi_compress_x86_64_avx2(IN OUT sha512_lanes_state_t *state,
+                                       IN const uint8_t *data[],
+                                       IN size_t         blocks_num,
+                                       IN uint32_t       lanes_mask)
+{
+  const vec_t lanes_bits = _mm256_setr_epi64x(1, 2, 4, 8);
+  const vec_t lanes_vmask =
+    _mm256_cmpeq_epi64(SET1_64(lanes_mask) & lanes_bits, lanes_bits);
+
+  vec_t s[8];
+  vec_t x[16];
+
+  PRAGMA_LOOP_UNROLL_8
+
+  for(size_t i = 0; i < 8; i++) {
+    s[i] = LOAD(state->w[i]);
+  }
+
+  for(size_t b = 0; b < blocks_num; b++) {
+    load_lanes(x, data, b * SHA512_BLOCK_BYTE_LEN, lanes_mask);
+    lanes_compress_block(s, x, lanes_vmask);
+  }
+
+  PRAGMA_LOOP_UNROLL_8
+
+  for(size_t i = 0; i < 8; i++) {
+    STORE(state->w[i], s[i]);
+  }
+
+  secure_clean(x, sizeof(x));
+}
+
+void sha512_multi_compress_wk_x86_64_avx2(
+  IN OUT sha512_lanes_state_t *state,
+  IN const sha512_word_t wk[SHA512_ROUNDS_NUM],
+  IN uint32_t            lanes_mask)
+{
+  const vec_t lanes_bits = _mm256_setr_epi64x(1, 2, 4, 8);
+  const vec_t lanes_vmask =
+    _mm256_cmpeq_epi64(SET1_64(lanes_mask) & lanes_bits, lanes_bits);
+
+  vec_t s[8];
+
+  PRAGMA_LOOP_UNROLL_8
+
+  for(size_t i = 0; i < 8; i++) {
+    s[i] = LOAD(state->w[i]);
+  }
+
+  lanes_compress_wk(s, wk, lanes_vmask);
+
+  PRAGMA_LOOP_UNROLL_8
+
+  for(size_t i = 0; i < 8; i++) {
+    STORE(state->w[i], s[i]);
+  }
+}
+
+void sha512_multi_compress_dgst_x86_64_avx2(
+  IN OUT sha512_lanes_state_t *state,
+  IN const sha512_lanes_state_t *init,
+  IN sha512_word_t               len_word,
+  IN uint32_t                    lanes_mask)
+{
+  const vec_t lanes_bits = _mm256_setr_epi64x(1, 2, 4, 8);
+  const vec_t lanes_vmask =
+    _mm256_cmpeq_epi64(SET1_64(lanes_mask) & lanes_bits, lanes_bits);
+
+  vec_t s[8];
+  vec_t t[8];
+
+  PRAGMA_LOOP_UNROLL_8
+
+  for(size_t i = 0; i < 8; i++) {
+    s[i] = LOAD(state->w[i]);
+    t[i] = LOAD(init->w[i]);
+  }
+
+  lanes_compress_dgst(s, t, len_word, lanes_vmask);
+
+  // Leave the state of the inactive lanes as is
+  PRAGMA_LOOP_UNROLL_8
+
+  for(size_t i = 0; i < 8; i++) {
+    _mm256_maskstore_epi64((long long *)state->w[i], lanes_vmask, s[i]);
+  }
+}
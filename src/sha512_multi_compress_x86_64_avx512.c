@@ -0,0 +1,176 @@
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+// A multi-buffer implementation of the compress function of SHA512 using
+// avx512. Hashes 8 independent messages in parallel (one message per 64-bit
+// lane). Every round is computed in SIMD: the sigmas with the 64-bit rotates
+// and a three-input XOR, and Ch/Maj with a single VPTERNLOGQ each. The active
+// lanes are an opmask, so a partly filled batch only masks the final
+// additions.
+
+#include "internal/avx512_defs.h"
+#include "sha512_defs.h"
+
+#define LANES_NUM            (sizeof(vec_t) / sizeof(sha512_word_t))
+#define LANES_ROR64(a, imm8) ROR64(a, imm8)
+
+// The immediates are the truth tables of the functions of (a, b, c)
+#define LANES_XOR3(a, b, c) (_mm512_ternarylogic_epi64(a, b, c, 0x96))
+#define LANES_Ch(x, y, z)   (_mm512_ternarylogic_epi64(x, y, z, 0xca))
+#define LANES_Maj(x, y, z)  (_mm512_ternarylogic_epi64(x, y, z, 0xe8))
+
+typedef __mmask8 lanes_mask_t;
+#define LANES_MASK_ADD64(a, mask, b) MADD64(a, mask, a, b)
+
+// This file depends on vec_t and on the macros ADD64, SET1_64, SRL64,
+// LANES_ROR64 and optionally LANES_XOR3, LANES_Ch, LANES_Maj and
+// LANES_MASK_ADD64
+#include "sha512_multi_compress_lanes_helper.c"
+
+// Transposes the 8x8 matrix of 64-bit words r, so that out[j] holds the j-th
+// word of every row.
+_INLINE_ void transpose_8x8(OUT vec_t out[8], IN const vec_t r[8])
+{
+  vec_t t[8];
+
+  // In every 128-bit value k, t[2i+j] holds the word 2k+j of the rows 2i,2i+1
+  PRAGMA_LOOP_UNROLL_4
+
+  for(size_t i = 0; i < 4; i++) {
+    t[2 * i]     = _mm512_unpacklo_epi64(r[2 * i], r[2 * i + 1]);
+    t[2 * i + 1] = _mm512_unpackhi_epi64(r[2 * i], r[2 * i + 1]);
+  }
+
+  // Transpose the 4x4 matrices of 128-bit values
+  PRAGMA_LOOP_UNROLL_2
+
+  for(size_t j = 0; j < 2; j++) {
+    const vec_t v0 = _mm512_shuffle_i64x2(t[j], t[2 + j], 0x44);
+    const vec_t v1 = _mm512_shuffle_i64x2(t[j], t[2 + j], 0xee);
+    const vec_t v2 = _mm512_shuffle_i64x2(t[4 + j], t[6 + j], 0x44);
+    const vec_t v3 = _mm512_shuffle_i64x2(t[4 + j], t[6 + j], 0xee);
+
+    out[j]     = _mm512_shuffle_i64x2(v0, v2, 0x88);
+    out[j + 2] = _mm512_shuffle_i64x2(v0, v2, 0xdd);
+    out[j + 4] = _mm512_shuffle_i64x2(v1, v3, 0x88);
+    out[j + 6] = _mm512_shuffle_i64x2(v1, v3, 0xdd);
+  }
+}
+
+// Loads the block at offset of every active lane into x (transposed and byte
+// swapped). The words of inactive lanes are set to zero.
+_INLINE_ void load_lanes(OUT vec_t x[16],
+                         IN const uint8_t *data[],
+                         IN const size_t   offset,
+                         IN const uint32_t lanes_mask)
+{
+  // 64 bits (8 bytes) swap masks
+  const vec_t shuf_mask =
+    _mm512_set_epi64(DUP4(0x08090a0b0c0d0e0f, 0x0001020304050607));
+
+  vec_t r[LANES_NUM];
+
+  PRAGMA_LOOP_UNROLL_2
+
+  for(size_t j = 0; j < 2; j++) {
+    PRAGMA_LOOP_UNROLL_8
+
+    for(size_t i = 0; i < LANES_NUM; i++) {
+      if((lanes_mask >> i) & 1) {
+        r[i] = LOAD(&data[i][offset + (j * sizeof(vec_t))]);
+      } else {
+        r[i] = _mm512_setzero_si512();
+      }
+    }
+
+    transpose_8x8(&x[j * LANES_NUM], r);
+  }
+
+  PRAGMA_LOOP_UNROLL_16
+
+  for(size_t i = 0; i < SHA512_BLOCK_WORDS_NUM; i++) {
+    x[i] = SHUF8(x[i], shuf_mask);
+  }
+}
+
+void sha512_multi_compress_x86_64_avx512(IN OUT sha512_lanes_state_t *state,
+                                         IN const uint8_t *data[],
+                                         IN size_t         blocks_num,
+                                         IN uint32_t       lanes_mask)
+{
+  const lanes_mask_t lanes_kmask = (lanes_mask_t)lanes_mask;
+
+  vec_t s[8];
+  vec_t x[16];
+
+  PRAGMA_LOOP_UNROLL_8
+
+  for(size_t i = 0; i < 8; i++) {
+    s[i] = LOAD(state->w[i]);
+  }
+
+  for(size_t b = 0; b < blocks_num; b++) {
+    load_lanes(x, data, b * SHA512_BLOCK_BYTE_LEN, lanes_mask);
+    lanes_compress_block(s, x, lanes_kmask);
+  }
+
+  PRAGMA_LOOP_UNROLL_8
+
+  for(size_t i = 0; i < 8; i++) {
+    STORE(state->w[i], s[i]);
+  }
+
+  secure_clean(x, sizeof(x));
+}
+
+void sha512_multi_compress_wk_x86_64_avx512(
+  IN OUT sha512_lanes_state_t *state,
+  IN const sha512_word_t wk[SHA512_ROUNDS_NUM],
+  IN uint32_t            lanes_mask)
+{
+  const lanes_mask_t lanes_kmask = (lanes_mask_t)lanes_mask;
+
+  vec_t s[8];
+
+  PRAGMA_LOOP_UNROLL_8
+
+  for(size_t i = 0; i < 8; i++) {
+    s[i] = LOAD(state->w[i]);
+  }
+
+  lanes_compress_wk(s, wk, lanes_kmask);
+
+  PRAGMA_LOOP_UNROLL_8
+
+  for(size_t i = 0; i < 8; i++) {
+    STORE(state->w[i], s[i]);
+  }
+}
+
+void sha512_multi_compress_dgst_x86_64_avx512(
+  IN OUT sha512_lanes_state_t *state,
+  IN const sha512_lanes_state_t *init,
+  IN sha512_word_t               len_word,
+  IN uint32_t                    lanes_mask)
+{
+  const lanes_mask_t lanes_kmask = (lanes_mask_t)lanes_mask;
+
+  vec_t s[8];
+  vec_t t[8];
+
+  PRAGMA_LOOP_UNROLL_8
+
+  for(size_t i = 0; i < 8; i++) {
+    s[i] = LOAD(state->w[i]);
+    t[i] = LOAD(init->w[i]);
+  }
+
+  lanes_compress_dgst(s, t, len_word, lanes_kmask);
+
+  // Leave the state of the inactive lanes as is
+  PRAGMA_LOOP_UNROLL_8
+
+  for(size_t i = 0; i < 8; i++) {
+    _mm512_mask_storeu_epi64(state->w[i], lanes_kmask, s[i]);
+  }
+}
@@ -0,0 +1,200 @@
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+// Hashing of files through memory mappings.
+// A regular file is mapped in windows of MAP_WINDOW_BYTE_LEN bytes and every
+// window is passed to sha*_update directly, so the full blocks are compressed
+// from the page cache without copying them into a buffer. The windows are
+// multiples of the block size, so only the tail of the file goes through the
+// padding of sha*_final. Files that cannot be mapped (e.g., pipes) and files
+// that report a size of 0 (e.g., in procfs and sysfs) are read into a buffer.
+
+// For madvise and MADV_HUGEPAGE
+#define _DEFAULT_SOURCE
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "defs.h"
+#include "sha.h"
+
+// A multiple of the block sizes, of the page size and of the huge page size
+#define MAP_WINDOW_BYTE_LEN (UINT64_C(1) << 30)
+
+#define READ_BUF_BYTE_LEN (1UL << 16)
+
+// Hashes len bytes of data into the context of the hashed file
+typedef void (*update_func_t)(IN OUT void *ctx,
+                              IN const uint8_t *data,
+                              IN size_t         len);
+
+_INLINE_ void update256(IN OUT void *ctx,
+                        IN const uint8_t *data,
+                        IN const size_t   len)
+{
+  sha256_update((sha256_ctx_t *)ctx, data, len);
+}
+
+_INLINE_ void update512(IN OUT void *ctx,
+                        IN const uint8_t *data,
+                        IN const size_t   len)
+{
+  sha512_update((sha512_ctx_t *)ctx, data, len);
+}
+
+// Maps the file in windows and hashes them in order. Accessing the pages of a
+// mapping beyond the end of the file raises SIGBUS, so the size of the file
+// is checked again before every window, and a file that was truncated since
+// it was opened fails with EIO. A truncation while a window is hashed is not
+// caught (see sha.h).
+_INLINE_ int hash_mapped(IN const int      fd,
+                         IN const uint64_t file_byte_len,
+                         IN update_func_t  update,
+                         IN OUT void *     ctx)
+{
+  struct stat st;
+
+  for(uint64_t pos = 0; pos < file_byte_len; pos += MAP_WINDOW_BYTE_LEN) {
+    const uint64_t rem_len = file_byte_len - pos;
+    const size_t   len =
+      (size_t)((rem_len < MAP_WINDOW_BYTE_LEN) ? rem_len : MAP_WINDOW_BYTE_LEN);
+
+    if(fstat(fd, &st) != 0) {
+      return -1;
+    }
+
+    if((uint64_t)st.st_size < (pos + len)) {
+      errno = EIO;
+      return -1;
+    }
+
+    void *map = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, (off_t)pos);
+    if(map == MAP_FAILED) {
+      return -1;
+    }
+
+    // The advice only affects performance, so its failures are ignored:
+    // increase the read-ahead, back the mapping with huge pages where the
+    // kernel supports it for files, and start reading the window now
+    (void)madvise(map, len, MADV_SEQUENTIAL);
+#if defined(MADV_HUGEPAGE)
+    (void)madvise(map, len, MADV_HUGEPAGE);
+#endif
+    (void)madvise(map, len, MADV_WILLNEED);
+
+    update(ctx, (const uint8_t *)map, len);
+
+    (void)munmap(map, len);
+  }
+
+  return 0;
+}
+
+// Reads the file until its end and hashes it in chunks
+_INLINE_ int hash_read(IN const int     fd,
+                       IN update_func_t update,
+                       IN OUT void *    ctx)
+{
+  ALIGN(64) uint8_t buf[READ_BUF_BYTE_LEN];
+  ssize_t           len;
+
+  while((len = read(fd, buf, sizeof(buf))) != 0) {
+    if(len < 0) {
+      if(errno == EINTR) {
+        continue;
+      }
+      return -1;
+    }
+
+    update(ctx, buf, (size_t)len);
+  }
+
+  return 0;
+}
+
+_INLINE_ int hash_file(IN const char *  path,
+                       IN update_func_t update,
+                       IN OUT void *    ctx)
+{
+  struct stat st;
+  int         ret;
+  int         err;
+
+  const int fd = open(path, O_RDONLY);
+  if(fd < 0) {
+    return -1;
+  }
+
+  if(fstat(fd, &st) != 0) {
+    ret = -1;
+  } else if(S_ISREG(st.st_mode) && (st.st_size != 0)) {
+    ret = hash_mapped(fd, (uint64_t)st.st_size, update, ctx);
+  } else {
+    // The regular files of procfs and sysfs report a size of 0, but are not
+    // necessarily empty
+    ret = hash_read(fd, update, ctx);
+  }
+
+  // Keep the errno of the failure
+  err = errno;
+  (void)close(fd);
+  errno = err;
+
+  return ret;
+}
+
+int sha256_file(OUT uint8_t *dgst,
+                IN const char *     path,
+                IN const sha_impl_t impl)
+{
+  assert((dgst != NULL) && (path != NULL));
+
+  // Only the public API is used here, and the context is opaque
+  sha256_ctx_t *ctx = sha256_ctx_new();
+  int           ret = -1;
+
+  if(ctx == NULL) {
+    errno = ENOMEM;
+    return -1;
+  }
+
+  sha256_init(ctx, impl);
+
+  if(hash_file(path, update256, ctx) == 0) {
+    sha256_final(dgst, ctx);
+    ret = 0;
+  }
+
+  sha256_ctx_free(ctx);
+  return ret;
+}
+
+int sha512_file(OUT uint8_t *dgst,
+                IN const char *     path,
+                IN const sha_impl_t impl)
+{
+  assert((dgst != NULL) && (path != NULL));
+
+  // Only the public API is used here, and the context is opaque
+  sha512_ctx_t *ctx = sha512_ctx_new();
+  int           ret = -1;
+
+  if(ctx == NULL) {
+    errno = ENOMEM;
+    return -1;
+  }
+
+  sha512_init(ctx, impl);
+
+  if(hash_file(path, update512, ctx) == 0) {
+    sha512_final(dgst, ctx);
+    ret = 0;
+  }
+
+  sha512_ctx_free(ctx);
+  return ret;
+}
@@ -0,0 +1,325 @@
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+// Hashing of files with direct (O_DIRECT) reads.
+// A reader thread fills a ring of DIRECT_BUFS_NUM aligned buffers in file
+// order, while the calling thread compresses the buffers that are already
+// full. The reads bypass the page cache, and as long as the device keeps up,
+// the hashing thread never waits for I/O. The buffers are multiples of the
+// block sizes, so sha*_update compresses them in place and only the tail of
+// the file goes through the padding of sha*_final.
+
+// For O_DIRECT and pread
+#define _GNU_SOURCE
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "defs.h"
+#include "sha.h"
+
+// O_DIRECT requires the buffers, the offsets and the lengths of the reads to
+// be aligned to the logical block size of the device
+#define DIRECT_ALIGN_BYTE_LEN (4096UL)
+#define DIRECT_BUF_BYTE_LEN   (1UL << 22)
+#define DIRECT_BUFS_NUM       (4)
+
+// Hashes len bytes of data into the context of the hashed file
+typedef void (*update_func_t)(IN OUT void *ctx,
+                              IN const uint8_t *data,
+                              IN size_t         len);
+
+// A buffer of the ring. len is the number of bytes that were read into it,
+// which is smaller than DIRECT_BUF_BYTE_LEN only at the end of the file.
+typedef struct direct_buf_s {
+  uint8_t *data;
+  size_t   len;
+  int      full;
+} direct_buf_t;
+
+typedef struct direct_reader_s {
+  direct_buf_t bufs[DIRECT_BUFS_NUM];
+  int          fd;
+
+  pthread_mutex_t lock;
+  pthread_cond_t  filled;
+  pthread_cond_t  emptied;
+
+  // Set by the reader on a read error (with the errno of the error), and by
+  // the hashing thread when it stops early
+  int err;
+  int stop;
+} direct_reader_t;
+
+_INLINE_ void update256(IN OUT void *ctx,
+                        IN const uint8_t *data,
+                        IN const size_t   len)
+{
+  sha256_update((sha256_ctx_t *)ctx, data, len);
+}
+
+_INLINE_ void update512(IN OUT void *ctx,
+                        IN const uint8_t *data,
+                        IN const size_t   len)
+{
+  sha512_update((sha512_ctx_t *)ctx, data, len);
+}
+
+#if defined(O_DIRECT)
+// Switches fd to reads through the page cache. Returns -1, without changing
+// errno, when fd is not opened with O_DIRECT.
+_INLINE_ int clear_direct(IN const int fd)
+{
+  const int flags = fcntl(fd, F_GETFL);
+
+  if((flags < 0) || ((flags & O_DIRECT) == 0)) {
+    return -1;
+  }
+
+  return fcntl(fd, F_SETFL, flags & ~O_DIRECT);
+}
+#endif
+
+// Reads up to len bytes at offset, until the end of the file. Returns the
+// number of bytes that were read, or -1 on error. A short read does not end
+// the file, only a read that returns 0 does.
+_INLINE_ ssize_t read_full(IN const int fd,
+                           OUT uint8_t *buf,
+                           IN const size_t len,
+                           IN const off_t  offset)
+{
+  size_t pos = 0;
+
+  while(pos < len) {
+    const ssize_t r = pread(fd, &buf[pos], len - pos, offset + (off_t)pos);
+
+    if(r == 0) {
+      break;
+    }
+
+    if(r < 0) {
+      if(errno == EINTR) {
+        continue;
+      }
+#if defined(O_DIRECT)
+      // O_DIRECT rejects the unaligned offset that follows a short read, both
+      // at the end of the file and in its middle. The rest of the file is
+      // read through the page cache.
+      if((errno == EINVAL) && ((pos % DIRECT_ALIGN_BYTE_LEN) != 0) &&
+         (clear_direct(fd) == 0)) {
+        continue;
+      }
+#endif
+      return -1;
+    }
+
+    pos += (size_t)r;
+  }
+
+  return (ssize_t)pos;
+}
+
+// The reader thread: fills the buffers of the ring in order, until the end of
+// the file, an error, or a stop request
+static void *reader_main(IN OUT void *arg)
+{
+  direct_reader_t *r = (direct_reader_t *)arg;
+
+  for(size_t i = 0;; i++) {
+    direct_buf_t *buf = &r->bufs[i % DIRECT_BUFS_NUM];
+
+    pthread_mutex_lock(&r->lock);
+    while(buf->full && !r->stop) {
+      pthread_cond_wait(&r->emptied, &r->lock);
+    }
+    const int stop = r->stop;
+    pthread_mutex_unlock(&r->lock);
+
+    if(stop) {
+      return NULL;
+    }
+
+    // The read is done without the lock, while the other buffers are hashed
+    const ssize_t len = read_full(r->fd, buf->data, DIRECT_BUF_BYTE_LEN,
+                                  (off_t)(i * DIRECT_BUF_BYTE_LEN));
+
+    pthread_mutex_lock(&r->lock);
+    if(len < 0) {
+      r->err = errno;
+    } else {
+      buf->len  = (size_t)len;
+      buf->full = 1;
+    }
+    pthread_cond_signal(&r->filled);
+    pthread_mutex_unlock(&r->lock);
+
+    if((len < 0) || ((size_t)len < DIRECT_BUF_BYTE_LEN)) {
+      return NULL;
+    }
+  }
+}
+
+// Hashes the buffers of the ring in order, as the reader fills them. Returns 0
+// at the end of the file and the errno of the reader on error.
+_INLINE_ int hash_bufs(IN OUT direct_reader_t *r,
+                       IN update_func_t        update,
+                       IN OUT void *           ctx)
+{
+  for(size_t i = 0;; i++) {
+    direct_buf_t *buf = &r->bufs[i % DIRECT_BUFS_NUM];
+
+    pthread_mutex_lock(&r->lock);
+    while(!buf->full && (r->err == 0)) {
+      pthread_cond_wait(&r->filled, &r->lock);
+    }
+    const int err = r->err;
+    pthread_mutex_unlock(&r->lock);
+
+    // The buffers that were read before the error are not needed anymore
+    if(err != 0) {
+      return err;
+    }
+
+    const size_t len = buf->len;
+    update(ctx, buf->data, len);
+
+    pthread_mutex_lock(&r->lock);
+    buf->full = 0;
+    pthread_cond_signal(&r->emptied);
+    pthread_mutex_unlock(&r->lock);
+
+    if(len < DIRECT_BUF_BYTE_LEN) {
+      return 0;
+    }
+  }
+}
+
+// Opens path for direct reads. File systems that do not support O_DIRECT
+// (e.g., tmpfs) are read through the page cache.
+_INLINE_ int open_direct(IN const char *path)
+{
+#if defined(O_DIRECT)
+  const int fd = open(path, O_RDONLY | O_DIRECT);
+  if((fd >= 0) || (errno != EINVAL)) {
+    return fd;
+  }
+#endif
+
+  return open(path, O_RDONLY);
+}
+
+_INLINE_ int hash_file_direct(IN const char *  path,
+                              IN update_func_t update,
+                              IN OUT void *    ctx)
+{
+  direct_reader_t r = {0};
+  pthread_t       reader;
+  int             err = 0;
+
+  r.fd = open_direct(path);
+  if(r.fd < 0) {
+    return -1;
+  }
+
+  for(size_t i = 0; (i < DIRECT_BUFS_NUM) && (err == 0); i++) {
+    void *data = NULL;
+
+    err = posix_memalign(&data, DIRECT_ALIGN_BYTE_LEN, DIRECT_BUF_BYTE_LEN);
+    r.bufs[i].data = (uint8_t *)data;
+  }
+
+  if(err == 0) {
+    pthread_mutex_init(&r.lock, NULL);
+    pthread_cond_init(&r.filled, NULL);
+    pthread_cond_init(&r.emptied, NULL);
+
+    err = pthread_create(&reader, NULL, reader_main, &r);
+    if(err == 0) {
+      err = hash_bufs(&r, update, ctx);
+
+      // Release a reader that waits for an empty buffer
+      pthread_mutex_lock(&r.lock);
+      r.stop = 1;
+      pthread_cond_signal(&r.emptied);
+      pthread_mutex_unlock(&r.lock);
+
+      pthread_join(reader, NULL);
+    }
+
+    pthread_cond_destroy(&r.emptied);
+    pthread_cond_destroy(&r.filled);
+    pthread_mutex_destroy(&r.lock);
+  }
+
+  for(size_t i = 0; i < DIRECT_BUFS_NUM; i++) {
+    if(r.bufs[i].data != NULL) {
+      secure_clean(r.bufs[i].data, DIRECT_BUF_BYTE_LEN);
+      free(r.bufs[i].data);
+    }
+  }
+
+  (void)close(r.fd);
+
+  if(err != 0) {
+    errno = err;
+    return -1;
+  }
+
+  return 0;
+}
+
+int sha256_file_direct(OUT uint8_t *dgst,
+                       IN const char *     path,
+                       IN const sha_impl_t impl)
+{
+  assert((dgst != NULL) && (path != NULL));
+
+  // Only the public API is used here, and the context is opaque
+  sha256_ctx_t *ctx = sha256_ctx_new();
+  int           ret = -1;
+
+  if(ctx == NULL) {
+    errno = ENOMEM;
+    return -1;
+  }
+
+  sha256_init(ctx, impl);
+
+  if(hash_file_direct(path, update256, ctx) == 0) {
+    sha256_final(dgst, ctx);
+    ret = 0;
+  }
+
+  sha256_ctx_free(ctx);
+  return ret;
+}
+
+int sha512_file_direct(OUT uint8_t *dgst,
+                       IN const char *     path,
+                       IN const sha_impl_t impl)
+{
+  assert((dgst != NULL) && (path != NULL));
+
+  // Only the public API is used here, and the context is opaque
+  sha512_ctx_t *ctx = sha512_ctx_new();
+  int           ret = -1;
+
+  if(ctx == NULL) {
+    errno = ENOMEM;
+    return -1;
+  }
+
+  sha512_init(ctx, impl);
+
+  if(hash_file_direct(path, update512, ctx) == 0) {
+    sha512_final(dgst, ctx);
+    ret = 0;
+  }
+
+  sha512_ctx_free(ctx);
+  return ret;
+}
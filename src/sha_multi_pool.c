@@ -0,0 +1,115 @@
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+// Hashing batches of independent messages on a pool of threads.
+// The messages are sorted by their number of blocks (longest first), and every
+// task of the pool hashes BATCH_MSGS_NUM consecutive messages of the sorted
+// order with sha*_multi. The lanes of a batch hash messages of similar lengths,
+// so they are rarely masked, and the long batches start first, so the short
+// ones balance the threads at the end. Every digest is written directly to its
+// slot in dgst. sha256_multi_pool and sha512_multi_pool (in sha*_multi.c)
+// pass their block size and the size of the length in their padding.
+
+#include <assert.h>
+#include <errno.h>
+#include <stdlib.h>
+
+#include "thread_pool.h"
+
+// The lanes of the widest multi-buffer implementation (SHA256 AVX512). The
+// narrower implementations hash a batch in several groups of lanes.
+#define BATCH_MSGS_NUM (16)
+
+typedef struct msg_s {
+  size_t blocks_num;
+  size_t idx;
+} msg_t;
+
+typedef struct batch_job_s {
+  uint8_t **       dgst;
+  const uint8_t ** data;
+  const size_t *   byte_len;
+  const msg_t *    msgs;
+  size_t           msgs_num;
+  sha_multi_func_t multi;
+  sha_impl_t       impl;
+} batch_job_t;
+
+// Sorts the messages by their number of blocks, in descending order
+static int cmp_msgs(IN const void *a, IN const void *b)
+{
+  const size_t a_blocks_num = ((const msg_t *)a)->blocks_num;
+  const size_t b_blocks_num = ((const msg_t *)b)->blocks_num;
+
+  return (a_blocks_num < b_blocks_num) - (a_blocks_num > b_blocks_num);
+}
+
+static void hash_batch(IN OUT void *arg, IN const size_t batch_idx)
+{
+  const batch_job_t *job   = (const batch_job_t *)arg;
+  const size_t       first = batch_idx * BATCH_MSGS_NUM;
+  const size_t       rem   = job->msgs_num - first;
+  const size_t       num   = (rem < BATCH_MSGS_NUM) ? rem : BATCH_MSGS_NUM;
+
+  uint8_t *      dgst[BATCH_MSGS_NUM];
+  const uint8_t *data[BATCH_MSGS_NUM];
+  size_t         byte_len[BATCH_MSGS_NUM];
+
+  for(size_t i = 0; i < num; i++) {
+    const size_t idx = job->msgs[first + i].idx;
+
+    dgst[i]     = job->dgst[idx];
+    data[i]     = job->data[idx];
+    byte_len[i] = job->byte_len[idx];
+  }
+
+  job->multi(dgst, data, byte_len, num, job->impl);
+}
+
+int sha_multi_pool(OUT uint8_t *dgst[],
+                   IN const uint8_t *data[],
+                   IN const size_t   byte_len[],
+                   IN const size_t   msgs_num,
+                   IN OUT sha_pool_t *pool,
+                   IN const sha_multi_func_t multi,
+                   IN const size_t           block_byte_len,
+                   IN const size_t           pad_len_byte_len,
+                   IN const sha_impl_t       impl)
+{
+  assert((dgst != NULL) && (data != NULL) && (byte_len != NULL));
+
+  batch_job_t job;
+
+  if(msgs_num == 0) {
+    return 0;
+  }
+
+  msg_t *msgs = malloc(msgs_num * sizeof(msg_t));
+  if(msgs == NULL) {
+    errno = ENOMEM;
+    return -1;
+  }
+
+  for(size_t i = 0; i < msgs_num; i++) {
+    // The padding adds the end symbol and the length to the message
+    msgs[i].blocks_num =
+      ((byte_len[i] + pad_len_byte_len) / block_byte_len) + 1;
+    msgs[i].idx = i;
+  }
+
+  qsort(msgs, msgs_num, sizeof(msg_t), cmp_msgs);
+
+  job.dgst     = dgst;
+  job.data     = data;
+  job.byte_len = byte_len;
+  job.msgs     = msgs;
+  job.msgs_num = msgs_num;
+  job.multi    = multi;
+  job.impl     = impl;
+
+  thread_pool_exec(pool, 1 + ((msgs_num - 1) / BATCH_MSGS_NUM), hash_batch,
+                   &job);
+
+  free(msgs);
+  return 0;
+}
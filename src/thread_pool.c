@@ -0,0 +1,287 @@
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+// A pool of threads with work stealing.
+// The tasks of a job are identified by their indices. Every thread owns a
+// range of indices, packed into a single word, that it takes from the bottom
+// with a compare-and-swap. A thread whose range is empty steals the top half
+// of the range of another thread with a compare-and-swap on the same word, so
+// the threads never lock to take or steal tasks. The idle workers sleep on a
+// condition variable until the next job is submitted.
+
+// For sysconf(_SC_NPROCESSORS_ONLN) and posix_memalign
+#define _DEFAULT_SOURCE
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "thread_pool.h"
+
+#define MAX_THREADS_NUM (256)
+
+// The range [begin, end) of tasks of a thread
+#define RANGE(begin, end)  (((uint64_t)(end) << 32) | (uint64_t)(begin))
+#define RANGE_BEGIN(range) ((size_t)((range)&UINT32_MAX))
+#define RANGE_END(range)   ((size_t)((range) >> 32))
+
+// Every worker is on its own cache line, so that taking a task does not
+// invalidate the ranges of the other threads
+typedef struct worker_s {
+  ALIGN(64) uint64_t range;
+  pthread_t          thread;
+  sha_pool_t *       pool;
+  size_t             idx;
+} worker_t;
+
+struct sha_pool_s {
+  // workers[0] is the thread that submits the job
+  worker_t *workers;
+  size_t    threads_num;
+
+  // The current job
+  thread_task_t task;
+  void *        arg;
+
+  // Wakes the workers when a job is submitted (the generation changes) and the
+  // submitting thread when all the workers are done (busy_num is 0)
+  pthread_mutex_t lock;
+  pthread_cond_t  start;
+  pthread_cond_t  done;
+  uint64_t        generation;
+  size_t          busy_num;
+  int             stop;
+
+  // Serializes the jobs that are submitted from several threads
+  pthread_mutex_t exec_lock;
+};
+
+// Takes the next task of the range of w
+_INLINE_ int take_task(OUT size_t *task_idx, IN OUT worker_t *w)
+{
+  uint64_t range = __atomic_load_n(&w->range, __ATOMIC_ACQUIRE);
+
+  while(RANGE_BEGIN(range) < RANGE_END(range)) {
+    const uint64_t rest = RANGE(RANGE_BEGIN(range) + 1, RANGE_END(range));
+
+    if(__atomic_compare_exchange_n(&w->range, &range, rest, 0, __ATOMIC_ACQ_REL,
+                                   __ATOMIC_ACQUIRE)) {
+      *task_idx = RANGE_BEGIN(range);
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+// Steals the top half of the range of another thread. The first stolen task is
+// returned and the others become the range of the thread self.
+_INLINE_ int steal_tasks(OUT size_t *task_idx,
+                         IN OUT sha_pool_t *pool,
+                         IN const size_t    self)
+{
+  for(size_t k = 1; k < pool->threads_num; k++) {
+    worker_t *victim = &pool->workers[(self + k) % pool->threads_num];
+    uint64_t  range  = __atomic_load_n(&victim->range, __ATOMIC_ACQUIRE);
+
+    while(RANGE_BEGIN(range) < RANGE_END(range)) {
+      const size_t begin = RANGE_BEGIN(range);
+      const size_t end   = RANGE_END(range);
+      const size_t mid   = end - ((end - begin + 1) / 2);
+
+      if(__atomic_compare_exchange_n(&victim->range, &range, RANGE(begin, mid),
+                                     0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        __atomic_store_n(&pool->workers[self].range, RANGE(mid + 1, end),
+                         __ATOMIC_RELEASE);
+        *task_idx = mid;
+        return 1;
+      }
+    }
+  }
+
+  return 0;
+}
+
+// Runs tasks until no thread has tasks left. The tasks that another thread
+// has just stolen are run by that thread.
+_INLINE_ void run_tasks(IN OUT sha_pool_t *pool, IN const size_t self)
+{
+  size_t task_idx;
+
+  while(take_task(&task_idx, &pool->workers[self]) ||
+        steal_tasks(&task_idx, pool, self)) {
+    pool->task(pool->arg, task_idx);
+  }
+}
+
+static void *worker_main(IN OUT void *p)
+{
+  worker_t *  w          = (worker_t *)p;
+  sha_pool_t *pool       = w->pool;
+  uint64_t    generation = 0;
+
+  pthread_mutex_lock(&pool->lock);
+
+  while(1) {
+    while((pool->generation == generation) && !pool->stop) {
+      pthread_cond_wait(&pool->start, &pool->lock);
+    }
+
+    if(pool->stop) {
+      break;
+    }
+
+    generation = pool->generation;
+    pthread_mutex_unlock(&pool->lock);
+
+    run_tasks(pool, w->idx);
+
+    pthread_mutex_lock(&pool->lock);
+    if(--pool->busy_num == 0) {
+      pthread_cond_signal(&pool->done);
+    }
+  }
+
+  pthread_mutex_unlock(&pool->lock);
+  return NULL;
+}
+
+size_t thread_pool_cpus_num(void)
+{
+  const long n = sysconf(_SC_NPROCESSORS_ONLN);
+
+  return (n > 0) ? (size_t)n : 1;
+}
+
+sha_pool_t *sha_pool_new(IN size_t threads_num)
+{
+  void *workers = NULL;
+
+  if(threads_num == 0) {
+    threads_num = thread_pool_cpus_num();
+  }
+  threads_num = (threads_num < MAX_THREADS_NUM) ? threads_num : MAX_THREADS_NUM;
+
+  sha_pool_t *pool = calloc(1, sizeof(*pool));
+  if((pool == NULL) ||
+     (0 != posix_memalign(&workers, 64, threads_num * sizeof(worker_t)))) {
+    free(pool);
+    return NULL;
+  }
+
+  my_memset((uint8_t *)workers, 0, threads_num * sizeof(worker_t));
+  pool->workers = (worker_t *)workers;
+
+  pthread_mutex_init(&pool->lock, NULL);
+  pthread_mutex_init(&pool->exec_lock, NULL);
+  pthread_cond_init(&pool->start, NULL);
+  pthread_cond_init(&pool->done, NULL);
+
+  // The thread that submits a job is the first thread. If a worker cannot be
+  // created, the pool has fewer threads.
+  pool->threads_num = 1;
+  for(size_t i = 1; i < threads_num; i++) {
+    worker_t *w = &pool->workers[i];
+
+    w->pool = pool;
+    w->idx  = i;
+    if(0 != pthread_create(&w->thread, NULL, worker_main, w)) {
+      break;
+    }
+    pool->threads_num++;
+  }
+
+  return pool;
+}
+
+void sha_pool_free(IN OUT sha_pool_t *pool)
+{
+  if(pool == NULL) {
+    return;
+  }
+
+  pthread_mutex_lock(&pool->lock);
+  pool->stop = 1;
+  pthread_cond_broadcast(&pool->start);
+  pthread_mutex_unlock(&pool->lock);
+
+  for(size_t i = 1; i < pool->threads_num; i++) {
+    pthread_join(pool->workers[i].thread, NULL);
+  }
+
+  pthread_cond_destroy(&pool->done);
+  pthread_cond_destroy(&pool->start);
+  pthread_mutex_destroy(&pool->exec_lock);
+  pthread_mutex_destroy(&pool->lock);
+
+  free(pool->workers);
+  free(pool);
+}
+
+size_t sha_pool_threads_num(IN const sha_pool_t *pool)
+{
+  return (pool == NULL) ? 1 : pool->threads_num;
+}
+
+void thread_pool_exec(IN OUT sha_pool_t *  pool,
+                      IN const size_t        tasks_num,
+                      IN const thread_task_t task,
+                      IN OUT void *          arg)
+{
+  assert(tasks_num <= UINT32_MAX);
+
+  // Nothing to share
+  if((pool == NULL) || (pool->threads_num == 1) || (tasks_num <= 1)) {
+    for(size_t i = 0; i < tasks_num; i++) {
+      task(arg, i);
+    }
+    return;
+  }
+
+  pthread_mutex_lock(&pool->exec_lock);
+
+  const size_t threads_num = pool->threads_num;
+
+  for(size_t i = 0; i < threads_num; i++) {
+    pool->workers[i].range =
+      RANGE((tasks_num * i) / threads_num, (tasks_num * (i + 1)) / threads_num);
+  }
+
+  // The lock publishes the ranges and the job to the workers
+  pthread_mutex_lock(&pool->lock);
+  pool->task     = task;
+  pool->arg      = arg;
+  pool->busy_num = threads_num - 1;
+  pool->generation++;
+  pthread_cond_broadcast(&pool->start);
+  pthread_mutex_unlock(&pool->lock);
+
+  run_tasks(pool, 0);
+
+  pthread_mutex_lock(&pool->lock);
+  while(pool->busy_num != 0) {
+    pthread_cond_wait(&pool->done, &pool->lock);
+  }
+  pthread_mutex_unlock(&pool->lock);
+
+  pthread_mutex_unlock(&pool->exec_lock);
+}
+
+void thread_pool_run(IN size_t              threads_num,
+                     IN const size_t        tasks_num,
+                     IN const thread_task_t task,
+                     IN OUT void *          arg)
+{
+  if(threads_num == 0) {
+    threads_num = thread_pool_cpus_num();
+  }
+
+  // No more threads than tasks
+  threads_num = (threads_num < tasks_num) ? threads_num : tasks_num;
+
+  sha_pool_t *pool = (threads_num > 1) ? sha_pool_new(threads_num) : NULL;
+
+  thread_pool_exec(pool, tasks_num, task, arg);
+  sha_pool_free(pool);
+}
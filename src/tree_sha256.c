@@ -0,0 +1,149 @@
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+// Parallel tree hashing over SHA256 (see sha.h for the construction).
+// The chunks are hashed on several threads, and every thread hashes a group of
+// consecutive chunks in the lanes of the multi-buffer implementations. The
+// leaf prefix block is the same for all the chunks, so its state is computed
+// once and every chunk continues from it, read in place. The root hashes the
+// leaf digests on the calling thread.
+
+#include <assert.h>
+#include <errno.h>
+#include <stdlib.h>
+
+#include "cpu_features.h"
+#include "sha256_defs.h"
+#include "thread_pool.h"
+
+typedef struct tree_s {
+  // The state after the leaf prefix block
+  sha256_state_t leaf_state;
+
+  const uint8_t *data;
+  size_t         byte_len;
+  size_t         chunk_byte_len;
+  size_t         chunks_num;
+  size_t         group_chunks_num;
+  uint8_t *      leaves;
+  sha_impl_t     impl;
+} tree_t;
+
+// Writes the ASCII string tag into a zeroed block
+_INLINE_ void init_prefix_block(OUT uint8_t block[SHA256_BLOCK_BYTE_LEN],
+                                IN const char *tag)
+{
+  my_memset(block, 0, SHA256_BLOCK_BYTE_LEN);
+  my_memcpy(block, (const uint8_t *)tag, strlen(tag));
+}
+
+// Hashes the chunks of the group group_idx into their leaf digests
+static void hash_group(IN OUT void *arg, IN const size_t group_idx)
+{
+  const tree_t *tree  = (const tree_t *)arg;
+  const size_t  first = group_idx * tree->group_chunks_num;
+  const size_t  rem   = tree->chunks_num - first;
+  const size_t  num =
+    (rem < tree->group_chunks_num) ? rem : tree->group_chunks_num;
+
+  const sha256_state_t *state[SHA256_MAX_LANES_NUM];
+  const uint8_t *       chunk[SHA256_MAX_LANES_NUM];
+  size_t                chunk_byte_len[SHA256_MAX_LANES_NUM];
+  uint8_t *             leaf[SHA256_MAX_LANES_NUM];
+
+  for(size_t i = 0; i < num; i++) {
+    const size_t pos = (first + i) * tree->chunk_byte_len;
+    const size_t len = tree->byte_len - pos;
+
+    state[i]          = &tree->leaf_state;
+    chunk[i]          = &tree->data[pos];
+    chunk_byte_len[i] =
+      (len < tree->chunk_byte_len) ? len : tree->chunk_byte_len;
+    leaf[i]           = &tree->leaves[(first + i) * SHA256_HASH_BYTE_LEN];
+  }
+
+  sha256_multi_from_states(leaf, state, SHA256_BLOCK_BYTE_LEN, chunk,
+                           chunk_byte_len, num, tree->impl);
+}
+
+int sha256_tree(OUT uint8_t *dgst,
+                IN const uint8_t *data,
+                IN const size_t   byte_len,
+                IN const size_t   chunk_byte_len,
+                IN const size_t   threads_num,
+                IN const sha_impl_t impl)
+{
+  assert(dgst != NULL);
+  assert((data != NULL) || (byte_len == 0));
+
+  ALIGN(64) uint8_t block[SHA256_BLOCK_BYTE_LEN];
+  tree_t            tree;
+  sha256_ctx_t      ctx;
+  size_t            lanes_num;
+
+  // An empty input has a single empty chunk
+  static const uint8_t empty[1] = {0};
+
+  const size_t threads =
+    (threads_num == 0) ? thread_pool_cpus_num() : threads_num;
+
+  // The chunks continue from the state after the leaf prefix block, so they
+  // must be whole blocks
+  if((chunk_byte_len == 0) || ((chunk_byte_len % SHA256_BLOCK_BYTE_LEN) != 0)) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  tree.data           = (data == NULL) ? empty : data;
+  tree.byte_len       = byte_len;
+  tree.chunk_byte_len = chunk_byte_len;
+  tree.impl           = impl;
+  tree.chunks_num =
+    (byte_len == 0) ? 1 : 1 + ((byte_len - 1) / chunk_byte_len);
+
+  // A group fills the lanes of the multi-buffer implementation, unless the
+  // groups are too few to keep all the threads busy
+  (void)sha256_multi_compress_func(&lanes_num, sha256_multi_resolve_impl(impl));
+  tree.group_chunks_num = 1 + ((tree.chunks_num - 1) / threads);
+  if(tree.group_chunks_num > lanes_num) {
+    tree.group_chunks_num = lanes_num;
+  }
+
+  tree.leaves = malloc(tree.chunks_num * SHA256_HASH_BYTE_LEN);
+  if(tree.leaves == NULL) {
+    errno = ENOMEM;
+    return -1;
+  }
+
+  for(size_t j = 0; j < SHA256_HASH_WORDS_NUM; j++) {
+    tree.leaf_state.w[j] = IV256[j];
+  }
+
+  init_prefix_block(block, SHA_TREE_LEAF_TAG);
+  sha256_compress(&tree.leaf_state, block, 1, sha256_resolve_impl(impl));
+
+  thread_pool_run(threads,
+                  1 + ((tree.chunks_num - 1) / tree.group_chunks_num),
+                  hash_group, &tree);
+
+  // The root prefix block ends with the chunk length and the input length
+  const uint64_t bswap_chunk_byte_len = bswap_64(chunk_byte_len);
+  const uint64_t bswap_byte_len       = bswap_64(byte_len);
+
+  init_prefix_block(block, SHA_TREE_ROOT_TAG);
+  my_memcpy(&block[SHA256_BLOCK_BYTE_LEN - (2 * sizeof(uint64_t))],
+            (const uint8_t *)&bswap_chunk_byte_len, sizeof(uint64_t));
+  my_memcpy(&block[SHA256_BLOCK_BYTE_LEN - sizeof(uint64_t)],
+            (const uint8_t *)&bswap_byte_len, sizeof(uint64_t));
+
+  sha256_init(&ctx, impl);
+  sha256_update(&ctx, block, SHA256_BLOCK_BYTE_LEN);
+  sha256_update(&ctx, tree.leaves, tree.chunks_num * SHA256_HASH_BYTE_LEN);
+  sha256_final(dgst, &ctx);
+
+  secure_clean(tree.leaves, tree.chunks_num * SHA256_HASH_BYTE_LEN);
+  free(tree.leaves);
+  secure_clean(&tree, sizeof(tree));
+
+  return 0;
+}
@@ -3,6 +3,11 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+#include <openssl/kdf.h>
 
 #include "measurements.h"
 #include "sha.h"
@@ -30,7 +35,7 @@ _INLINE_ void speed_sha256(void)
   RUN_X86_64_SHA_EXT(printf("  sha ext (C) sha ext (ossl) \n"););
 
   // Aarch64 specific options
-  RUN_NEON(printf("  neon (ossl)"););
+  RUN_NEON(printf("     neon (C)  neon (ossl)"););
   RUN_AARCH64_SHA_EXT(printf("  sha ext (C) sha ext (ossl) \n"););
 
   printf("\n");
@@ -51,6 +56,7 @@ _INLINE_ void speed_sha256(void)
       MEASURE(sha256(dgst, data, msg_byte_len, OPENSSL_SHA_EXT_IMPL);););
 
     // Aarch64 specific options
+    RUN_NEON(MEASURE(sha256(dgst, data, msg_byte_len, NEON_IMPL);););
     RUN_NEON(MEASURE(sha256(dgst, data, msg_byte_len, OPENSSL_NEON_IMPL);););
     RUN_AARCH64_SHA_EXT(
       MEASURE(sha256(dgst, data, msg_byte_len, SHA_EXT_IMPL);););
@@ -61,6 +67,85 @@ _INLINE_ void speed_sha256(void)
   }
 }
 
+// The multi-buffer benchmark hashes MULTI_MSGS_NUM messages of the same length
+#define MULTI_MSGS_NUM         (64UL)
+#define MULTI_MAX_MSG_BYTE_LEN (16384UL)
+
+_INLINE_ void speed_sha256_multi(void)
+{
+  static uint8_t data[MULTI_MSGS_NUM * MULTI_MAX_MSG_BYTE_LEN];
+  static uint8_t dgst[MULTI_MSGS_NUM][SHA256_HASH_BYTE_LEN];
+
+  const uint8_t *msgs[MULTI_MSGS_NUM];
+  uint8_t *      dgsts[MULTI_MSGS_NUM];
+  size_t         byte_lens[MULTI_MSGS_NUM];
+
+  // Use a deterministic seed.
+  srand(0);
+  rand_data(data, sizeof(data));
+
+  printf("\nSHA-256 multi-buffer Benchmark (%ld messages):", MULTI_MSGS_NUM);
+  printf("\n---------------------------------------------\n");
+  printf("        msg   one-by-one (auto)");
+
+  // X86-64 specific options
+  RUN_AVX2(printf("   multi avx2"););
+  RUN_AVX512(printf("  avx512 (1x) multi avx512"););
+  RUN_X86_64_SHA_EXT(printf("  sha ext (1x)  sha ext (2x)"););
+
+  // Aarch64 specific options
+  RUN_NEON(printf("   multi neon"););
+  RUN_AARCH64_SHA_EXT(printf("  sha ext (1x)"););
+  RUN_SVE(printf("    multi sve"););
+
+  printf("\n");
+  for(size_t msg_byte_len = 16; msg_byte_len <= MULTI_MAX_MSG_BYTE_LEN;
+      msg_byte_len <<= 1) {
+
+    for(size_t i = 0; i < MULTI_MSGS_NUM; i++) {
+      msgs[i]      = &data[i * msg_byte_len];
+      dgsts[i]     = dgst[i];
+      byte_lens[i] = msg_byte_len;
+    }
+
+    printf("%5ld bytes         ", msg_byte_len);
+    MEASURE(for(size_t i = 0; i < MULTI_MSGS_NUM; i++) {
+      sha256(dgsts[i], msgs[i], msg_byte_len, AUTO_IMPL);
+    });
+
+    // X86-64 specific options
+    RUN_AVX2(MEASURE(
+      sha256_multi(dgsts, msgs, byte_lens, MULTI_MSGS_NUM, AVX2_IMPL);););
+
+    // The single buffer AVX512 kernel vs. the 16 AVX512 lanes
+    RUN_AVX512(MEASURE(for(size_t i = 0; i < MULTI_MSGS_NUM; i++) {
+      sha256(dgsts[i], msgs[i], msg_byte_len, AVX512_IMPL);
+    }););
+    RUN_AVX512(MEASURE(
+      sha256_multi(dgsts, msgs, byte_lens, MULTI_MSGS_NUM, AVX512_IMPL);););
+
+    // The single-stream SHA extension kernel vs. the interleaved kernel
+    RUN_X86_64_SHA_EXT(MEASURE(for(size_t i = 0; i < MULTI_MSGS_NUM; i++) {
+      sha256(dgsts[i], msgs[i], msg_byte_len, SHA_EXT_IMPL);
+    }););
+    RUN_X86_64_SHA_EXT(MEASURE(
+      sha256_multi(dgsts, msgs, byte_lens, MULTI_MSGS_NUM, SHA_EXT_IMPL);););
+
+    // Aarch64 specific options
+    RUN_NEON(MEASURE(
+      sha256_multi(dgsts, msgs, byte_lens, MULTI_MSGS_NUM, NEON_IMPL);););
+
+    // The single-stream SHA extension kernel vs. the SVE lanes
+    RUN_AARCH64_SHA_EXT(MEASURE(for(size_t i = 0; i < MULTI_MSGS_NUM; i++) {
+      sha256(dgsts[i], msgs[i], msg_byte_len, SHA_EXT_IMPL);
+    }););
+    RUN_SVE(MEASURE(
+      sha256_multi(dgsts, msgs, byte_lens, MULTI_MSGS_NUM, SVE_IMPL);););
+
+    printf("\n");
+  }
+}
+
 _INLINE_ void speed_sha512(void)
 {
   uint8_t dgst[SHA512_HASH_BYTE_LEN] = {0};
@@ -80,7 +165,8 @@ _INLINE_ void speed_sha512(void)
   RUN_AVX512(printf("   avx512 (C)"););
 
   // Aarch64 specific options
-  RUN_NEON(printf("  neon (ossl)"););
+  RUN_NEON(printf("     neon (C)  neon (ossl)"););
+  RUN_AARCH64_SHA512_EXT(printf("  sha ext (C) sha ext (ossl)"););
 
   printf("\n");
 
@@ -98,16 +184,1277 @@ _INLINE_ void speed_sha512(void)
     RUN_AVX512(MEASURE(sha512(dgst, data, msg_byte_len, AVX512_IMPL);););
 
     // Aarch64 specific options
+    RUN_NEON(MEASURE(sha512(dgst, data, msg_byte_len, NEON_IMPL);););
     RUN_NEON(MEASURE(sha512(dgst, data, msg_byte_len, OPENSSL_NEON_IMPL);););
+    RUN_AARCH64_SHA512_EXT(
+      MEASURE(sha512(dgst, data, msg_byte_len, SHA_EXT_IMPL);););
+    RUN_AARCH64_SHA512_EXT(
+      MEASURE(sha512(dgst, data, msg_byte_len, OPENSSL_SHA_EXT_IMPL);););
+
+    printf("\n");
+  }
+}
+
+_INLINE_ void speed_sha512_multi(void)
+{
+  static uint8_t data[MULTI_MSGS_NUM * MULTI_MAX_MSG_BYTE_LEN];
+  static uint8_t dgst[MULTI_MSGS_NUM][SHA512_HASH_BYTE_LEN];
+
+  const uint8_t *msgs[MULTI_MSGS_NUM];
+  uint8_t *      dgsts[MULTI_MSGS_NUM];
+  size_t         byte_lens[MULTI_MSGS_NUM];
+
+  // Use a deterministic seed.
+  srand(0);
+  rand_data(data, sizeof(data));
+
+  printf("\nSHA-512 multi-buffer Benchmark (%ld messages):", MULTI_MSGS_NUM);
+  printf("\n---------------------------------------------\n");
+  printf("        msg   one-by-one (auto)");
+
+  // X86-64 specific options
+  RUN_AVX2(printf("   multi avx2"););
+  RUN_AVX512(printf("  avx512 (1x) multi avx512"););
+
+  // Aarch64 specific options
+  RUN_AARCH64_SHA512_EXT(printf("  sha ext (1x)"););
+  RUN_SVE(printf("    multi sve"););
+
+  printf("\n");
+  for(size_t msg_byte_len = 16; msg_byte_len <= MULTI_MAX_MSG_BYTE_LEN;
+      msg_byte_len <<= 1) {
+
+    for(size_t i = 0; i < MULTI_MSGS_NUM; i++) {
+      msgs[i]      = &data[i * msg_byte_len];
+      dgsts[i]     = dgst[i];
+      byte_lens[i] = msg_byte_len;
+    }
+
+    printf("%5ld bytes         ", msg_byte_len);
+    MEASURE(for(size_t i = 0; i < MULTI_MSGS_NUM; i++) {
+      sha512(dgsts[i], msgs[i], msg_byte_len, AUTO_IMPL);
+    });
+
+    // X86-64 specific options
+    RUN_AVX2(MEASURE(
+      sha512_multi(dgsts, msgs, byte_lens, MULTI_MSGS_NUM, AVX2_IMPL);););
+
+    // The single buffer AVX512 kernel vs. the 8 AVX512 lanes
+    RUN_AVX512(MEASURE(for(size_t i = 0; i < MULTI_MSGS_NUM; i++) {
+      sha512(dgsts[i], msgs[i], msg_byte_len, AVX512_IMPL);
+    }););
+    RUN_AVX512(MEASURE(
+      sha512_multi(dgsts, msgs, byte_lens, MULTI_MSGS_NUM, AVX512_IMPL);););
+
+    // Aarch64 specific options
+    RUN_AARCH64_SHA512_EXT(MEASURE(for(size_t i = 0; i < MULTI_MSGS_NUM; i++) {
+      sha512(dgsts[i], msgs[i], msg_byte_len, SHA_EXT_IMPL);
+    }););
+    RUN_SVE(MEASURE(
+      sha512_multi(dgsts, msgs, byte_lens, MULTI_MSGS_NUM, SVE_IMPL);););
+
+    printf("\n");
+  }
+}
+
+// SHA512/256 has the digest size of SHA256, and hashes 128 bytes per 80
+// rounds instead of 64 bytes per 64 rounds. On CPUs without the SHA extension
+// it is usually faster than SHA256 for long messages.
+_INLINE_ void speed_sha2_variants(void)
+{
+  uint8_t dgst[SHA512_HASH_BYTE_LEN] = {0};
+  uint8_t data[MAX_MSG_BYTE_LEN]     = {0};
+
+  // Use a deterministic seed.
+  srand(0);
+  rand_data(data, sizeof(data));
+
+  printf("\nSHA-2 variants Benchmark (auto):");
+  printf("\n--------------------------------\n");
+  printf("        msg      sha224       sha256       sha384       sha512"
+         "   sha512/224   sha512/256\n");
+
+  for(size_t msg_byte_len = 64; msg_byte_len <= MAX_MSG_BYTE_LEN;
+      msg_byte_len <<= 2) {
+
+    printf("%5ld bytes", msg_byte_len);
+    MEASURE(sha224(dgst, data, msg_byte_len, AUTO_IMPL););
+    MEASURE(sha256(dgst, data, msg_byte_len, AUTO_IMPL););
+    MEASURE(sha384(dgst, data, msg_byte_len, AUTO_IMPL););
+    MEASURE(sha512(dgst, data, msg_byte_len, AUTO_IMPL););
+    MEASURE(sha512_t224(dgst, data, msg_byte_len, AUTO_IMPL););
+    MEASURE(sha512_t256(dgst, data, msg_byte_len, AUTO_IMPL););
+
+    printf("\n");
+  }
+}
+
+// The HMAC benchmark measures short messages, where the two key blocks that
+// are compressed on every call dominate the cost.
+#define HMAC_MAX_MSG_BYTE_LEN (1024UL)
+
+_INLINE_ void speed_hmac_sha256(void)
+{
+  uint8_t            mac[SHA256_HASH_BYTE_LEN]   = {0};
+  uint8_t            key_data[32]                = {0};
+  uint8_t            data[HMAC_MAX_MSG_BYTE_LEN] = {0};
+  unsigned int       mac_len                     = 0;
+  hmac_sha256_key_t *key                         = hmac_sha256_key_new();
+
+  if(key == NULL) {
+    return;
+  }
+
+  // Use a deterministic seed.
+  srand(0);
+  rand_data(key_data, sizeof(key_data));
+  rand_data(data, sizeof(data));
+
+  hmac_sha256_key_init(key, key_data, sizeof(key_data), AUTO_IMPL);
+
+  printf("\nHMAC-SHA-256 Benchmark:");
+  printf("\n-----------------------\n");
+  printf("        msg  key init + mac  precomputed key  openssl HMAC\n");
+
+  for(size_t msg_byte_len = 16; msg_byte_len <= HMAC_MAX_MSG_BYTE_LEN;
+      msg_byte_len <<= 1) {
+
+    printf("%5ld bytes    ", msg_byte_len);
+    MEASURE(hmac_sha256_key_init(key, key_data, sizeof(key_data), AUTO_IMPL);
+            hmac_sha256(mac, key, data, msg_byte_len););
+    printf("    ");
+    MEASURE(hmac_sha256(mac, key, data, msg_byte_len););
+    MEASURE(HMAC(EVP_sha256(), key_data, sizeof(key_data), data, msg_byte_len,
+                 mac, &mac_len););
+
+    printf("\n");
+  }
+
+  hmac_sha256_key_free(key);
+}
+
+_INLINE_ void speed_hmac_sha512(void)
+{
+  uint8_t            mac[SHA512_HASH_BYTE_LEN]   = {0};
+  uint8_t            key_data[32]                = {0};
+  uint8_t            data[HMAC_MAX_MSG_BYTE_LEN] = {0};
+  unsigned int       mac_len                     = 0;
+  hmac_sha512_key_t *key                         = hmac_sha512_key_new();
+
+  if(key == NULL) {
+    return;
+  }
+
+  // Use a deterministic seed.
+  srand(0);
+  rand_data(key_data, sizeof(key_data));
+  rand_data(data, sizeof(data));
+
+  hmac_sha512_key_init(key, key_data, sizeof(key_data), AUTO_IMPL);
+
+  printf("\nHMAC-SHA-512 Benchmark:");
+  printf("\n-----------------------\n");
+  printf("        msg  key init + mac  precomputed key  openssl HMAC\n");
+
+  for(size_t msg_byte_len = 16; msg_byte_len <= HMAC_MAX_MSG_BYTE_LEN;
+      msg_byte_len <<= 1) {
+
+    printf("%5ld bytes    ", msg_byte_len);
+    MEASURE(hmac_sha512_key_init(key, key_data, sizeof(key_data), AUTO_IMPL);
+            hmac_sha512(mac, key, data, msg_byte_len););
+    printf("    ");
+    MEASURE(hmac_sha512(mac, key, data, msg_byte_len););
+    MEASURE(HMAC(EVP_sha512(), key_data, sizeof(key_data), data, msg_byte_len,
+                 mac, &mac_len););
+
+    printf("\n");
+  }
+
+  hmac_sha512_key_free(key);
+}
+
+_INLINE_ void speed_hmac_sha256_multi(void)
+{
+  static uint8_t data[MULTI_MSGS_NUM * HMAC_MAX_MSG_BYTE_LEN];
+  static uint8_t tags[MULTI_MSGS_NUM][SHA256_HASH_BYTE_LEN];
+
+  const uint8_t *          msgs[MULTI_MSGS_NUM];
+  const uint8_t *          tag[MULTI_MSGS_NUM];
+  uint8_t *                macs[MULTI_MSGS_NUM];
+  size_t                   byte_lens[MULTI_MSGS_NUM];
+  const hmac_sha256_key_t *keys[MULTI_MSGS_NUM];
+  uint8_t                  pass_bitmap[MULTI_MSGS_NUM / 8];
+  uint8_t                  key_data[32] = {0};
+  hmac_sha256_key_t *      key          = hmac_sha256_key_new();
+
+  if(key == NULL) {
+    return;
+  }
+
+  // Use a deterministic seed.
+  srand(0);
+  rand_data(key_data, sizeof(key_data));
+  rand_data(data, sizeof(data));
+
+  hmac_sha256_key_init(key, key_data, sizeof(key_data), AUTO_IMPL);
+
+  printf("\nHMAC-SHA-256 batched verification Benchmark (%ld messages):",
+         MULTI_MSGS_NUM);
+  printf("\n-----------------------------------------------------------\n");
+  printf("        msg   one-by-one (auto)");
+
+  // X86-64 specific options
+  RUN_AVX2(printf("   multi avx2"););
+  RUN_AVX512(printf(" multi avx512"););
+  RUN_X86_64_SHA_EXT(printf("  sha ext (2x)"););
+
+  printf("\n");
+  for(size_t msg_byte_len = 16; msg_byte_len <= HMAC_MAX_MSG_BYTE_LEN;
+      msg_byte_len <<= 1) {
+
+    for(size_t i = 0; i < MULTI_MSGS_NUM; i++) {
+      msgs[i]      = &data[i * msg_byte_len];
+      tag[i]       = tags[i];
+      macs[i]      = tags[i];
+      byte_lens[i] = msg_byte_len;
+      keys[i]      = key;
+    }
+
+    // Compute the expected tags
+    hmac_sha256_multi(macs, keys, msgs, byte_lens, MULTI_MSGS_NUM, AUTO_IMPL);
+
+    printf("%5ld bytes         ", msg_byte_len);
+    MEASURE(for(size_t i = 0; i < MULTI_MSGS_NUM; i++) {
+      hmac_sha256(macs[i], keys[i], msgs[i], msg_byte_len);
+    });
+
+    // X86-64 specific options
+    RUN_AVX2(MEASURE(hmac_sha256_verify_multi(pass_bitmap, keys, msgs,
+                                              byte_lens, tag, MULTI_MSGS_NUM,
+                                              AVX2_IMPL);););
+    RUN_AVX512(MEASURE(hmac_sha256_verify_multi(pass_bitmap, keys, msgs,
+                                                byte_lens, tag, MULTI_MSGS_NUM,
+                                                AVX512_IMPL);););
+    RUN_X86_64_SHA_EXT(MEASURE(hmac_sha256_verify_multi(
+      pass_bitmap, keys, msgs, byte_lens, tag, MULTI_MSGS_NUM, SHA_EXT_IMPL);););
+
+    printf("\n");
+  }
+
+  hmac_sha256_key_free(key);
+}
+
+_INLINE_ void speed_hmac_sha512_multi(void)
+{
+  static uint8_t data[MULTI_MSGS_NUM * HMAC_MAX_MSG_BYTE_LEN];
+  static uint8_t tags[MULTI_MSGS_NUM][SHA512_HASH_BYTE_LEN];
+
+  const uint8_t *          msgs[MULTI_MSGS_NUM];
+  const uint8_t *          tag[MULTI_MSGS_NUM];
+  uint8_t *                macs[MULTI_MSGS_NUM];
+  size_t                   byte_lens[MULTI_MSGS_NUM];
+  const hmac_sha512_key_t *keys[MULTI_MSGS_NUM];
+  uint8_t                  pass_bitmap[MULTI_MSGS_NUM / 8];
+  uint8_t                  key_data[32] = {0};
+  hmac_sha512_key_t *      key          = hmac_sha512_key_new();
+
+  if(key == NULL) {
+    return;
+  }
+
+  // Use a deterministic seed.
+  srand(0);
+  rand_data(key_data, sizeof(key_data));
+  rand_data(data, sizeof(data));
+
+  hmac_sha512_key_init(key, key_data, sizeof(key_data), AUTO_IMPL);
+
+  printf("\nHMAC-SHA-512 batched verification Benchmark (%ld messages):",
+         MULTI_MSGS_NUM);
+  printf("\n-----------------------------------------------------------\n");
+  printf("        msg   one-by-one (auto)");
+
+  // X86-64 specific options
+  RUN_AVX2(printf("   multi avx2"););
+  RUN_AVX512(printf(" multi avx512"););
+
+  printf("\n");
+  for(size_t msg_byte_len = 16; msg_byte_len <= HMAC_MAX_MSG_BYTE_LEN;
+      msg_byte_len <<= 1) {
+
+    for(size_t i = 0; i < MULTI_MSGS_NUM; i++) {
+      msgs[i]      = &data[i * msg_byte_len];
+      tag[i]       = tags[i];
+      macs[i]      = tags[i];
+      byte_lens[i] = msg_byte_len;
+      keys[i]      = key;
+    }
+
+    // Compute the expected tags
+    hmac_sha512_multi(macs, keys, msgs, byte_lens, MULTI_MSGS_NUM, AUTO_IMPL);
+
+    printf("%5ld bytes         ", msg_byte_len);
+    MEASURE(for(size_t i = 0; i < MULTI_MSGS_NUM; i++) {
+      hmac_sha512(macs[i], keys[i], msgs[i], msg_byte_len);
+    });
+
+    // X86-64 specific options
+    RUN_AVX2(MEASURE(hmac_sha512_verify_multi(pass_bitmap, keys, msgs,
+                                              byte_lens, tag, MULTI_MSGS_NUM,
+                                              AVX2_IMPL);););
+    RUN_AVX512(MEASURE(hmac_sha512_verify_multi(pass_bitmap, keys, msgs,
+                                                byte_lens, tag, MULTI_MSGS_NUM,
+                                                AVX512_IMPL);););
+
+    printf("\n");
+  }
+
+  hmac_sha512_key_free(key);
+}
+
+// PBKDF2 is measured with a small number of iterations. Its cost is linear in
+// the number of iterations.
+#define PBKDF2_ITER_NUM (100)
+#define PBKDF2_PWDS_NUM (16UL)
+
+_INLINE_ void speed_pbkdf2_sha256(void)
+{
+  uint8_t out[PBKDF2_PWDS_NUM][8 * SHA256_HASH_BYTE_LEN] = {0};
+  uint8_t pwds[PBKDF2_PWDS_NUM][16]                      = {0};
+  uint8_t salt[16]                                       = {0};
+
+  const uint8_t *pwd[PBKDF2_PWDS_NUM];
+  const uint8_t *salts[PBKDF2_PWDS_NUM];
+  uint8_t *      outs[PBKDF2_PWDS_NUM];
+  size_t         pwd_byte_len[PBKDF2_PWDS_NUM];
+  size_t         salt_byte_len[PBKDF2_PWDS_NUM];
+
+  // Use a deterministic seed.
+  srand(0);
+  rand_data(&pwds[0][0], sizeof(pwds));
+  rand_data(salt, sizeof(salt));
+
+  for(size_t i = 0; i < PBKDF2_PWDS_NUM; i++) {
+    pwd[i]           = pwds[i];
+    salts[i]         = salt;
+    outs[i]          = out[i];
+    pwd_byte_len[i]  = sizeof(pwds[i]);
+    salt_byte_len[i] = sizeof(salt);
+  }
+
+  printf("\nPBKDF2-HMAC-SHA-256 Benchmark (%d iterations):", PBKDF2_ITER_NUM);
+  printf("\n---------------------------------------------\n");
+  printf("                   openssl         auto");
+
+  // X86-64 specific options
+  RUN_AVX2(printf("   multi avx2"););
+  RUN_AVX512(printf(" multi avx512"););
+  RUN_X86_64_SHA_EXT(printf("  sha ext (2x)"););
+
+  printf("\n");
+  for(size_t blocks_num = 1; blocks_num <= 8; blocks_num <<= 1) {
+    const size_t out_byte_len = blocks_num * SHA256_HASH_BYTE_LEN;
+
+    printf("%5ld bytes       ", out_byte_len);
+    MEASURE(PKCS5_PBKDF2_HMAC((const char *)pwd[0], (int)pwd_byte_len[0], salt,
+                              sizeof(salt), PBKDF2_ITER_NUM, EVP_sha256(),
+                              (int)out_byte_len, out[0]););
+    MEASURE(pbkdf2_hmac_sha256(out[0], out_byte_len, pwd[0], pwd_byte_len[0],
+                               salt, sizeof(salt), PBKDF2_ITER_NUM,
+                               AUTO_IMPL););
+
+    // X86-64 specific options
+    RUN_AVX2(MEASURE(pbkdf2_hmac_sha256(out[0], out_byte_len, pwd[0],
+                                        pwd_byte_len[0], salt, sizeof(salt),
+                                        PBKDF2_ITER_NUM, AVX2_IMPL);););
+    RUN_AVX512(MEASURE(pbkdf2_hmac_sha256(out[0], out_byte_len, pwd[0],
+                                          pwd_byte_len[0], salt, sizeof(salt),
+                                          PBKDF2_ITER_NUM, AVX512_IMPL);););
+    RUN_X86_64_SHA_EXT(MEASURE(pbkdf2_hmac_sha256(
+      out[0], out_byte_len, pwd[0], pwd_byte_len[0], salt, sizeof(salt),
+      PBKDF2_ITER_NUM, SHA_EXT_IMPL);););
+
+    printf("\n");
+  }
+
+  // Derive a 32 bytes key for every password
+  printf("%2ld passwords      ", PBKDF2_PWDS_NUM);
+  MEASURE(for(size_t i = 0; i < PBKDF2_PWDS_NUM; i++) {
+    PKCS5_PBKDF2_HMAC((const char *)pwd[i], (int)pwd_byte_len[i], salt,
+                      sizeof(salt), PBKDF2_ITER_NUM, EVP_sha256(),
+                      SHA256_HASH_BYTE_LEN, out[i]);
+  });
+  MEASURE(pbkdf2_hmac_sha256_multi(outs, SHA256_HASH_BYTE_LEN, pwd,
+                                   pwd_byte_len, salts, salt_byte_len,
+                                   PBKDF2_PWDS_NUM, PBKDF2_ITER_NUM,
+                                   AUTO_IMPL););
+
+  // X86-64 specific options
+  RUN_AVX2(MEASURE(pbkdf2_hmac_sha256_multi(
+    outs, SHA256_HASH_BYTE_LEN, pwd, pwd_byte_len, salts, salt_byte_len,
+    PBKDF2_PWDS_NUM, PBKDF2_ITER_NUM, AVX2_IMPL);););
+  RUN_AVX512(MEASURE(pbkdf2_hmac_sha256_multi(
+    outs, SHA256_HASH_BYTE_LEN, pwd, pwd_byte_len, salts, salt_byte_len,
+    PBKDF2_PWDS_NUM, PBKDF2_ITER_NUM, AVX512_IMPL);););
+  RUN_X86_64_SHA_EXT(MEASURE(pbkdf2_hmac_sha256_multi(
+    outs, SHA256_HASH_BYTE_LEN, pwd, pwd_byte_len, salts, salt_byte_len,
+    PBKDF2_PWDS_NUM, PBKDF2_ITER_NUM, SHA_EXT_IMPL);););
+
+  printf("\n");
+}
+
+_INLINE_ void speed_pbkdf2_sha512(void)
+{
+  uint8_t out[PBKDF2_PWDS_NUM][8 * SHA512_HASH_BYTE_LEN] = {0};
+  uint8_t pwds[PBKDF2_PWDS_NUM][16]                      = {0};
+  uint8_t salt[16]                                       = {0};
+
+  const uint8_t *pwd[PBKDF2_PWDS_NUM];
+  const uint8_t *salts[PBKDF2_PWDS_NUM];
+  uint8_t *      outs[PBKDF2_PWDS_NUM];
+  size_t         pwd_byte_len[PBKDF2_PWDS_NUM];
+  size_t         salt_byte_len[PBKDF2_PWDS_NUM];
+
+  // Use a deterministic seed.
+  srand(0);
+  rand_data(&pwds[0][0], sizeof(pwds));
+  rand_data(salt, sizeof(salt));
+
+  for(size_t i = 0; i < PBKDF2_PWDS_NUM; i++) {
+    pwd[i]           = pwds[i];
+    salts[i]         = salt;
+    outs[i]          = out[i];
+    pwd_byte_len[i]  = sizeof(pwds[i]);
+    salt_byte_len[i] = sizeof(salt);
+  }
+
+  printf("\nPBKDF2-HMAC-SHA-512 Benchmark (%d iterations):", PBKDF2_ITER_NUM);
+  printf("\n---------------------------------------------\n");
+  printf("                   openssl         auto");
+
+  // X86-64 specific options
+  RUN_AVX2(printf("   multi avx2"););
+  RUN_AVX512(printf(" multi avx512"););
+
+  printf("\n");
+  for(size_t blocks_num = 1; blocks_num <= 8; blocks_num <<= 1) {
+    const size_t out_byte_len = blocks_num * SHA512_HASH_BYTE_LEN;
+
+    printf("%5ld bytes       ", out_byte_len);
+    MEASURE(PKCS5_PBKDF2_HMAC((const char *)pwd[0], (int)pwd_byte_len[0], salt,
+                              sizeof(salt), PBKDF2_ITER_NUM, EVP_sha512(),
+                              (int)out_byte_len, out[0]););
+    MEASURE(pbkdf2_hmac_sha512(out[0], out_byte_len, pwd[0], pwd_byte_len[0],
+                               salt, sizeof(salt), PBKDF2_ITER_NUM,
+                               AUTO_IMPL););
+
+    // X86-64 specific options
+    RUN_AVX2(MEASURE(pbkdf2_hmac_sha512(out[0], out_byte_len, pwd[0],
+                                        pwd_byte_len[0], salt, sizeof(salt),
+                                        PBKDF2_ITER_NUM, AVX2_IMPL);););
+    RUN_AVX512(MEASURE(pbkdf2_hmac_sha512(out[0], out_byte_len, pwd[0],
+                                          pwd_byte_len[0], salt, sizeof(salt),
+                                          PBKDF2_ITER_NUM, AVX512_IMPL);););
+
+    printf("\n");
+  }
+
+  // Derive a 32 bytes key for every password
+  printf("%2ld passwords      ", PBKDF2_PWDS_NUM);
+  MEASURE(for(size_t i = 0; i < PBKDF2_PWDS_NUM; i++) {
+    PKCS5_PBKDF2_HMAC((const char *)pwd[i], (int)pwd_byte_len[i], salt,
+                      sizeof(salt), PBKDF2_ITER_NUM, EVP_sha512(),
+                      SHA512_HASH_BYTE_LEN, out[i]);
+  });
+  MEASURE(pbkdf2_hmac_sha512_multi(outs, SHA512_HASH_BYTE_LEN, pwd,
+                                   pwd_byte_len, salts, salt_byte_len,
+                                   PBKDF2_PWDS_NUM, PBKDF2_ITER_NUM,
+                                   AUTO_IMPL););
+
+  // X86-64 specific options
+  RUN_AVX2(MEASURE(pbkdf2_hmac_sha512_multi(
+    outs, SHA512_HASH_BYTE_LEN, pwd, pwd_byte_len, salts, salt_byte_len,
+    PBKDF2_PWDS_NUM, PBKDF2_ITER_NUM, AVX2_IMPL);););
+  RUN_AVX512(MEASURE(pbkdf2_hmac_sha512_multi(
+    outs, SHA512_HASH_BYTE_LEN, pwd, pwd_byte_len, salts, salt_byte_len,
+    PBKDF2_PWDS_NUM, PBKDF2_ITER_NUM, AVX512_IMPL);););
+
+  printf("\n");
+}
+
+// A key schedule expands several labels of the same PRK
+#define HKDF_OUTPUTS_NUM (8UL)
+
+_INLINE_ void openssl_hkdf_expand_sha256(OUT uint8_t *okm,
+                                         IN size_t okm_byte_len,
+                                         IN const uint8_t *prk,
+                                         IN const uint8_t *info,
+                                         IN const size_t   info_byte_len)
+{
+  EVP_PKEY_CTX *ctx = EVP_PKEY_CTX_new_id(EVP_PKEY_HKDF, NULL);
+
+  EVP_PKEY_derive_init(ctx);
+  EVP_PKEY_CTX_set_hkdf_mode(ctx, EVP_PKEY_HKDEF_MODE_EXPAND_ONLY);
+  EVP_PKEY_CTX_set_hkdf_md(ctx, EVP_sha256());
+  EVP_PKEY_CTX_set1_hkdf_key(ctx, prk, SHA256_HASH_BYTE_LEN);
+  EVP_PKEY_CTX_add1_hkdf_info(ctx, info, (int)info_byte_len);
+  EVP_PKEY_derive(ctx, okm, &okm_byte_len);
+  EVP_PKEY_CTX_free(ctx);
+}
+
+_INLINE_ void speed_hkdf_sha256(void)
+{
+  uint8_t okm[HKDF_OUTPUTS_NUM][4 * SHA256_HASH_BYTE_LEN] = {0};
+  uint8_t labels[HKDF_OUTPUTS_NUM][20]                    = {0};
+  uint8_t prk[SHA256_HASH_BYTE_LEN]                       = {0};
+
+  const uint8_t *info[HKDF_OUTPUTS_NUM];
+  uint8_t *      okms[HKDF_OUTPUTS_NUM];
+  size_t         info_byte_len[HKDF_OUTPUTS_NUM];
+  size_t         okm_byte_len[HKDF_OUTPUTS_NUM];
+
+  hmac_sha256_key_t *prk_key = hmac_sha256_key_new();
+
+  if(prk_key == NULL) {
+    return;
+  }
+
+  // Use a deterministic seed.
+  srand(0);
+  rand_data(&labels[0][0], sizeof(labels));
+  rand_data(prk, sizeof(prk));
+
+  for(size_t i = 0; i < HKDF_OUTPUTS_NUM; i++) {
+    info[i]          = labels[i];
+    okms[i]          = okm[i];
+    info_byte_len[i] = sizeof(labels[i]);
+  }
+
+  printf("\nHKDF-SHA-256 expand Benchmark (%ld outputs of the same PRK):",
+         HKDF_OUTPUTS_NUM);
+  printf("\n-----------------------------------------------------------\n");
+  printf("        okm      openssl  key per call   cached PRK  expand multi\n");
 
+  for(size_t blocks_num = 1; blocks_num <= 4; blocks_num <<= 1) {
+    const size_t len = blocks_num * SHA256_HASH_BYTE_LEN;
+
+    for(size_t i = 0; i < HKDF_OUTPUTS_NUM; i++) {
+      okm_byte_len[i] = len;
+    }
+
+    printf("%5ld bytes ", len);
+    MEASURE(for(size_t i = 0; i < HKDF_OUTPUTS_NUM; i++) {
+      openssl_hkdf_expand_sha256(okms[i], len, prk, info[i], info_byte_len[i]);
+    });
+    printf("  ");
+    MEASURE(for(size_t i = 0; i < HKDF_OUTPUTS_NUM; i++) {
+      hmac_sha256_key_init(prk_key, prk, sizeof(prk), AUTO_IMPL);
+      hkdf_sha256_expand(okms[i], len, prk_key, info[i], info_byte_len[i]);
+    });
+
+    hmac_sha256_key_init(prk_key, prk, sizeof(prk), AUTO_IMPL);
+    MEASURE(for(size_t i = 0; i < HKDF_OUTPUTS_NUM; i++) {
+      hkdf_sha256_expand(okms[i], len, prk_key, info[i], info_byte_len[i]);
+    });
+    printf("  ");
+    MEASURE(hkdf_sha256_expand_multi(okms, okm_byte_len, prk_key, info,
+                                     info_byte_len, HKDF_OUTPUTS_NUM,
+                                     AUTO_IMPL););
+    printf("\n");
+  }
+
+  hmac_sha256_key_free(prk_key);
+}
+
+_INLINE_ void openssl_hkdf_expand_sha512(OUT uint8_t *okm,
+                                         IN size_t okm_byte_len,
+                                         IN const uint8_t *prk,
+                                         IN const uint8_t *info,
+                                         IN const size_t   info_byte_len)
+{
+  EVP_PKEY_CTX *ctx = EVP_PKEY_CTX_new_id(EVP_PKEY_HKDF, NULL);
+
+  EVP_PKEY_derive_init(ctx);
+  EVP_PKEY_CTX_set_hkdf_mode(ctx, EVP_PKEY_HKDEF_MODE_EXPAND_ONLY);
+  EVP_PKEY_CTX_set_hkdf_md(ctx, EVP_sha512());
+  EVP_PKEY_CTX_set1_hkdf_key(ctx, prk, SHA512_HASH_BYTE_LEN);
+  EVP_PKEY_CTX_add1_hkdf_info(ctx, info, (int)info_byte_len);
+  EVP_PKEY_derive(ctx, okm, &okm_byte_len);
+  EVP_PKEY_CTX_free(ctx);
+}
+
+_INLINE_ void speed_hkdf_sha512(void)
+{
+  uint8_t okm[HKDF_OUTPUTS_NUM][4 * SHA512_HASH_BYTE_LEN] = {0};
+  uint8_t labels[HKDF_OUTPUTS_NUM][20]                    = {0};
+  uint8_t prk[SHA512_HASH_BYTE_LEN]                       = {0};
+
+  const uint8_t *info[HKDF_OUTPUTS_NUM];
+  uint8_t *      okms[HKDF_OUTPUTS_NUM];
+  size_t         info_byte_len[HKDF_OUTPUTS_NUM];
+  size_t         okm_byte_len[HKDF_OUTPUTS_NUM];
+
+  hmac_sha512_key_t *prk_key = hmac_sha512_key_new();
+
+  if(prk_key == NULL) {
+    return;
+  }
+
+  // Use a deterministic seed.
+  srand(0);
+  rand_data(&labels[0][0], sizeof(labels));
+  rand_data(prk, sizeof(prk));
+
+  for(size_t i = 0; i < HKDF_OUTPUTS_NUM; i++) {
+    info[i]          = labels[i];
+    okms[i]          = okm[i];
+    info_byte_len[i] = sizeof(labels[i]);
+  }
+
+  printf("\nHKDF-SHA-512 expand Benchmark (%ld outputs of the same PRK):",
+         HKDF_OUTPUTS_NUM);
+  printf("\n-----------------------------------------------------------\n");
+  printf("        okm      openssl  key per call   cached PRK  expand multi\n");
+
+  for(size_t blocks_num = 1; blocks_num <= 4; blocks_num <<= 1) {
+    const size_t len = blocks_num * SHA512_HASH_BYTE_LEN;
+
+    for(size_t i = 0; i < HKDF_OUTPUTS_NUM; i++) {
+      okm_byte_len[i] = len;
+    }
+
+    printf("%5ld bytes ", len);
+    MEASURE(for(size_t i = 0; i < HKDF_OUTPUTS_NUM; i++) {
+      openssl_hkdf_expand_sha512(okms[i], len, prk, info[i], info_byte_len[i]);
+    });
+    printf("  ");
+    MEASURE(for(size_t i = 0; i < HKDF_OUTPUTS_NUM; i++) {
+      hmac_sha512_key_init(prk_key, prk, sizeof(prk), AUTO_IMPL);
+      hkdf_sha512_expand(okms[i], len, prk_key, info[i], info_byte_len[i]);
+    });
+
+    hmac_sha512_key_init(prk_key, prk, sizeof(prk), AUTO_IMPL);
+    MEASURE(for(size_t i = 0; i < HKDF_OUTPUTS_NUM; i++) {
+      hkdf_sha512_expand(okms[i], len, prk_key, info[i], info_byte_len[i]);
+    });
+    printf("  ");
+    MEASURE(hkdf_sha512_expand_multi(okms, okm_byte_len, prk_key, info,
+                                     info_byte_len, HKDF_OUTPUTS_NUM,
+                                     AUTO_IMPL););
     printf("\n");
   }
+
+  hmac_sha512_key_free(prk_key);
+}
+
+// The Merkle tree benchmark builds a tree of MERKLE_LEAVES_NUM leaves
+#define MERKLE_LEAVES_NUM         (256UL)
+#define MERKLE_MAX_LEAF_BYTE_LEN  (4096UL)
+
+// A tree of the plain mode that hashes every node with a separate call
+_INLINE_ void naive_merkle_sha256(OUT uint8_t *nodes,
+                                  IN const uint8_t *leaf[],
+                                  IN const size_t   leaf_byte_len[],
+                                  IN const size_t   leaves_num)
+{
+  uint8_t *level = nodes;
+
+  for(size_t i = 0; i < leaves_num; i++) {
+    sha256(&nodes[i * SHA256_HASH_BYTE_LEN], leaf[i], leaf_byte_len[i],
+           AUTO_IMPL);
+  }
+
+  for(size_t n = leaves_num; n > 1; n = (n + 1) / 2) {
+    uint8_t *next = &level[n * SHA256_HASH_BYTE_LEN];
+
+    for(size_t i = 0; i < n / 2; i++) {
+      sha256(&next[i * SHA256_HASH_BYTE_LEN],
+             &level[2 * i * SHA256_HASH_BYTE_LEN], 2 * SHA256_HASH_BYTE_LEN,
+             AUTO_IMPL);
+    }
+
+    if(n & 1) {
+      memcpy(&next[(n / 2) * SHA256_HASH_BYTE_LEN],
+             &level[(n - 1) * SHA256_HASH_BYTE_LEN], SHA256_HASH_BYTE_LEN);
+    }
+
+    level = next;
+  }
+}
+
+_INLINE_ void speed_merkle_sha256(void)
+{
+  static uint8_t data[MERKLE_LEAVES_NUM * MERKLE_MAX_LEAF_BYTE_LEN];
+  static uint8_t nodes[2 * MERKLE_LEAVES_NUM][SHA256_HASH_BYTE_LEN];
+
+  const uint8_t *leaf[MERKLE_LEAVES_NUM];
+  size_t         leaf_byte_len[MERKLE_LEAVES_NUM];
+
+  // Use a deterministic seed.
+  srand(0);
+  rand_data(data, sizeof(data));
+
+  printf("\nMerkle tree SHA-256 Benchmark (%ld leaves):", MERKLE_LEAVES_NUM);
+  printf("\n-------------------------------------------\n");
+  printf("       leaf  per node (auto)  tree (auto)  rfc6962 (auto)\n");
+
+  for(size_t leaf_len = 64; leaf_len <= MERKLE_MAX_LEAF_BYTE_LEN;
+      leaf_len <<= 2) {
+
+    for(size_t i = 0; i < MERKLE_LEAVES_NUM; i++) {
+      leaf[i]          = &data[i * leaf_len];
+      leaf_byte_len[i] = leaf_len;
+    }
+
+    printf("%5ld bytes     ", leaf_len);
+    MEASURE(naive_merkle_sha256(&nodes[0][0], leaf, leaf_byte_len,
+                                MERKLE_LEAVES_NUM););
+    MEASURE(merkle_sha256_tree(&nodes[0][0], leaf, leaf_byte_len,
+                               MERKLE_LEAVES_NUM, MERKLE_PLAIN_MODE,
+                               AUTO_IMPL););
+    printf("   ");
+    MEASURE(merkle_sha256_tree(&nodes[0][0], leaf, leaf_byte_len,
+                               MERKLE_LEAVES_NUM, MERKLE_RFC6962_MODE,
+                               AUTO_IMPL););
+    printf("\n");
+  }
+}
+
+// A tree of the plain mode that hashes every node with a separate call
+_INLINE_ void naive_merkle_sha512(OUT uint8_t *nodes,
+                                  IN const uint8_t *leaf[],
+                                  IN const size_t   leaf_byte_len[],
+                                  IN const size_t   leaves_num)
+{
+  uint8_t *level = nodes;
+
+  for(size_t i = 0; i < leaves_num; i++) {
+    sha512(&nodes[i * SHA512_HASH_BYTE_LEN], leaf[i], leaf_byte_len[i],
+           AUTO_IMPL);
+  }
+
+  for(size_t n = leaves_num; n > 1; n = (n + 1) / 2) {
+    uint8_t *next = &level[n * SHA512_HASH_BYTE_LEN];
+
+    for(size_t i = 0; i < n / 2; i++) {
+      sha512(&next[i * SHA512_HASH_BYTE_LEN],
+             &level[2 * i * SHA512_HASH_BYTE_LEN], 2 * SHA512_HASH_BYTE_LEN,
+             AUTO_IMPL);
+    }
+
+    if(n & 1) {
+      memcpy(&next[(n / 2) * SHA512_HASH_BYTE_LEN],
+             &level[(n - 1) * SHA512_HASH_BYTE_LEN], SHA512_HASH_BYTE_LEN);
+    }
+
+    level = next;
+  }
+}
+
+_INLINE_ void speed_merkle_sha512(void)
+{
+  static uint8_t data[MERKLE_LEAVES_NUM * MERKLE_MAX_LEAF_BYTE_LEN];
+  static uint8_t nodes[2 * MERKLE_LEAVES_NUM][SHA512_HASH_BYTE_LEN];
+
+  const uint8_t *leaf[MERKLE_LEAVES_NUM];
+  size_t         leaf_byte_len[MERKLE_LEAVES_NUM];
+
+  // Use a deterministic seed.
+  srand(0);
+  rand_data(data, sizeof(data));
+
+  printf("\nMerkle tree SHA-512 Benchmark (%ld leaves):", MERKLE_LEAVES_NUM);
+  printf("\n-------------------------------------------\n");
+  printf("       leaf  per node (auto)  tree (auto)  rfc6962 (auto)\n");
+
+  for(size_t leaf_len = 64; leaf_len <= MERKLE_MAX_LEAF_BYTE_LEN;
+      leaf_len <<= 2) {
+
+    for(size_t i = 0; i < MERKLE_LEAVES_NUM; i++) {
+      leaf[i]          = &data[i * leaf_len];
+      leaf_byte_len[i] = leaf_len;
+    }
+
+    printf("%5ld bytes     ", leaf_len);
+    MEASURE(naive_merkle_sha512(&nodes[0][0], leaf, leaf_byte_len,
+                                MERKLE_LEAVES_NUM););
+    MEASURE(merkle_sha512_tree(&nodes[0][0], leaf, leaf_byte_len,
+                               MERKLE_LEAVES_NUM, MERKLE_PLAIN_MODE,
+                               AUTO_IMPL););
+    printf("   ");
+    MEASURE(merkle_sha512_tree(&nodes[0][0], leaf, leaf_byte_len,
+                               MERKLE_LEAVES_NUM, MERKLE_RFC6962_MODE,
+                               AUTO_IMPL););
+    printf("\n");
+  }
+}
+
+// The fixed length benchmark hashes FIXED_MSGS_NUM messages of 32/64 (SHA256)
+// or 64/128 (SHA512) bytes
+#define FIXED_MSGS_NUM (64UL)
+
+typedef struct speed_impl_s {
+  sha_impl_t  impl;
+  const char *name;
+} speed_impl_t;
+
+static const speed_impl_t fixed_impls[] = {
+  {GENERIC_IMPL, "generic"}, {AVX_IMPL, "avx"},         {AVX2_IMPL, "avx2"},
+  {AVX512_IMPL, "avx512"},   {SHA_EXT_IMPL, "sha ext"}, {NEON_IMPL, "neon"},
+};
+
+#define FIXED_IMPLS_NUM (sizeof(fixed_impls) / sizeof(fixed_impls[0]))
+
+_INLINE_ void speed_fixed_sha256(void)
+{
+  static uint8_t data[FIXED_MSGS_NUM * 64];
+  static uint8_t dgst[FIXED_MSGS_NUM][SHA256_HASH_BYTE_LEN];
+
+  const uint8_t *msgs[FIXED_MSGS_NUM];
+  uint8_t *      dgsts[FIXED_MSGS_NUM];
+  size_t         byte_lens_32[FIXED_MSGS_NUM];
+  size_t         byte_lens_64[FIXED_MSGS_NUM];
+
+  // Use a deterministic seed.
+  srand(0);
+  rand_data(data, sizeof(data));
+
+  for(size_t i = 0; i < FIXED_MSGS_NUM; i++) {
+    msgs[i]         = &data[i * 64];
+    dgsts[i]        = dgst[i];
+    byte_lens_32[i] = 32;
+    byte_lens_64[i] = 64;
+  }
+
+  printf("\nFixed length SHA-256 Benchmark:");
+  printf("\n-------------------------------\n");
+  printf("       impl  sha256 (32)         32B  sha256 (64)         64B\n");
+
+  for(size_t k = 0; k < FIXED_IMPLS_NUM; k++) {
+    const sha_impl_t impl = fixed_impls[k].impl;
+
+    if(!sha_impl_supported(impl)) {
+      continue;
+    }
+
+    printf("%11s", fixed_impls[k].name);
+    MEASURE(sha256(dgst[0], data, 32, impl););
+    MEASURE(sha256_32B(dgst[0], data, impl););
+    MEASURE(sha256(dgst[0], data, 64, impl););
+    MEASURE(sha256_64B(dgst[0], data, impl););
+    printf("\n");
+  }
+
+  printf("\nFixed length SHA-256 multi-buffer Benchmark (%ld messages):",
+         FIXED_MSGS_NUM);
+  printf("\n----------------------------------------------------------\n");
+  printf("       impl   multi (32)   32B multi   multi (64)   64B multi\n");
+
+  for(size_t k = 0; k < FIXED_IMPLS_NUM; k++) {
+    const sha_impl_t impl = fixed_impls[k].impl;
+
+    if(!sha_impl_supported(impl)) {
+      continue;
+    }
+
+    printf("%11s", fixed_impls[k].name);
+    MEASURE(sha256_multi(dgsts, msgs, byte_lens_32, FIXED_MSGS_NUM, impl););
+    MEASURE(sha256_32B_multi(dgst[0], data, FIXED_MSGS_NUM, impl););
+    MEASURE(sha256_multi(dgsts, msgs, byte_lens_64, FIXED_MSGS_NUM, impl););
+    MEASURE(sha256_64B_multi(dgst[0], data, FIXED_MSGS_NUM, impl););
+    printf("\n");
+  }
+}
+
+_INLINE_ void speed_fixed_sha512(void)
+{
+  static uint8_t data[FIXED_MSGS_NUM * 128];
+  static uint8_t dgst[FIXED_MSGS_NUM][SHA512_HASH_BYTE_LEN];
+
+  const uint8_t *msgs[FIXED_MSGS_NUM];
+  uint8_t *      dgsts[FIXED_MSGS_NUM];
+  size_t         byte_lens_64[FIXED_MSGS_NUM];
+  size_t         byte_lens_128[FIXED_MSGS_NUM];
+
+  // Use a deterministic seed.
+  srand(0);
+  rand_data(data, sizeof(data));
+
+  for(size_t i = 0; i < FIXED_MSGS_NUM; i++) {
+    msgs[i]          = &data[i * 128];
+    dgsts[i]         = dgst[i];
+    byte_lens_64[i]  = 64;
+    byte_lens_128[i] = 128;
+  }
+
+  printf("\nFixed length SHA-512 Benchmark:");
+  printf("\n-------------------------------\n");
+  printf("       impl  sha512 (64)         64B sha512 (128)        128B\n");
+
+  for(size_t k = 0; k < FIXED_IMPLS_NUM; k++) {
+    const sha_impl_t impl = fixed_impls[k].impl;
+
+    // SHA512 has no SHA extension implementation
+    if((impl == SHA_EXT_IMPL) || !sha_impl_supported(impl)) {
+      continue;
+    }
+
+    printf("%11s", fixed_impls[k].name);
+    MEASURE(sha512(dgst[0], data, 64, impl););
+    MEASURE(sha512_64B(dgst[0], data, impl););
+    MEASURE(sha512(dgst[0], data, 128, impl););
+    MEASURE(sha512_128B(dgst[0], data, impl););
+    printf("\n");
+  }
+
+  printf("\nFixed length SHA-512 multi-buffer Benchmark (%ld messages):",
+         FIXED_MSGS_NUM);
+  printf("\n----------------------------------------------------------\n");
+  printf("       impl   multi (64)   64B multi  multi (128)  128B multi\n");
+
+  for(size_t k = 0; k < FIXED_IMPLS_NUM; k++) {
+    const sha_impl_t impl = fixed_impls[k].impl;
+
+    if((impl == SHA_EXT_IMPL) || !sha_impl_supported(impl)) {
+      continue;
+    }
+
+    printf("%11s", fixed_impls[k].name);
+    MEASURE(sha512_multi(dgsts, msgs, byte_lens_64, FIXED_MSGS_NUM, impl););
+    MEASURE(sha512_64B_multi(dgst[0], data, FIXED_MSGS_NUM, impl););
+    MEASURE(sha512_multi(dgsts, msgs, byte_lens_128, FIXED_MSGS_NUM, impl););
+    MEASURE(sha512_128B_multi(dgst[0], data, FIXED_MSGS_NUM, impl););
+    printf("\n");
+  }
+}
+
+// SHA256d of messages up to an 80 bytes (block) header
+#define SHA256D_MAX_MSG_BYTE_LEN (128UL)
+
+_INLINE_ void naive_sha256d(OUT uint8_t *dgst,
+                            IN const uint8_t *data,
+                            IN const size_t   byte_len,
+                            IN const sha_impl_t impl)
+{
+  uint8_t tmp[SHA256_HASH_BYTE_LEN];
+
+  sha256(tmp, data, byte_len, impl);
+  sha256(dgst, tmp, sizeof(tmp), impl);
+}
+
+_INLINE_ void speed_sha256d(void)
+{
+  static uint8_t data[FIXED_MSGS_NUM * SHA256D_MAX_MSG_BYTE_LEN];
+  static uint8_t dgst[FIXED_MSGS_NUM][SHA256_HASH_BYTE_LEN];
+
+  const uint8_t *msgs[FIXED_MSGS_NUM];
+  uint8_t *      dgsts[FIXED_MSGS_NUM];
+  uint8_t *      tmp_dgsts[FIXED_MSGS_NUM];
+  const uint8_t *tmp_msgs[FIXED_MSGS_NUM];
+  size_t         byte_lens[FIXED_MSGS_NUM];
+  size_t         dgst_lens[FIXED_MSGS_NUM];
+  uint8_t        tmp[FIXED_MSGS_NUM][SHA256_HASH_BYTE_LEN];
+
+  // Use a deterministic seed.
+  srand(0);
+  rand_data(data, sizeof(data));
+
+  printf("\nSHA-256d Benchmark (80 bytes messages):");
+  printf("\n---------------------------------------\n");
+  printf("       impl  sha256 x 2     sha256d\n");
+
+  for(size_t k = 0; k < FIXED_IMPLS_NUM; k++) {
+    const sha_impl_t impl = fixed_impls[k].impl;
+
+    if(!sha_impl_supported(impl)) {
+      continue;
+    }
+
+    printf("%11s", fixed_impls[k].name);
+    MEASURE(naive_sha256d(dgst[0], data, 80, impl););
+    MEASURE(sha256d(dgst[0], data, 80, impl););
+    printf("\n");
+  }
+
+  for(size_t i = 0; i < FIXED_MSGS_NUM; i++) {
+    msgs[i]      = &data[i * SHA256D_MAX_MSG_BYTE_LEN];
+    dgsts[i]     = dgst[i];
+    tmp_dgsts[i] = tmp[i];
+    tmp_msgs[i]  = tmp[i];
+    byte_lens[i] = 80;
+    dgst_lens[i] = SHA256_HASH_BYTE_LEN;
+  }
+
+  printf("\nSHA-256d multi-buffer Benchmark (%ld messages of 80 bytes):",
+         FIXED_MSGS_NUM);
+  printf("\n----------------------------------------------------------\n");
+  printf("       impl   multi x 2     sha256d\n");
+
+  for(size_t k = 0; k < FIXED_IMPLS_NUM; k++) {
+    const sha_impl_t impl = fixed_impls[k].impl;
+
+    if(!sha_impl_supported(impl)) {
+      continue;
+    }
+
+    printf("%11s", fixed_impls[k].name);
+    MEASURE(
+      sha256_multi(tmp_dgsts, msgs, byte_lens, FIXED_MSGS_NUM, impl);
+      sha256_multi(dgsts, tmp_msgs, dgst_lens, FIXED_MSGS_NUM, impl););
+    MEASURE(sha256d_multi(dgsts, msgs, byte_lens, FIXED_MSGS_NUM, impl););
+    printf("\n");
+  }
+}
+
+#define SCAN_NONCES_NUM (4096UL)
+
+// Hashes every nonce of the header with a separate sha256d call
+_INLINE_ void naive_sha256d_scan(IN OUT uint8_t *header, IN const sha_impl_t impl)
+{
+  uint8_t dgst[SHA256_HASH_BYTE_LEN];
+
+  for(uint32_t nonce = 0; nonce < SCAN_NONCES_NUM; nonce++) {
+    memcpy(&header[SHA256D_HEADER_BYTE_LEN - sizeof(nonce)], &nonce,
+           sizeof(nonce));
+    sha256d(dgst, header, SHA256D_HEADER_BYTE_LEN, impl);
+  }
+}
+
+_INLINE_ void speed_sha256d_scan(void)
+{
+  uint8_t  header[SHA256D_HEADER_BYTE_LEN];
+  uint8_t  target[SHA256_HASH_BYTE_LEN] = {0};
+  uint32_t hits[1];
+
+  sha256d_scan_t *scan = sha256d_scan_new();
+  if(scan == NULL) {
+    return;
+  }
+
+  // Use a deterministic seed.
+  srand(0);
+  rand_data(header, sizeof(header));
+
+  printf("\nSHA-256d nonce scanning Benchmark (%ld nonces):", SCAN_NONCES_NUM);
+  printf("\n----------------------------------------------\n");
+  printf("       impl     sha256d        scan\n");
+
+  for(size_t k = 0; k < FIXED_IMPLS_NUM; k++) {
+    const sha_impl_t impl = fixed_impls[k].impl;
+
+    if(!sha_impl_supported(impl)) {
+      continue;
+    }
+
+    sha256d_scan_init(scan, header, impl);
+
+    printf("%11s", fixed_impls[k].name);
+    MEASURE(naive_sha256d_scan(header, impl););
+    MEASURE(sha256d_scan(hits, 1, scan, 0, SCAN_NONCES_NUM, target););
+    printf("\n");
+  }
+
+  sha256d_scan_free(scan);
+}
+
+#define TREE_BYTE_LEN       (1UL << 22)
+#define TREE_CHUNK_BYTE_LEN (1UL << 16)
+
+// The tree hashing with one thread shows the gain of the multi-buffer lanes,
+// and with all the CPUs, the gain of the threads
+_INLINE_ void speed_tree(void)
+{
+  uint8_t dgst[SHA512_HASH_BYTE_LEN];
+
+  uint8_t *data = malloc(TREE_BYTE_LEN);
+  if(data == NULL) {
+    return;
+  }
+
+  // Use a deterministic seed.
+  srand(0);
+  rand_data(data, TREE_BYTE_LEN);
+
+  printf("\nTree hashing Benchmark (%ld bytes, %ld bytes chunks):",
+         TREE_BYTE_LEN, TREE_CHUNK_BYTE_LEN);
+  printf("\n--------------------------------------------------------\n");
+  printf("       impl      sha256  tree256(1)  tree256(N)      sha512  "
+         "tree512(1)  tree512(N)\n");
+
+  for(size_t k = 0; k < FIXED_IMPLS_NUM; k++) {
+    const sha_impl_t impl = fixed_impls[k].impl;
+
+    if(!sha_impl_supported(impl)) {
+      continue;
+    }
+
+    printf("%11s", fixed_impls[k].name);
+    MEASURE(sha256(dgst, data, TREE_BYTE_LEN, impl););
+    MEASURE(sha256_tree(dgst, data, TREE_BYTE_LEN, TREE_CHUNK_BYTE_LEN, 1,
+                        impl););
+    MEASURE(sha256_tree(dgst, data, TREE_BYTE_LEN, TREE_CHUNK_BYTE_LEN, 0,
+                        impl););
+    MEASURE(sha512(dgst, data, TREE_BYTE_LEN, impl););
+    MEASURE(sha512_tree(dgst, data, TREE_BYTE_LEN, TREE_CHUNK_BYTE_LEN, 1,
+                        impl););
+    MEASURE(sha512_tree(dgst, data, TREE_BYTE_LEN, TREE_CHUNK_BYTE_LEN, 0,
+                        impl););
+    printf("\n");
+  }
+
+  free(data);
+}
+
+#define POOL_MSGS_NUM         (256)
+#define POOL_MIN_MSG_BYTE_LEN (100)
+#define POOL_MAX_MSG_BYTE_LEN (16384)
+
+// Messages of mixed lengths. sha*_multi (multi) hashes them in the given order,
+// and sha*_multi_pool sorts them first, and hashes them on the calling thread
+// (sorted) and on a pool of all the CPUs (pool).
+_INLINE_ void speed_multi_pool(void)
+{
+  static uint8_t data[POOL_MAX_MSG_BYTE_LEN];
+  static uint8_t dgst[POOL_MSGS_NUM][SHA512_HASH_BYTE_LEN];
+
+  const uint8_t *msgs[POOL_MSGS_NUM];
+  uint8_t *      dgsts[POOL_MSGS_NUM];
+  size_t         byte_lens[POOL_MSGS_NUM];
+
+  sha_pool_t *pool = sha_pool_new(0);
+  if(pool == NULL) {
+    return;
+  }
+
+  // Use a deterministic seed.
+  srand(0);
+  rand_data(data, sizeof(data));
+
+  const size_t lens_range = POOL_MAX_MSG_BYTE_LEN - POOL_MIN_MSG_BYTE_LEN;
+
+  for(size_t i = 0; i < POOL_MSGS_NUM; i++) {
+    msgs[i]      = data;
+    dgsts[i]     = dgst[i];
+    byte_lens[i] = POOL_MIN_MSG_BYTE_LEN + ((size_t)rand() % lens_range);
+  }
+
+  printf("\nThread pool multi-buffer Benchmark (%d messages, %d-%d bytes, %ld "
+         "threads):",
+         POOL_MSGS_NUM, POOL_MIN_MSG_BYTE_LEN, POOL_MAX_MSG_BYTE_LEN,
+         sha_pool_threads_num(pool));
+  printf("\n------------------------------------------------------------------"
+         "-------\n");
+  printf("       impl    multi256    sorted256      pool256"
+         "     multi512    sorted512      pool512\n");
+
+  for(size_t k = 0; k < FIXED_IMPLS_NUM; k++) {
+    const sha_impl_t impl = fixed_impls[k].impl;
+
+    if(!sha_impl_supported(impl)) {
+      continue;
+    }
+
+    printf("%11s", fixed_impls[k].name);
+    MEASURE(sha256_multi(dgsts, msgs, byte_lens, POOL_MSGS_NUM, impl););
+    MEASURE(sha256_multi_pool(dgsts, msgs, byte_lens, POOL_MSGS_NUM, NULL,
+                              impl););
+    MEASURE(sha256_multi_pool(dgsts, msgs, byte_lens, POOL_MSGS_NUM, pool,
+                              impl););
+    MEASURE(sha512_multi(dgsts, msgs, byte_lens, POOL_MSGS_NUM, impl););
+    MEASURE(sha512_multi_pool(dgsts, msgs, byte_lens, POOL_MSGS_NUM, NULL,
+                              impl););
+    MEASURE(sha512_multi_pool(dgsts, msgs, byte_lens, POOL_MSGS_NUM, pool,
+                              impl););
+    printf("\n");
+  }
+
+  sha_pool_free(pool);
+}
+
+// The percentage of the lanes that had a message, over all the multi-buffer
+// compressions (0 without a multi-buffer implementation)
+_INLINE_ double utilization(IN const sha_multi_stats_t *stats)
+{
+  if(stats->lanes_blocks_num == 0) {
+    return 0;
+  }
+
+  return (100.0 * (double)stats->busy_blocks_num) /
+         (double)stats->lanes_blocks_num;
+}
+
+// The lane utilization of sha*_multi for the messages of mixed lengths of
+// speed_multi_pool, in the given order
+_INLINE_ void speed_multi_stats(void)
+{
+  static uint8_t data[POOL_MAX_MSG_BYTE_LEN];
+  static uint8_t dgst[POOL_MSGS_NUM][SHA512_HASH_BYTE_LEN];
+
+  const uint8_t *msgs[POOL_MSGS_NUM];
+  uint8_t *      dgsts[POOL_MSGS_NUM];
+  size_t         byte_lens[POOL_MSGS_NUM];
+
+  const size_t lens_range = POOL_MAX_MSG_BYTE_LEN - POOL_MIN_MSG_BYTE_LEN;
+
+  // Use a deterministic seed.
+  srand(0);
+  rand_data(data, sizeof(data));
+
+  for(size_t i = 0; i < POOL_MSGS_NUM; i++) {
+    msgs[i]      = data;
+    dgsts[i]     = dgst[i];
+    byte_lens[i] = POOL_MIN_MSG_BYTE_LEN + ((size_t)rand() % lens_range);
+  }
+
+  printf("\nMulti-buffer lane utilization (%d messages, %d-%d bytes):",
+         POOL_MSGS_NUM, POOL_MIN_MSG_BYTE_LEN, POOL_MAX_MSG_BYTE_LEN);
+  printf("\n--------------------------------------------------------\n");
+  printf("       impl    multi256  utilization    multi512  utilization\n");
+
+  for(size_t k = 0; k < FIXED_IMPLS_NUM; k++) {
+    const sha_impl_t  impl     = fixed_impls[k].impl;
+    sha_multi_stats_t stats256 = {0};
+    sha_multi_stats_t stats512 = {0};
+
+    if(!sha_impl_supported(impl)) {
+      continue;
+    }
+
+    sha256_multi_stats(dgsts, msgs, byte_lens, POOL_MSGS_NUM, impl, &stats256);
+    sha512_multi_stats(dgsts, msgs, byte_lens, POOL_MSGS_NUM, impl, &stats512);
+
+    printf("%11s", fixed_impls[k].name);
+    MEASURE(sha256_multi(dgsts, msgs, byte_lens, POOL_MSGS_NUM, impl););
+    printf("%11.1f%% ", utilization(&stats256));
+    MEASURE(sha512_multi(dgsts, msgs, byte_lens, POOL_MSGS_NUM, impl););
+    printf("%11.1f%%\n", utilization(&stats512));
+  }
 }
 
 int main(void)
 {
   speed_sha256();
+  speed_sha256_multi();
   speed_sha512();
+  speed_sha512_multi();
+  speed_sha2_variants();
+  speed_hmac_sha256();
+  speed_hmac_sha512();
+  speed_hmac_sha256_multi();
+  speed_hmac_sha512_multi();
+  speed_pbkdf2_sha256();
+  speed_pbkdf2_sha512();
+  speed_hkdf_sha256();
+  speed_hkdf_sha512();
+  speed_merkle_sha256();
+  speed_merkle_sha512();
+  speed_fixed_sha256();
+  speed_fixed_sha512();
+  speed_sha256d();
+  speed_sha256d_scan();
+  speed_tree();
+  speed_multi_pool();
+  speed_multi_stats();
 
   return 0;
 }
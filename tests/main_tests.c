@@ -1,10 +1,14 @@
 // Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
 // SPDX-License-Identifier: Apache-2.0
 
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+#include <openssl/kdf.h>
 #include <openssl/sha.h>
 
 #include "sha.h"
@@ -17,6 +21,131 @@
 #  define MONTE_CARLO_NUM_OF_TESTS (100000)
 #endif
 
+// Chunk sizes that are smaller than, equal to, and larger than the blocks of
+// SHA256 and SHA512, so that the streaming API is tested with partial blocks.
+static const size_t chunk_byte_lens[] = {1,   3,  64,   127, 128,
+                                         7, 200, 63, 1000, 129};
+
+#define CHUNKS_NUM (sizeof(chunk_byte_lens) / sizeof(chunk_byte_lens[0]))
+
+// More messages than the lanes of the widest (AVX512) multi-buffer
+// implementation.
+#define MULTI_TEST_MAX_MSGS_NUM (40)
+#define MULTI_TEST_CASES_NUM    (2000)
+
+// Keys that are shorter than, equal to, and longer than the blocks of SHA256
+// and SHA512.
+#define HMAC_TEST_MAX_KEY_BYTE_LEN (300)
+#define HMAC_TEST_CASES_NUM        (1000)
+
+// The batched HMAC tests pick the key of every message from a small pool
+#define HMAC_MULTI_TEST_KEYS_NUM (4)
+
+// PBKDF2 outputs of up to 17 blocks fill more than one group of lanes
+#define PBKDF2_TEST_CASES_NUM        (100)
+#define PBKDF2_TEST_MAX_PWDS_NUM     (20)
+#define PBKDF2_TEST_MAX_ITER_NUM     (50)
+#define PBKDF2_TEST_MAX_OUT_BLOCKS   (17)
+#define PBKDF2_TEST_MAX_IN_BYTE_LEN  (300)
+
+#define HKDF_TEST_CASES_NUM       (300)
+#define HKDF_TEST_MAX_OUTPUTS_NUM (20)
+#define HKDF_TEST_MAX_OKM_BYTE_LEN (1000)
+
+// SHA224, SHA384, SHA512/224 and SHA512/256. The first lengths span a few
+// blocks of SHA512, to cover both one and two padding blocks.
+#define VARIANTS_TEST_CASES_NUM     (1000)
+#define VARIANTS_TEST_ALL_LENS_NUM  (512)
+
+// Trees of up to 70 leaves fill several groups of lanes in the lower levels,
+// and have odd levels
+#define MERKLE_TEST_CASES_NUM      (400)
+#define MERKLE_TEST_MAX_LEAVES_NUM (70)
+#define MERKLE_TEST_MAX_NODES_NUM  (2 * MERKLE_TEST_MAX_LEAVES_NUM + 8)
+
+// The fixed length messages are read from unaligned offsets of the buffer
+#define FIXED_TEST_CASES_NUM     (400)
+#define FIXED_TEST_MAX_BYTE_LEN  (128)
+
+// SHA256d messages of all the lengths up to a few blocks, and random lengths
+#define SHA256D_TEST_ALL_LENS_NUM (300)
+#define SHA256D_TEST_CASES_NUM    (1000)
+
+// Nonce scans of up to 100 nonces cover partially filled lanes. Some of the
+// scans wrap around the nonce range.
+#define SCAN_TEST_CASES_NUM      (200)
+#define SCAN_TEST_MAX_NONCES_NUM (100)
+
+// Files of all the lengths up to a few blocks, around the 4MB buffers of the
+// direct reads, and random lengths of up to a few MB, written to the current
+// directory
+#define FILE_TEST_ALL_LENS_NUM (300)
+#define FILE_TEST_CASES_NUM    (20)
+#define FILE_TEST_MAX_BYTE_LEN (9UL << 20)
+#define FILE_TEST_BUF_BYTE_LEN (1UL << 22)
+#define FILE_TEST_PATH         "sha_file_test.bin"
+#define FILE_TEST_PROC_PATH    "/proc/version"
+
+// Tree hashing of inputs of up to 40 chunks of the smallest chunk length, which
+// fill several groups of lanes, with chunks of one block and longer chunks
+#define TREE_TEST_CASES_NUM     (100)
+#define TREE_TEST_MAX_BYTE_LEN  (1UL << 20)
+#define TREE_TEST_MAX_CHUNKS_NUM (40)
+
+// Batches of up to 300 messages of mixed lengths, on pools of several sizes
+// (the pools are shared by all the batches)
+#define POOL_TEST_CASES_NUM      (100)
+#define POOL_TEST_MAX_MSGS_NUM   (300)
+#define POOL_TEST_MAX_BYTE_LEN   (16384)
+#define POOL_TEST_POOLS_NUM      (4)
+
+// Batches of mixed lengths (see MULTI_TEST_MAX_MSGS_NUM). The refilled lanes
+// of the multi-buffer implementations are idle only at the end of a batch, so
+// the lanes of long batches are mostly busy.
+#define STATS_TEST_CASES_NUM        (200)
+#define STATS_TEST_MAX_MSGS_NUM     (200)
+#define STATS_TEST_LONG_MSGS_NUM    (100)
+#define STATS_TEST_MIN_UTILIZATION  (0.8)
+
+#define PBKDF2_SHA256_MAX_OUT (PBKDF2_TEST_MAX_OUT_BLOCKS * 32)
+#define PBKDF2_SHA512_MAX_OUT (PBKDF2_TEST_MAX_OUT_BLOCKS * 64)
+
+_INLINE_ int test_sha256_stream_impl(IN const sha_impl_t impl,
+                                     IN const uint8_t *data,
+                                     IN const uint8_t *ref_dgst,
+                                     IN const size_t   byte_len)
+{
+  uint8_t       tst_dgst[SHA256_HASH_BYTE_LEN] = {0};
+  sha256_ctx_t *ctx                            = sha256_ctx_new();
+
+  if(ctx == NULL) {
+    return FAILURE;
+  }
+
+  // Hash the message in chunks of different sizes
+  sha256_init(ctx, impl);
+  for(size_t pos = 0, i = 0; pos < byte_len; i++) {
+    const size_t rem_len   = byte_len - pos;
+    const size_t chunk_len = chunk_byte_lens[i % CHUNKS_NUM];
+    const size_t len       = (chunk_len < rem_len) ? chunk_len : rem_len;
+
+    sha256_update(ctx, &data[pos], len);
+    pos += len;
+  }
+  sha256_final(tst_dgst, ctx);
+  sha256_ctx_free(ctx);
+
+  if(0 != memcmp(ref_dgst, tst_dgst, SHA256_HASH_BYTE_LEN)) {
+    printf("Streaming digest mismatch for impl=%d and size=%ld\n", impl,
+           byte_len);
+    print(ref_dgst, SHA256_HASH_BYTE_LEN);
+    print(tst_dgst, SHA256_HASH_BYTE_LEN);
+    return FAILURE;
+  }
+
+  return SUCCESS;
+}
+
 _INLINE_ int test_sha256_impl(IN const sha_impl_t impl,
                               IN const uint8_t *data,
                               IN const uint8_t *ref_dgst,
@@ -32,7 +161,7 @@ _INLINE_ int test_sha256_impl(IN const sha_impl_t impl,
     return FAILURE;
   }
 
-  return SUCCESS;
+  return test_sha256_stream_impl(impl, data, ref_dgst, byte_len);
 }
 
 _INLINE_ int test_sha256()
@@ -50,6 +179,7 @@ _INLINE_ int test_sha256()
     SHA256(data, byte_len, ref_dgst);
 
     GUARD(test_sha256_impl(GENERIC_IMPL, data, ref_dgst, byte_len));
+    GUARD(test_sha256_impl(AUTO_IMPL, data, ref_dgst, byte_len));
 
     // X86-64 specific options
     RUN_X86_64(GUARD(test_sha256_impl(AVX_IMPL, data, ref_dgst, byte_len)););
@@ -59,6 +189,7 @@ _INLINE_ int test_sha256()
       GUARD(test_sha256_impl(SHA_EXT_IMPL, data, ref_dgst, byte_len)););
 
     // Aarch64 specific options
+    RUN_NEON(GUARD(test_sha256_impl(NEON_IMPL, data, ref_dgst, byte_len)););
     RUN_AARCH64_SHA_EXT(
       GUARD(test_sha256_impl(SHA_EXT_IMPL, data, ref_dgst, byte_len)););
   }
@@ -83,6 +214,7 @@ _INLINE_ int test_sha256()
       GUARD(test_sha256_impl(SHA_EXT_IMPL, data, ref_dgst, byte_len)););
 
     // Aarch64 specific options
+    RUN_NEON(GUARD(test_sha256_impl(NEON_IMPL, data, ref_dgst, byte_len)););
     RUN_AARCH64_SHA_EXT(
       GUARD(test_sha256_impl(SHA_EXT_IMPL, data, ref_dgst, byte_len)););
   }
@@ -91,6 +223,127 @@ _INLINE_ int test_sha256()
   return SUCCESS;
 }
 
+_INLINE_ int test_sha256_multi_impl(IN const sha_impl_t impl,
+                                    IN const uint8_t *data[],
+                                    IN const size_t   byte_len[],
+                                    IN uint8_t ref_dgst[][SHA256_HASH_BYTE_LEN],
+                                    IN const size_t   msgs_num)
+{
+  uint8_t  tst_dgst[MULTI_TEST_MAX_MSGS_NUM][SHA256_HASH_BYTE_LEN] = {0};
+  uint8_t *dgst[MULTI_TEST_MAX_MSGS_NUM];
+
+  for(size_t i = 0; i < msgs_num; i++) {
+    dgst[i] = tst_dgst[i];
+  }
+
+  sha256_multi(dgst, data, byte_len, msgs_num, impl);
+
+  for(size_t i = 0; i < msgs_num; i++) {
+    if(0 != memcmp(ref_dgst[i], tst_dgst[i], SHA256_HASH_BYTE_LEN)) {
+      printf("Multi-buffer digest mismatch for impl=%d, msg=%ld/%ld and "
+             "size=%ld\n",
+             impl, i, msgs_num, byte_len[i]);
+      print(ref_dgst[i], SHA256_HASH_BYTE_LEN);
+      print(tst_dgst[i], SHA256_HASH_BYTE_LEN);
+      return FAILURE;
+    }
+  }
+
+  return SUCCESS;
+}
+
+_INLINE_ int test_sha256_multi()
+{
+  uint8_t        ref_dgst[MULTI_TEST_MAX_MSGS_NUM][SHA256_HASH_BYTE_LEN];
+  const uint8_t *data[MULTI_TEST_MAX_MSGS_NUM];
+  size_t         byte_len[MULTI_TEST_MAX_MSGS_NUM];
+  uint8_t        buf[SHA256_TEST_MAX_MSG_BYTE_LEN] = {0};
+
+  // Use a deterministic seed.
+  srand(0);
+  rand_data(buf, sizeof(buf));
+
+  printf("Testing SHA256 multi-buffer tests\n");
+
+  for(size_t t = 0; t < MULTI_TEST_CASES_NUM; t++) {
+    // Vary the number of messages to test partially filled lanes.
+    // Half of the cases use messages of the same length, the other half mixes
+    // short and long messages.
+    const size_t msgs_num = 1 + (t % MULTI_TEST_MAX_MSGS_NUM);
+    const size_t same_len = (t / 2) % 300;
+
+    for(size_t i = 0; i < msgs_num; i++) {
+      if(t % 2) {
+        const size_t max_len = (rand() % 4) ? 300 : sizeof(buf);
+        byte_len[i]          = rand() % max_len;
+      } else {
+        byte_len[i] = same_len;
+      }
+
+      data[i] = &buf[rand() % (sizeof(buf) - byte_len[i] + 1)];
+      SHA256(data[i], byte_len[i], ref_dgst[i]);
+    }
+
+    GUARD(test_sha256_multi_impl(GENERIC_IMPL, data, byte_len, ref_dgst,
+                                 msgs_num));
+    GUARD(test_sha256_multi_impl(AUTO_IMPL, data, byte_len, ref_dgst, msgs_num));
+
+    // X86-64 specific options
+    RUN_AVX2(GUARD(test_sha256_multi_impl(AVX2_IMPL, data, byte_len, ref_dgst,
+                                          msgs_num)););
+    RUN_AVX512(GUARD(test_sha256_multi_impl(AVX512_IMPL, data, byte_len,
+                                            ref_dgst, msgs_num)););
+    RUN_X86_64_SHA_EXT(GUARD(test_sha256_multi_impl(
+      SHA_EXT_IMPL, data, byte_len, ref_dgst, msgs_num)););
+
+    // Aarch64 specific options
+    RUN_NEON(GUARD(test_sha256_multi_impl(
+      NEON_IMPL, data, byte_len, ref_dgst, msgs_num)););
+    RUN_AARCH64_SHA_EXT(GUARD(test_sha256_multi_impl(
+      SHA_EXT_IMPL, data, byte_len, ref_dgst, msgs_num)););
+    RUN_SVE(GUARD(test_sha256_multi_impl(SVE_IMPL, data, byte_len, ref_dgst,
+                                         msgs_num)););
+  }
+
+  return SUCCESS;
+}
+
+_INLINE_ int test_sha512_stream_impl(IN const sha_impl_t impl,
+                                     IN const uint8_t *data,
+                                     IN const uint8_t *ref_dgst,
+                                     IN const size_t   byte_len)
+{
+  uint8_t       tst_dgst[SHA512_HASH_BYTE_LEN] = {0};
+  sha512_ctx_t *ctx                            = sha512_ctx_new();
+
+  if(ctx == NULL) {
+    return FAILURE;
+  }
+
+  // Hash the message in chunks of different sizes
+  sha512_init(ctx, impl);
+  for(size_t pos = 0, i = 0; pos < byte_len; i++) {
+    const size_t rem_len   = byte_len - pos;
+    const size_t chunk_len = chunk_byte_lens[i % CHUNKS_NUM];
+    const size_t len       = (chunk_len < rem_len) ? chunk_len : rem_len;
+
+    sha512_update(ctx, &data[pos], len);
+    pos += len;
+  }
+  sha512_final(tst_dgst, ctx);
+  sha512_ctx_free(ctx);
+
+  if(0 != memcmp(ref_dgst, tst_dgst, SHA512_HASH_BYTE_LEN)) {
+    printf("Streaming digest mismatch for impl=%d and size=%ld\n", impl,
+           byte_len);
+    print(ref_dgst, SHA512_HASH_BYTE_LEN);
+    print(tst_dgst, SHA512_HASH_BYTE_LEN);
+    return FAILURE;
+  }
+
+  return SUCCESS;
+}
+
 _INLINE_ int test_sha512_impl(IN const sha_impl_t impl,
                               IN const uint8_t *data,
                               IN const uint8_t *ref_dgst,
@@ -106,7 +359,7 @@ _INLINE_ int test_sha512_impl(IN const sha_impl_t impl,
     return FAILURE;
   }
 
-  return SUCCESS;
+  return test_sha512_stream_impl(impl, data, ref_dgst, byte_len);
 }
 
 _INLINE_ int test_sha512()
@@ -124,11 +377,19 @@ _INLINE_ int test_sha512()
     SHA512(data, byte_len, ref_dgst);
 
     GUARD(test_sha512_impl(GENERIC_IMPL, data, ref_dgst, byte_len));
+    GUARD(test_sha512_impl(AUTO_IMPL, data, ref_dgst, byte_len));
 
     // X86-64 specific options
     RUN_X86_64(GUARD(test_sha512_impl(AVX_IMPL, data, ref_dgst, byte_len)););
     RUN_AVX2(GUARD(test_sha512_impl(AVX2_IMPL, data, ref_dgst, byte_len)););
     RUN_AVX512(GUARD(test_sha512_impl(AVX512_IMPL, data, ref_dgst, byte_len)););
+
+    // Aarch64 specific options
+    RUN_NEON(GUARD(test_sha512_impl(NEON_IMPL, data, ref_dgst, byte_len)););
+    RUN_AARCH64_SHA512_EXT(
+      GUARD(test_sha512_impl(SHA_EXT_IMPL, data, ref_dgst, byte_len)););
+    RUN_AARCH64_SHA512_EXT(
+      GUARD(test_sha512_impl(OPENSSL_SHA_EXT_IMPL, data, ref_dgst, byte_len)););
   }
 
   printf("Testing SHA512 Monte Carlo tests\n");
@@ -144,21 +405,2638 @@ _INLINE_ int test_sha512()
     SHA512(data, byte_len, ref_dgst);
 
     GUARD(test_sha512_impl(GENERIC_IMPL, data, ref_dgst, byte_len));
+    GUARD(test_sha512_impl(AUTO_IMPL, data, ref_dgst, byte_len));
 
     // X86-64 specific options
     RUN_X86_64(GUARD(test_sha512_impl(AVX_IMPL, data, ref_dgst, byte_len)););
     RUN_AVX2(GUARD(test_sha512_impl(AVX2_IMPL, data, ref_dgst, byte_len)););
     RUN_AVX512(GUARD(test_sha512_impl(AVX512_IMPL, data, ref_dgst, byte_len)););
+
+    // Aarch64 specific options
+    RUN_NEON(GUARD(test_sha512_impl(NEON_IMPL, data, ref_dgst, byte_len)););
+    RUN_AARCH64_SHA512_EXT(
+      GUARD(test_sha512_impl(SHA_EXT_IMPL, data, ref_dgst, byte_len)););
+    RUN_AARCH64_SHA512_EXT(
+      GUARD(test_sha512_impl(OPENSSL_SHA_EXT_IMPL, data, ref_dgst, byte_len)););
   }
 
   printf("\n");
   return SUCCESS;
 }
 
+_INLINE_ int test_sha512_multi_impl(IN const sha_impl_t impl,
+                                    IN const uint8_t *data[],
+                                    IN const size_t   byte_len[],
+                                    IN uint8_t ref_dgst[][SHA512_HASH_BYTE_LEN],
+                                    IN const size_t   msgs_num)
+{
+  uint8_t  tst_dgst[MULTI_TEST_MAX_MSGS_NUM][SHA512_HASH_BYTE_LEN] = {0};
+  uint8_t *dgst[MULTI_TEST_MAX_MSGS_NUM];
+
+  for(size_t i = 0; i < msgs_num; i++) {
+    dgst[i] = tst_dgst[i];
+  }
+
+  sha512_multi(dgst, data, byte_len, msgs_num, impl);
+
+  for(size_t i = 0; i < msgs_num; i++) {
+    if(0 != memcmp(ref_dgst[i], tst_dgst[i], SHA512_HASH_BYTE_LEN)) {
+      printf("Multi-buffer digest mismatch for impl=%d, msg=%ld/%ld and "
+             "size=%ld\n",
+             impl, i, msgs_num, byte_len[i]);
+      print(ref_dgst[i], SHA512_HASH_BYTE_LEN);
+      print(tst_dgst[i], SHA512_HASH_BYTE_LEN);
+      return FAILURE;
+    }
+  }
+
+  return SUCCESS;
+}
+
+_INLINE_ int test_sha512_multi()
+{
+  uint8_t        ref_dgst[MULTI_TEST_MAX_MSGS_NUM][SHA512_HASH_BYTE_LEN];
+  const uint8_t *data[MULTI_TEST_MAX_MSGS_NUM];
+  size_t         byte_len[MULTI_TEST_MAX_MSGS_NUM];
+  uint8_t        buf[SHA512_TEST_MAX_MSG_BYTE_LEN] = {0};
+
+  // Use a deterministic seed.
+  srand(0);
+  rand_data(buf, sizeof(buf));
+
+  printf("Testing SHA512 multi-buffer tests\n");
+
+  for(size_t t = 0; t < MULTI_TEST_CASES_NUM; t++) {
+    // Vary the number of messages to test partially filled lanes.
+    // Half of the cases use messages of the same length, the other half mixes
+    // short and long messages.
+    const size_t msgs_num = 1 + (t % MULTI_TEST_MAX_MSGS_NUM);
+    const size_t same_len = (t / 2) % 300;
+
+    for(size_t i = 0; i < msgs_num; i++) {
+      if(t % 2) {
+        const size_t max_len = (rand() % 4) ? 300 : sizeof(buf);
+        byte_len[i]          = rand() % max_len;
+      } else {
+        byte_len[i] = same_len;
+      }
+
+      data[i] = &buf[rand() % (sizeof(buf) - byte_len[i] + 1)];
+      SHA512(data[i], byte_len[i], ref_dgst[i]);
+    }
+
+    GUARD(test_sha512_multi_impl(GENERIC_IMPL, data, byte_len, ref_dgst,
+                                 msgs_num));
+    GUARD(test_sha512_multi_impl(AUTO_IMPL, data, byte_len, ref_dgst, msgs_num));
+
+    // X86-64 specific options
+    RUN_AVX2(GUARD(test_sha512_multi_impl(AVX2_IMPL, data, byte_len, ref_dgst,
+                                          msgs_num)););
+    RUN_AVX512(GUARD(test_sha512_multi_impl(AVX512_IMPL, data, byte_len,
+                                            ref_dgst, msgs_num)););
+
+    // Aarch64 specific options
+    RUN_SVE(GUARD(test_sha512_multi_impl(SVE_IMPL, data, byte_len, ref_dgst,
+                                         msgs_num)););
+  }
+
+  return SUCCESS;
+}
+
+// The truncated variants of SHA512
+typedef struct sha512_variant_s {
+  const char *name;
+  void (*init)(sha512_ctx_t *ctx, sha_impl_t impl);
+  void (*hash)(uint8_t *dgst, const uint8_t *data, size_t len, sha_impl_t impl);
+  const EVP_MD *(*ref_md)(void);
+  size_t dgst_byte_len;
+} sha512_variant_t;
+
+static const sha512_variant_t sha512_variants[] = {
+  {"SHA384", sha384_init, sha384, EVP_sha384, SHA384_HASH_BYTE_LEN},
+  {"SHA512/224", sha512_t224_init, sha512_t224, EVP_sha512_224,
+   SHA512_T224_HASH_BYTE_LEN},
+  {"SHA512/256", sha512_t256_init, sha512_t256, EVP_sha512_256,
+   SHA512_T256_HASH_BYTE_LEN},
+};
+
+#define SHA512_VARIANTS_NUM (sizeof(sha512_variants) / sizeof(sha512_variants[0]))
+
+_INLINE_ int test_sha224_impl(IN const sha_impl_t impl,
+                              IN const uint8_t *data,
+                              IN const uint8_t *ref_dgst,
+                              IN const size_t   byte_len)
+{
+  uint8_t       tst_dgst[SHA224_HASH_BYTE_LEN] = {0};
+  uint8_t       str_dgst[SHA224_HASH_BYTE_LEN] = {0};
+  sha256_ctx_t *ctx = sha256_ctx_new();
+
+  if(ctx == NULL) {
+    return FAILURE;
+  }
+
+  sha224(tst_dgst, data, byte_len, impl);
+
+  sha224_init(ctx, impl);
+  for(size_t pos = 0, i = 0; pos < byte_len; i++) {
+    const size_t rem_len   = byte_len - pos;
+    const size_t chunk_len = chunk_byte_lens[i % CHUNKS_NUM];
+    const size_t len       = (chunk_len < rem_len) ? chunk_len : rem_len;
+
+    sha256_update(ctx, &data[pos], len);
+    pos += len;
+  }
+  sha256_final(str_dgst, ctx);
+  sha256_ctx_free(ctx);
+
+  if((0 != memcmp(ref_dgst, tst_dgst, SHA224_HASH_BYTE_LEN)) ||
+     (0 != memcmp(ref_dgst, str_dgst, SHA224_HASH_BYTE_LEN))) {
+    printf("SHA224 digest mismatch for impl=%d and size=%ld\n", impl,
+           byte_len);
+    print(ref_dgst, SHA224_HASH_BYTE_LEN);
+    print(tst_dgst, SHA224_HASH_BYTE_LEN);
+    print(str_dgst, SHA224_HASH_BYTE_LEN);
+    return FAILURE;
+  }
+
+  return SUCCESS;
+}
+
+_INLINE_ int test_sha224()
+{
+  uint8_t ref_dgst[SHA224_HASH_BYTE_LEN]     = {0};
+  uint8_t data[SHA256_TEST_MAX_MSG_BYTE_LEN] = {0};
+
+  // Use a deterministic seed.
+  srand(0);
+  rand_data(data, sizeof(data));
+
+  printf("Testing SHA224\n");
+
+  for(size_t t = 0; t < VARIANTS_TEST_CASES_NUM; t++) {
+    // Test all the short lengths, then random lengths
+    const size_t byte_len =
+      (t < VARIANTS_TEST_ALL_LENS_NUM) ? t : (rand() % sizeof(data));
+
+    EVP_Digest(data, byte_len, ref_dgst, NULL, EVP_sha224(), NULL);
+
+    GUARD(test_sha224_impl(GENERIC_IMPL, data, ref_dgst, byte_len));
+    GUARD(test_sha224_impl(AUTO_IMPL, data, ref_dgst, byte_len));
+
+    // X86-64 specific options
+    RUN_X86_64(GUARD(test_sha224_impl(AVX_IMPL, data, ref_dgst, byte_len)););
+    RUN_AVX2(GUARD(test_sha224_impl(AVX2_IMPL, data, ref_dgst, byte_len)););
+    RUN_AVX512(GUARD(test_sha224_impl(AVX512_IMPL, data, ref_dgst, byte_len)););
+    RUN_X86_64_SHA_EXT(
+      GUARD(test_sha224_impl(SHA_EXT_IMPL, data, ref_dgst, byte_len)););
+
+    // Aarch64 specific options
+    RUN_AARCH64_SHA_EXT(
+      GUARD(test_sha224_impl(SHA_EXT_IMPL, data, ref_dgst, byte_len)););
+  }
+
+  return SUCCESS;
+}
+
+_INLINE_ int test_sha512_variant_impl(IN const sha_impl_t impl,
+                                      IN const sha512_variant_t *v,
+                                      IN const uint8_t *         data,
+                                      IN const uint8_t *         ref_dgst,
+                                      IN const size_t            byte_len)
+{
+  uint8_t       tst_dgst[SHA512_HASH_BYTE_LEN] = {0};
+  uint8_t       str_dgst[SHA512_HASH_BYTE_LEN] = {0};
+  sha512_ctx_t *ctx = sha512_ctx_new();
+
+  if(ctx == NULL) {
+    return FAILURE;
+  }
+
+  v->hash(tst_dgst, data, byte_len, impl);
+
+  v->init(ctx, impl);
+  for(size_t pos = 0, i = 0; pos < byte_len; i++) {
+    const size_t rem_len   = byte_len - pos;
+    const size_t chunk_len = chunk_byte_lens[i % CHUNKS_NUM];
+    const size_t len       = (chunk_len < rem_len) ? chunk_len : rem_len;
+
+    sha512_update(ctx, &data[pos], len);
+    pos += len;
+  }
+  sha512_final(str_dgst, ctx);
+  sha512_ctx_free(ctx);
+
+  // The bytes after the truncated digest must not be written
+  if((0 != memcmp(ref_dgst, tst_dgst, v->dgst_byte_len)) ||
+     (0 != memcmp(ref_dgst, str_dgst, v->dgst_byte_len)) ||
+     (tst_dgst[v->dgst_byte_len] != 0) || (str_dgst[v->dgst_byte_len] != 0)) {
+    printf("%s digest mismatch for impl=%d and size=%ld\n", v->name, impl,
+           byte_len);
+    print(ref_dgst, v->dgst_byte_len);
+    print(tst_dgst, v->dgst_byte_len);
+    print(str_dgst, v->dgst_byte_len);
+    return FAILURE;
+  }
+
+  return SUCCESS;
+}
+
+_INLINE_ int test_sha512_variants()
+{
+  uint8_t ref_dgst[SHA512_HASH_BYTE_LEN]     = {0};
+  uint8_t data[SHA512_TEST_MAX_MSG_BYTE_LEN] = {0};
+
+  // Use a deterministic seed.
+  srand(0);
+  rand_data(data, sizeof(data));
+
+  for(size_t k = 0; k < SHA512_VARIANTS_NUM; k++) {
+    const sha512_variant_t *v = &sha512_variants[k];
+
+    printf("Testing %s\n", v->name);
+
+    for(size_t t = 0; t < VARIANTS_TEST_CASES_NUM; t++) {
+      // Test all the short lengths, then random lengths
+      const size_t byte_len =
+        (t < VARIANTS_TEST_ALL_LENS_NUM) ? t : (rand() % sizeof(data));
+
+      EVP_Digest(data, byte_len, ref_dgst, NULL, v->ref_md(), NULL);
+
+      GUARD(test_sha512_variant_impl(GENERIC_IMPL, v, data, ref_dgst, byte_len));
+      GUARD(test_sha512_variant_impl(AUTO_IMPL, v, data, ref_dgst, byte_len));
+
+      // X86-64 specific options
+      RUN_X86_64(GUARD(
+        test_sha512_variant_impl(AVX_IMPL, v, data, ref_dgst, byte_len)););
+      RUN_AVX2(GUARD(
+        test_sha512_variant_impl(AVX2_IMPL, v, data, ref_dgst, byte_len)););
+      RUN_AVX512(GUARD(
+        test_sha512_variant_impl(AVX512_IMPL, v, data, ref_dgst, byte_len)););
+    }
+  }
+
+  return SUCCESS;
+}
+
+_INLINE_ int test_hmac_sha256_impl(IN const sha_impl_t impl,
+                                   IN const uint8_t *key_data,
+                                   IN const size_t   key_byte_len,
+                                   IN const uint8_t *data,
+                                   IN const size_t   byte_len,
+                                   IN const uint8_t *ref_mac)
+{
+  uint8_t            tst_mac[SHA256_HASH_BYTE_LEN]    = {0};
+  uint8_t            stream_mac[SHA256_HASH_BYTE_LEN] = {0};
+  hmac_sha256_key_t *key                              = hmac_sha256_key_new();
+  sha256_ctx_t *     ctx                              = sha256_ctx_new();
+
+  if((key == NULL) || (ctx == NULL)) {
+    hmac_sha256_key_free(key);
+    sha256_ctx_free(ctx);
+    return FAILURE;
+  }
+
+  hmac_sha256_key_init(key, key_data, key_byte_len, impl);
+  hmac_sha256(tst_mac, key, data, byte_len);
+
+  // Hash the message in chunks of different sizes
+  hmac_sha256_init(ctx, key);
+  for(size_t pos = 0, i = 0; pos < byte_len; i++) {
+    const size_t rem_len   = byte_len - pos;
+    const size_t chunk_len = chunk_byte_lens[i % CHUNKS_NUM];
+    const size_t len       = (chunk_len < rem_len) ? chunk_len : rem_len;
+
+    sha256_update(ctx, &data[pos], len);
+    pos += len;
+  }
+  hmac_sha256_final(stream_mac, ctx, key);
+
+  hmac_sha256_key_free(key);
+  sha256_ctx_free(ctx);
+
+  if((0 != memcmp(ref_mac, tst_mac, SHA256_HASH_BYTE_LEN)) ||
+     (0 != memcmp(ref_mac, stream_mac, SHA256_HASH_BYTE_LEN))) {
+    printf("HMAC mismatch for impl=%d, key size=%ld and size=%ld\n", impl,
+           key_byte_len, byte_len);
+    print(ref_mac, SHA256_HASH_BYTE_LEN);
+    print(tst_mac, SHA256_HASH_BYTE_LEN);
+    print(stream_mac, SHA256_HASH_BYTE_LEN);
+    return FAILURE;
+  }
+
+  return SUCCESS;
+}
+
+_INLINE_ int test_hmac_sha256()
+{
+  uint8_t      ref_mac[SHA256_HASH_BYTE_LEN]        = {0};
+  uint8_t      key_data[HMAC_TEST_MAX_KEY_BYTE_LEN] = {0};
+  uint8_t      data[SHA256_TEST_MAX_MSG_BYTE_LEN]   = {0};
+  unsigned int ref_mac_len                          = 0;
+
+  // Use a deterministic seed.
+  srand(0);
+
+  printf("Testing HMAC-SHA256 tests\n");
+
+  for(size_t t = 0; t < HMAC_TEST_CASES_NUM; t++) {
+    const size_t key_byte_len = t % HMAC_TEST_MAX_KEY_BYTE_LEN;
+    const size_t byte_len     = rand() % 1000;
+
+    rand_data(key_data, key_byte_len);
+    rand_data(data, byte_len);
+    HMAC(EVP_sha256(), key_data, (int)key_byte_len, data, byte_len, ref_mac,
+         &ref_mac_len);
+
+    GUARD(test_hmac_sha256_impl(GENERIC_IMPL, key_data, key_byte_len, data,
+                                byte_len, ref_mac));
+    GUARD(test_hmac_sha256_impl(AUTO_IMPL, key_data, key_byte_len, data,
+                                byte_len, ref_mac));
+
+    // X86-64 specific options
+    RUN_X86_64(GUARD(test_hmac_sha256_impl(AVX_IMPL, key_data, key_byte_len,
+                                           data, byte_len, ref_mac)););
+    RUN_AVX2(GUARD(test_hmac_sha256_impl(AVX2_IMPL, key_data, key_byte_len,
+                                         data, byte_len, ref_mac)););
+    RUN_AVX512(GUARD(test_hmac_sha256_impl(AVX512_IMPL, key_data, key_byte_len,
+                                           data, byte_len, ref_mac)););
+    RUN_X86_64_SHA_EXT(GUARD(test_hmac_sha256_impl(
+      SHA_EXT_IMPL, key_data, key_byte_len, data, byte_len, ref_mac)););
+
+    // Aarch64 specific options
+    RUN_AARCH64_SHA_EXT(GUARD(test_hmac_sha256_impl(
+      SHA_EXT_IMPL, key_data, key_byte_len, data, byte_len, ref_mac)););
+  }
+
+  // An empty key and an empty message may be passed as NULL
+  HMAC(EVP_sha256(), key_data, 0, data, 0, ref_mac, &ref_mac_len);
+  GUARD(test_hmac_sha256_impl(GENERIC_IMPL, NULL, 0, NULL, 0, ref_mac));
+  GUARD(test_hmac_sha256_impl(AUTO_IMPL, NULL, 0, NULL, 0, ref_mac));
+
+  return SUCCESS;
+}
+
+_INLINE_ int test_hmac_sha512_impl(IN const sha_impl_t impl,
+                                   IN const uint8_t *key_data,
+                                   IN const size_t   key_byte_len,
+                                   IN const uint8_t *data,
+                                   IN const size_t   byte_len,
+                                   IN const uint8_t *ref_mac)
+{
+  uint8_t            tst_mac[SHA512_HASH_BYTE_LEN]    = {0};
+  uint8_t            stream_mac[SHA512_HASH_BYTE_LEN] = {0};
+  hmac_sha512_key_t *key                              = hmac_sha512_key_new();
+  sha512_ctx_t *     ctx                              = sha512_ctx_new();
+
+  if((key == NULL) || (ctx == NULL)) {
+    hmac_sha512_key_free(key);
+    sha512_ctx_free(ctx);
+    return FAILURE;
+  }
+
+  hmac_sha512_key_init(key, key_data, key_byte_len, impl);
+  hmac_sha512(tst_mac, key, data, byte_len);
+
+  // Hash the message in chunks of different sizes
+  hmac_sha512_init(ctx, key);
+  for(size_t pos = 0, i = 0; pos < byte_len; i++) {
+    const size_t rem_len   = byte_len - pos;
+    const size_t chunk_len = chunk_byte_lens[i % CHUNKS_NUM];
+    const size_t len       = (chunk_len < rem_len) ? chunk_len : rem_len;
+
+    sha512_update(ctx, &data[pos], len);
+    pos += len;
+  }
+  hmac_sha512_final(stream_mac, ctx, key);
+
+  hmac_sha512_key_free(key);
+  sha512_ctx_free(ctx);
+
+  if((0 != memcmp(ref_mac, tst_mac, SHA512_HASH_BYTE_LEN)) ||
+     (0 != memcmp(ref_mac, stream_mac, SHA512_HASH_BYTE_LEN))) {
+    printf("HMAC mismatch for impl=%d, key size=%ld and size=%ld\n", impl,
+           key_byte_len, byte_len);
+    print(ref_mac, SHA512_HASH_BYTE_LEN);
+    print(tst_mac, SHA512_HASH_BYTE_LEN);
+    print(stream_mac, SHA512_HASH_BYTE_LEN);
+    return FAILURE;
+  }
+
+  return SUCCESS;
+}
+
+_INLINE_ int test_hmac_sha512()
+{
+  uint8_t      ref_mac[SHA512_HASH_BYTE_LEN]        = {0};
+  uint8_t      key_data[HMAC_TEST_MAX_KEY_BYTE_LEN] = {0};
+  uint8_t      data[SHA512_TEST_MAX_MSG_BYTE_LEN]   = {0};
+  unsigned int ref_mac_len                          = 0;
+
+  // Use a deterministic seed.
+  srand(0);
+
+  printf("Testing HMAC-SHA512 tests\n");
+
+  for(size_t t = 0; t < HMAC_TEST_CASES_NUM; t++) {
+    const size_t key_byte_len = t % HMAC_TEST_MAX_KEY_BYTE_LEN;
+    const size_t byte_len     = rand() % 1000;
+
+    rand_data(key_data, key_byte_len);
+    rand_data(data, byte_len);
+    HMAC(EVP_sha512(), key_data, (int)key_byte_len, data, byte_len, ref_mac,
+         &ref_mac_len);
+
+    GUARD(test_hmac_sha512_impl(GENERIC_IMPL, key_data, key_byte_len, data,
+                                byte_len, ref_mac));
+    GUARD(test_hmac_sha512_impl(AUTO_IMPL, key_data, key_byte_len, data,
+                                byte_len, ref_mac));
+
+    // X86-64 specific options
+    RUN_X86_64(GUARD(test_hmac_sha512_impl(AVX_IMPL, key_data, key_byte_len,
+                                           data, byte_len, ref_mac)););
+    RUN_AVX2(GUARD(test_hmac_sha512_impl(AVX2_IMPL, key_data, key_byte_len,
+                                         data, byte_len, ref_mac)););
+    RUN_AVX512(GUARD(test_hmac_sha512_impl(AVX512_IMPL, key_data, key_byte_len,
+                                           data, byte_len, ref_mac)););
+  }
+
+  // An empty key and an empty message may be passed as NULL
+  HMAC(EVP_sha512(), key_data, 0, data, 0, ref_mac, &ref_mac_len);
+  GUARD(test_hmac_sha512_impl(GENERIC_IMPL, NULL, 0, NULL, 0, ref_mac));
+  GUARD(test_hmac_sha512_impl(AUTO_IMPL, NULL, 0, NULL, 0, ref_mac));
+
+  return SUCCESS;
+}
+
+_INLINE_ int test_hmac_sha256_multi_impl(IN const sha_impl_t impl,
+                                         IN const hmac_sha256_key_t *key[],
+                                         IN const uint8_t *data[],
+                                         IN const size_t   byte_len[],
+                                         IN const uint8_t *tag[],
+                                         IN uint8_t ref[][SHA256_HASH_BYTE_LEN],
+                                         IN const uint8_t *ref_bitmap,
+                                         IN const size_t   msgs_num)
+{
+  uint8_t  tst_mac[MULTI_TEST_MAX_MSGS_NUM][SHA256_HASH_BYTE_LEN] = {0};
+  uint8_t  tst_bitmap[(MULTI_TEST_MAX_MSGS_NUM + 7) / 8]          = {0};
+  uint8_t *mac[MULTI_TEST_MAX_MSGS_NUM];
+
+  for(size_t i = 0; i < msgs_num; i++) {
+    mac[i] = tst_mac[i];
+  }
+
+  hmac_sha256_multi(mac, key, data, byte_len, msgs_num, impl);
+
+  for(size_t i = 0; i < msgs_num; i++) {
+    if(0 != memcmp(ref[i], tst_mac[i], SHA256_HASH_BYTE_LEN)) {
+      printf("Batched HMAC mismatch for impl=%d, msg=%ld/%ld and size=%ld\n",
+             impl, i, msgs_num, byte_len[i]);
+      print(ref[i], SHA256_HASH_BYTE_LEN);
+      print(tst_mac[i], SHA256_HASH_BYTE_LEN);
+      return FAILURE;
+    }
+  }
+
+  // Set all the bits to check that the function clears the failed ones
+  memset(tst_bitmap, 0xff, sizeof(tst_bitmap));
+  hmac_sha256_verify_multi(tst_bitmap, key, data, byte_len, tag, msgs_num,
+                           impl);
+
+  if(0 != memcmp(ref_bitmap, tst_bitmap, (msgs_num + 7) / 8)) {
+    printf("Batched HMAC verification mismatch for impl=%d and %ld msgs\n",
+           impl, msgs_num);
+    print(ref_bitmap, (msgs_num + 7) / 8);
+    print(tst_bitmap, (msgs_num + 7) / 8);
+    return FAILURE;
+  }
+
+  return SUCCESS;
+}
+
+_INLINE_ int test_hmac_sha256_multi()
+{
+  uint8_t ref_mac[MULTI_TEST_MAX_MSGS_NUM][SHA256_HASH_BYTE_LEN];
+  uint8_t tags[MULTI_TEST_MAX_MSGS_NUM][SHA256_HASH_BYTE_LEN];
+  uint8_t ref_bitmap[(MULTI_TEST_MAX_MSGS_NUM + 7) / 8];
+  uint8_t key_data[HMAC_MULTI_TEST_KEYS_NUM][HMAC_TEST_MAX_KEY_BYTE_LEN];
+  size_t  key_byte_len[HMAC_MULTI_TEST_KEYS_NUM];
+  size_t  byte_len[MULTI_TEST_MAX_MSGS_NUM];
+
+  const uint8_t *          data[MULTI_TEST_MAX_MSGS_NUM];
+  const uint8_t *          tag[MULTI_TEST_MAX_MSGS_NUM];
+  const hmac_sha256_key_t *key[MULTI_TEST_MAX_MSGS_NUM];
+  hmac_sha256_key_t *      keys_pool[HMAC_MULTI_TEST_KEYS_NUM] = {0};
+
+  uint8_t      buf[SHA256_TEST_MAX_MSG_BYTE_LEN] = {0};
+  unsigned int ref_mac_len                       = 0;
+  int          ret                               = SUCCESS;
+
+  // Use a deterministic seed.
+  srand(0);
+  rand_data(buf, sizeof(buf));
+  rand_data(&key_data[0][0], sizeof(key_data));
+
+  printf("Testing HMAC-SHA256 batched tests\n");
+
+  for(size_t k = 0; k < HMAC_MULTI_TEST_KEYS_NUM; k++) {
+    keys_pool[k] = hmac_sha256_key_new();
+    if(keys_pool[k] == NULL) {
+      ret = FAILURE;
+      goto cleanup;
+    }
+
+    key_byte_len[k] = rand() % HMAC_TEST_MAX_KEY_BYTE_LEN;
+    hmac_sha256_key_init(keys_pool[k], key_data[k], key_byte_len[k], AUTO_IMPL);
+  }
+
+  for(size_t t = 0; t < MULTI_TEST_CASES_NUM; t++) {
+    const size_t msgs_num = 1 + (t % MULTI_TEST_MAX_MSGS_NUM);
+
+    memset(ref_bitmap, 0, sizeof(ref_bitmap));
+
+    for(size_t i = 0; i < msgs_num; i++) {
+      const size_t k = rand() % HMAC_MULTI_TEST_KEYS_NUM;
+
+      byte_len[i] = rand() % 300;
+      data[i]     = &buf[rand() % (sizeof(buf) - byte_len[i] + 1)];
+      key[i]      = keys_pool[k];
+      HMAC(EVP_sha256(), key_data[k], (int)key_byte_len[k], data[i],
+           byte_len[i], ref_mac[i], &ref_mac_len);
+
+      // Corrupt a single bit of half of the tags
+      memcpy(tags[i], ref_mac[i], SHA256_HASH_BYTE_LEN);
+      if(rand() % 2) {
+        const size_t bit = rand() % (8 * SHA256_HASH_BYTE_LEN);
+        tags[i][bit >> 3] ^= (uint8_t)(1 << (bit & 7));
+      } else {
+        ref_bitmap[i >> 3] |= (uint8_t)(1 << (i & 7));
+      }
+      tag[i] = tags[i];
+    }
+
+    GUARD_GOTO(test_hmac_sha256_multi_impl(GENERIC_IMPL, key, data, byte_len,
+                                           tag, ref_mac, ref_bitmap, msgs_num));
+    GUARD_GOTO(test_hmac_sha256_multi_impl(AUTO_IMPL, key, data, byte_len, tag,
+                                           ref_mac, ref_bitmap, msgs_num));
+
+    // X86-64 specific options
+    RUN_AVX2(GUARD_GOTO(test_hmac_sha256_multi_impl(
+      AVX2_IMPL, key, data, byte_len, tag, ref_mac, ref_bitmap, msgs_num)););
+    RUN_AVX512(GUARD_GOTO(test_hmac_sha256_multi_impl(
+      AVX512_IMPL, key, data, byte_len, tag, ref_mac, ref_bitmap, msgs_num)););
+    RUN_X86_64_SHA_EXT(GUARD_GOTO(test_hmac_sha256_multi_impl(
+      SHA_EXT_IMPL, key, data, byte_len, tag, ref_mac, ref_bitmap, msgs_num)););
+  }
+
+cleanup:
+  for(size_t k = 0; k < HMAC_MULTI_TEST_KEYS_NUM; k++) {
+    hmac_sha256_key_free(keys_pool[k]);
+  }
+
+  return ret;
+}
+
+_INLINE_ int test_hmac_sha512_multi_impl(IN const sha_impl_t impl,
+                                         IN const hmac_sha512_key_t *key[],
+                                         IN const uint8_t *data[],
+                                         IN const size_t   byte_len[],
+                                         IN const uint8_t *tag[],
+                                         IN uint8_t ref[][SHA512_HASH_BYTE_LEN],
+                                         IN const uint8_t *ref_bitmap,
+                                         IN const size_t   msgs_num)
+{
+  uint8_t  tst_mac[MULTI_TEST_MAX_MSGS_NUM][SHA512_HASH_BYTE_LEN] = {0};
+  uint8_t  tst_bitmap[(MULTI_TEST_MAX_MSGS_NUM + 7) / 8]          = {0};
+  uint8_t *mac[MULTI_TEST_MAX_MSGS_NUM];
+
+  for(size_t i = 0; i < msgs_num; i++) {
+    mac[i] = tst_mac[i];
+  }
+
+  hmac_sha512_multi(mac, key, data, byte_len, msgs_num, impl);
+
+  for(size_t i = 0; i < msgs_num; i++) {
+    if(0 != memcmp(ref[i], tst_mac[i], SHA512_HASH_BYTE_LEN)) {
+      printf("Batched HMAC mismatch for impl=%d, msg=%ld/%ld and size=%ld\n",
+             impl, i, msgs_num, byte_len[i]);
+      print(ref[i], SHA512_HASH_BYTE_LEN);
+      print(tst_mac[i], SHA512_HASH_BYTE_LEN);
+      return FAILURE;
+    }
+  }
+
+  // Set all the bits to check that the function clears the failed ones
+  memset(tst_bitmap, 0xff, sizeof(tst_bitmap));
+  hmac_sha512_verify_multi(tst_bitmap, key, data, byte_len, tag, msgs_num,
+                           impl);
+
+  if(0 != memcmp(ref_bitmap, tst_bitmap, (msgs_num + 7) / 8)) {
+    printf("Batched HMAC verification mismatch for impl=%d and %ld msgs\n",
+           impl, msgs_num);
+    print(ref_bitmap, (msgs_num + 7) / 8);
+    print(tst_bitmap, (msgs_num + 7) / 8);
+    return FAILURE;
+  }
+
+  return SUCCESS;
+}
+
+_INLINE_ int test_hmac_sha512_multi()
+{
+  uint8_t ref_mac[MULTI_TEST_MAX_MSGS_NUM][SHA512_HASH_BYTE_LEN];
+  uint8_t tags[MULTI_TEST_MAX_MSGS_NUM][SHA512_HASH_BYTE_LEN];
+  uint8_t ref_bitmap[(MULTI_TEST_MAX_MSGS_NUM + 7) / 8];
+  uint8_t key_data[HMAC_MULTI_TEST_KEYS_NUM][HMAC_TEST_MAX_KEY_BYTE_LEN];
+  size_t  key_byte_len[HMAC_MULTI_TEST_KEYS_NUM];
+  size_t  byte_len[MULTI_TEST_MAX_MSGS_NUM];
+
+  const uint8_t *          data[MULTI_TEST_MAX_MSGS_NUM];
+  const uint8_t *          tag[MULTI_TEST_MAX_MSGS_NUM];
+  const hmac_sha512_key_t *key[MULTI_TEST_MAX_MSGS_NUM];
+  hmac_sha512_key_t *      keys_pool[HMAC_MULTI_TEST_KEYS_NUM] = {0};
+
+  uint8_t      buf[SHA512_TEST_MAX_MSG_BYTE_LEN] = {0};
+  unsigned int ref_mac_len                       = 0;
+  int          ret                               = SUCCESS;
+
+  // Use a deterministic seed.
+  srand(0);
+  rand_data(buf, sizeof(buf));
+  rand_data(&key_data[0][0], sizeof(key_data));
+
+  printf("Testing HMAC-SHA512 batched tests\n");
+
+  for(size_t k = 0; k < HMAC_MULTI_TEST_KEYS_NUM; k++) {
+    keys_pool[k] = hmac_sha512_key_new();
+    if(keys_pool[k] == NULL) {
+      ret = FAILURE;
+      goto cleanup;
+    }
+
+    key_byte_len[k] = rand() % HMAC_TEST_MAX_KEY_BYTE_LEN;
+    hmac_sha512_key_init(keys_pool[k], key_data[k], key_byte_len[k], AUTO_IMPL);
+  }
+
+  for(size_t t = 0; t < MULTI_TEST_CASES_NUM; t++) {
+    const size_t msgs_num = 1 + (t % MULTI_TEST_MAX_MSGS_NUM);
+
+    memset(ref_bitmap, 0, sizeof(ref_bitmap));
+
+    for(size_t i = 0; i < msgs_num; i++) {
+      const size_t k = rand() % HMAC_MULTI_TEST_KEYS_NUM;
+
+      byte_len[i] = rand() % 300;
+      data[i]     = &buf[rand() % (sizeof(buf) - byte_len[i] + 1)];
+      key[i]      = keys_pool[k];
+      HMAC(EVP_sha512(), key_data[k], (int)key_byte_len[k], data[i],
+           byte_len[i], ref_mac[i], &ref_mac_len);
+
+      // Corrupt a single bit of half of the tags
+      memcpy(tags[i], ref_mac[i], SHA512_HASH_BYTE_LEN);
+      if(rand() % 2) {
+        const size_t bit = rand() % (8 * SHA512_HASH_BYTE_LEN);
+        tags[i][bit >> 3] ^= (uint8_t)(1 << (bit & 7));
+      } else {
+        ref_bitmap[i >> 3] |= (uint8_t)(1 << (i & 7));
+      }
+      tag[i] = tags[i];
+    }
+
+    GUARD_GOTO(test_hmac_sha512_multi_impl(GENERIC_IMPL, key, data, byte_len,
+                                           tag, ref_mac, ref_bitmap, msgs_num));
+    GUARD_GOTO(test_hmac_sha512_multi_impl(AUTO_IMPL, key, data, byte_len, tag,
+                                           ref_mac, ref_bitmap, msgs_num));
+
+    // X86-64 specific options
+    RUN_AVX2(GUARD_GOTO(test_hmac_sha512_multi_impl(
+      AVX2_IMPL, key, data, byte_len, tag, ref_mac, ref_bitmap, msgs_num)););
+    RUN_AVX512(GUARD_GOTO(test_hmac_sha512_multi_impl(
+      AVX512_IMPL, key, data, byte_len, tag, ref_mac, ref_bitmap, msgs_num)););
+  }
+
+cleanup:
+  for(size_t k = 0; k < HMAC_MULTI_TEST_KEYS_NUM; k++) {
+    hmac_sha512_key_free(keys_pool[k]);
+  }
+
+  return ret;
+}
+
+_INLINE_ int test_pbkdf2_sha256_impl(IN const sha_impl_t impl,
+                                     IN const uint8_t *pwd[],
+                                     IN const size_t   pwd_byte_len[],
+                                     IN const uint8_t *salt[],
+                                     IN const size_t   salt_byte_len[],
+                                     IN const size_t   pwds_num,
+                                     IN const size_t   iter_num,
+                                     IN uint8_t ref_out[][PBKDF2_SHA256_MAX_OUT],
+                                     IN const size_t   out_byte_len)
+{
+  uint8_t  tst_out[PBKDF2_TEST_MAX_PWDS_NUM][PBKDF2_SHA256_MAX_OUT];
+  uint8_t *out[PBKDF2_TEST_MAX_PWDS_NUM];
+
+  for(size_t i = 0; i < pwds_num; i++) {
+    out[i] = tst_out[i];
+  }
+
+  // The single password API derives the first password
+  memset(tst_out, 0, sizeof(tst_out));
+  pbkdf2_hmac_sha256(out[0], out_byte_len, pwd[0], pwd_byte_len[0], salt[0],
+                     salt_byte_len[0], iter_num, impl);
+
+  if(0 != memcmp(ref_out[0], tst_out[0], out_byte_len)) {
+    printf("PBKDF2 mismatch for impl=%d, iter=%ld and out size=%ld\n", impl,
+           iter_num, out_byte_len);
+    print(ref_out[0], out_byte_len);
+    print(tst_out[0], out_byte_len);
+    return FAILURE;
+  }
+
+  memset(tst_out, 0, sizeof(tst_out));
+  pbkdf2_hmac_sha256_multi(out, out_byte_len, pwd, pwd_byte_len, salt,
+                           salt_byte_len, pwds_num, iter_num, impl);
+
+  for(size_t i = 0; i < pwds_num; i++) {
+    if(0 != memcmp(ref_out[i], tst_out[i], out_byte_len)) {
+      printf("Batched PBKDF2 mismatch for impl=%d, pwd=%ld/%ld, iter=%ld and "
+             "out size=%ld\n",
+             impl, i, pwds_num, iter_num, out_byte_len);
+      print(ref_out[i], out_byte_len);
+      print(tst_out[i], out_byte_len);
+      return FAILURE;
+    }
+  }
+
+  return SUCCESS;
+}
+
+_INLINE_ int test_pbkdf2_sha256()
+{
+  uint8_t ref_out[PBKDF2_TEST_MAX_PWDS_NUM][PBKDF2_SHA256_MAX_OUT];
+  uint8_t buf[SHA256_TEST_MAX_MSG_BYTE_LEN] = {0};
+  size_t  pwd_byte_len[PBKDF2_TEST_MAX_PWDS_NUM];
+  size_t  salt_byte_len[PBKDF2_TEST_MAX_PWDS_NUM];
+
+  const uint8_t *pwd[PBKDF2_TEST_MAX_PWDS_NUM];
+  const uint8_t *salt[PBKDF2_TEST_MAX_PWDS_NUM];
+
+  // Use a deterministic seed.
+  srand(0);
+  rand_data(buf, sizeof(buf));
+
+  printf("Testing PBKDF2-HMAC-SHA256 tests\n");
+
+  for(size_t t = 0; t < PBKDF2_TEST_CASES_NUM; t++) {
+    const size_t pwds_num     = 1 + (t % PBKDF2_TEST_MAX_PWDS_NUM);
+    const size_t iter_num     = 1 + (rand() % PBKDF2_TEST_MAX_ITER_NUM);
+    const size_t out_byte_len = 1 + (rand() % PBKDF2_SHA256_MAX_OUT);
+
+    for(size_t i = 0; i < pwds_num; i++) {
+      pwd_byte_len[i]  = rand() % PBKDF2_TEST_MAX_IN_BYTE_LEN;
+      salt_byte_len[i] = rand() % PBKDF2_TEST_MAX_IN_BYTE_LEN;
+      pwd[i]           = &buf[rand() % (sizeof(buf) - pwd_byte_len[i])];
+      salt[i]          = &buf[rand() % (sizeof(buf) - salt_byte_len[i])];
+
+      // Every tenth test case starts with an empty password and salt
+      if(((t % 10) == 0) && (i == 0)) {
+        pwd_byte_len[i]  = 0;
+        salt_byte_len[i] = 0;
+      }
+
+      PKCS5_PBKDF2_HMAC((const char *)pwd[i], (int)pwd_byte_len[i], salt[i],
+                        (int)salt_byte_len[i], (int)iter_num, EVP_sha256(),
+                        (int)out_byte_len, ref_out[i]);
+
+      // An empty password and salt may be passed as NULL
+      if(pwd_byte_len[i] == 0) {
+        pwd[i] = NULL;
+      }
+      if(salt_byte_len[i] == 0) {
+        salt[i] = NULL;
+      }
+    }
+
+    GUARD(test_pbkdf2_sha256_impl(GENERIC_IMPL, pwd, pwd_byte_len, salt,
+                                  salt_byte_len, pwds_num, iter_num, ref_out,
+                                  out_byte_len));
+    GUARD(test_pbkdf2_sha256_impl(AUTO_IMPL, pwd, pwd_byte_len, salt,
+                                  salt_byte_len, pwds_num, iter_num, ref_out,
+                                  out_byte_len));
+
+    // X86-64 specific options
+    RUN_AVX2(GUARD(test_pbkdf2_sha256_impl(AVX2_IMPL, pwd, pwd_byte_len, salt,
+                                           salt_byte_len, pwds_num, iter_num,
+                                           ref_out, out_byte_len)););
+    RUN_AVX512(GUARD(test_pbkdf2_sha256_impl(AVX512_IMPL, pwd, pwd_byte_len,
+                                             salt, salt_byte_len, pwds_num,
+                                             iter_num, ref_out, out_byte_len)););
+    RUN_X86_64_SHA_EXT(GUARD(test_pbkdf2_sha256_impl(
+      SHA_EXT_IMPL, pwd, pwd_byte_len, salt, salt_byte_len, pwds_num, iter_num,
+      ref_out, out_byte_len)););
+
+    // Aarch64 specific options
+    RUN_AARCH64_SHA_EXT(GUARD(test_pbkdf2_sha256_impl(
+      SHA_EXT_IMPL, pwd, pwd_byte_len, salt, salt_byte_len, pwds_num, iter_num,
+      ref_out, out_byte_len)););
+  }
+
+  return SUCCESS;
+}
+
+_INLINE_ int test_pbkdf2_sha512_impl(IN const sha_impl_t impl,
+                                     IN const uint8_t *pwd[],
+                                     IN const size_t   pwd_byte_len[],
+                                     IN const uint8_t *salt[],
+                                     IN const size_t   salt_byte_len[],
+                                     IN const size_t   pwds_num,
+                                     IN const size_t   iter_num,
+                                     IN uint8_t ref_out[][PBKDF2_SHA512_MAX_OUT],
+                                     IN const size_t   out_byte_len)
+{
+  uint8_t  tst_out[PBKDF2_TEST_MAX_PWDS_NUM][PBKDF2_SHA512_MAX_OUT];
+  uint8_t *out[PBKDF2_TEST_MAX_PWDS_NUM];
+
+  for(size_t i = 0; i < pwds_num; i++) {
+    out[i] = tst_out[i];
+  }
+
+  // The single password API derives the first password
+  memset(tst_out, 0, sizeof(tst_out));
+  pbkdf2_hmac_sha512(out[0], out_byte_len, pwd[0], pwd_byte_len[0], salt[0],
+                     salt_byte_len[0], iter_num, impl);
+
+  if(0 != memcmp(ref_out[0], tst_out[0], out_byte_len)) {
+    printf("PBKDF2 mismatch for impl=%d, iter=%ld and out size=%ld\n", impl,
+           iter_num, out_byte_len);
+    print(ref_out[0], out_byte_len);
+    print(tst_out[0], out_byte_len);
+    return FAILURE;
+  }
+
+  memset(tst_out, 0, sizeof(tst_out));
+  pbkdf2_hmac_sha512_multi(out, out_byte_len, pwd, pwd_byte_len, salt,
+                           salt_byte_len, pwds_num, iter_num, impl);
+
+  for(size_t i = 0; i < pwds_num; i++) {
+    if(0 != memcmp(ref_out[i], tst_out[i], out_byte_len)) {
+      printf("Batched PBKDF2 mismatch for impl=%d, pwd=%ld/%ld, iter=%ld and "
+             "out size=%ld\n",
+             impl, i, pwds_num, iter_num, out_byte_len);
+      print(ref_out[i], out_byte_len);
+      print(tst_out[i], out_byte_len);
+      return FAILURE;
+    }
+  }
+
+  return SUCCESS;
+}
+
+_INLINE_ int test_pbkdf2_sha512()
+{
+  uint8_t ref_out[PBKDF2_TEST_MAX_PWDS_NUM][PBKDF2_SHA512_MAX_OUT];
+  uint8_t buf[SHA512_TEST_MAX_MSG_BYTE_LEN] = {0};
+  size_t  pwd_byte_len[PBKDF2_TEST_MAX_PWDS_NUM];
+  size_t  salt_byte_len[PBKDF2_TEST_MAX_PWDS_NUM];
+
+  const uint8_t *pwd[PBKDF2_TEST_MAX_PWDS_NUM];
+  const uint8_t *salt[PBKDF2_TEST_MAX_PWDS_NUM];
+
+  // Use a deterministic seed.
+  srand(0);
+  rand_data(buf, sizeof(buf));
+
+  printf("Testing PBKDF2-HMAC-SHA512 tests\n");
+
+  for(size_t t = 0; t < PBKDF2_TEST_CASES_NUM; t++) {
+    const size_t pwds_num     = 1 + (t % PBKDF2_TEST_MAX_PWDS_NUM);
+    const size_t iter_num     = 1 + (rand() % PBKDF2_TEST_MAX_ITER_NUM);
+    const size_t out_byte_len = 1 + (rand() % PBKDF2_SHA512_MAX_OUT);
+
+    for(size_t i = 0; i < pwds_num; i++) {
+      pwd_byte_len[i]  = rand() % PBKDF2_TEST_MAX_IN_BYTE_LEN;
+      salt_byte_len[i] = rand() % PBKDF2_TEST_MAX_IN_BYTE_LEN;
+      pwd[i]           = &buf[rand() % (sizeof(buf) - pwd_byte_len[i])];
+      salt[i]          = &buf[rand() % (sizeof(buf) - salt_byte_len[i])];
+
+      // Every tenth test case starts with an empty password and salt
+      if(((t % 10) == 0) && (i == 0)) {
+        pwd_byte_len[i]  = 0;
+        salt_byte_len[i] = 0;
+      }
+
+      PKCS5_PBKDF2_HMAC((const char *)pwd[i], (int)pwd_byte_len[i], salt[i],
+                        (int)salt_byte_len[i], (int)iter_num, EVP_sha512(),
+                        (int)out_byte_len, ref_out[i]);
+
+      // An empty password and salt may be passed as NULL
+      if(pwd_byte_len[i] == 0) {
+        pwd[i] = NULL;
+      }
+      if(salt_byte_len[i] == 0) {
+        salt[i] = NULL;
+      }
+    }
+
+    GUARD(test_pbkdf2_sha512_impl(GENERIC_IMPL, pwd, pwd_byte_len, salt,
+                                  salt_byte_len, pwds_num, iter_num, ref_out,
+                                  out_byte_len));
+    GUARD(test_pbkdf2_sha512_impl(AUTO_IMPL, pwd, pwd_byte_len, salt,
+                                  salt_byte_len, pwds_num, iter_num, ref_out,
+                                  out_byte_len));
+
+    // X86-64 specific options
+    RUN_AVX2(GUARD(test_pbkdf2_sha512_impl(AVX2_IMPL, pwd, pwd_byte_len, salt,
+                                           salt_byte_len, pwds_num, iter_num,
+                                           ref_out, out_byte_len)););
+    RUN_AVX512(GUARD(test_pbkdf2_sha512_impl(AVX512_IMPL, pwd, pwd_byte_len,
+                                             salt, salt_byte_len, pwds_num,
+                                             iter_num, ref_out, out_byte_len)););
+  }
+
+  return SUCCESS;
+}
+
+// Computes the reference HKDF with OpenSSL. mode is one of the
+// EVP_PKEY_HKDEF_MODE_* modes. OpenSSL rejects a NULL salt, and an empty salt
+// is its default.
+_INLINE_ int ref_hkdf(OUT uint8_t *out,
+                      IN size_t        out_byte_len,
+                      IN const EVP_MD *md,
+                      IN const int     mode,
+                      IN const uint8_t *salt,
+                      IN const size_t   salt_byte_len,
+                      IN const uint8_t *key,
+                      IN const size_t   key_byte_len,
+                      IN const uint8_t *info,
+                      IN const size_t   info_byte_len)
+{
+  EVP_PKEY_CTX *ctx = EVP_PKEY_CTX_new_id(EVP_PKEY_HKDF, NULL);
+  int           ret = FAILURE;
+
+  if((ctx != NULL) && (EVP_PKEY_derive_init(ctx) > 0) &&
+     (EVP_PKEY_CTX_set_hkdf_mode(ctx, mode) > 0) &&
+     (EVP_PKEY_CTX_set_hkdf_md(ctx, md) > 0) &&
+     ((salt_byte_len == 0) ||
+      (EVP_PKEY_CTX_set1_hkdf_salt(ctx, salt, (int)salt_byte_len) > 0)) &&
+     (EVP_PKEY_CTX_set1_hkdf_key(ctx, key, (int)key_byte_len) > 0) &&
+     (EVP_PKEY_CTX_add1_hkdf_info(ctx, info, (int)info_byte_len) > 0) &&
+     (EVP_PKEY_derive(ctx, out, &out_byte_len) > 0)) {
+    ret = SUCCESS;
+  }
+
+  EVP_PKEY_CTX_free(ctx);
+  return ret;
+}
+
+_INLINE_ int test_hkdf_sha256_impl(IN const sha_impl_t impl,
+                                   IN const uint8_t *buf,
+                                   IN const size_t   buf_byte_len)
+{
+  uint8_t ref_okm[HKDF_TEST_MAX_OUTPUTS_NUM][HKDF_TEST_MAX_OKM_BYTE_LEN];
+  uint8_t tst_okm[HKDF_TEST_MAX_OUTPUTS_NUM][HKDF_TEST_MAX_OKM_BYTE_LEN];
+  uint8_t ref_prk[SHA256_HASH_BYTE_LEN];
+  uint8_t tst_prk[SHA256_HASH_BYTE_LEN];
+  size_t  okm_byte_len[HKDF_TEST_MAX_OUTPUTS_NUM];
+  size_t  info_byte_len[HKDF_TEST_MAX_OUTPUTS_NUM];
+
+  const uint8_t *info[HKDF_TEST_MAX_OUTPUTS_NUM];
+  uint8_t *      okm[HKDF_TEST_MAX_OUTPUTS_NUM];
+
+  hmac_sha256_key_t *prk_key = hmac_sha256_key_new();
+  int                ret     = SUCCESS;
+
+  if(prk_key == NULL) {
+    return FAILURE;
+  }
+
+  for(size_t t = 0; t < HKDF_TEST_CASES_NUM; t++) {
+    const size_t outputs_num   = 1 + (t % HKDF_TEST_MAX_OUTPUTS_NUM);
+    const size_t salt_byte_len = rand() % 200;
+    const size_t ikm_byte_len  = rand() % 200;
+
+    const uint8_t *salt = &buf[rand() % (buf_byte_len - salt_byte_len)];
+    const uint8_t *ikm  = &buf[rand() % (buf_byte_len - ikm_byte_len)];
+
+    for(size_t i = 0; i < outputs_num; i++) {
+      // Some of the info strings are too long for the lanes
+      okm_byte_len[i]  = 1 + (rand() % HKDF_TEST_MAX_OKM_BYTE_LEN);
+      info_byte_len[i] = rand() % ((rand() % 8) ? 100 : 400);
+      info[i]          = &buf[rand() % (buf_byte_len - info_byte_len[i])];
+      okm[i]           = tst_okm[i];
+    }
+
+    memset(tst_okm, 0, sizeof(tst_okm));
+    GUARD_GOTO(ref_hkdf(ref_prk, sizeof(ref_prk), EVP_sha256(),
+                        EVP_PKEY_HKDEF_MODE_EXTRACT_ONLY, salt, salt_byte_len,
+                        ikm, ikm_byte_len, NULL, 0));
+    GUARD_GOTO(ref_hkdf(ref_okm[0], okm_byte_len[0], EVP_sha256(),
+                        EVP_PKEY_HKDEF_MODE_EXTRACT_AND_EXPAND, salt,
+                        salt_byte_len, ikm, ikm_byte_len, info[0],
+                        info_byte_len[0]));
+
+    hkdf_sha256_extract(tst_prk, salt, salt_byte_len, ikm, ikm_byte_len, impl);
+    GUARD_GOTO(hkdf_sha256(tst_okm[0], okm_byte_len[0], salt, salt_byte_len,
+                           ikm, ikm_byte_len, info[0], info_byte_len[0], impl));
+
+    if((0 != memcmp(ref_prk, tst_prk, sizeof(ref_prk))) ||
+       (0 != memcmp(ref_okm[0], tst_okm[0], okm_byte_len[0]))) {
+      printf("HKDF mismatch for impl=%d, salt size=%ld and ikm size=%ld\n",
+             impl, salt_byte_len, ikm_byte_len);
+      print(ref_okm[0], (int)okm_byte_len[0]);
+      print(tst_okm[0], (int)okm_byte_len[0]);
+      ret = FAILURE;
+      goto cleanup;
+    }
+
+    // Expand several outputs from the same PRK
+    for(size_t i = 0; i < outputs_num; i++) {
+      GUARD_GOTO(ref_hkdf(ref_okm[i], okm_byte_len[i], EVP_sha256(),
+                          EVP_PKEY_HKDEF_MODE_EXPAND_ONLY, NULL, 0, ref_prk,
+                          sizeof(ref_prk), info[i], info_byte_len[i]));
+    }
+
+    hmac_sha256_key_init(prk_key, tst_prk, sizeof(tst_prk), impl);
+    memset(tst_okm, 0, sizeof(tst_okm));
+    GUARD_GOTO(hkdf_sha256_expand(tst_okm[0], okm_byte_len[0], prk_key,
+                                  info[0], info_byte_len[0]));
+    GUARD_GOTO(hkdf_sha256_expand_multi(&okm[1], &okm_byte_len[1], prk_key,
+                                        &info[1], &info_byte_len[1],
+                                        outputs_num - 1, impl));
+
+    for(size_t i = 0; i < outputs_num; i++) {
+      if(0 != memcmp(ref_okm[i], tst_okm[i], okm_byte_len[i])) {
+        printf("HKDF expand mismatch for impl=%d, output=%ld/%ld, info "
+               "size=%ld and size=%ld\n",
+               impl, i, outputs_num, info_byte_len[i], okm_byte_len[i]);
+        print(ref_okm[i], (int)okm_byte_len[i]);
+        print(tst_okm[i], (int)okm_byte_len[i]);
+        ret = FAILURE;
+        goto cleanup;
+      }
+    }
+  }
+
+cleanup:
+  hmac_sha256_key_free(prk_key);
+  return ret;
+}
+
+// An empty salt and an empty info may be passed as NULL
+_INLINE_ int test_hkdf_sha256_null_impl(IN const sha_impl_t impl,
+                                        IN const uint8_t *ikm,
+                                        IN const size_t   ikm_byte_len)
+{
+  uint8_t ref_okm[HKDF_TEST_MAX_OKM_BYTE_LEN];
+  uint8_t tst_okm[3][HKDF_TEST_MAX_OKM_BYTE_LEN];
+  uint8_t ref_prk[SHA256_HASH_BYTE_LEN];
+  uint8_t tst_prk[SHA256_HASH_BYTE_LEN];
+
+  uint8_t *      okm[2]           = {tst_okm[1], tst_okm[2]};
+  const size_t   okm_byte_len[2]  = {sizeof(ref_okm), sizeof(ref_okm)};
+  const uint8_t *info[2]          = {NULL, NULL};
+  const size_t   info_byte_len[2] = {0, 0};
+
+  hmac_sha256_key_t *prk_key = hmac_sha256_key_new();
+  int                ret     = SUCCESS;
+
+  if(prk_key == NULL) {
+    return FAILURE;
+  }
+
+  GUARD_GOTO(ref_hkdf(ref_prk, sizeof(ref_prk), EVP_sha256(),
+                      EVP_PKEY_HKDEF_MODE_EXTRACT_ONLY, NULL, 0, ikm,
+                      ikm_byte_len, NULL, 0));
+  GUARD_GOTO(ref_hkdf(ref_okm, sizeof(ref_okm), EVP_sha256(),
+                      EVP_PKEY_HKDEF_MODE_EXTRACT_AND_EXPAND, NULL, 0, ikm,
+                      ikm_byte_len, NULL, 0));
+
+  memset(tst_okm, 0, sizeof(tst_okm));
+  hkdf_sha256_extract(tst_prk, NULL, 0, ikm, ikm_byte_len, impl);
+  GUARD_GOTO(hkdf_sha256(tst_okm[0], sizeof(ref_okm), NULL, 0, ikm,
+                         ikm_byte_len, NULL, 0, impl));
+  hmac_sha256_key_init(prk_key, tst_prk, sizeof(tst_prk), impl);
+  GUARD_GOTO(hkdf_sha256_expand_multi(okm, okm_byte_len, prk_key, info,
+                                      info_byte_len, 2, impl));
+
+  if((0 != memcmp(ref_prk, tst_prk, sizeof(ref_prk))) ||
+     (0 != memcmp(ref_okm, tst_okm[0], sizeof(ref_okm))) ||
+     (0 != memcmp(ref_okm, tst_okm[1], sizeof(ref_okm))) ||
+     (0 != memcmp(ref_okm, tst_okm[2], sizeof(ref_okm)))) {
+    printf("HKDF mismatch for impl=%d with a NULL salt and info\n", impl);
+    ret = FAILURE;
+  }
+
+cleanup:
+  hmac_sha256_key_free(prk_key);
+  return ret;
+}
+
+// The output is at most 255 blocks long. A longer output fails with EINVAL.
+_INLINE_ int test_hkdf_sha256_max_len_impl(IN const sha_impl_t impl,
+                                           IN const uint8_t *ikm,
+                                           IN const size_t   ikm_byte_len)
+{
+  uint8_t ref_okm[255 * SHA256_HASH_BYTE_LEN];
+  uint8_t tst_okm[255 * SHA256_HASH_BYTE_LEN] = {0};
+  uint8_t prk[SHA256_HASH_BYTE_LEN];
+
+  uint8_t *      okm[2]           = {tst_okm, tst_okm};
+  const size_t   okm_byte_len[2]  = {1, sizeof(tst_okm) + 1};
+  const uint8_t *info[2]          = {ikm, ikm};
+  const size_t   info_byte_len[2] = {1, 1};
+
+  hmac_sha256_key_t *prk_key = hmac_sha256_key_new();
+  int                ret     = SUCCESS;
+
+  if(prk_key == NULL) {
+    return FAILURE;
+  }
+
+  GUARD_GOTO(ref_hkdf(ref_okm, sizeof(ref_okm), EVP_sha256(),
+                      EVP_PKEY_HKDEF_MODE_EXTRACT_AND_EXPAND, NULL, 0, ikm,
+                      ikm_byte_len, NULL, 0));
+  GUARD_GOTO(hkdf_sha256(tst_okm, sizeof(tst_okm), NULL, 0, ikm, ikm_byte_len,
+                         NULL, 0, impl));
+
+  if(0 != memcmp(ref_okm, tst_okm, sizeof(ref_okm))) {
+    printf("HKDF mismatch for impl=%d with the longest output\n", impl);
+    GUARD_GOTO(FAILURE);
+  }
+
+  hkdf_sha256_extract(prk, NULL, 0, ikm, ikm_byte_len, impl);
+  hmac_sha256_key_init(prk_key, prk, sizeof(prk), impl);
+
+  // Every call fails, also when the output that is too long is not the first
+  errno = 0;
+  if((-1 != hkdf_sha256(tst_okm, sizeof(tst_okm) + 1, NULL, 0, ikm,
+                        ikm_byte_len, NULL, 0, impl)) ||
+     (errno != EINVAL)) {
+    printf("HKDF did not fail with a too long output for impl=%d\n", impl);
+    GUARD_GOTO(FAILURE);
+  }
+
+  errno = 0;
+  if((-1 != hkdf_sha256_expand(tst_okm, sizeof(tst_okm) + 1, prk_key, NULL,
+                               0)) ||
+     (errno != EINVAL)) {
+    printf("HKDF expand did not fail with a too long output for impl=%d\n",
+           impl);
+    GUARD_GOTO(FAILURE);
+  }
+
+  errno = 0;
+  if((-1 != hkdf_sha256_expand_multi(okm, okm_byte_len, prk_key, info,
+                                     info_byte_len, 2, impl)) ||
+     (errno != EINVAL)) {
+    printf("HKDF expand_multi did not fail with a too long output for "
+           "impl=%d\n",
+           impl);
+    ret = FAILURE;
+  }
+
+cleanup:
+  hmac_sha256_key_free(prk_key);
+  return ret;
+}
+
+_INLINE_ int test_hkdf_sha256()
+{
+  uint8_t buf[SHA256_TEST_MAX_MSG_BYTE_LEN] = {0};
+
+  // Use a deterministic seed.
+  srand(0);
+  rand_data(buf, sizeof(buf));
+
+  printf("Testing HKDF-SHA256 tests\n");
+
+  GUARD(test_hkdf_sha256_impl(GENERIC_IMPL, buf, sizeof(buf)));
+  GUARD(test_hkdf_sha256_impl(AUTO_IMPL, buf, sizeof(buf)));
+  GUARD(test_hkdf_sha256_null_impl(GENERIC_IMPL, buf, 100));
+  GUARD(test_hkdf_sha256_null_impl(AUTO_IMPL, buf, 100));
+  GUARD(test_hkdf_sha256_max_len_impl(GENERIC_IMPL, buf, 100));
+  GUARD(test_hkdf_sha256_max_len_impl(AUTO_IMPL, buf, 100));
+
+  // X86-64 specific options
+  RUN_X86_64(GUARD(test_hkdf_sha256_impl(AVX_IMPL, buf, sizeof(buf))););
+  RUN_AVX2(GUARD(test_hkdf_sha256_impl(AVX2_IMPL, buf, sizeof(buf))););
+  RUN_AVX512(GUARD(test_hkdf_sha256_impl(AVX512_IMPL, buf, sizeof(buf))););
+  RUN_X86_64_SHA_EXT(
+    GUARD(test_hkdf_sha256_impl(SHA_EXT_IMPL, buf, sizeof(buf))););
+
+  // Aarch64 specific options
+  RUN_AARCH64_SHA_EXT(
+    GUARD(test_hkdf_sha256_impl(SHA_EXT_IMPL, buf, sizeof(buf))););
+
+  return SUCCESS;
+}
+
+_INLINE_ int test_hkdf_sha512_impl(IN const sha_impl_t impl,
+                                   IN const uint8_t *buf,
+                                   IN const size_t   buf_byte_len)
+{
+  uint8_t ref_okm[HKDF_TEST_MAX_OUTPUTS_NUM][HKDF_TEST_MAX_OKM_BYTE_LEN];
+  uint8_t tst_okm[HKDF_TEST_MAX_OUTPUTS_NUM][HKDF_TEST_MAX_OKM_BYTE_LEN];
+  uint8_t ref_prk[SHA512_HASH_BYTE_LEN];
+  uint8_t tst_prk[SHA512_HASH_BYTE_LEN];
+  size_t  okm_byte_len[HKDF_TEST_MAX_OUTPUTS_NUM];
+  size_t  info_byte_len[HKDF_TEST_MAX_OUTPUTS_NUM];
+
+  const uint8_t *info[HKDF_TEST_MAX_OUTPUTS_NUM];
+  uint8_t *      okm[HKDF_TEST_MAX_OUTPUTS_NUM];
+
+  hmac_sha512_key_t *prk_key = hmac_sha512_key_new();
+  int                ret     = SUCCESS;
+
+  if(prk_key == NULL) {
+    return FAILURE;
+  }
+
+  for(size_t t = 0; t < HKDF_TEST_CASES_NUM; t++) {
+    const size_t outputs_num   = 1 + (t % HKDF_TEST_MAX_OUTPUTS_NUM);
+    const size_t salt_byte_len = rand() % 200;
+    const size_t ikm_byte_len  = rand() % 200;
+
+    const uint8_t *salt = &buf[rand() % (buf_byte_len - salt_byte_len)];
+    const uint8_t *ikm  = &buf[rand() % (buf_byte_len - ikm_byte_len)];
+
+    for(size_t i = 0; i < outputs_num; i++) {
+      // Some of the info strings are too long for the lanes
+      okm_byte_len[i]  = 1 + (rand() % HKDF_TEST_MAX_OKM_BYTE_LEN);
+      info_byte_len[i] = rand() % ((rand() % 8) ? 100 : 400);
+      info[i]          = &buf[rand() % (buf_byte_len - info_byte_len[i])];
+      okm[i]           = tst_okm[i];
+    }
+
+    memset(tst_okm, 0, sizeof(tst_okm));
+    GUARD_GOTO(ref_hkdf(ref_prk, sizeof(ref_prk), EVP_sha512(),
+                        EVP_PKEY_HKDEF_MODE_EXTRACT_ONLY, salt, salt_byte_len,
+                        ikm, ikm_byte_len, NULL, 0));
+    GUARD_GOTO(ref_hkdf(ref_okm[0], okm_byte_len[0], EVP_sha512(),
+                        EVP_PKEY_HKDEF_MODE_EXTRACT_AND_EXPAND, salt,
+                        salt_byte_len, ikm, ikm_byte_len, info[0],
+                        info_byte_len[0]));
+
+    hkdf_sha512_extract(tst_prk, salt, salt_byte_len, ikm, ikm_byte_len, impl);
+    GUARD_GOTO(hkdf_sha512(tst_okm[0], okm_byte_len[0], salt, salt_byte_len,
+                           ikm, ikm_byte_len, info[0], info_byte_len[0], impl));
+
+    if((0 != memcmp(ref_prk, tst_prk, sizeof(ref_prk))) ||
+       (0 != memcmp(ref_okm[0], tst_okm[0], okm_byte_len[0]))) {
+      printf("HKDF mismatch for impl=%d, salt size=%ld and ikm size=%ld\n",
+             impl, salt_byte_len, ikm_byte_len);
+      print(ref_okm[0], (int)okm_byte_len[0]);
+      print(tst_okm[0], (int)okm_byte_len[0]);
+      ret = FAILURE;
+      goto cleanup;
+    }
+
+    // Expand several outputs from the same PRK
+    for(size_t i = 0; i < outputs_num; i++) {
+      GUARD_GOTO(ref_hkdf(ref_okm[i], okm_byte_len[i], EVP_sha512(),
+                          EVP_PKEY_HKDEF_MODE_EXPAND_ONLY, NULL, 0, ref_prk,
+                          sizeof(ref_prk), info[i], info_byte_len[i]));
+    }
+
+    hmac_sha512_key_init(prk_key, tst_prk, sizeof(tst_prk), impl);
+    memset(tst_okm, 0, sizeof(tst_okm));
+    GUARD_GOTO(hkdf_sha512_expand(tst_okm[0], okm_byte_len[0], prk_key,
+                                  info[0], info_byte_len[0]));
+    GUARD_GOTO(hkdf_sha512_expand_multi(&okm[1], &okm_byte_len[1], prk_key,
+                                        &info[1], &info_byte_len[1],
+                                        outputs_num - 1, impl));
+
+    for(size_t i = 0; i < outputs_num; i++) {
+      if(0 != memcmp(ref_okm[i], tst_okm[i], okm_byte_len[i])) {
+        printf("HKDF expand mismatch for impl=%d, output=%ld/%ld, info "
+               "size=%ld and size=%ld\n",
+               impl, i, outputs_num, info_byte_len[i], okm_byte_len[i]);
+        print(ref_okm[i], (int)okm_byte_len[i]);
+        print(tst_okm[i], (int)okm_byte_len[i]);
+        ret = FAILURE;
+        goto cleanup;
+      }
+    }
+  }
+
+cleanup:
+  hmac_sha512_key_free(prk_key);
+  return ret;
+}
+
+// An empty salt and an empty info may be passed as NULL
+_INLINE_ int test_hkdf_sha512_null_impl(IN const sha_impl_t impl,
+                                        IN const uint8_t *ikm,
+                                        IN const size_t   ikm_byte_len)
+{
+  uint8_t ref_okm[HKDF_TEST_MAX_OKM_BYTE_LEN];
+  uint8_t tst_okm[3][HKDF_TEST_MAX_OKM_BYTE_LEN];
+  uint8_t ref_prk[SHA512_HASH_BYTE_LEN];
+  uint8_t tst_prk[SHA512_HASH_BYTE_LEN];
+
+  uint8_t *      okm[2]           = {tst_okm[1], tst_okm[2]};
+  const size_t   okm_byte_len[2]  = {sizeof(ref_okm), sizeof(ref_okm)};
+  const uint8_t *info[2]          = {NULL, NULL};
+  const size_t   info_byte_len[2] = {0, 0};
+
+  hmac_sha512_key_t *prk_key = hmac_sha512_key_new();
+  int                ret     = SUCCESS;
+
+  if(prk_key == NULL) {
+    return FAILURE;
+  }
+
+  GUARD_GOTO(ref_hkdf(ref_prk, sizeof(ref_prk), EVP_sha512(),
+                      EVP_PKEY_HKDEF_MODE_EXTRACT_ONLY, NULL, 0, ikm,
+                      ikm_byte_len, NULL, 0));
+  GUARD_GOTO(ref_hkdf(ref_okm, sizeof(ref_okm), EVP_sha512(),
+                      EVP_PKEY_HKDEF_MODE_EXTRACT_AND_EXPAND, NULL, 0, ikm,
+                      ikm_byte_len, NULL, 0));
+
+  memset(tst_okm, 0, sizeof(tst_okm));
+  hkdf_sha512_extract(tst_prk, NULL, 0, ikm, ikm_byte_len, impl);
+  GUARD_GOTO(hkdf_sha512(tst_okm[0], sizeof(ref_okm), NULL, 0, ikm,
+                         ikm_byte_len, NULL, 0, impl));
+  hmac_sha512_key_init(prk_key, tst_prk, sizeof(tst_prk), impl);
+  GUARD_GOTO(hkdf_sha512_expand_multi(okm, okm_byte_len, prk_key, info,
+                                      info_byte_len, 2, impl));
+
+  if((0 != memcmp(ref_prk, tst_prk, sizeof(ref_prk))) ||
+     (0 != memcmp(ref_okm, tst_okm[0], sizeof(ref_okm))) ||
+     (0 != memcmp(ref_okm, tst_okm[1], sizeof(ref_okm))) ||
+     (0 != memcmp(ref_okm, tst_okm[2], sizeof(ref_okm)))) {
+    printf("HKDF mismatch for impl=%d with a NULL salt and info\n", impl);
+    ret = FAILURE;
+  }
+
+cleanup:
+  hmac_sha512_key_free(prk_key);
+  return ret;
+}
+
+// The output is at most 255 blocks long. A longer output fails with EINVAL.
+_INLINE_ int test_hkdf_sha512_max_len_impl(IN const sha_impl_t impl,
+                                           IN const uint8_t *ikm,
+                                           IN const size_t   ikm_byte_len)
+{
+  uint8_t ref_okm[255 * SHA512_HASH_BYTE_LEN];
+  uint8_t tst_okm[255 * SHA512_HASH_BYTE_LEN] = {0};
+  uint8_t prk[SHA512_HASH_BYTE_LEN];
+
+  uint8_t *      okm[2]           = {tst_okm, tst_okm};
+  const size_t   okm_byte_len[2]  = {1, sizeof(tst_okm) + 1};
+  const uint8_t *info[2]          = {ikm, ikm};
+  const size_t   info_byte_len[2] = {1, 1};
+
+  hmac_sha512_key_t *prk_key = hmac_sha512_key_new();
+  int                ret     = SUCCESS;
+
+  if(prk_key == NULL) {
+    return FAILURE;
+  }
+
+  GUARD_GOTO(ref_hkdf(ref_okm, sizeof(ref_okm), EVP_sha512(),
+                      EVP_PKEY_HKDEF_MODE_EXTRACT_AND_EXPAND, NULL, 0, ikm,
+                      ikm_byte_len, NULL, 0));
+  GUARD_GOTO(hkdf_sha512(tst_okm, sizeof(tst_okm), NULL, 0, ikm, ikm_byte_len,
+                         NULL, 0, impl));
+
+  if(0 != memcmp(ref_okm, tst_okm, sizeof(ref_okm))) {
+    printf("HKDF mismatch for impl=%d with the longest output\n", impl);
+    GUARD_GOTO(FAILURE);
+  }
+
+  hkdf_sha512_extract(prk, NULL, 0, ikm, ikm_byte_len, impl);
+  hmac_sha512_key_init(prk_key, prk, sizeof(prk), impl);
+
+  // Every call fails, also when the output that is too long is not the first
+  errno = 0;
+  if((-1 != hkdf_sha512(tst_okm, sizeof(tst_okm) + 1, NULL, 0, ikm,
+                        ikm_byte_len, NULL, 0, impl)) ||
+     (errno != EINVAL)) {
+    printf("HKDF did not fail with a too long output for impl=%d\n", impl);
+    GUARD_GOTO(FAILURE);
+  }
+
+  errno = 0;
+  if((-1 != hkdf_sha512_expand(tst_okm, sizeof(tst_okm) + 1, prk_key, NULL,
+                               0)) ||
+     (errno != EINVAL)) {
+    printf("HKDF expand did not fail with a too long output for impl=%d\n",
+           impl);
+    GUARD_GOTO(FAILURE);
+  }
+
+  errno = 0;
+  if((-1 != hkdf_sha512_expand_multi(okm, okm_byte_len, prk_key, info,
+                                     info_byte_len, 2, impl)) ||
+     (errno != EINVAL)) {
+    printf("HKDF expand_multi did not fail with a too long output for "
+           "impl=%d\n",
+           impl);
+    ret = FAILURE;
+  }
+
+cleanup:
+  hmac_sha512_key_free(prk_key);
+  return ret;
+}
+
+_INLINE_ int test_hkdf_sha512()
+{
+  uint8_t buf[SHA512_TEST_MAX_MSG_BYTE_LEN] = {0};
+
+  // Use a deterministic seed.
+  srand(0);
+  rand_data(buf, sizeof(buf));
+
+  printf("Testing HKDF-SHA512 tests\n");
+
+  GUARD(test_hkdf_sha512_impl(GENERIC_IMPL, buf, sizeof(buf)));
+  GUARD(test_hkdf_sha512_impl(AUTO_IMPL, buf, sizeof(buf)));
+  GUARD(test_hkdf_sha512_null_impl(GENERIC_IMPL, buf, 100));
+  GUARD(test_hkdf_sha512_null_impl(AUTO_IMPL, buf, 100));
+  GUARD(test_hkdf_sha512_max_len_impl(GENERIC_IMPL, buf, 100));
+  GUARD(test_hkdf_sha512_max_len_impl(AUTO_IMPL, buf, 100));
+
+  // X86-64 specific options
+  RUN_X86_64(GUARD(test_hkdf_sha512_impl(AVX_IMPL, buf, sizeof(buf))););
+  RUN_AVX2(GUARD(test_hkdf_sha512_impl(AVX2_IMPL, buf, sizeof(buf))););
+  RUN_AVX512(GUARD(test_hkdf_sha512_impl(AVX512_IMPL, buf, sizeof(buf))););
+
+  return SUCCESS;
+}
+
+typedef void (*merkle_tree_t)(uint8_t *      nodes,
+                              const uint8_t *leaf[],
+                              const size_t   leaf_byte_len[],
+                              size_t         leaves_num,
+                              merkle_mode_t  mode,
+                              sha_impl_t     impl);
+
+// Hashes prefix || a || b, where the prefix is omitted in the plain mode
+_INLINE_ int ref_merkle_hash(OUT uint8_t *dgst,
+                             IN const EVP_MD *     md,
+                             IN const merkle_mode_t mode,
+                             IN const uint8_t      prefix,
+                             IN const uint8_t *    a,
+                             IN const size_t       a_byte_len,
+                             IN const uint8_t *    b,
+                             IN const size_t       b_byte_len)
+{
+  EVP_MD_CTX *ctx = EVP_MD_CTX_new();
+  int         ret = FAILURE;
+
+  if((ctx != NULL) && (EVP_DigestInit_ex(ctx, md, NULL) > 0) &&
+     ((mode == MERKLE_PLAIN_MODE) || (EVP_DigestUpdate(ctx, &prefix, 1) > 0)) &&
+     (EVP_DigestUpdate(ctx, a, a_byte_len) > 0) &&
+     (EVP_DigestUpdate(ctx, b, b_byte_len) > 0) &&
+     (EVP_DigestFinal_ex(ctx, dgst, NULL) > 0)) {
+    ret = SUCCESS;
+  }
+
+  EVP_MD_CTX_free(ctx);
+  return ret;
+}
+
+// The recursive definition of the root in RFC 6962: the left subtree holds the
+// largest power of two of the leaves that is smaller than leaves_num
+_INLINE_ int ref_merkle_root(OUT uint8_t *root,
+                             IN const EVP_MD *     md,
+                             IN const merkle_mode_t mode,
+                             IN const uint8_t *    leaf[],
+                             IN const size_t       leaf_byte_len[],
+                             IN const size_t       leaves_num)
+{
+  uint8_t left[SHA512_HASH_BYTE_LEN];
+  uint8_t right[SHA512_HASH_BYTE_LEN];
+  size_t  k = 1;
+
+  if(leaves_num == 1) {
+    return ref_merkle_hash(root, md, mode, 0x00, leaf[0], leaf_byte_len[0],
+                           NULL, 0);
+  }
+
+  while((2 * k) < leaves_num) {
+    k *= 2;
+  }
+
+  const size_t dgst_byte_len = (size_t)EVP_MD_size(md);
+
+  GUARD(ref_merkle_root(left, md, mode, leaf, leaf_byte_len, k));
+  GUARD(ref_merkle_root(right, md, mode, &leaf[k], &leaf_byte_len[k],
+                        leaves_num - k));
+
+  return ref_merkle_hash(root, md, mode, 0x01, left, dgst_byte_len, right,
+                         dgst_byte_len);
+}
+
+_INLINE_ int test_merkle_impl(IN const sha_impl_t impl,
+                              IN const merkle_tree_t tree,
+                              IN const EVP_MD *      md,
+                              IN const uint8_t *     buf,
+                              IN const size_t        buf_byte_len)
+{
+  static uint8_t ref_nodes[MERKLE_TEST_MAX_NODES_NUM][SHA512_HASH_BYTE_LEN];
+  static uint8_t tst_nodes[MERKLE_TEST_MAX_NODES_NUM][SHA512_HASH_BYTE_LEN];
+  uint8_t        ref_root[SHA512_HASH_BYTE_LEN];
+  const uint8_t *leaf[MERKLE_TEST_MAX_LEAVES_NUM];
+  size_t         leaf_byte_len[MERKLE_TEST_MAX_LEAVES_NUM];
+
+  const size_t dgst_byte_len = (size_t)EVP_MD_size(md);
+
+  for(size_t t = 0; t < MERKLE_TEST_CASES_NUM; t++) {
+    const size_t        leaves_num = t % (MERKLE_TEST_MAX_LEAVES_NUM + 1);
+    const merkle_mode_t mode = (t & 1) ? MERKLE_RFC6962_MODE : MERKLE_PLAIN_MODE;
+    const size_t        nodes_num = merkle_nodes_num(leaves_num);
+
+    // Short leaves around the block sizes, and a few long leaves
+    for(size_t i = 0; i < leaves_num; i++) {
+      const size_t max_len = (rand() % 8) ? 300 : buf_byte_len;
+
+      leaf_byte_len[i] = rand() % max_len;
+      leaf[i]          = &buf[rand() % (buf_byte_len - leaf_byte_len[i] + 1)];
+    }
+
+    if(leaves_num == 0) {
+      GUARD(ref_merkle_hash(ref_root, md, MERKLE_PLAIN_MODE, 0, NULL, 0, NULL,
+                            0));
+    } else {
+      GUARD(ref_merkle_root(ref_root, md, mode, leaf, leaf_byte_len,
+                            leaves_num));
+    }
+
+    // The nodes of every implementation must match the generic implementation
+    tree((uint8_t *)ref_nodes, leaf, leaf_byte_len, leaves_num, mode,
+         GENERIC_IMPL);
+    tree((uint8_t *)tst_nodes, leaf, leaf_byte_len, leaves_num, mode, impl);
+
+    const uint8_t *tst_root =
+      &((const uint8_t *)tst_nodes)[(nodes_num - 1) * dgst_byte_len];
+
+    if((0 != memcmp(ref_root, tst_root, dgst_byte_len)) ||
+       (0 != memcmp(ref_nodes, tst_nodes, nodes_num * dgst_byte_len))) {
+      printf("Merkle tree mismatch for impl=%d, mode=%d and leaves=%ld\n",
+             impl, mode, leaves_num);
+      print(ref_root, dgst_byte_len);
+      print(tst_root, dgst_byte_len);
+      return FAILURE;
+    }
+  }
+
+  return SUCCESS;
+}
+
+_INLINE_ int test_merkle_sha256()
+{
+  uint8_t buf[SHA256_TEST_MAX_MSG_BYTE_LEN] = {0};
+
+  // Use a deterministic seed.
+  srand(0);
+  rand_data(buf, sizeof(buf));
+
+  printf("Testing Merkle tree SHA256 tests\n");
+
+  GUARD(test_merkle_impl(GENERIC_IMPL, merkle_sha256_tree, EVP_sha256(), buf,
+                         sizeof(buf)));
+  GUARD(test_merkle_impl(AUTO_IMPL, merkle_sha256_tree, EVP_sha256(), buf,
+                         sizeof(buf)));
+
+  // X86-64 specific options
+  RUN_X86_64(GUARD(test_merkle_impl(AVX_IMPL, merkle_sha256_tree, EVP_sha256(),
+                                    buf, sizeof(buf))););
+  RUN_AVX2(GUARD(test_merkle_impl(AVX2_IMPL, merkle_sha256_tree, EVP_sha256(),
+                                  buf, sizeof(buf))););
+  RUN_AVX512(GUARD(test_merkle_impl(AVX512_IMPL, merkle_sha256_tree,
+                                    EVP_sha256(), buf, sizeof(buf))););
+  RUN_X86_64_SHA_EXT(GUARD(test_merkle_impl(
+    SHA_EXT_IMPL, merkle_sha256_tree, EVP_sha256(), buf, sizeof(buf))););
+
+  // Aarch64 specific options
+  RUN_AARCH64_SHA_EXT(GUARD(test_merkle_impl(
+    SHA_EXT_IMPL, merkle_sha256_tree, EVP_sha256(), buf, sizeof(buf))););
+
+  return SUCCESS;
+}
+
+_INLINE_ int test_merkle_sha512()
+{
+  uint8_t buf[SHA512_TEST_MAX_MSG_BYTE_LEN] = {0};
+
+  // Use a deterministic seed.
+  srand(0);
+  rand_data(buf, sizeof(buf));
+
+  printf("Testing Merkle tree SHA512 tests\n");
+
+  GUARD(test_merkle_impl(GENERIC_IMPL, merkle_sha512_tree, EVP_sha512(), buf,
+                         sizeof(buf)));
+  GUARD(test_merkle_impl(AUTO_IMPL, merkle_sha512_tree, EVP_sha512(), buf,
+                         sizeof(buf)));
+
+  // X86-64 specific options
+  RUN_X86_64(GUARD(test_merkle_impl(AVX_IMPL, merkle_sha512_tree, EVP_sha512(),
+                                    buf, sizeof(buf))););
+  RUN_AVX2(GUARD(test_merkle_impl(AVX2_IMPL, merkle_sha512_tree, EVP_sha512(),
+                                  buf, sizeof(buf))););
+  RUN_AVX512(GUARD(test_merkle_impl(AVX512_IMPL, merkle_sha512_tree,
+                                    EVP_sha512(), buf, sizeof(buf))););
+
+  return SUCCESS;
+}
+
+typedef void (*fixed_hash_t)(uint8_t *dgst, const uint8_t *data, sha_impl_t impl);
+
+typedef void (*fixed_multi_t)(uint8_t *      dgst,
+                              const uint8_t *data,
+                              size_t         msgs_num,
+                              sha_impl_t     impl);
+
+_INLINE_ int test_fixed_impl(IN const sha_impl_t impl,
+                             IN const fixed_hash_t  hash,
+                             IN const fixed_multi_t multi,
+                             IN const EVP_MD *      md,
+                             IN const size_t        msg_byte_len,
+                             IN const uint8_t *     buf,
+                             IN const size_t        buf_byte_len)
+{
+  static uint8_t ref_dgst[MULTI_TEST_MAX_MSGS_NUM][SHA512_HASH_BYTE_LEN];
+  static uint8_t tst_multi[MULTI_TEST_MAX_MSGS_NUM * SHA512_HASH_BYTE_LEN];
+  uint8_t        tst_dgst[SHA512_HASH_BYTE_LEN];
+
+  const size_t dgst_byte_len  = (size_t)EVP_MD_size(md);
+  const size_t max_msgs_bytes = MULTI_TEST_MAX_MSGS_NUM * msg_byte_len;
+
+  for(size_t t = 0; t < FIXED_TEST_CASES_NUM; t++) {
+    const size_t   msgs_num = 1 + (t % MULTI_TEST_MAX_MSGS_NUM);
+    const uint8_t *data = &buf[rand() % (buf_byte_len - max_msgs_bytes + 1)];
+
+    for(size_t i = 0; i < msgs_num; i++) {
+      GUARD((EVP_Digest(&data[i * msg_byte_len], msg_byte_len, ref_dgst[i],
+                        NULL, md, NULL) > 0)
+              ? SUCCESS
+              : FAILURE);
+    }
+
+    hash(tst_dgst, data, impl);
+    multi(tst_multi, data, msgs_num, impl);
+
+    if(0 != memcmp(ref_dgst[0], tst_dgst, dgst_byte_len)) {
+      printf("Fixed length digest mismatch for impl=%d and size=%ld\n", impl,
+             msg_byte_len);
+      print(ref_dgst[0], dgst_byte_len);
+      print(tst_dgst, dgst_byte_len);
+      return FAILURE;
+    }
+
+    // The digests of the multi function are stored consecutively
+    for(size_t i = 0; i < msgs_num; i++) {
+      const uint8_t *tst = &tst_multi[i * dgst_byte_len];
+
+      if(0 != memcmp(ref_dgst[i], tst, dgst_byte_len)) {
+        printf("Fixed length multi-buffer digest mismatch for impl=%d, "
+               "msg=%ld/%ld and size=%ld\n",
+               impl, i, msgs_num, msg_byte_len);
+        print(ref_dgst[i], dgst_byte_len);
+        print(tst, dgst_byte_len);
+        return FAILURE;
+      }
+    }
+  }
+
+  return SUCCESS;
+}
+
+_INLINE_ int test_fixed_sha256()
+{
+  uint8_t buf[MULTI_TEST_MAX_MSGS_NUM * FIXED_TEST_MAX_BYTE_LEN + 64] = {0};
+
+  // Use a deterministic seed.
+  srand(0);
+  rand_data(buf, sizeof(buf));
+
+  printf("Testing fixed length SHA256 tests\n");
+
+  static const struct {
+    fixed_hash_t  hash;
+    fixed_multi_t multi;
+    size_t        msg_byte_len;
+  } funcs[] = {{sha256_32B, sha256_32B_multi, 32},
+               {sha256_64B, sha256_64B_multi, 64}};
+
+  for(size_t f = 0; f < 2; f++) {
+    const fixed_hash_t  h = funcs[f].hash;
+    const fixed_multi_t m = funcs[f].multi;
+    const size_t        n = funcs[f].msg_byte_len;
+
+    GUARD(test_fixed_impl(GENERIC_IMPL, h, m, EVP_sha256(), n, buf, sizeof(buf)));
+    GUARD(test_fixed_impl(AUTO_IMPL, h, m, EVP_sha256(), n, buf, sizeof(buf)));
+
+    // X86-64 specific options
+    RUN_X86_64(GUARD(
+      test_fixed_impl(AVX_IMPL, h, m, EVP_sha256(), n, buf, sizeof(buf))););
+    RUN_X86_64(GUARD(test_fixed_impl(OPENSSL_AVX_IMPL, h, m, EVP_sha256(), n,
+                                     buf, sizeof(buf))););
+    RUN_AVX2(GUARD(
+      test_fixed_impl(AVX2_IMPL, h, m, EVP_sha256(), n, buf, sizeof(buf))););
+    RUN_AVX512(GUARD(
+      test_fixed_impl(AVX512_IMPL, h, m, EVP_sha256(), n, buf, sizeof(buf))););
+    RUN_X86_64_SHA_EXT(GUARD(
+      test_fixed_impl(SHA_EXT_IMPL, h, m, EVP_sha256(), n, buf, sizeof(buf))););
+
+    // Aarch64 specific options
+    RUN_NEON(GUARD(
+      test_fixed_impl(NEON_IMPL, h, m, EVP_sha256(), n, buf, sizeof(buf))););
+    RUN_AARCH64_SHA_EXT(GUARD(
+      test_fixed_impl(SHA_EXT_IMPL, h, m, EVP_sha256(), n, buf, sizeof(buf))););
+  }
+
+  return SUCCESS;
+}
+
+_INLINE_ int test_fixed_sha512()
+{
+  uint8_t buf[MULTI_TEST_MAX_MSGS_NUM * FIXED_TEST_MAX_BYTE_LEN + 64] = {0};
+
+  // Use a deterministic seed.
+  srand(0);
+  rand_data(buf, sizeof(buf));
+
+  printf("Testing fixed length SHA512 tests\n");
+
+  static const struct {
+    fixed_hash_t  hash;
+    fixed_multi_t multi;
+    size_t        msg_byte_len;
+  } funcs[] = {{sha512_64B, sha512_64B_multi, 64},
+               {sha512_128B, sha512_128B_multi, 128}};
+
+  for(size_t f = 0; f < 2; f++) {
+    const fixed_hash_t  h = funcs[f].hash;
+    const fixed_multi_t m = funcs[f].multi;
+    const size_t        n = funcs[f].msg_byte_len;
+
+    GUARD(test_fixed_impl(GENERIC_IMPL, h, m, EVP_sha512(), n, buf, sizeof(buf)));
+    GUARD(test_fixed_impl(AUTO_IMPL, h, m, EVP_sha512(), n, buf, sizeof(buf)));
+
+    // X86-64 specific options
+    RUN_X86_64(GUARD(
+      test_fixed_impl(AVX_IMPL, h, m, EVP_sha512(), n, buf, sizeof(buf))););
+    RUN_X86_64(GUARD(test_fixed_impl(OPENSSL_AVX_IMPL, h, m, EVP_sha512(), n,
+                                     buf, sizeof(buf))););
+    RUN_AVX2(GUARD(
+      test_fixed_impl(AVX2_IMPL, h, m, EVP_sha512(), n, buf, sizeof(buf))););
+    RUN_AVX512(GUARD(
+      test_fixed_impl(AVX512_IMPL, h, m, EVP_sha512(), n, buf, sizeof(buf))););
+  }
+
+  return SUCCESS;
+}
+
+_INLINE_ void ref_sha256d(OUT uint8_t *dgst,
+                          IN const uint8_t *data,
+                          IN const size_t   byte_len)
+{
+  uint8_t tmp[SHA256_HASH_BYTE_LEN];
+
+  SHA256(data, byte_len, tmp);
+  SHA256(tmp, sizeof(tmp), dgst);
+}
+
+_INLINE_ int test_sha256d_impl(IN const sha_impl_t impl,
+                               IN const uint8_t *data,
+                               IN const size_t   byte_len,
+                               IN const uint8_t *ref_dgst)
+{
+  uint8_t       tst_dgst[SHA256_HASH_BYTE_LEN] = {0};
+  uint8_t       mid_dgst[SHA256_HASH_BYTE_LEN] = {0};
+  sha256_ctx_t *prefix                         = sha256_ctx_new();
+  sha256_ctx_t *ctx                            = sha256_ctx_new();
+  int           ret                            = SUCCESS;
+
+  // The message continues from the midstate of its first half
+  const size_t prefix_byte_len = byte_len / 2;
+
+  GUARD_GOTO((prefix != NULL) && (ctx != NULL) ? SUCCESS : FAILURE);
+
+  sha256d(tst_dgst, data, byte_len, impl);
+
+  sha256_init(prefix, impl);
+  sha256_update(prefix, data, prefix_byte_len);
+  sha256_ctx_copy(ctx, prefix);
+  sha256_update(ctx, &data[prefix_byte_len], byte_len - prefix_byte_len);
+  sha256d_final(mid_dgst, ctx);
+
+  if((0 != memcmp(ref_dgst, tst_dgst, SHA256_HASH_BYTE_LEN)) ||
+     (0 != memcmp(ref_dgst, mid_dgst, SHA256_HASH_BYTE_LEN))) {
+    printf("SHA256d digest mismatch for impl=%d and size=%ld\n", impl,
+           byte_len);
+    print(ref_dgst, SHA256_HASH_BYTE_LEN);
+    print(tst_dgst, SHA256_HASH_BYTE_LEN);
+    print(mid_dgst, SHA256_HASH_BYTE_LEN);
+    ret = FAILURE;
+  }
+
+cleanup:
+  sha256_ctx_free(prefix);
+  sha256_ctx_free(ctx);
+  return ret;
+}
+
+_INLINE_ int test_sha256d_null_impl(IN const sha_impl_t impl,
+                                    IN const uint8_t *ref_dgst)
+{
+  uint8_t tst_dgst[SHA256_HASH_BYTE_LEN] = {0};
+
+  sha256d(tst_dgst, NULL, 0, impl);
+
+  if(0 != memcmp(ref_dgst, tst_dgst, SHA256_HASH_BYTE_LEN)) {
+    printf("SHA256d digest mismatch for impl=%d and NULL data\n", impl);
+    print(ref_dgst, SHA256_HASH_BYTE_LEN);
+    print(tst_dgst, SHA256_HASH_BYTE_LEN);
+    return FAILURE;
+  }
+
+  return SUCCESS;
+}
+
+_INLINE_ int test_sha256d_multi_impl(IN const sha_impl_t impl,
+                                     IN const uint8_t *data[],
+                                     IN const size_t   byte_len[],
+                                     IN uint8_t ref_dgst[][SHA256_HASH_BYTE_LEN],
+                                     IN const size_t   msgs_num)
+{
+  uint8_t  tst_dgst[MULTI_TEST_MAX_MSGS_NUM][SHA256_HASH_BYTE_LEN] = {0};
+  uint8_t *dgst[MULTI_TEST_MAX_MSGS_NUM];
+
+  for(size_t i = 0; i < msgs_num; i++) {
+    dgst[i] = tst_dgst[i];
+  }
+
+  sha256d_multi(dgst, data, byte_len, msgs_num, impl);
+
+  for(size_t i = 0; i < msgs_num; i++) {
+    if(0 != memcmp(ref_dgst[i], tst_dgst[i], SHA256_HASH_BYTE_LEN)) {
+      printf("SHA256d multi-buffer digest mismatch for impl=%d, msg=%ld/%ld "
+             "and size=%ld\n",
+             impl, i, msgs_num, byte_len[i]);
+      print(ref_dgst[i], SHA256_HASH_BYTE_LEN);
+      print(tst_dgst[i], SHA256_HASH_BYTE_LEN);
+      return FAILURE;
+    }
+  }
+
+  return SUCCESS;
+}
+
+_INLINE_ int test_sha256d()
+{
+  uint8_t        ref_dgst[MULTI_TEST_MAX_MSGS_NUM][SHA256_HASH_BYTE_LEN];
+  const uint8_t *data[MULTI_TEST_MAX_MSGS_NUM];
+  size_t         byte_len[MULTI_TEST_MAX_MSGS_NUM];
+  uint8_t        buf[SHA256_TEST_MAX_MSG_BYTE_LEN] = {0};
+
+  // Use a deterministic seed.
+  srand(0);
+  rand_data(buf, sizeof(buf));
+
+  printf("Testing SHA256d tests\n");
+
+  for(size_t t = 0; t < SHA256D_TEST_ALL_LENS_NUM + SHA256D_TEST_CASES_NUM;
+      t++) {
+    const size_t len =
+      (t < SHA256D_TEST_ALL_LENS_NUM) ? t : (size_t)(rand() % sizeof(buf));
+
+    ref_sha256d(ref_dgst[0], buf, len);
+
+    GUARD(test_sha256d_impl(GENERIC_IMPL, buf, len, ref_dgst[0]));
+    GUARD(test_sha256d_impl(AUTO_IMPL, buf, len, ref_dgst[0]));
+
+    // X86-64 specific options
+    RUN_X86_64(GUARD(test_sha256d_impl(AVX_IMPL, buf, len, ref_dgst[0])););
+    RUN_X86_64(
+      GUARD(test_sha256d_impl(OPENSSL_AVX_IMPL, buf, len, ref_dgst[0])););
+    RUN_AVX2(GUARD(test_sha256d_impl(AVX2_IMPL, buf, len, ref_dgst[0])););
+    RUN_AVX512(GUARD(test_sha256d_impl(AVX512_IMPL, buf, len, ref_dgst[0])););
+    RUN_X86_64_SHA_EXT(
+      GUARD(test_sha256d_impl(SHA_EXT_IMPL, buf, len, ref_dgst[0])););
+
+    // Aarch64 specific options
+    RUN_AARCH64_SHA_EXT(
+      GUARD(test_sha256d_impl(SHA_EXT_IMPL, buf, len, ref_dgst[0])););
+  }
+
+  // An empty message may be NULL
+  ref_sha256d(ref_dgst[0], buf, 0);
+  GUARD(test_sha256d_null_impl(GENERIC_IMPL, ref_dgst[0]));
+  GUARD(test_sha256d_null_impl(AUTO_IMPL, ref_dgst[0]));
+
+  printf("Testing SHA256d multi-buffer tests\n");
+
+  for(size_t t = 0; t < MULTI_TEST_CASES_NUM; t++) {
+    const size_t msgs_num = 1 + (t % MULTI_TEST_MAX_MSGS_NUM);
+
+    for(size_t i = 0; i < msgs_num; i++) {
+      const size_t max_len = (rand() % 4) ? 300 : sizeof(buf);
+
+      byte_len[i] = rand() % max_len;
+      data[i]     = &buf[rand() % (sizeof(buf) - byte_len[i] + 1)];
+      ref_sha256d(ref_dgst[i], data[i], byte_len[i]);
+    }
+
+    GUARD(test_sha256d_multi_impl(GENERIC_IMPL, data, byte_len, ref_dgst,
+                                  msgs_num));
+    GUARD(
+      test_sha256d_multi_impl(AUTO_IMPL, data, byte_len, ref_dgst, msgs_num));
+
+    // X86-64 specific options
+    RUN_AVX2(GUARD(test_sha256d_multi_impl(AVX2_IMPL, data, byte_len,
+                                           ref_dgst, msgs_num)););
+    RUN_AVX512(GUARD(test_sha256d_multi_impl(AVX512_IMPL, data, byte_len,
+                                             ref_dgst, msgs_num)););
+    RUN_X86_64_SHA_EXT(GUARD(test_sha256d_multi_impl(
+      SHA_EXT_IMPL, data, byte_len, ref_dgst, msgs_num)););
+
+    // Aarch64 specific options
+    RUN_NEON(GUARD(test_sha256d_multi_impl(
+      NEON_IMPL, data, byte_len, ref_dgst, msgs_num)););
+    RUN_AARCH64_SHA_EXT(GUARD(test_sha256d_multi_impl(
+      SHA_EXT_IMPL, data, byte_len, ref_dgst, msgs_num)););
+    RUN_SVE(GUARD(
+      test_sha256d_multi_impl(SVE_IMPL, data, byte_len, ref_dgst, msgs_num)););
+  }
+
+  return SUCCESS;
+}
+
+// Returns 1 if dgst, read as a 256-bit little endian number, is less than or
+// equal to target
+_INLINE_ int ref_below_target(IN const uint8_t *dgst, IN const uint8_t *target)
+{
+  for(size_t i = SHA256_HASH_BYTE_LEN; i-- > 0;) {
+    if(dgst[i] != target[i]) {
+      return dgst[i] < target[i];
+    }
+  }
+
+  return 1;
+}
+
+_INLINE_ int test_sha256d_scan_impl(IN const sha_impl_t impl,
+                                    IN const uint8_t *header,
+                                    IN const uint32_t first_nonce,
+                                    IN const size_t   nonces_num,
+                                    IN const uint8_t *target,
+                                    IN const size_t   max_hits,
+                                    IN const uint32_t ref_hits[],
+                                    IN const size_t   ref_hits_num)
+{
+  uint32_t        tst_hits[SCAN_TEST_MAX_NONCES_NUM] = {0};
+  sha256d_scan_t *scan                               = sha256d_scan_new();
+
+  if(scan == NULL) {
+    printf("Failed to allocate a scan context\n");
+    return FAILURE;
+  }
+
+  sha256d_scan_init(scan, header, impl);
+  const size_t hits_num =
+    sha256d_scan(tst_hits, max_hits, scan, first_nonce, nonces_num, target);
+  sha256d_scan_free(scan);
+
+  if((hits_num != ref_hits_num) ||
+     (0 != memcmp(ref_hits, tst_hits, hits_num * sizeof(uint32_t)))) {
+    printf("SHA256d scan mismatch for impl=%d, first nonce=0x%x, nonces=%ld "
+           "and hits=%ld/%ld\n",
+           impl, first_nonce, nonces_num, hits_num, ref_hits_num);
+    return FAILURE;
+  }
+
+  return SUCCESS;
+}
+
+_INLINE_ int test_sha256d_scan()
+{
+  uint8_t  header[SHA256D_HEADER_BYTE_LEN];
+  uint8_t  target[SHA256_HASH_BYTE_LEN];
+  uint8_t  dgst[SHA256_HASH_BYTE_LEN];
+  uint32_t ref_hits[SCAN_TEST_MAX_NONCES_NUM];
+
+  // Use a deterministic seed.
+  srand(0);
+
+  printf("Testing SHA256d nonce scanning tests\n");
+
+  for(size_t t = 0; t < SCAN_TEST_CASES_NUM; t++) {
+    const size_t nonces_num = 1 + (rand() % SCAN_TEST_MAX_NONCES_NUM);
+    const size_t max_hits = (t % 3) ? SCAN_TEST_MAX_NONCES_NUM : (t % 7);
+    uint32_t     first_nonce;
+    size_t       ref_hits_num = 0;
+
+    rand_data(header, sizeof(header));
+    rand_data(target, sizeof(target));
+    rand_data((uint8_t *)&first_nonce, sizeof(first_nonce));
+
+    if((t % 5) == 0) {
+      first_nonce = UINT32_MAX - (uint32_t)(t % 20);
+    }
+
+    // About a quarter of the nonces are hits, and some targets accept all
+    target[SHA256_HASH_BYTE_LEN - 1] = (t % 11) ? 0x3f : 0xff;
+
+    for(size_t k = 0; (k < nonces_num) && (ref_hits_num < max_hits); k++) {
+      const uint32_t nonce = first_nonce + (uint32_t)k;
+
+      // The nonce is stored in little endian
+      for(size_t i = 0; i < sizeof(nonce); i++) {
+        header[SHA256D_HEADER_BYTE_LEN - sizeof(nonce) + i] =
+          (uint8_t)(nonce >> (8 * i));
+      }
+
+      ref_sha256d(dgst, header, sizeof(header));
+      if(ref_below_target(dgst, target)) {
+        ref_hits[ref_hits_num++] = nonce;
+      }
+    }
+
+    GUARD(test_sha256d_scan_impl(GENERIC_IMPL, header, first_nonce, nonces_num,
+                                 target, max_hits, ref_hits, ref_hits_num));
+    GUARD(test_sha256d_scan_impl(AUTO_IMPL, header, first_nonce, nonces_num,
+                                 target, max_hits, ref_hits, ref_hits_num));
+
+    // X86-64 specific options
+    RUN_X86_64(GUARD(test_sha256d_scan_impl(AVX_IMPL, header, first_nonce,
+                                            nonces_num, target, max_hits,
+                                            ref_hits, ref_hits_num)););
+    RUN_AVX2(GUARD(test_sha256d_scan_impl(AVX2_IMPL, header, first_nonce,
+                                          nonces_num, target, max_hits,
+                                          ref_hits, ref_hits_num)););
+    RUN_AVX512(GUARD(test_sha256d_scan_impl(AVX512_IMPL, header, first_nonce,
+                                            nonces_num, target, max_hits,
+                                            ref_hits, ref_hits_num)););
+    RUN_X86_64_SHA_EXT(GUARD(test_sha256d_scan_impl(
+      SHA_EXT_IMPL, header, first_nonce, nonces_num, target, max_hits,
+      ref_hits, ref_hits_num)););
+
+    // Aarch64 specific options
+    RUN_NEON(GUARD(test_sha256d_scan_impl(
+      NEON_IMPL, header, first_nonce, nonces_num, target, max_hits,
+      ref_hits, ref_hits_num)););
+    RUN_AARCH64_SHA_EXT(GUARD(test_sha256d_scan_impl(
+      SHA_EXT_IMPL, header, first_nonce, nonces_num, target, max_hits,
+      ref_hits, ref_hits_num)););
+    RUN_SVE(GUARD(test_sha256d_scan_impl(SVE_IMPL, header, first_nonce,
+                                         nonces_num, target, max_hits,
+                                         ref_hits, ref_hits_num)););
+  }
+
+  return SUCCESS;
+}
+
+_INLINE_ int test_file_impl(IN const sha_impl_t impl,
+                            IN const uint8_t *data,
+                            IN const size_t   byte_len)
+{
+  uint8_t ref_dgst[SHA512_HASH_BYTE_LEN];
+  uint8_t tst_dgst[SHA512_HASH_BYTE_LEN] = {0};
+
+  SHA256(data, byte_len, ref_dgst);
+  if((0 != sha256_file(tst_dgst, FILE_TEST_PATH, impl)) ||
+     (0 != memcmp(ref_dgst, tst_dgst, SHA256_HASH_BYTE_LEN))) {
+    printf("SHA256 file digest mismatch for impl=%d and size=%ld\n", impl,
+           byte_len);
+    return FAILURE;
+  }
+
+  SHA512(data, byte_len, ref_dgst);
+  if((0 != sha512_file(tst_dgst, FILE_TEST_PATH, impl)) ||
+     (0 != memcmp(ref_dgst, tst_dgst, SHA512_HASH_BYTE_LEN))) {
+    printf("SHA512 file digest mismatch for impl=%d and size=%ld\n", impl,
+           byte_len);
+    return FAILURE;
+  }
+
+  // The direct reads
+  SHA256(data, byte_len, ref_dgst);
+  if((0 != sha256_file_direct(tst_dgst, FILE_TEST_PATH, impl)) ||
+     (0 != memcmp(ref_dgst, tst_dgst, SHA256_HASH_BYTE_LEN))) {
+    printf("SHA256 direct file digest mismatch for impl=%d and size=%ld\n",
+           impl, byte_len);
+    return FAILURE;
+  }
+
+  SHA512(data, byte_len, ref_dgst);
+  if((0 != sha512_file_direct(tst_dgst, FILE_TEST_PATH, impl)) ||
+     (0 != memcmp(ref_dgst, tst_dgst, SHA512_HASH_BYTE_LEN))) {
+    printf("SHA512 direct file digest mismatch for impl=%d and size=%ld\n",
+           impl, byte_len);
+    return FAILURE;
+  }
+
+  return SUCCESS;
+}
+
+_INLINE_ int test_file()
+{
+  uint8_t ref_dgst[SHA512_HASH_BYTE_LEN];
+  uint8_t dgst[SHA512_HASH_BYTE_LEN];
+  int     ret = SUCCESS;
+
+  uint8_t *buf = malloc(FILE_TEST_MAX_BYTE_LEN);
+  if(buf == NULL) {
+    return FAILURE;
+  }
+
+  // Use a deterministic seed.
+  srand(0);
+  rand_data(buf, FILE_TEST_MAX_BYTE_LEN);
+
+  printf("Testing file hashing tests\n");
+
+  for(size_t t = 0; t < FILE_TEST_ALL_LENS_NUM + FILE_TEST_CASES_NUM; t++) {
+    size_t len = (t < FILE_TEST_ALL_LENS_NUM)
+                   ? t
+                   : (size_t)(rand() % FILE_TEST_MAX_BYTE_LEN);
+
+    // Lengths around one and two buffers of the direct reads
+    if((t >= FILE_TEST_ALL_LENS_NUM) && (t < FILE_TEST_ALL_LENS_NUM + 6)) {
+      len = (((t & 1) + 1) * FILE_TEST_BUF_BYTE_LEN) + ((t % 3) - 1);
+    }
+
+    FILE *f = fopen(FILE_TEST_PATH, "wb");
+    if((f == NULL) || (len != fwrite(buf, 1, len, f)) || (0 != fclose(f))) {
+      printf("Failed to write %s\n", FILE_TEST_PATH);
+      GUARD_GOTO(FAILURE);
+    }
+
+    GUARD_GOTO(test_file_impl(GENERIC_IMPL, buf, len));
+    GUARD_GOTO(test_file_impl(AUTO_IMPL, buf, len));
+  }
+
+  // A missing file is an error
+  (void)remove(FILE_TEST_PATH);
+  if((0 == sha256_file(dgst, FILE_TEST_PATH, AUTO_IMPL)) ||
+     (0 == sha512_file(dgst, FILE_TEST_PATH, AUTO_IMPL)) ||
+     (0 == sha256_file_direct(dgst, FILE_TEST_PATH, AUTO_IMPL)) ||
+     (0 == sha512_file_direct(dgst, FILE_TEST_PATH, AUTO_IMPL))) {
+    printf("Hashing a missing file did not fail\n");
+    GUARD_GOTO(FAILURE);
+  }
+
+  // The files of procfs report a size of 0 but are not empty
+  FILE *f = fopen(FILE_TEST_PROC_PATH, "rb");
+  if(f != NULL) {
+    const size_t len = fread(buf, 1, FILE_TEST_MAX_BYTE_LEN, f);
+    (void)fclose(f);
+
+    SHA256(buf, len, ref_dgst);
+    if((0 != sha256_file(dgst, FILE_TEST_PROC_PATH, AUTO_IMPL)) ||
+       (0 != memcmp(ref_dgst, dgst, SHA256_HASH_BYTE_LEN))) {
+      printf("SHA256 file digest mismatch for %s\n", FILE_TEST_PROC_PATH);
+      GUARD_GOTO(FAILURE);
+    }
+
+    SHA512(buf, len, ref_dgst);
+    if((0 != sha512_file(dgst, FILE_TEST_PROC_PATH, AUTO_IMPL)) ||
+       (0 != memcmp(ref_dgst, dgst, SHA512_HASH_BYTE_LEN))) {
+      printf("SHA512 file digest mismatch for %s\n", FILE_TEST_PROC_PATH);
+      ret = FAILURE;
+    }
+  }
+
+cleanup:
+  (void)remove(FILE_TEST_PATH);
+  free(buf);
+  return ret;
+}
+
+typedef int (*tree_hash_t)(uint8_t *      dgst,
+                           const uint8_t *data,
+                           size_t         byte_len,
+                           size_t         chunk_byte_len,
+                           size_t         threads_num,
+                           sha_impl_t     impl);
+
+// Computes the root of the tree hash from its definition in sha.h
+_INLINE_ int ref_tree_hash(OUT uint8_t *dgst,
+                           IN const EVP_MD *md,
+                           IN const uint8_t *data,
+                           IN const size_t   byte_len,
+                           IN const size_t   chunk_byte_len)
+{
+  uint8_t  block[128] = {0};
+  uint8_t *leaves     = NULL;
+  int      ret        = FAILURE;
+
+  const size_t dgst_byte_len  = (size_t)EVP_MD_size(md);
+  const size_t block_byte_len = (size_t)EVP_MD_block_size(md);
+  const size_t chunks_num =
+    (byte_len == 0) ? 1 : 1 + ((byte_len - 1) / chunk_byte_len);
+
+  EVP_MD_CTX *ctx = EVP_MD_CTX_new();
+  leaves          = malloc(chunks_num * dgst_byte_len);
+  if((ctx == NULL) || (leaves == NULL)) {
+    GUARD_GOTO(FAILURE);
+  }
+
+  memcpy(block, SHA_TREE_LEAF_TAG, strlen(SHA_TREE_LEAF_TAG));
+
+  for(size_t i = 0; i < chunks_num; i++) {
+    const size_t pos = i * chunk_byte_len;
+    const size_t len = ((byte_len - pos) < chunk_byte_len) ? (byte_len - pos)
+                                                           : chunk_byte_len;
+
+    if((EVP_DigestInit_ex(ctx, md, NULL) <= 0) ||
+       (EVP_DigestUpdate(ctx, block, block_byte_len) <= 0) ||
+       (EVP_DigestUpdate(ctx, &data[pos], len) <= 0) ||
+       (EVP_DigestFinal_ex(ctx, &leaves[i * dgst_byte_len], NULL) <= 0)) {
+      GUARD_GOTO(FAILURE);
+    }
+  }
+
+  memset(block, 0, sizeof(block));
+  memcpy(block, SHA_TREE_ROOT_TAG, strlen(SHA_TREE_ROOT_TAG));
+
+  // The lengths are stored as 64-bit big endian integers
+  for(size_t i = 0; i < 8; i++) {
+    block[block_byte_len - 16 + i] = (uint8_t)(chunk_byte_len >> (56 - 8 * i));
+    block[block_byte_len - 8 + i]  = (uint8_t)(byte_len >> (56 - 8 * i));
+  }
+
+  if((EVP_DigestInit_ex(ctx, md, NULL) <= 0) ||
+     (EVP_DigestUpdate(ctx, block, block_byte_len) <= 0) ||
+     (EVP_DigestUpdate(ctx, leaves, chunks_num * dgst_byte_len) <= 0) ||
+     (EVP_DigestFinal_ex(ctx, dgst, NULL) <= 0)) {
+    GUARD_GOTO(FAILURE);
+  }
+
+  ret = SUCCESS;
+
+cleanup:
+  EVP_MD_CTX_free(ctx);
+  free(leaves);
+  return ret;
+}
+
+_INLINE_ int test_tree_impl(IN const sha_impl_t impl,
+                            IN const tree_hash_t tree,
+                            IN const EVP_MD *    md,
+                            IN const uint8_t *   buf)
+{
+  uint8_t ref_dgst[SHA512_HASH_BYTE_LEN];
+  uint8_t tst_dgst[SHA512_HASH_BYTE_LEN] = {0};
+
+  const size_t dgst_byte_len  = (size_t)EVP_MD_size(md);
+  const size_t block_byte_len = (size_t)EVP_MD_block_size(md);
+
+  // One block chunks, short chunks, and the default chunks
+  const size_t tree_chunk_lens[] = {block_byte_len, 4096, 8 * block_byte_len,
+                                    SHA_TREE_DEFAULT_CHUNK_BYTE_LEN};
+  const size_t threads_nums[]    = {1, 2, 3, 0};
+
+  for(size_t t = 0; t < TREE_TEST_CASES_NUM; t++) {
+    const size_t chunk_byte_len = tree_chunk_lens[t % 4];
+    const size_t threads_num    = threads_nums[(t / 4) % 4];
+    const size_t max_len        = (chunk_byte_len < 4096)
+                                    ? TREE_TEST_MAX_CHUNKS_NUM * chunk_byte_len
+                                    : TREE_TEST_MAX_BYTE_LEN;
+
+    // Empty inputs, whole chunks and random lengths
+    size_t len = (size_t)rand() % (max_len + 1);
+    if(t < 8) {
+      len = (t < 4) ? 0 : chunk_byte_len;
+    } else if((t % 5) == 0) {
+      len -= len % chunk_byte_len;
+    }
+
+    GUARD(ref_tree_hash(ref_dgst, md, buf, len, chunk_byte_len));
+
+    if((0 != tree(tst_dgst, buf, len, chunk_byte_len, threads_num, impl)) ||
+       (0 != memcmp(ref_dgst, tst_dgst, dgst_byte_len))) {
+      printf("Tree hash mismatch for impl=%d, size=%ld, chunk=%ld and "
+             "threads=%ld\n",
+             impl, len, chunk_byte_len, threads_num);
+      print(ref_dgst, dgst_byte_len);
+      print(tst_dgst, dgst_byte_len);
+      return FAILURE;
+    }
+  }
+
+  // A chunk that is empty or not a whole number of blocks fails
+  const size_t bad_chunk_lens[] = {0, block_byte_len / 2, block_byte_len + 1};
+
+  for(size_t i = 0; i < 3; i++) {
+    errno = 0;
+    if((-1 != tree(tst_dgst, buf, 1000, bad_chunk_lens[i], 1, impl)) ||
+       (errno != EINVAL)) {
+      printf("Tree hash accepted chunk=%ld for impl=%d\n", bad_chunk_lens[i],
+             impl);
+      return FAILURE;
+    }
+  }
+
+  return SUCCESS;
+}
+
+_INLINE_ int test_tree()
+{
+  int ret = SUCCESS;
+
+  uint8_t *buf = malloc(TREE_TEST_MAX_BYTE_LEN);
+  if(buf == NULL) {
+    return FAILURE;
+  }
+
+  // Use a deterministic seed.
+  srand(0);
+  rand_data(buf, TREE_TEST_MAX_BYTE_LEN);
+
+  printf("Testing tree hashing tests\n");
+
+  GUARD_GOTO(test_tree_impl(GENERIC_IMPL, sha256_tree, EVP_sha256(), buf));
+  GUARD_GOTO(test_tree_impl(AUTO_IMPL, sha256_tree, EVP_sha256(), buf));
+  GUARD_GOTO(test_tree_impl(GENERIC_IMPL, sha512_tree, EVP_sha512(), buf));
+  GUARD_GOTO(test_tree_impl(AUTO_IMPL, sha512_tree, EVP_sha512(), buf));
+
+  // X86-64 specific options
+  RUN_AVX2(
+    GUARD_GOTO(test_tree_impl(AVX2_IMPL, sha256_tree, EVP_sha256(), buf));
+    GUARD_GOTO(test_tree_impl(AVX2_IMPL, sha512_tree, EVP_sha512(), buf)););
+  RUN_AVX512(
+    GUARD_GOTO(test_tree_impl(AVX512_IMPL, sha256_tree, EVP_sha256(), buf));
+    GUARD_GOTO(test_tree_impl(AVX512_IMPL, sha512_tree, EVP_sha512(), buf)););
+  RUN_X86_64_SHA_EXT(
+    GUARD_GOTO(test_tree_impl(SHA_EXT_IMPL, sha256_tree, EVP_sha256(), buf)););
+
+  // Aarch64 specific options
+  RUN_NEON(
+    GUARD_GOTO(test_tree_impl(NEON_IMPL, sha256_tree, EVP_sha256(), buf)););
+  RUN_AARCH64_SHA_EXT(
+    GUARD_GOTO(test_tree_impl(SHA_EXT_IMPL, sha256_tree, EVP_sha256(), buf)););
+  RUN_SVE(
+    GUARD_GOTO(test_tree_impl(SVE_IMPL, sha256_tree, EVP_sha256(), buf));
+    GUARD_GOTO(test_tree_impl(SVE_IMPL, sha512_tree, EVP_sha512(), buf)););
+
+cleanup:
+  free(buf);
+  return ret;
+}
+
+_INLINE_ int test_multi_pool_impl(IN const sha_impl_t impl,
+                                  IN sha_pool_t *pools[],
+                                  IN const uint8_t *buf)
+{
+  static uint8_t ref_dgst[POOL_TEST_MAX_MSGS_NUM][SHA512_HASH_BYTE_LEN];
+  static uint8_t tst_dgst[POOL_TEST_MAX_MSGS_NUM][SHA512_HASH_BYTE_LEN];
+  const uint8_t *msg[POOL_TEST_MAX_MSGS_NUM];
+  uint8_t *      dgst[POOL_TEST_MAX_MSGS_NUM];
+  size_t         byte_len[POOL_TEST_MAX_MSGS_NUM];
+
+  for(size_t i = 0; i < POOL_TEST_MAX_MSGS_NUM; i++) {
+    dgst[i] = tst_dgst[i];
+  }
+
+  for(size_t t = 0; t < POOL_TEST_CASES_NUM; t++) {
+    sha_pool_t * pool     = pools[t % POOL_TEST_POOLS_NUM];
+    const size_t msgs_num = (size_t)rand() % (POOL_TEST_MAX_MSGS_NUM + 1);
+
+    // Mostly short messages, and a few long ones
+    for(size_t i = 0; i < msgs_num; i++) {
+      const size_t max_len = (rand() % 8) ? 300 : POOL_TEST_MAX_BYTE_LEN;
+
+      byte_len[i] = (size_t)rand() % max_len;
+      msg[i]      = &buf[(size_t)rand() % (POOL_TEST_MAX_BYTE_LEN - byte_len[i])];
+    }
+
+    for(size_t i = 0; i < msgs_num; i++) {
+      SHA256(msg[i], byte_len[i], ref_dgst[i]);
+    }
+
+    if(0 != sha256_multi_pool(dgst, msg, byte_len, msgs_num, pool, impl)) {
+      printf("sha256_multi_pool failed\n");
+      return FAILURE;
+    }
+
+    for(size_t i = 0; i < msgs_num; i++) {
+      if(0 != memcmp(ref_dgst[i], tst_dgst[i], SHA256_HASH_BYTE_LEN)) {
+        printf("SHA256 pool digest mismatch for impl=%d, threads=%ld and "
+               "msg=%ld of %ld\n",
+               impl, sha_pool_threads_num(pool), i, msgs_num);
+        return FAILURE;
+      }
+    }
+
+    for(size_t i = 0; i < msgs_num; i++) {
+      SHA512(msg[i], byte_len[i], ref_dgst[i]);
+    }
+
+    if(0 != sha512_multi_pool(dgst, msg, byte_len, msgs_num, pool, impl)) {
+      printf("sha512_multi_pool failed\n");
+      return FAILURE;
+    }
+
+    for(size_t i = 0; i < msgs_num; i++) {
+      if(0 != memcmp(ref_dgst[i], tst_dgst[i], SHA512_HASH_BYTE_LEN)) {
+        printf("SHA512 pool digest mismatch for impl=%d, threads=%ld and "
+               "msg=%ld of %ld\n",
+               impl, sha_pool_threads_num(pool), i, msgs_num);
+        return FAILURE;
+      }
+    }
+  }
+
+  return SUCCESS;
+}
+
+_INLINE_ int test_multi_pool()
+{
+  static uint8_t buf[POOL_TEST_MAX_BYTE_LEN];
+  sha_pool_t *   pools[POOL_TEST_POOLS_NUM] = {NULL};
+  int            ret                        = SUCCESS;
+
+  // Use a deterministic seed.
+  srand(0);
+  rand_data(buf, sizeof(buf));
+
+  printf("Testing thread pool multi-buffer tests\n");
+
+  // The calling thread only (NULL), and pools of 1, 3 and all the CPUs
+  pools[1] = sha_pool_new(1);
+  pools[2] = sha_pool_new(3);
+  pools[3] = sha_pool_new(0);
+  if((pools[1] == NULL) || (pools[2] == NULL) || (pools[3] == NULL)) {
+    GUARD_GOTO(FAILURE);
+  }
+
+  GUARD_GOTO(test_multi_pool_impl(GENERIC_IMPL, pools, buf));
+  GUARD_GOTO(test_multi_pool_impl(AUTO_IMPL, pools, buf));
+
+  // X86-64 specific options
+  RUN_X86_64(GUARD_GOTO(test_multi_pool_impl(AVX_IMPL, pools, buf)););
+  RUN_AVX2(GUARD_GOTO(test_multi_pool_impl(AVX2_IMPL, pools, buf)););
+  RUN_AVX512(GUARD_GOTO(test_multi_pool_impl(AVX512_IMPL, pools, buf)););
+  RUN_X86_64_SHA_EXT(
+    GUARD_GOTO(test_multi_pool_impl(SHA_EXT_IMPL, pools, buf)););
+
+  // Aarch64 specific options
+  RUN_AARCH64_SHA_EXT(
+    GUARD_GOTO(test_multi_pool_impl(SHA_EXT_IMPL, pools, buf)););
+  RUN_SVE(GUARD_GOTO(test_multi_pool_impl(SVE_IMPL, pools, buf)););
+
+cleanup:
+  for(size_t i = 0; i < POOL_TEST_POOLS_NUM; i++) {
+    sha_pool_free(pools[i]);
+  }
+  return ret;
+}
+
+// The number of blocks of the padded message
+#define SHA256_PADDED_BLOCKS_NUM(len) (((len) + 8) / 64 + 1)
+#define SHA512_PADDED_BLOCKS_NUM(len) (((len) + 16) / 128 + 1)
+
+// Checks the counters of the lane utilization of a batch. The multi-buffer
+// implementations (multi_expected) hash batches of several messages in lanes.
+_INLINE_ int check_multi_stats(IN const sha_multi_stats_t *stats,
+                               IN const uint64_t blocks_num,
+                               IN const size_t   msgs_num,
+                               IN const int      multi_expected)
+{
+  const uint64_t busy_num  = stats->busy_blocks_num;
+  const uint64_t lanes_num = stats->lanes_blocks_num;
+
+  // Every block is compressed once, in a busy lane or on its own
+  if(((busy_num + stats->single_blocks_num) != blocks_num) ||
+     (busy_num > lanes_num) ||
+     (multi_expected && (msgs_num > 1) && (lanes_num == 0))) {
+    printf("Inconsistent lane utilization counters\n");
+    return FAILURE;
+  }
+
+  if((lanes_num != 0) && (msgs_num >= STATS_TEST_LONG_MSGS_NUM) &&
+     ((double)busy_num < STATS_TEST_MIN_UTILIZATION * (double)lanes_num)) {
+    printf("Low lane utilization %lu/%lu for %ld messages\n", busy_num,
+           lanes_num, msgs_num);
+    return FAILURE;
+  }
+
+  return SUCCESS;
+}
+
+_INLINE_ int test_multi_stats_impl(IN const sha_impl_t impl,
+                                   IN const int        multi_expected)
+{
+  uint8_t        buf[SHA512_TEST_MAX_MSG_BYTE_LEN];
+  uint8_t        ref_dgst[STATS_TEST_MAX_MSGS_NUM][SHA512_HASH_BYTE_LEN];
+  uint8_t        tst_dgst[STATS_TEST_MAX_MSGS_NUM][SHA512_HASH_BYTE_LEN];
+  uint8_t *      dgst[STATS_TEST_MAX_MSGS_NUM];
+  const uint8_t *msg[STATS_TEST_MAX_MSGS_NUM];
+  size_t         byte_len[STATS_TEST_MAX_MSGS_NUM];
+
+  rand_data(buf, sizeof(buf));
+
+  for(size_t i = 0; i < STATS_TEST_MAX_MSGS_NUM; i++) {
+    dgst[i] = tst_dgst[i];
+  }
+
+  for(size_t t = 0; t < STATS_TEST_CASES_NUM; t++) {
+    sha_multi_stats_t stats256 = {0};
+    sha_multi_stats_t stats512 = {0};
+    uint64_t          blocks256 = 0;
+    uint64_t          blocks512 = 0;
+
+    const size_t msgs_num = (size_t)rand() % (STATS_TEST_MAX_MSGS_NUM + 1);
+
+    for(size_t i = 0; i < msgs_num; i++) {
+      byte_len[i] = (size_t)rand() % SHA512_TEST_MAX_MSG_BYTE_LEN;
+      msg[i]      = &buf[(size_t)rand() % (sizeof(buf) - byte_len[i])];
+      blocks256 += SHA256_PADDED_BLOCKS_NUM(byte_len[i]);
+      blocks512 += SHA512_PADDED_BLOCKS_NUM(byte_len[i]);
+    }
+
+    for(size_t i = 0; i < msgs_num; i++) {
+      SHA256(msg[i], byte_len[i], ref_dgst[i]);
+    }
+
+    sha256_multi_stats(dgst, msg, byte_len, msgs_num, impl, &stats256);
+
+    for(size_t i = 0; i < msgs_num; i++) {
+      if(0 != memcmp(ref_dgst[i], tst_dgst[i], SHA256_HASH_BYTE_LEN)) {
+        printf("SHA256 multi digest mismatch for impl=%d\n", impl);
+        return FAILURE;
+      }
+    }
+
+    GUARD(check_multi_stats(&stats256, blocks256, msgs_num, multi_expected));
+
+    for(size_t i = 0; i < msgs_num; i++) {
+      SHA512(msg[i], byte_len[i], ref_dgst[i]);
+    }
+
+    sha512_multi_stats(dgst, msg, byte_len, msgs_num, impl, &stats512);
+
+    for(size_t i = 0; i < msgs_num; i++) {
+      if(0 != memcmp(ref_dgst[i], tst_dgst[i], SHA512_HASH_BYTE_LEN)) {
+        printf("SHA512 multi digest mismatch for impl=%d\n", impl);
+        return FAILURE;
+      }
+    }
+
+    // There is no SHA512 SHA extension multi-buffer implementation
+    GUARD(check_multi_stats(&stats512, blocks512, msgs_num,
+                            multi_expected && (impl != SHA_EXT_IMPL)));
+  }
+
+  return SUCCESS;
+}
+
+_INLINE_ int test_multi_stats()
+{
+  // Use a deterministic seed.
+  srand(0);
+
+  printf("Testing multi-buffer lane utilization tests\n");
+
+  GUARD(test_multi_stats_impl(GENERIC_IMPL, 0));
+
+  // X86-64 specific options
+  RUN_X86_64(GUARD(test_multi_stats_impl(AVX_IMPL, 0)););
+  RUN_AVX2(GUARD(test_multi_stats_impl(AVX2_IMPL, 1)););
+  RUN_AVX512(GUARD(test_multi_stats_impl(AVX512_IMPL, 1)););
+  RUN_X86_64_SHA_EXT(GUARD(test_multi_stats_impl(SHA_EXT_IMPL, 1)););
+
+  // Aarch64 specific options
+  RUN_NEON(GUARD(test_multi_stats_impl(NEON_IMPL, 0)););
+  RUN_AARCH64_SHA_EXT(GUARD(test_multi_stats_impl(SHA_EXT_IMPL, 0)););
+  RUN_SVE(GUARD(test_multi_stats_impl(SVE_IMPL, 1)););
+
+  return SUCCESS;
+}
+
 int main(void)
 {
   GUARD(test_sha256());
+  GUARD(test_sha256_multi());
   GUARD(test_sha512());
+  GUARD(test_sha512_multi());
+  GUARD(test_sha224());
+  GUARD(test_sha512_variants());
+  GUARD(test_hmac_sha256());
+  GUARD(test_hmac_sha512());
+  GUARD(test_hmac_sha256_multi());
+  GUARD(test_hmac_sha512_multi());
+  GUARD(test_pbkdf2_sha256());
+  GUARD(test_pbkdf2_sha512());
+  GUARD(test_hkdf_sha256());
+  GUARD(test_hkdf_sha512());
+  GUARD(test_merkle_sha256());
+  GUARD(test_merkle_sha512());
+  GUARD(test_fixed_sha256());
+  GUARD(test_fixed_sha512());
+  GUARD(test_sha256d());
+  GUARD(test_sha256d_scan());
+  GUARD(test_file());
+  GUARD(test_tree());
+  GUARD(test_multi_pool());
+  GUARD(test_multi_stats());
 
   return 0;
 }
@@ -3,6 +3,9 @@
 
 #pragma once
 
+#include "defs.h"
+#include "sha.h"
+
 #define SUCCESS 0
 #define FAILURE (-1)
 #define GUARD(x)         \
@@ -12,41 +15,61 @@
     }                    \
   } while(0)
 
+// Requires a variable ret and a cleanup label in the calling function
+#define GUARD_GOTO(x)    \
+  do {                   \
+    if(SUCCESS != (x)) { \
+      ret = FAILURE;     \
+      goto cleanup;      \
+    }                    \
+  } while(0)
+
 /////////////////////////////
 //  X86_64 specific options
 /////////////////////////////
 
+// The RUN_* macros run x only if the implementation was compiled in and the
+// current CPU supports it.
+
 #if defined(X86_64)
-#  define RUN_X86_64(x) \
-    do {                \
-      x                 \
+#  define RUN_X86_64(x)                  \
+    do {                                 \
+      if(sha_impl_supported(AVX_IMPL)) { \
+        x                                \
+      }                                  \
     } while(0)
 #else
 #  define RUN_X86_64(x)
 #endif
 
 #if defined(AVX2_SUPPORT)
-#  define RUN_AVX2(x) \
-    do {              \
-      x               \
+#  define RUN_AVX2(x)                     \
+    do {                                  \
+      if(sha_impl_supported(AVX2_IMPL)) { \
+        x                                 \
+      }                                   \
     } while(0)
 #else
 #  define RUN_AVX2(x)
 #endif
 
 #if defined(AVX512_SUPPORT)
-#  define RUN_AVX512(x) \
-    do {                \
-      x                 \
+#  define RUN_AVX512(x)                     \
+    do {                                    \
+      if(sha_impl_supported(AVX512_IMPL)) { \
+        x                                   \
+      }                                     \
     } while(0)
 #else
 #  define RUN_AVX512(x)
 #endif
 
 #if defined(X86_64_SHA_SUPPORT)
-#  define RUN_X86_64_SHA_EXT(x) \
-    do {                        \
-      x                         \
+#  define RUN_X86_64_SHA_EXT(x)              \
+    do {                                     \
+      if(sha_impl_supported(SHA_EXT_IMPL)) { \
+        x                                    \
+      }                                      \
     } while(0)
 #else
 #  define RUN_X86_64_SHA_EXT(x)
@@ -57,23 +80,49 @@
 /////////////////////////////
 
 #if defined(NEON_SUPPORT)
-#  define RUN_NEON(x) \
-    do {              \
-      x               \
+#  define RUN_NEON(x)                             \
+    do {                                          \
+      if(sha_impl_supported(OPENSSL_NEON_IMPL)) { \
+        x                                         \
+      }                                           \
     } while(0)
 #else
 #  define RUN_NEON(x)
 #endif
 
 #if defined(AARCH64_SHA_SUPPORT)
-#  define RUN_AARCH64_SHA_EXT(x) \
-    do {                         \
-      x                          \
+#  define RUN_AARCH64_SHA_EXT(x)             \
+    do {                                     \
+      if(sha_impl_supported(SHA_EXT_IMPL)) { \
+        x                                    \
+      }                                      \
     } while(0)
 #else
 #  define RUN_AARCH64_SHA_EXT(x)
 #endif
-    
+
+#if defined(AARCH64_SHA512_SUPPORT)
+#  define RUN_AARCH64_SHA512_EXT(x)             \
+    do {                                        \
+      if(sha512_impl_supported(SHA_EXT_IMPL)) { \
+        x                                       \
+      }                                         \
+    } while(0)
+#else
+#  define RUN_AARCH64_SHA512_EXT(x)
+#endif
+
+#if defined(AARCH64_SVE_SUPPORT)
+#  define RUN_SVE(x)                     \
+    do {                                 \
+      if(sha_impl_supported(SVE_IMPL)) { \
+        x                                \
+      }                                  \
+    } while(0)
+#else
+#  define RUN_SVE(x)
+#endif
+
 /////////////////////////////
 //  Inline utilities
 /////////////////////////////
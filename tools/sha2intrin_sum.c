@@ -0,0 +1,208 @@
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+// Prints the SHA256 or SHA512 digests of files (like sha256sum), hashing them
+// with sha256_file/sha512_file (or with direct reads, sha*_file_direct). With
+// -b, hashes every file with every implementation that the CPU supports and
+// reports the throughput in GB/s.
+
+// For getopt and clock_gettime
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "sha.h"
+
+typedef struct impl_name_s {
+  sha_impl_t  impl;
+  const char *name;
+} impl_name_t;
+
+static const impl_name_t impl_names[] = {
+  {GENERIC_IMPL, "generic"},
+  {AVX_IMPL, "avx"},
+  {OPENSSL_AVX_IMPL, "openssl-avx"},
+  {AVX2_IMPL, "avx2"},
+  {OPENSSL_AVX2_IMPL, "openssl-avx2"},
+  {AVX512_IMPL, "avx512"},
+  {SHA_EXT_IMPL, "sha-ext"},
+  {OPENSSL_SHA_EXT_IMPL, "openssl-sha-ext"},
+  {NEON_IMPL, "neon"},
+  {OPENSSL_NEON_IMPL, "openssl-neon"},
+  {AUTO_IMPL, "auto"},
+  {SVE_IMPL, "sve"},
+};
+
+#define IMPLS_NUM (sizeof(impl_names) / sizeof(impl_names[0]))
+
+typedef int (*file_func_t)(OUT uint8_t *dgst,
+                           IN const char *path,
+                           IN sha_impl_t  impl);
+
+// sha_impl_supported or sha512_impl_supported, matching file_func
+typedef int (*impl_supported_t)(IN sha_impl_t impl);
+
+static void usage(IN const char *prog)
+{
+  fprintf(stderr,
+          "Usage: %s [-a 256|512] [-i impl] [-d] [-b] file...\n"
+          "  -a  the hash function: 256 (default) or 512\n"
+          "  -i  the implementation (default auto):",
+          prog);
+
+  for(size_t i = 0; i < IMPLS_NUM; i++) {
+    fprintf(stderr, " %s", impl_names[i].name);
+  }
+
+  fprintf(stderr, "\n  -d  read the files with O_DIRECT\n");
+  fprintf(stderr, "  -b  report the throughput of every supported "
+                  "implementation in GB/s\n");
+}
+
+static int parse_impl(OUT sha_impl_t *impl, IN const char *name)
+{
+  for(size_t i = 0; i < IMPLS_NUM; i++) {
+    if(strcmp(impl_names[i].name, name) == 0) {
+      *impl = impl_names[i].impl;
+      return 0;
+    }
+  }
+
+  return -1;
+}
+
+static double now_sec(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + ((double)ts.tv_nsec * 1e-9);
+}
+
+static int print_dgst(IN const char *path,
+                      IN file_func_t file_func,
+                      IN size_t      dgst_byte_len,
+                      IN sha_impl_t  impl)
+{
+  uint8_t dgst[SHA512_HASH_BYTE_LEN];
+
+  if(file_func(dgst, path, impl) != 0) {
+    fprintf(stderr, "%s: %s\n", path, strerror(errno));
+    return -1;
+  }
+
+  for(size_t i = 0; i < dgst_byte_len; i++) {
+    printf("%02x", dgst[i]);
+  }
+  printf("  %s\n", path);
+
+  return 0;
+}
+
+static int bench_file(IN const char *path,
+                      IN file_func_t      file_func,
+                      IN impl_supported_t impl_supported)
+{
+  uint8_t     dgst[SHA512_HASH_BYTE_LEN];
+  struct stat st;
+
+  // Warm the page cache (direct reads bypass it), so that all the
+  // implementations read the file under the same conditions
+  if((stat(path, &st) != 0) || (file_func(dgst, path, AUTO_IMPL) != 0)) {
+    fprintf(stderr, "%s: %s\n", path, strerror(errno));
+    return -1;
+  }
+
+  printf("%s (%lld bytes):\n", path, (long long)st.st_size);
+
+  for(size_t i = 0; i < IMPLS_NUM; i++) {
+    // An unsupported implementation falls back to another one, which would be
+    // reported under the wrong name. AUTO_IMPL is one of the other rows.
+    if((impl_names[i].impl == AUTO_IMPL) ||
+       !impl_supported(impl_names[i].impl)) {
+      continue;
+    }
+
+    const double start = now_sec();
+    if(file_func(dgst, path, impl_names[i].impl) != 0) {
+      fprintf(stderr, "%s: %s\n", path, strerror(errno));
+      return -1;
+    }
+    const double sec = now_sec() - start;
+
+    printf("  %16s %8.2f GB/s\n", impl_names[i].name,
+           ((double)st.st_size / 1e9) / sec);
+  }
+
+  return 0;
+}
+
+int main(int argc, char *argv[])
+{
+  file_func_t      file_func      = sha256_file;
+  impl_supported_t impl_supported = sha_impl_supported;
+  size_t           dgst_byte_len  = SHA256_HASH_BYTE_LEN;
+  sha_impl_t       impl           = AUTO_IMPL;
+  int              bench          = 0;
+  int              direct         = 0;
+  int              ret            = EXIT_SUCCESS;
+  int              opt;
+
+  while((opt = getopt(argc, argv, "a:i:db")) != -1) {
+    switch(opt) {
+      case 'a':
+        if(strcmp(optarg, "256") == 0) {
+          file_func      = sha256_file;
+          impl_supported = sha_impl_supported;
+          dgst_byte_len  = SHA256_HASH_BYTE_LEN;
+        } else if(strcmp(optarg, "512") == 0) {
+          file_func      = sha512_file;
+          impl_supported = sha512_impl_supported;
+          dgst_byte_len  = SHA512_HASH_BYTE_LEN;
+        } else {
+          usage(argv[0]);
+          return EXIT_FAILURE;
+        }
+        break;
+
+      case 'i':
+        if(parse_impl(&impl, optarg) != 0) {
+          usage(argv[0]);
+          return EXIT_FAILURE;
+        }
+        break;
+
+      case 'd': direct = 1; break;
+
+      case 'b': bench = 1; break;
+
+      default: usage(argv[0]); return EXIT_FAILURE;
+    }
+  }
+
+  if(direct) {
+    file_func = (dgst_byte_len == SHA256_HASH_BYTE_LEN) ? sha256_file_direct
+                                                        : sha512_file_direct;
+  }
+
+  if(optind == argc) {
+    usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  for(int i = optind; i < argc; i++) {
+    const int res = bench ? bench_file(argv[i], file_func, impl_supported)
+                          : print_dgst(argv[i], file_func, dgst_byte_len, impl);
+    if(res != 0) {
+      ret = EXIT_FAILURE;
+    }
+  }
+
+  return ret;
+}